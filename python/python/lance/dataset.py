@@ -593,6 +593,68 @@ class LanceDataset(pa.dataset.Dataset):
         """
         return pa.Table.from_batches([self._ds.take_rows(row_ids, columns)])
 
+    def shuffled_batches(
+        self,
+        columns: Optional[List[str]] = None,
+        *,
+        seed: int = 0,
+        batch_size: Optional[int] = None,
+        block_size: Optional[int] = None,
+        shuffle_buffer_size: Optional[int] = None,
+        prefetch: Optional[int] = None,
+        rank: int = 0,
+        world_size: int = 1,
+        drop_last: bool = False,
+    ) -> pa.RecordBatchReader:
+        """Read the dataset in a seeded, block-shuffled order, e.g. for training.
+
+        Fragments are visited in a random order and read in blocks of consecutive
+        rows, which keeps I/O sequential.  Rows from several blocks are then shuffled
+        together in memory before they are returned.
+
+        Parameters
+        ----------
+        columns: list of str, optional
+            The columns to read. All columns are read if None.
+        seed: int, default 0
+            Seed for the shuffle. The same seed gives the same order.
+        batch_size: int, optional
+            The number of rows in each batch.
+        block_size: int, optional
+            The number of consecutive rows read together. Larger blocks give
+            longer sequential reads but a less random order.
+        shuffle_buffer_size: int, optional
+            The number of rows shuffled together in memory.
+        prefetch: int, optional
+            The number of blocks read ahead of the consumer.
+        rank: int, default 0
+            The rank of this reader when the dataset is shared by several
+            readers, e.g. in distributed training.
+        world_size: int, default 1
+            The number of readers. Each rank gets a disjoint set of rows as long
+            as all ranks use the same seed. Every rank returns the same number of
+            rows, and so of batches, which distributed training requires.
+        drop_last: bool, default False
+            How ranks are given the same number of rows. If True, the extra rows
+            of the larger shards are dropped. If False, the smaller shards are
+            padded by repeating rows.
+
+        Returns
+        -------
+        reader : RecordBatchReader
+        """
+        return self._ds.shuffled_scan(
+            columns,
+            seed,
+            batch_size,
+            block_size,
+            shuffle_buffer_size,
+            prefetch,
+            rank,
+            world_size,
+            drop_last,
+        )
+
     def head(self, num_rows, **kwargs):
         """
         Load the first N rows of the dataset.
@@ -2314,6 +2376,7 @@ class DatasetOptimizer:
         materialize_deletions: bool = True,
         materialize_deletions_threshold: float = 0.1,
         num_threads: Optional[int] = None,
+        cluster_by: Optional[Union[str, List[str]]] = None,
     ) -> CompactionMetrics:
         """Compacts small files in the dataset, reducing total number of files.
 
@@ -2346,6 +2409,11 @@ class DatasetOptimizer:
         num_threads: int, optional
             The number of threads to use when performing compaction. If not
             specified, defaults to the number of cores on the machine.
+        cluster_by: str or list of str, optional
+            Rewrite every fragment, ordering the rows by this column instead of
+            insertion order. If several columns are given the rows follow a
+            Z-order curve over them. Filters on these columns can then skip
+            most of the data.
 
         Returns
         -------
@@ -2363,6 +2431,10 @@ class DatasetOptimizer:
             materialize_deletions_threshold=materialize_deletions_threshold,
             num_threads=num_threads,
         )
+        if cluster_by is not None:
+            opts["cluster_by"] = (
+                [cluster_by] if isinstance(cluster_by, str) else list(cluster_by)
+            )
         return Compaction.execute(self._dataset, opts)
 
     def optimize_indices(self, **kwargs):
@@ -2431,6 +2503,8 @@ def write_dataset(
     progress: Optional[FragmentWriteProgress] = None,
     storage_options: Optional[Dict[str, str]] = None,
     use_legacy_format: bool = True,
+    max_writers: int = 1,
+    enable_fragment_chunks: bool = False,
 ) -> LanceDataset:
     """Write a given data_obj to the given uri
 
@@ -2473,6 +2547,14 @@ def write_dataset(
     use_legacy_format : optional, bool, default True
         Use the Lance v1 writer to write Lance v1 files.  The default is currently
         True but will change as we roll out the v2 format.
+    max_writers : int, default 1
+        The number of files to encode and write in parallel. The order of the
+        rows is preserved. This only helps when the data spans several files.
+    enable_fragment_chunks : bool, default False
+        Store the list of fragments in chunk files that are shared between
+        versions instead of inline in every manifest. This makes commits and
+        checkouts of datasets with very many fragments cheaper. Once enabled it
+        stays enabled, and older versions of Lance cannot read the dataset.
     """
     if _check_for_hugging_face(data_obj):
         # Huggingface datasets
@@ -2495,6 +2577,8 @@ def write_dataset(
         "progress": progress,
         "storage_options": storage_options,
         "use_legacy_format": use_legacy_format,
+        "max_writers": max_writers,
+        "enable_fragment_chunks": enable_fragment_chunks,
     }
 
     if commit_lock:
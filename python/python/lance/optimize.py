@@ -1,7 +1,7 @@
 # SPDX-License-Identifier: Apache-2.0
 # SPDX-FileCopyrightText: Copyright The Lance Authors
 
-from typing import Optional, TypedDict
+from typing import List, Optional, TypedDict
 
 # Re-exported from native module. See src/dataset/optimize.rs for implementation.
 from .lance import Compaction as Compaction
@@ -43,3 +43,8 @@ class CompactionOptions(TypedDict):
     The number of threads to use when performing compaction. If not
     specified, defaults to the number of cores on the machine.
     """
+    cluster_by: Optional[List[str]]
+    """
+    Rewrite every fragment with the rows sorted by this column, or along a
+    Z-order curve if several columns are given. (default: None)
+    """
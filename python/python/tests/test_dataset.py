@@ -116,6 +116,21 @@ def test_dataset_append(tmp_path: Path):
         lance.write_dataset(table2, base_dir, mode="append")
 
 
+def test_fragment_chunks(tmp_path: Path):
+    table = pa.Table.from_pydict({"a": range(100)})
+    base_dir = tmp_path / "test"
+    lance.write_dataset(
+        table, base_dir, max_rows_per_file=10, enable_fragment_chunks=True
+    )
+    lance.write_dataset(table, base_dir, mode="append")
+
+    assert len(list((base_dir / "_fragments").iterdir())) == 2
+    dataset = lance.dataset(base_dir)
+    assert len(dataset.get_fragments()) == 11
+    assert dataset.count_rows() == 200
+    assert lance.dataset(base_dir, version=1).count_rows() == 100
+
+
 def test_dataset_from_record_batch_iterable(tmp_path: Path):
     base_dir = tmp_path / "test"
 
@@ -304,6 +319,30 @@ def test_take_with_columns(tmp_path: Path):
     assert table2 == pa.Table.from_pylist([{"b": 2}])
 
 
+def test_shuffled_batches(tmp_path: Path):
+    table = pa.table({"x": range(1000), "y": range(1000)})
+    dataset = lance.write_dataset(table, tmp_path, max_rows_per_file=100)
+
+    def read(**kwargs):
+        reader = dataset.shuffled_batches(
+            ["x"], seed=1, batch_size=32, block_size=25, **kwargs
+        )
+        return pa.Table.from_batches(reader)["x"].to_pylist()
+
+    shuffled = read()
+    assert shuffled != list(range(1000))
+    assert sorted(shuffled) == list(range(1000))
+    assert read() == shuffled
+
+    shards = [read(rank=rank, world_size=3) for rank in range(3)]
+    assert len({len(shard) for shard in shards}) == 1
+    assert set(shards[0] + shards[1] + shards[2]) == set(range(1000))
+
+    shards = [read(rank=rank, world_size=3, drop_last=True) for rank in range(3)]
+    assert len({len(shard) for shard in shards}) == 1
+    assert len(set(shards[0] + shards[1] + shards[2])) == 3 * len(shards[0])
+
+
 def test_filter(tmp_path: Path):
     table = pa.Table.from_pydict({"a": range(100), "b": range(100)})
     base_dir = tmp_path / "test"
@@ -36,6 +36,24 @@ def test_dataset_optimize(tmp_path: Path):
     assert dataset.version == 3
 
 
+def test_compact_cluster_by(tmp_path: Path):
+    values = list(range(1000))
+    random.Random(42).shuffle(values)
+    data = pa.table({"a": values, "b": range(1000)})
+    dataset = lance.write_dataset(data, tmp_path, max_rows_per_file=100)
+
+    metrics = dataset.optimize.compact_files(
+        target_rows_per_fragment=300, cluster_by="a"
+    )
+    assert metrics.fragments_removed == 10
+    assert metrics.fragments_added == 4
+    assert dataset.to_table().column("a").to_pylist() == list(range(1000))
+
+    metrics = dataset.optimize.compact_files(cluster_by=["a", "b"])
+    assert metrics.fragments_added == 1
+    assert dataset.count_rows() == 1000
+
+
 def create_table(min, max, nvec, ndim=8):
     mat = np.random.uniform(min, max, (nvec, ndim))
     tbl = vec_to_table(data=mat)
@@ -33,8 +33,8 @@ use lance::dataset::{
     fragment::FileFragment as LanceFileFragment, progress::WriteFragmentProgress,
     scanner::Scanner as LanceScanner, transaction::Operation as LanceOperation,
     Dataset as LanceDataset, MergeInsertBuilder as LanceMergeInsertBuilder, ReadParams,
-    UpdateBuilder, Version, WhenMatched, WhenNotMatched, WhenNotMatchedBySource, WriteMode,
-    WriteParams,
+    ShuffleParams, UpdateBuilder, Version, WhenMatched, WhenNotMatched, WhenNotMatchedBySource,
+    WriteMode, WriteParams,
 };
 use lance::dataset::{BatchInfo, BatchUDF, NewColumnTransform, UDFCheckpointStore};
 use lance::index::{scalar::ScalarIndexParams, vector::VectorIndexParams};
@@ -207,6 +207,9 @@ impl MergeInsertBuilder {
         merge_dict.set_item("num_inserted_rows", merge_stats.num_inserted_rows)?;
         merge_dict.set_item("num_updated_rows", merge_stats.num_updated_rows)?;
         merge_dict.set_item("num_deleted_rows", merge_stats.num_deleted_rows)?;
+        merge_dict.set_item("num_spilled_partitions", merge_stats.num_spilled_partitions)?;
+        merge_dict.set_item("num_spilled_rows", merge_stats.num_spilled_rows)?;
+        merge_dict.set_item("num_spilled_bytes", merge_stats.num_spilled_bytes)?;
 
         Ok(merge_dict.into())
     }
@@ -687,6 +690,51 @@ impl Dataset {
         Ok(PyArrowType(Box::new(LanceReader::from_stream(stream))))
     }
 
+    #[allow(clippy::too_many_arguments)]
+    #[pyo3(signature = (columns = None, seed = 0, batch_size = None, block_size = None, shuffle_buffer_size = None, prefetch = None, rank = 0, world_size = 1, drop_last = false))]
+    fn shuffled_scan(
+        self_: PyRef<'_, Self>,
+        columns: Option<Vec<String>>,
+        seed: u64,
+        batch_size: Option<usize>,
+        block_size: Option<usize>,
+        shuffle_buffer_size: Option<usize>,
+        prefetch: Option<usize>,
+        rank: usize,
+        world_size: usize,
+        drop_last: bool,
+    ) -> PyResult<PyArrowType<Box<dyn RecordBatchReader + Send>>> {
+        let projection = if let Some(columns) = columns {
+            self_
+                .ds
+                .schema()
+                .project(&columns)
+                .map_err(|err| PyValueError::new_err(err.to_string()))?
+        } else {
+            self_.ds.schema().clone()
+        };
+
+        let defaults = ShuffleParams::default();
+        let params = ShuffleParams {
+            seed,
+            batch_size: batch_size.unwrap_or(defaults.batch_size),
+            block_size: block_size.unwrap_or(defaults.block_size),
+            shuffle_buffer_size: shuffle_buffer_size.unwrap_or(defaults.shuffle_buffer_size),
+            prefetch: prefetch.unwrap_or(defaults.prefetch),
+            rank,
+            world_size,
+            drop_last,
+        };
+        let stream = RT
+            .block_on(
+                Some(self_.py()),
+                self_.ds.shuffled_scan(Arc::new(projection), params),
+            )?
+            .map_err(|err| PyValueError::new_err(err.to_string()))?;
+
+        Ok(PyArrowType(Box::new(LanceReader::from_stream(stream))))
+    }
+
     fn alter_columns(&mut self, alterations: &PyList) -> PyResult<()> {
         let alterations = alterations
             .iter()
@@ -1182,9 +1230,17 @@ pub fn get_write_params(options: &PyDict) -> PyResult<Option<WriteParams>> {
         if let Some(maybe_nbytes) = get_dict_opt::<usize>(options, "max_bytes_per_file")? {
             p.max_bytes_per_file = maybe_nbytes;
         }
+        if let Some(max_writers) = get_dict_opt::<usize>(options, "max_writers")? {
+            p.max_writers = max_writers;
+        }
         if let Some(use_legacy_format) = get_dict_opt::<bool>(options, "use_legacy_format")? {
             p.use_legacy_format = use_legacy_format;
         }
+        if let Some(enable_fragment_chunks) =
+            get_dict_opt::<bool>(options, "enable_fragment_chunks")?
+        {
+            p.enable_fragment_chunks = enable_fragment_chunks;
+        }
         if let Some(progress) = get_dict_opt::<PyObject>(options, "progress")? {
             p.progress = Arc::new(PyWriteProgress::new(progress.to_object(options.py())));
         }
@@ -15,8 +15,8 @@
 use lance::dataset::{
     index::DatasetIndexRemapperOptions,
     optimize::{
-        commit_compaction, compact_files, plan_compaction, CompactionMetrics, CompactionOptions,
-        CompactionPlan, CompactionTask, RewriteResult,
+        commit_compaction, compact_files, plan_compaction, Clustering, CompactionMetrics,
+        CompactionOptions, CompactionPlan, CompactionTask, RewriteResult,
     },
 };
 use pyo3::{exceptions::PyNotImplementedError, pyclass::CompareOp, types::PyTuple};
@@ -47,6 +47,16 @@ fn parse_compaction_options(options: &PyDict) -> PyResult<CompactionOptions> {
                     .extract::<Option<usize>>()?
                     .unwrap_or_else(num_cpus::get);
             }
+            "cluster_by" => {
+                let columns = value.extract::<Option<Vec<String>>>()?.unwrap_or_default();
+                opts.clustering = match columns.len() {
+                    0 => None,
+                    1 => Some(Clustering::Sort {
+                        column: columns[0].clone(),
+                    }),
+                    _ => Some(Clustering::ZOrder { columns }),
+                };
+            }
             _ => {
                 return Err(PyValueError::new_err(format!(
                     "Invalid compaction option: {}",
@@ -15,6 +15,7 @@ use crate::Result;
 
 pub const DEFAULT_INDEX_CACHE_SIZE: usize = 128;
 pub const DEFAULT_METADATA_CACHE_SIZE: usize = 128;
+pub const DEFAULT_INDEX_PAGE_CACHE_SIZE_BYTES: usize = 256 * 1024 * 1024;
 
 type ArcAny = Arc<dyn Any + Send + Sync>;
 
@@ -101,3 +102,65 @@ impl FileMetadataCache {
         Ok(metadata)
     }
 }
+
+/// Cache for deserialized pages of index files.
+///
+/// Unlike the other caches this one is bounded by the (deep) size of the cached pages in bytes
+/// rather than by the number of entries, since pages vary widely in size.  The cache is keyed
+/// by the file path and the page number.  Index files are immutable so entries never need to be
+/// invalidated.
+#[derive(Clone, Debug)]
+pub struct IndexPageCache {
+    cache: Arc<Cache<(Path, u32), SizedRecord>>,
+}
+
+impl DeepSizeOf for IndexPageCache {
+    fn deep_size_of_children(&self, _: &mut Context) -> usize {
+        self.cache.weighted_size() as usize
+    }
+}
+
+impl IndexPageCache {
+    pub fn new(capacity_bytes: usize) -> Self {
+        let cache = Cache::builder()
+            .max_capacity(capacity_bytes as u64)
+            .weigher(|_, page: &SizedRecord| {
+                u32::try_from((page.size_accessor)(page.record.clone())).unwrap_or(u32::MAX)
+            })
+            .build();
+        Self {
+            cache: Arc::new(cache),
+        }
+    }
+
+    pub fn get<T: Send + Sync + 'static>(&self, path: &Path, page: u32) -> Option<Arc<T>> {
+        self.cache
+            .get(&(path.to_owned(), page))
+            .and_then(|entry| entry.record.clone().downcast::<T>().ok())
+    }
+
+    pub fn insert<T: DeepSizeOf + Send + Sync + 'static>(
+        &self,
+        path: Path,
+        page: u32,
+        value: Arc<T>,
+    ) {
+        self.cache.insert((path, page), SizedRecord::new(value));
+    }
+
+    /// The number of cached pages
+    pub fn len(&self) -> usize {
+        self.cache.sync();
+        self.cache.entry_count() as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// The total size of the cached pages in bytes
+    pub fn size_bytes(&self) -> usize {
+        self.cache.sync();
+        self.cache.weighted_size() as usize
+    }
+}
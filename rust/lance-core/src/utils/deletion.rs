@@ -4,6 +4,7 @@
 use std::{collections::HashSet, ops::Range};
 
 use arrow_array::BooleanArray;
+use arrow_buffer::BooleanBufferBuilder;
 use deepsize::{Context, DeepSizeOf};
 use roaring::RoaringBitmap;
 
@@ -60,6 +61,26 @@ impl DeletionVector {
         }
     }
 
+    /// The number of deleted rows in `range`
+    ///
+    /// Bitmaps answer this from their rank so the cost does not depend on the size of the range.
+    pub fn count_range(&self, range: Range<u32>) -> usize {
+        if range.is_empty() {
+            return 0;
+        }
+        match self {
+            Self::NoDeletions => 0,
+            Self::Set(set) => set.iter().filter(|offset| range.contains(offset)).count(),
+            Self::Bitmap(bitmap) => {
+                let before_start = match range.start {
+                    0 => 0,
+                    start => bitmap.rank(start - 1),
+                };
+                (bitmap.rank(range.end - 1) - before_start) as usize
+            }
+        }
+    }
+
     pub fn into_sorted_iter(self) -> Box<dyn Iterator<Item = u32> + Send + 'static> {
         match self {
             Self::NoDeletions => Box::new(std::iter::empty()),
@@ -94,6 +115,44 @@ impl DeletionVector {
         }
         .map(BooleanArray::from)
     }
+
+    /// Build a predicate for the contiguous row offsets in `range`, true for rows that are kept
+    ///
+    /// Returns None if no row in the range is deleted.  This starts from an all-true mask and
+    /// clears the bits of the deleted rows, which are found by intersecting the bitmap with the
+    /// range container by container, so the cost scales with the number of deletions in the
+    /// range instead of the number of rows.
+    pub fn build_predicate_for_range(&self, range: Range<u32>) -> Option<BooleanArray> {
+        let deleted = match self {
+            Self::NoDeletions => return None,
+            Self::Set(set) => set
+                .iter()
+                .copied()
+                .filter(|offset| range.contains(offset))
+                .collect::<RoaringBitmap>(),
+            Self::Bitmap(bitmap) => {
+                let mut deleted = RoaringBitmap::new();
+                deleted.insert_range(range.clone());
+                deleted &= bitmap;
+                deleted
+            }
+        };
+        if deleted.is_empty() {
+            return None;
+        }
+
+        let num_rows = (range.end - range.start) as usize;
+        let mut mask = BooleanBufferBuilder::new(num_rows);
+        if deleted.len() as usize == num_rows {
+            mask.append_n(num_rows, false);
+        } else {
+            mask.append_n(num_rows, true);
+            for offset in deleted {
+                mask.set_bit((offset - range.start) as usize, false);
+            }
+        }
+        Some(BooleanArray::new(mask.finish(), None))
+    }
 }
 
 impl Default for DeletionVector {
@@ -217,4 +276,45 @@ mod test {
         let dv = DeletionVector::from_iter(0..(BITMAP_THRESDHOLD as u32));
         assert!(matches!(dv, DeletionVector::Bitmap(_)));
     }
+
+    #[test]
+    fn test_build_predicate_for_range() {
+        let deleted = [3, 5, 6, 200];
+        for dv in [
+            DeletionVector::Set(HashSet::from_iter(deleted)),
+            DeletionVector::Bitmap(RoaringBitmap::from_iter(deleted)),
+        ] {
+            // Same result as the row by row predicate
+            let row_ids = (2..10).collect::<Vec<u64>>();
+            assert_eq!(
+                dv.build_predicate_for_range(2..10),
+                dv.build_predicate(row_ids.iter())
+            );
+            // No deletions in range
+            assert!(dv.build_predicate_for_range(10..200).is_none());
+            // Everything in range deleted
+            let mask = dv.build_predicate_for_range(5..7).unwrap();
+            assert_eq!(mask.true_count(), 0);
+        }
+        assert!(DeletionVector::NoDeletions
+            .build_predicate_for_range(0..10)
+            .is_none());
+    }
+
+    #[test]
+    fn test_count_range() {
+        let deleted = [0, 3, 5, 6, 200];
+        for dv in [
+            DeletionVector::Set(HashSet::from_iter(deleted)),
+            DeletionVector::Bitmap(RoaringBitmap::from_iter(deleted)),
+        ] {
+            assert_eq!(dv.count_range(0..10), 4);
+            assert_eq!(dv.count_range(1..6), 2);
+            assert_eq!(dv.count_range(5..7), 2);
+            assert_eq!(dv.count_range(7..200), 0);
+            assert_eq!(dv.count_range(7..201), 1);
+            assert_eq!(dv.count_range(4..4), 0);
+        }
+        assert_eq!(DeletionVector::NoDeletions.count_range(0..10), 0);
+    }
 }
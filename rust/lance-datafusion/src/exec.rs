@@ -17,8 +17,8 @@ use datafusion::{
         TaskContext,
     },
     physical_plan::{
-        streaming::PartitionStream, DisplayAs, DisplayFormatType, ExecutionPlan, PlanProperties,
-        SendableRecordBatchStream,
+        coalesce_partitions::CoalescePartitionsExec, streaming::PartitionStream, DisplayAs,
+        DisplayFormatType, ExecutionPlan, PlanProperties, SendableRecordBatchStream,
     },
 };
 use datafusion_common::{DataFusionError, Statistics};
@@ -182,7 +182,8 @@ impl LanceExecutionOptions {
 
 /// Executes a plan using default session & runtime configuration
 ///
-/// Only executes a single partition.  Panics if the plan has more than one partition.
+/// If the plan has more than one partition then the partitions are executed
+/// concurrently and merged into a single stream (in no particular order).
 pub fn execute_plan(
     plan: Arc<dyn ExecutionPlan>,
     options: LanceExecutionOptions,
@@ -197,9 +198,11 @@ pub fn execute_plan(
     }
     let runtime_env = Arc::new(RuntimeEnv::new(runtime_config)?);
     let session_state = SessionState::new_with_config_rt(session_config, runtime_env);
-    // NOTE: we are only executing the first partition here. Therefore, if
-    // the plan has more than one partition, we will be missing data.
-    assert_eq!(plan.properties().partitioning.partition_count(), 1);
+    let plan = if plan.properties().partitioning.partition_count() > 1 {
+        Arc::new(CoalescePartitionsExec::new(plan))
+    } else {
+        plan
+    };
     Ok(plan.execute(0, session_state.task_ctx())?)
 }
 
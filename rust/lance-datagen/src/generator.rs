@@ -684,6 +684,76 @@ impl ArrayGenerator for RandomBinaryGenerator {
     }
 }
 
+/// Generates random printable strings whose lengths are uniformly distributed in a range
+pub struct RandomVariableUtf8Generator {
+    lengths: Uniform<u64>,
+    avg_bytes_per_element: u64,
+    is_large: bool,
+    data_type: DataType,
+}
+
+impl RandomVariableUtf8Generator {
+    pub fn new(min_bytes: ByteCount, max_bytes: ByteCount, is_large: bool) -> Self {
+        assert!(min_bytes.0 <= max_bytes.0);
+        Self {
+            lengths: Uniform::new_inclusive(min_bytes.0, max_bytes.0),
+            avg_bytes_per_element: (min_bytes.0 + max_bytes.0) / 2,
+            is_large,
+            data_type: if is_large {
+                DataType::LargeUtf8
+            } else {
+                DataType::Utf8
+            },
+        }
+    }
+}
+
+impl ArrayGenerator for RandomVariableUtf8Generator {
+    fn generate(
+        &mut self,
+        length: RowCount,
+        rng: &mut rand_xoshiro::Xoshiro256PlusPlus,
+    ) -> Result<Arc<dyn arrow_array::Array>, ArrowError> {
+        let lengths = (0..length.0)
+            .map(|_| rng.sample(self.lengths) as usize)
+            .collect::<Vec<_>>();
+        let mut bytes = vec![0; lengths.iter().sum::<usize>()];
+        rng.fill_bytes(&mut bytes);
+        // Same printable-ASCII trick as RandomBinaryGenerator
+        let bytes = Buffer::from(
+            bytes
+                .into_iter()
+                .map(|val| (val % 95) + 32)
+                .collect::<Vec<_>>(),
+        );
+        // This is safe because we are only using printable characters
+        if self.is_large {
+            let offsets = OffsetBuffer::from_lengths(lengths);
+            unsafe {
+                Ok(Arc::new(arrow_array::LargeStringArray::new_unchecked(
+                    offsets, bytes, None,
+                )))
+            }
+        } else {
+            let offsets = OffsetBuffer::from_lengths(lengths);
+            unsafe {
+                Ok(Arc::new(arrow_array::StringArray::new_unchecked(
+                    offsets, bytes, None,
+                )))
+            }
+        }
+    }
+
+    fn data_type(&self) -> &DataType {
+        &self.data_type
+    }
+
+    fn element_size_bytes(&self) -> Option<ByteCount> {
+        // The size varies by element
+        None
+    }
+}
+
 pub struct CycleBinaryGenerator<T: ByteArrayType> {
     values: Vec<u8>,
     lengths: Vec<usize>,
@@ -1609,6 +1679,22 @@ pub mod array {
         ))
     }
 
+    /// Create a generator of random strings with lengths uniformly distributed between
+    /// `min_bytes_per_element` and `max_bytes_per_element` (inclusive)
+    ///
+    /// All strings will consist entirely of printable ASCII characters
+    pub fn rand_utf8_var_length(
+        min_bytes_per_element: ByteCount,
+        max_bytes_per_element: ByteCount,
+        is_large: bool,
+    ) -> Box<dyn ArrayGenerator> {
+        Box::new(RandomVariableUtf8Generator::new(
+            min_bytes_per_element,
+            max_bytes_per_element,
+            is_large,
+        ))
+    }
+
     /// Create a random generator of boolean values
     pub fn rand_boolean() -> Box<dyn ArrayGenerator> {
         Box::<RandomBooleanGenerator>::default()
@@ -1861,6 +1947,18 @@ mod tests {
         assert!(bools.true_count() > 100);
     }
 
+    #[test]
+    fn test_rng_utf8_var_length() {
+        let mut rng = rand_xoshiro::Xoshiro256PlusPlus::seed_from_u64(DEFAULT_SEED.0);
+        let mut gen = array::rand_utf8_var_length(ByteCount::from(2), ByteCount::from(20), false);
+        let arr = gen.generate(RowCount::from(1000), &mut rng).unwrap();
+        let arr = arr.as_string::<i32>();
+        assert!(arr.iter().all(|s| (2..=20).contains(&s.unwrap().len())));
+        // Sanity check that we actually get a spread of lengths
+        assert!(arr.iter().any(|s| s.unwrap().len() < 6));
+        assert!(arr.iter().any(|s| s.unwrap().len() > 16));
+    }
+
     #[test]
     fn test_rng_list() {
         // Note: these tests are heavily dependent on the default seed.
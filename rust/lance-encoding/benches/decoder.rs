@@ -1,15 +1,36 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! Decoder benchmarks over a range of realistic data shapes
+//!
+//! The `compression` group encodes and decodes with each page compression scheme (none,
+//! zstd, lz4 and adaptive).
+//!
+//! Every case reports throughput in bytes of (in-memory) Arrow data.  Set
+//! `LANCE_BENCH_THROUGHPUT=rows` to report rows per second instead.
 use std::sync::Arc;
 
-use arrow_schema::{DataType, Field, TimeUnit};
-use criterion::{criterion_group, criterion_main, Criterion};
+use arrow_array::{
+    types::{Int32Type, Int64Type},
+    RecordBatch,
+};
+use arrow_schema::{DataType, Field, Fields, TimeUnit};
+use criterion::{criterion_group, criterion_main, BenchmarkGroup, Criterion, Throughput};
+use futures::StreamExt;
+use lance_datagen::{array, ArrayGenerator, ByteCount, RowCount};
 use lance_encoding::{
-    decoder::{DecoderMiddlewareChain, FilterExpression},
-    encoder::{encode_batch, CoreFieldEncodingStrategy},
+    decoder::{
+        BatchDecodeStream, DecodeBatchScheduler, DecodeParallelism, DecoderMiddlewareChain,
+        FilterExpression,
+    },
+    encoder::{encode_batch, CoreFieldEncodingStrategy, EncodedBatch},
+    BufferScheduler, EncodingsIo,
 };
+use rand::{seq::index::sample, SeedableRng};
+use tokio::{runtime::Runtime, sync::mpsc::unbounded_channel};
 
 const PRIMITIVE_TYPES: &[DataType] = &[
+    DataType::Boolean,
     DataType::Date32,
     DataType::Date64,
     DataType::Int8,
@@ -50,79 +71,321 @@ const PRIMITIVE_TYPES_FOR_FSL: &[DataType] = &[
     DataType::Float64,
 ];
 
+const NULL_RATES: &[f64] = &[0.0, 0.1, 0.9];
+
+// (name, min length, max length) in bytes
+const STRING_LENGTHS: &[(&str, u64, u64)] =
+    &[("short", 1, 8), ("medium", 16, 64), ("long", 256, 1024)];
+
+const NUM_ROWS: u64 = 1024 * 1024;
+const BATCH_SIZE: u32 = 32 * 1024;
+const PAGE_SIZE: u64 = 1024 * 1024;
+
+fn use_row_throughput() -> bool {
+    std::env::var("LANCE_BENCH_THROUGHPUT").is_ok_and(|val| val == "rows")
+}
+
+fn throughput(num_bytes: u64, num_rows: u64) -> Throughput {
+    if use_row_throughput() {
+        Throughput::Elements(num_rows)
+    } else {
+        Throughput::Bytes(num_bytes)
+    }
+}
+
+fn generate(gen: Box<dyn ArrayGenerator>, num_rows: u64, null_rate: f64) -> RecordBatch {
+    let mut builder = lance_datagen::gen().anon_col(gen);
+    if null_rate > 0.0 {
+        builder.with_random_nulls(null_rate);
+    }
+    builder.into_batch_rows(RowCount::from(num_rows)).unwrap()
+}
+
+fn encode(rt: &Runtime, data: &RecordBatch) -> EncodedBatch {
+    let lance_schema =
+        Arc::new(lance_core::datatypes::Schema::try_from(data.schema().as_ref()).unwrap());
+    let encoding_strategy = CoreFieldEncodingStrategy::default();
+    rt.block_on(encode_batch(
+        data,
+        lance_schema,
+        &encoding_strategy,
+        PAGE_SIZE,
+    ))
+    .unwrap()
+}
+
+/// Decodes either all of `encoded` or just the rows at `indices` and returns the row count
+///
+/// If `parallelism` is set then batches are decoded with [`BatchDecodeStream::into_parallel_stream`]
+async fn decode(
+    encoded: &EncodedBatch,
+    indices: Option<&[u64]>,
+    parallelism: Option<DecodeParallelism>,
+) -> usize {
+    let io = Arc::new(BufferScheduler::new(encoded.data.clone())) as Arc<dyn EncodingsIo>;
+    let mut decode_scheduler = DecodeBatchScheduler::try_new(
+        encoded.schema.as_ref(),
+        &encoded.page_table,
+        &vec![],
+        encoded.num_rows,
+        &DecoderMiddlewareChain::default(),
+        &io,
+    )
+    .await
+    .unwrap();
+    let (tx, rx) = unbounded_channel();
+    let filter = FilterExpression::no_filter();
+    let (root_decoder, num_rows) = if let Some(indices) = indices {
+        decode_scheduler.schedule_take(indices, &filter, tx, io);
+        (
+            decode_scheduler.new_root_decoder_indices(indices),
+            indices.len() as u64,
+        )
+    } else {
+        decode_scheduler.schedule_range(0..encoded.num_rows, &filter, tx, io);
+        #[allow(clippy::single_range_in_vec_init)]
+        let root_decoder = decode_scheduler.new_root_decoder_ranges(&[0..encoded.num_rows]);
+        (root_decoder, encoded.num_rows)
+    };
+    let stream = BatchDecodeStream::new(rx, BATCH_SIZE, num_rows, root_decoder);
+    let mut batches = if let Some(parallelism) = parallelism {
+        stream.into_parallel_stream(parallelism)
+    } else {
+        stream
+            .into_stream()
+            .map(|task| task.task)
+            .buffered(1)
+            .boxed()
+    };
+    let mut rows_decoded = 0;
+    while let Some(batch) = batches.next().await {
+        rows_decoded += batch.unwrap().num_rows();
+    }
+    rows_decoded
+}
+
+fn bench_full_decode(
+    group: &mut BenchmarkGroup<'_, criterion::measurement::WallTime>,
+    rt: &Runtime,
+    name: &str,
+    data: &RecordBatch,
+) {
+    let encoded = encode(rt, data);
+    group.throughput(throughput(
+        data.get_array_memory_size() as u64,
+        data.num_rows() as u64,
+    ));
+    group.bench_function(name, |b| {
+        b.iter(|| {
+            let rows_decoded = rt.block_on(decode(&encoded, None, None));
+            assert_eq!(data.num_rows(), rows_decoded);
+        })
+    });
+}
+
 fn bench_decode(c: &mut Criterion) {
-    let rt = tokio::runtime::Runtime::new().unwrap();
+    let rt = Runtime::new().unwrap();
     let mut group = c.benchmark_group("decode_primitive");
     for data_type in PRIMITIVE_TYPES {
-        let data = lance_datagen::gen()
-            .anon_col(lance_datagen::array::rand_type(&DataType::Int32))
-            .into_batch_rows(lance_datagen::RowCount::from(1024 * 1024))
-            .unwrap();
-        let lance_schema =
-            Arc::new(lance_core::datatypes::Schema::try_from(data.schema().as_ref()).unwrap());
-        let input_bytes = data.get_array_memory_size();
-        group.throughput(criterion::Throughput::Bytes(input_bytes as u64));
-        let encoding_strategy = CoreFieldEncodingStrategy::default();
-        let encoded = rt
-            .block_on(encode_batch(
-                &data,
-                lance_schema,
-                &encoding_strategy,
-                1024 * 1024,
-            ))
-            .unwrap();
-        let func_name = format!("{:?}", data_type).to_lowercase();
-        group.bench_function(func_name, |b| {
-            b.iter(|| {
-                let batch = rt
-                    .block_on(lance_encoding::decoder::decode_batch(
-                        &encoded,
-                        &FilterExpression::no_filter(),
-                        &DecoderMiddlewareChain::default(),
-                    ))
-                    .unwrap();
-                assert_eq!(data.num_rows(), batch.num_rows());
-            })
-        });
+        for null_rate in NULL_RATES {
+            let data = generate(array::rand_type(data_type), NUM_ROWS, *null_rate);
+            let name = format!("{:?}_nulls_{}", data_type, null_rate).to_lowercase();
+            bench_full_decode(&mut group, &rt, &name, &data);
+        }
     }
 }
+
 fn bench_decode_fsl(c: &mut Criterion) {
-    let rt = tokio::runtime::Runtime::new().unwrap();
+    let rt = Runtime::new().unwrap();
     let mut group = c.benchmark_group("decode_primitive_fsl");
     for data_type in PRIMITIVE_TYPES_FOR_FSL {
-        let data = lance_datagen::gen()
-            .anon_col(lance_datagen::array::rand_type(&DataType::FixedSizeList(
-                Arc::new(Field::new("item", DataType::Int32, true)),
+        let data = generate(
+            array::rand_type(&DataType::FixedSizeList(
+                Arc::new(Field::new("item", data_type.clone(), true)),
                 1024,
-            )))
-            .into_batch_rows(lance_datagen::RowCount::from(1024))
-            .unwrap();
-        let lance_schema =
-            Arc::new(lance_core::datatypes::Schema::try_from(data.schema().as_ref()).unwrap());
-        let input_bytes = data.get_array_memory_size();
-        group.throughput(criterion::Throughput::Bytes(input_bytes as u64));
-        let encoding_strategy = CoreFieldEncodingStrategy::default();
-        let encoded = rt
-            .block_on(encode_batch(
-                &data,
-                lance_schema,
-                &encoding_strategy,
-                1024 * 1024,
-            ))
-            .unwrap();
-        let func_name = format!("{:?}", data_type).to_lowercase();
-        group.bench_function(func_name, |b| {
-            b.iter(|| {
-                let batch = rt
-                    .block_on(lance_encoding::decoder::decode_batch(
-                        &encoded,
-                        &FilterExpression::no_filter(),
-                        &DecoderMiddlewareChain::default(),
-                    ))
-                    .unwrap();
-                assert_eq!(data.num_rows(), batch.num_rows());
-            })
-        });
+            )),
+            1024,
+            0.0,
+        );
+        let name = format!("{:?}", data_type).to_lowercase();
+        bench_full_decode(&mut group, &rt, &name, &data);
+    }
+}
+
+fn bench_decode_string(c: &mut Criterion) {
+    let rt = Runtime::new().unwrap();
+    let mut group = c.benchmark_group("decode_string");
+    for (length_name, min_len, max_len) in STRING_LENGTHS {
+        // Keep the data size roughly constant so long strings don't dominate the run time
+        let num_rows = NUM_ROWS * 16 / (min_len + max_len);
+        for null_rate in NULL_RATES {
+            let data = generate(
+                array::rand_utf8_var_length(
+                    ByteCount::from(*min_len),
+                    ByteCount::from(*max_len),
+                    false,
+                ),
+                num_rows,
+                *null_rate,
+            );
+            let name = format!("{}_nulls_{}", length_name, null_rate);
+            bench_full_decode(&mut group, &rt, &name, &data);
+        }
+    }
+}
+
+fn nested_shapes() -> Vec<(&'static str, DataType)> {
+    let int_list = DataType::List(Arc::new(Field::new("item", DataType::Int32, true)));
+    let string_list = DataType::List(Arc::new(Field::new("item", DataType::Utf8, true)));
+    let flat_struct = DataType::Struct(Fields::from(vec![
+        Field::new("id", DataType::Int64, true),
+        Field::new("score", DataType::Float32, true),
+        Field::new("name", DataType::Utf8, true),
+    ]));
+    let struct_with_list = DataType::Struct(Fields::from(vec![
+        Field::new("id", DataType::Int64, true),
+        Field::new("tags", string_list.clone(), true),
+    ]));
+    vec![
+        ("list_int32", int_list),
+        ("list_utf8", string_list),
+        ("struct", flat_struct),
+        ("struct_with_list", struct_with_list),
+    ]
+}
+
+fn bench_decode_nested(c: &mut Criterion) {
+    let rt = Runtime::new().unwrap();
+    let mut group = c.benchmark_group("decode_nested");
+    for (name, data_type) in nested_shapes() {
+        let data = generate(array::rand_type(&data_type), NUM_ROWS / 4, 0.0);
+        bench_full_decode(&mut group, &rt, name, &data);
+    }
+}
+
+fn bench_take(c: &mut Criterion) {
+    let rt = Runtime::new().unwrap();
+    let mut group = c.benchmark_group("take");
+    let mut shapes = vec![
+        ("int32", DataType::Int32),
+        ("float64", DataType::Float64),
+        ("utf8", DataType::Utf8),
+        (
+            "vector",
+            DataType::FixedSizeList(Arc::new(Field::new("item", DataType::Float32, true)), 128),
+        ),
+    ];
+    shapes.extend(nested_shapes());
+    let mut rng = rand::rngs::StdRng::seed_from_u64(42);
+    for (name, data_type) in shapes {
+        let num_rows = if matches!(data_type, DataType::FixedSizeList(_, _)) {
+            NUM_ROWS / 64
+        } else {
+            NUM_ROWS / 4
+        };
+        let data = generate(array::rand_type(&data_type), num_rows, 0.0);
+        let encoded = encode(&rt, &data);
+        let bytes_per_row = data.get_array_memory_size() as u64 / num_rows;
+        for num_indices in [1, 100, 10000] {
+            let mut indices = sample(&mut rng, num_rows as usize, num_indices)
+                .into_iter()
+                .map(|idx| idx as u64)
+                .collect::<Vec<_>>();
+            indices.sort_unstable();
+            group.throughput(throughput(
+                bytes_per_row * num_indices as u64,
+                num_indices as u64,
+            ));
+            group.bench_function(format!("{}_{}", name, num_indices), |b| {
+                b.iter(|| {
+                    let rows_decoded = rt.block_on(decode(&encoded, Some(&indices), None));
+                    assert_eq!(indices.len(), rows_decoded);
+                })
+            });
+        }
+    }
+}
+
+/// Sets LANCE_PAGE_COMPRESSION to `compression` while encoding `data`
+fn encode_compressed(rt: &Runtime, data: &RecordBatch, compression: &str) -> EncodedBatch {
+    std::env::set_var("LANCE_PAGE_COMPRESSION", compression);
+    let encoded = encode(rt, data);
+    std::env::remove_var("LANCE_PAGE_COMPRESSION");
+    encoded
+}
+
+fn bench_compression(c: &mut Criterion) {
+    let rt = Runtime::new().unwrap();
+    let mut group = c.benchmark_group("compression");
+    let shapes = [
+        // Small repeating values compress well, random floats and vectors barely compress
+        ("int32_cycle", array::cycle::<Int32Type>((0..64).collect())),
+        ("int64_step", array::step::<Int64Type>()),
+        ("float32", array::rand_type(&DataType::Float32)),
+        (
+            "vector",
+            array::rand_type(&DataType::FixedSizeList(
+                Arc::new(Field::new("item", DataType::Float32, true)),
+                128,
+            )),
+        ),
+    ];
+    for (name, gen) in shapes {
+        let num_rows = if name == "vector" {
+            NUM_ROWS / 64
+        } else {
+            NUM_ROWS
+        };
+        let data = generate(gen, num_rows, 0.0);
+        group.throughput(throughput(
+            data.get_array_memory_size() as u64,
+            data.num_rows() as u64,
+        ));
+        for compression in ["none", "zstd", "lz4", "adaptive"] {
+            // Encoding is where the adaptive selection spends its time
+            group.bench_function(format!("{}_{}_encode", name, compression), |b| {
+                b.iter(|| encode_compressed(&rt, &data, compression))
+            });
+            let encoded = encode_compressed(&rt, &data, compression);
+            group.bench_function(format!("{}_{}_decode", name, compression), |b| {
+                b.iter(|| {
+                    let rows_decoded = rt.block_on(decode(&encoded, None, None));
+                    assert_eq!(data.num_rows(), rows_decoded);
+                })
+            });
+        }
+    }
+}
+
+fn bench_decode_parallel(c: &mut Criterion) {
+    let rt = Runtime::new().unwrap();
+    let mut group = c.benchmark_group("decode_parallel");
+    let shapes = [
+        ("int32", array::rand_type(&DataType::Int32)),
+        (
+            "utf8",
+            array::rand_utf8_var_length(ByteCount::from(16), ByteCount::from(64), false),
+        ),
+    ];
+    for (name, gen) in shapes {
+        let data = generate(gen, NUM_ROWS * 4, 0.1);
+        let encoded = encode(&rt, &data);
+        group.throughput(throughput(
+            data.get_array_memory_size() as u64,
+            data.num_rows() as u64,
+        ));
+        for num_tasks in [1, 2, 4, 8, 16] {
+            let parallelism = DecodeParallelism {
+                max_in_flight: num_tasks,
+                rows_per_task: BATCH_SIZE / 4,
+            };
+            group.bench_function(format!("{}_tasks_{}", name, num_tasks), |b| {
+                b.iter(|| {
+                    let rows_decoded = rt.block_on(decode(&encoded, None, Some(parallelism)));
+                    assert_eq!(data.num_rows(), rows_decoded);
+                })
+            });
+        }
     }
 }
 
@@ -131,12 +394,14 @@ criterion_group!(
     name=benches;
     config = Criterion::default().significance_level(0.1).sample_size(10)
         .with_profiler(pprof::criterion::PProfProfiler::new(100, pprof::criterion::Output::Flamegraph(None)));
-    targets = bench_decode, bench_decode_fsl);
+    targets = bench_decode, bench_decode_fsl, bench_decode_string, bench_decode_nested,
+              bench_take, bench_compression, bench_decode_parallel);
 
 // Non-linux version does not support pprof.
 #[cfg(not(target_os = "linux"))]
 criterion_group!(
     name=benches;
     config = Criterion::default().significance_level(0.1).sample_size(10);
-    targets = bench_decode, bench_decode_fsl);
+    targets = bench_decode, bench_decode_fsl, bench_decode_string, bench_decode_nested,
+              bench_take, bench_compression, bench_decode_parallel);
 criterion_main!(benches);
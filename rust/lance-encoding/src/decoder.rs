@@ -222,7 +222,9 @@ use bytes::{Bytes, BytesMut};
 use futures::future::BoxFuture;
 use futures::stream::{BoxStream, FuturesOrdered};
 use futures::{FutureExt, StreamExt, TryStreamExt};
+use lance_arrow::DataTypeExt;
 use lance_core::datatypes::{Field, Schema};
+use lance_core::utils::tokio::spawn_cpu;
 use log::trace;
 use snafu::{location, Location};
 use tokio::sync::mpsc::{self, unbounded_channel};
@@ -1033,8 +1035,10 @@ impl BatchDecodeStream {
         Ok(scheduled_need)
     }
 
-    #[instrument(level = "debug", skip_all)]
-    async fn next_batch_task(&mut self) -> Result<Option<NextDecodeTask>> {
+    /// Waits until the next batch worth of rows is available in the root decoder
+    ///
+    /// Returns the number of rows in the next batch (0 if there are no more batches)
+    async fn wait_for_next_batch(&mut self) -> Result<u32> {
         trace!(
             "Draining batch task (rows_remaining={} rows_drained={} rows_scheduled={})",
             self.rows_remaining,
@@ -1042,7 +1046,7 @@ impl BatchDecodeStream {
             self.rows_scheduled,
         );
         if self.rows_remaining == 0 {
-            return Ok(None);
+            return Ok(0);
         }
 
         let mut to_take = self.rows_remaining.min(self.rows_per_batch as u64) as u32;
@@ -1065,7 +1069,7 @@ impl BatchDecodeStream {
         }
 
         if to_take == 0 {
-            return Ok(None);
+            return Ok(0);
         }
 
         let avail = self.root_decoder.avail_u64();
@@ -1077,11 +1081,42 @@ impl BatchDecodeStream {
             );
             self.root_decoder.wait(to_take).await?;
         }
+        Ok(to_take)
+    }
+
+    #[instrument(level = "debug", skip_all)]
+    async fn next_batch_task(&mut self) -> Result<Option<NextDecodeTask>> {
+        let to_take = self.wait_for_next_batch().await?;
+        if to_take == 0 {
+            return Ok(None);
+        }
         let next_task = self.root_decoder.drain(to_take)?;
         self.rows_drained += to_take as u64;
         Ok(Some(next_task))
     }
 
+    /// Similar to [`Self::next_batch_task`] but splits the batch into several decode tasks
+    /// of at most `rows_per_task` rows each.  Each of these can be decoded on a different core.
+    #[instrument(level = "debug", skip_all)]
+    async fn next_batch_subtasks(
+        &mut self,
+        rows_per_task: u32,
+    ) -> Result<Option<Vec<NextDecodeTask>>> {
+        let to_take = self.wait_for_next_batch().await?;
+        if to_take == 0 {
+            return Ok(None);
+        }
+        let mut subtasks = Vec::with_capacity(to_take.div_ceil(rows_per_task) as usize);
+        let mut remaining = to_take;
+        while remaining > 0 {
+            let rows_in_task = remaining.min(rows_per_task);
+            subtasks.push(self.root_decoder.drain(rows_in_task)?);
+            remaining -= rows_in_task;
+        }
+        self.rows_drained += to_take as u64;
+        Ok(Some(subtasks))
+    }
+
     #[instrument(level = "debug", skip_all)]
     fn task_to_batch(task: NextDecodeTask) -> Result<RecordBatch> {
         let struct_arr = task.task.decode();
@@ -1116,6 +1151,96 @@ impl BatchDecodeStream {
         });
         stream.boxed()
     }
+
+    /// Decodes the next batch directly into caller-owned memory
+    ///
+    /// There must be one destination in `dest` for each top-level field and each destination
+    /// must have room for `rows_per_batch` rows.  Returns the number of rows written, which
+    /// will be 0 once all scheduled rows have been decoded.
+    ///
+    /// This avoids allocating Arrow arrays for consumers (e.g. the DuckDB extension or NumPy)
+    /// that would otherwise immediately copy the decoded arrays into their own buffers.  It is
+    /// only supported when all fields are fixed-width (see [`FixedWidthDestination::supports`]).
+    /// The decode happens on the calling thread.
+    ///
+    /// If any field is not supported, or a destination is too small, this fails before any
+    /// rows are consumed.  The caller can then fall back to [`Self::into_stream`] and will
+    /// still get every row.
+    pub async fn next_batch_into(&mut self, dest: &mut [FixedWidthDestination<'_>]) -> Result<u32> {
+        let next_rows = self.rows_remaining.min(self.rows_per_batch as u64) as u32;
+        self.root_decoder.check_destinations(next_rows, dest)?;
+        let to_take = self.wait_for_next_batch().await?;
+        if to_take == 0 {
+            return Ok(0);
+        }
+        let rows_written = self.root_decoder.drain_into(to_take, dest)?;
+        self.rows_drained += to_take as u64;
+        Ok(rows_written)
+    }
+
+    /// Converts the decode stream into a stream of decoded batches, decoding on the CPU pool
+    ///
+    /// Unlike [`Self::into_stream`], which leaves it up to the caller to decide how many tasks
+    /// to poll at once, this method drives the decode itself.  Each batch is split into
+    /// sub-tasks of at most `rows_per_task` rows and each sub-task is decoded on the
+    /// dedicated CPU thread pool (see [`lance_core::utils::tokio::spawn_cpu`]).  This means
+    /// a single page (e.g. a large page of zstd compressed data in a single wide column) can
+    /// be decoded by many cores at once.
+    ///
+    /// Batches are emitted in order.  At most `max_in_flight` batches will be decoding (or
+    /// decoded and waiting for the consumer) at any one time.
+    pub fn into_parallel_stream(
+        self,
+        parallelism: DecodeParallelism,
+    ) -> BoxStream<'static, Result<RecordBatch>> {
+        let rows_per_task = parallelism.rows_per_task.max(1);
+        let subtasks = futures::stream::unfold(self, move |mut slf| async move {
+            let next_tasks = slf.next_batch_subtasks(rows_per_task).await;
+            next_tasks.transpose().map(|next_tasks| (next_tasks, slf))
+        });
+        subtasks
+            .map(|subtasks| async move {
+                let subtasks = subtasks?;
+                let batches = futures::future::try_join_all(
+                    subtasks
+                        .into_iter()
+                        .map(|subtask| spawn_cpu(move || Self::task_to_batch(subtask))),
+                )
+                .await?;
+                if batches.len() == 1 {
+                    Ok(batches.into_iter().next().unwrap())
+                } else {
+                    let schema = batches[0].schema();
+                    Ok(arrow_select::concat::concat_batches(&schema, &batches)?)
+                }
+            })
+            .buffered(parallelism.max_in_flight.max(1))
+            .boxed()
+    }
+}
+
+/// Controls how [`BatchDecodeStream::into_parallel_stream`] spreads decode work across cores
+#[derive(Debug, Clone, Copy)]
+pub struct DecodeParallelism {
+    /// The maximum number of batches that may be decoding at once
+    ///
+    /// This also bounds the number of decoded batches that can pile up if the consumer is slow.
+    pub max_in_flight: usize,
+    /// The maximum number of rows decoded by a single CPU task
+    ///
+    /// Batches larger than this are split into several tasks that decode in parallel and are
+    /// then concatenated.  Smaller values spread a single wide column across more cores at
+    /// the cost of an extra copy when the pieces are reassembled.
+    pub rows_per_task: u32,
+}
+
+impl Default for DecodeParallelism {
+    fn default() -> Self {
+        Self {
+            max_in_flight: num_cpus::get(),
+            rows_per_task: 8 * 1024,
+        }
+    }
 }
 
 /// A decoder for single-column encodings of primitive data (this includes fixed size
@@ -1173,6 +1298,32 @@ pub trait PhysicalPageDecoder: Send + Sync {
         num_rows: u32,
         dest_buffers: &mut [BytesMut],
     ) -> Result<()>;
+    /// Decodes the data into caller-owned memory
+    ///
+    /// This is similar to [`PhysicalPageDecoder::decode_into`] but the destination is owned by
+    /// the caller (e.g. a NumPy array or a DuckDB vector) and so it cannot be grown.  Each
+    /// slice must be exactly as large as the capacity calculated in
+    /// [`PhysicalPageDecoder::update_capacity`].  Optional buffers that are not needed may be
+    /// given as empty slices.
+    ///
+    /// The default implementation decodes into temporary buffers and then copies the result.
+    /// Encodings that can write their output in place should override this.
+    fn decode_into_slices(
+        &self,
+        rows_to_skip: u32,
+        num_rows: u32,
+        dest_buffers: &mut [&mut [u8]],
+    ) -> Result<()> {
+        let mut bufs = dest_buffers
+            .iter()
+            .map(|dest| BytesMut::with_capacity(dest.len()))
+            .collect::<Vec<_>>();
+        self.decode_into(rows_to_skip, num_rows, &mut bufs)?;
+        for (dest, buf) in dest_buffers.iter_mut().zip(bufs) {
+            dest[..buf.len()].copy_from_slice(&buf);
+        }
+        Ok(())
+    }
     fn num_buffers(&self) -> u32;
 }
 
@@ -1345,10 +1496,98 @@ pub trait FieldScheduler: Send + Sync + std::fmt::Debug {
     fn num_rows(&self) -> u64;
 }
 
+/// Caller-owned memory that a single fixed-width field can be decoded into
+///
+/// See [`BatchDecodeStream::next_batch_into`]
+pub struct FixedWidthDestination<'a> {
+    /// The values buffer
+    ///
+    /// This must have room for `num_rows * bytes_per_value` bytes.  Boolean values are
+    /// bit-packed (least significant bit first) and need `ceil(num_rows / 8)` bytes.
+    pub values: &'a mut [u8],
+    /// An optional validity bitmap (one bit per row, least significant bit first, 1 = valid)
+    ///
+    /// If this is `None` then decoding will fail if any of the decoded rows are null.
+    pub validity: Option<&'a mut [u8]>,
+}
+
+impl FixedWidthDestination<'_> {
+    /// Whether fields of `data_type` can be decoded into a destination
+    ///
+    /// These are the types that are stored as a validity bitmap and a buffer of values.
+    pub fn supports(data_type: &DataType) -> bool {
+        matches!(data_type, DataType::Boolean | DataType::FixedSizeBinary(_))
+            || (data_type.is_primitive() && !matches!(data_type, DataType::Interval(_)))
+    }
+
+    /// Checks that a field of `data_type` can be decoded into this destination and that
+    /// there is room for `num_rows` rows
+    pub(crate) fn check(&self, data_type: &DataType, num_rows: u32) -> Result<()> {
+        if !Self::supports(data_type) {
+            return Err(Error::NotSupported {
+                source: format!(
+                    "decoding {} into caller-provided buffers is not supported",
+                    data_type
+                )
+                .into(),
+                location: location!(),
+            });
+        }
+        let num_rows = num_rows as usize;
+        let values_size = if *data_type == DataType::Boolean {
+            num_rows.div_ceil(8)
+        } else {
+            num_rows * data_type.byte_width()
+        };
+        if self.values.len() < values_size {
+            return Err(Error::invalid_input(
+                format!(
+                    "Values buffer of {} bytes is too small for {} rows of {}",
+                    self.values.len(),
+                    num_rows,
+                    data_type
+                ),
+                location!(),
+            ));
+        }
+        if let Some(validity) = self.validity.as_ref() {
+            if validity.len() < num_rows.div_ceil(8) {
+                return Err(Error::invalid_input(
+                    format!(
+                        "Validity buffer of {} bytes is too small for {} rows",
+                        validity.len(),
+                        num_rows
+                    ),
+                    location!(),
+                ));
+            }
+        }
+        Ok(())
+    }
+}
+
 /// A trait for tasks that decode data into an Arrow array
 pub trait DecodeArrayTask: Send {
     /// Decodes the data into an Arrow array
     fn decode(self: Box<Self>) -> Result<ArrayRef>;
+    /// Decodes the data directly into caller-owned memory
+    ///
+    /// The data is written starting at row `dest_offset` of `dest`.  Returns the number of
+    /// rows written.
+    ///
+    /// Only fixed-width data can be decoded in this way.  The default implementation
+    /// returns [`Error::NotSupported`].
+    fn decode_into_dest(
+        self: Box<Self>,
+        _dest: &mut FixedWidthDestination,
+        _dest_offset: u64,
+    ) -> Result<u32> {
+        Err(Error::NotSupported {
+            source: "decoding into caller-provided buffers is only supported for fixed-width data"
+                .into(),
+            location: location!(),
+        })
+    }
 }
 
 /// A task to decode data into an Arrow array
@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
-use std::{collections::HashMap, sync::Arc};
+use std::{
+    collections::HashMap,
+    sync::{Arc, Mutex},
+};
 
-use arrow_array::{ArrayRef, RecordBatch};
+use arrow_array::{cast::AsArray, ArrayRef, RecordBatch};
 use arrow_buffer::Buffer;
 use arrow_schema::DataType;
 use bytes::{Bytes, BytesMut};
@@ -10,6 +13,7 @@ use futures::future::BoxFuture;
 use lance_core::datatypes::{Field, Schema};
 use lance_core::Result;
 
+use crate::encodings::physical::buffers::{CompressionCandidate, CompressionSelector};
 use crate::encodings::physical::value::{parse_compression_scheme, CompressionScheme};
 use crate::{
     decoder::{ColumnInfo, PageInfo},
@@ -225,6 +229,11 @@ fn get_compression_scheme() -> CompressionScheme {
     parse_compression_scheme(&compression_scheme).unwrap_or(CompressionScheme::None)
 }
 
+// LANCE_PAGE_COMPRESSION=adaptive picks the compression of each column by sampling its pages
+fn use_adaptive_compression() -> bool {
+    std::env::var("LANCE_PAGE_COMPRESSION").is_ok_and(|scheme| scheme == "adaptive")
+}
+
 impl CoreArrayEncodingStrategy {
     fn array_encoder_from_type(data_type: &DataType) -> Result<Box<dyn ArrayEncoder>> {
         match data_type {
@@ -247,6 +256,77 @@ impl ArrayEncodingStrategy for CoreArrayEncodingStrategy {
     }
 }
 
+/// Picks the compression of each page with a [`CompressionSelector`]
+///
+/// Only one in every `sample_page_interval` pages is trial compressed, the pages in between
+/// reuse the last choice.  A new strategy should be created for each column so that the
+/// choice is only reused within a column.
+#[derive(Debug)]
+pub struct AdaptiveArrayEncodingStrategy {
+    selector: CompressionSelector,
+    // The number of pages encoded so far and the last choice
+    state: Mutex<(u64, CompressionCandidate)>,
+}
+
+impl AdaptiveArrayEncodingStrategy {
+    pub fn new(selector: CompressionSelector) -> Self {
+        Self {
+            selector,
+            state: Mutex::new((0, CompressionCandidate::NONE)),
+        }
+    }
+
+    fn choose(&self, arrays: &[ArrayRef]) -> Result<CompressionCandidate> {
+        let mut state = self.state.lock().unwrap();
+        let (num_pages, candidate) = &mut *state;
+        if *num_pages % self.selector.sample_page_interval.max(1) == 0 {
+            *candidate = self.selector.choose(arrays)?;
+        }
+        *num_pages += 1;
+        Ok(*candidate)
+    }
+
+    fn array_encoder_from_type(
+        data_type: &DataType,
+        candidate: CompressionCandidate,
+    ) -> Result<Box<dyn ArrayEncoder>> {
+        match data_type {
+            DataType::FixedSizeList(inner, dimension) => {
+                Ok(Box::new(BasicEncoder::new(Box::new(FslEncoder::new(
+                    Self::array_encoder_from_type(inner.data_type(), candidate)?,
+                    *dimension as u32,
+                )))))
+            }
+            // Booleans are bit-packed and never compressed
+            DataType::Boolean => Ok(Box::new(BasicEncoder::new(Box::new(
+                ValueEncoder::try_new(data_type, CompressionScheme::None)?,
+            )))),
+            _ => Ok(Box::new(BasicEncoder::new(Box::new(
+                ValueEncoder::try_new_with_level(data_type, candidate.scheme, candidate.level)?,
+            )))),
+        }
+    }
+}
+
+impl ArrayEncodingStrategy for AdaptiveArrayEncodingStrategy {
+    fn create_array_encoder(&self, arrays: &[ArrayRef]) -> Result<Box<dyn ArrayEncoder>> {
+        // Fixed size lists are compressed as their flattened values
+        let mut values = arrays.to_vec();
+        while let DataType::FixedSizeList(..) = values[0].data_type() {
+            values = values
+                .iter()
+                .map(|arr| arr.as_fixed_size_list().values().clone())
+                .collect();
+        }
+        let candidate = if *values[0].data_type() == DataType::Boolean {
+            CompressionCandidate::NONE
+        } else {
+            self.choose(&values)?
+        };
+        Self::array_encoder_from_type(arrays[0].data_type(), candidate)
+    }
+}
+
 /// Keeps track of the current column index and makes a mapping
 /// from field id to column index
 #[derive(Default)]
@@ -346,12 +426,22 @@ impl FieldEncodingStrategy for CoreFieldEncodingStrategy {
             | DataType::UInt64
             | DataType::UInt8
             | DataType::FixedSizeBinary(_)
-            | DataType::FixedSizeList(_, _) => Ok(Box::new(PrimitiveFieldEncoder::try_new(
-                cache_bytes_per_column,
-                keep_original_array,
-                self.array_encoding_strategy.clone(),
-                column_index.next_column_index(field.id),
-            )?)),
+            | DataType::FixedSizeList(_, _) => {
+                let array_encoding_strategy: Arc<dyn ArrayEncodingStrategy> =
+                    if use_adaptive_compression() {
+                        Arc::new(AdaptiveArrayEncodingStrategy::new(
+                            CompressionSelector::default(),
+                        ))
+                    } else {
+                        self.array_encoding_strategy.clone()
+                    };
+                Ok(Box::new(PrimitiveFieldEncoder::try_new(
+                    cache_bytes_per_column,
+                    keep_original_array,
+                    array_encoding_strategy,
+                    column_index.next_column_index(field.id),
+                )?))
+            }
             DataType::List(child) => {
                 let list_idx = column_index.next_column_index(field.id);
                 let inner_encoding = encoding_strategy_root.create_field_encoder(
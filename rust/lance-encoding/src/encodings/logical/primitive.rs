@@ -16,7 +16,7 @@ use arrow_array::{
     },
     ArrayRef, BooleanArray, FixedSizeBinaryArray, FixedSizeListArray, PrimitiveArray,
 };
-use arrow_buffer::{BooleanBuffer, Buffer, NullBuffer, ScalarBuffer};
+use arrow_buffer::{bit_mask, bit_util, BooleanBuffer, Buffer, NullBuffer, ScalarBuffer};
 use arrow_schema::{DataType, IntervalUnit, TimeUnit};
 use bytes::BytesMut;
 use futures::{future::BoxFuture, FutureExt};
@@ -28,9 +28,9 @@ use lance_core::{Error, Result};
 
 use crate::{
     decoder::{
-        DecodeArrayTask, FieldScheduler, FilterExpression, LogicalPageDecoder, NextDecodeTask,
-        PageInfo, PageScheduler, PhysicalPageDecoder, ScheduledScanLine, SchedulerContext,
-        SchedulingJob,
+        DecodeArrayTask, FieldScheduler, FilterExpression, FixedWidthDestination,
+        LogicalPageDecoder, NextDecodeTask, PageInfo, PageScheduler, PhysicalPageDecoder,
+        ScheduledScanLine, SchedulerContext, SchedulingJob,
     },
     encoder::{ArrayEncodingStrategy, EncodeTask, EncodedColumn, EncodedPage, FieldEncoder},
     encodings::physical::{decoder_from_array_encoding, ColumnBuffers, PageBuffers},
@@ -273,9 +273,161 @@ impl DecodeArrayTask for PrimitiveFieldDecodeTask {
         // Convert the two buffers into an Arrow array
         Self::primitive_array_from_buffers(&self.data_type, bufs, self.rows_to_take)
     }
+
+    fn decode_into_dest(
+        self: Box<Self>,
+        dest: &mut FixedWidthDestination,
+        dest_offset: u64,
+    ) -> Result<u32> {
+        // Only "validity + values" layouts can be written into a single destination (e.g. not
+        // fixed size lists which have a validity buffer per layer)
+        if self.physical_decoder.num_buffers() != 2 {
+            return Err(Error::NotSupported {
+                source: format!(
+                    "decoding {} into caller-provided buffers is not supported",
+                    self.data_type
+                )
+                .into(),
+                location: location!(),
+            });
+        }
+        let num_rows = self.rows_to_take as usize;
+        if num_rows == 0 {
+            return Ok(0);
+        }
+        let dest_offset = dest_offset as usize;
+
+        let mut capacities = [(0, false); 2];
+        let mut all_null = false;
+        self.physical_decoder.update_capacity(
+            self.rows_to_skip,
+            self.rows_to_take,
+            &mut capacities,
+            &mut all_null,
+        );
+
+        if all_null {
+            let validity = dest.validity.as_deref_mut().ok_or_else(Self::nulls_error)?;
+            Self::dest_slice(validity, 0, (dest_offset + num_rows).div_ceil(8))?;
+            Self::fill_bits(validity, dest_offset, num_rows, false);
+            return Ok(self.rows_to_take);
+        }
+
+        // The validity is small (one bit per row) and has to be shifted to dest_offset
+        // anyways so it goes through a scratch buffer
+        let mut validity_buf = if capacities[0].1 {
+            vec![0; capacities[0].0 as usize]
+        } else {
+            Vec::new()
+        };
+        let values_size = capacities[1].0 as usize;
+        if self.data_type == DataType::Boolean {
+            // Bit-packed values are only byte aligned if dest_offset is a multiple of 8
+            if dest_offset % 8 == 0 {
+                let start = dest_offset / 8;
+                let values = Self::dest_slice(dest.values, start, values_size)?;
+                self.physical_decoder.decode_into_slices(
+                    self.rows_to_skip,
+                    self.rows_to_take,
+                    &mut [validity_buf.as_mut_slice(), values],
+                )?;
+            } else {
+                let mut values_buf = vec![0; values_size];
+                self.physical_decoder.decode_into_slices(
+                    self.rows_to_skip,
+                    self.rows_to_take,
+                    &mut [validity_buf.as_mut_slice(), values_buf.as_mut_slice()],
+                )?;
+                Self::dest_slice(dest.values, 0, (dest_offset + num_rows).div_ceil(8))?;
+                Self::copy_bits(dest.values, dest_offset, &values_buf, num_rows);
+            }
+        } else {
+            let bytes_per_value = values_size / num_rows;
+            let values = Self::dest_slice(dest.values, dest_offset * bytes_per_value, values_size)?;
+            self.physical_decoder.decode_into_slices(
+                self.rows_to_skip,
+                self.rows_to_take,
+                &mut [validity_buf.as_mut_slice(), values],
+            )?;
+        }
+
+        match dest.validity.as_deref_mut() {
+            Some(validity) => {
+                Self::dest_slice(validity, 0, (dest_offset + num_rows).div_ceil(8))?;
+                if validity_buf.is_empty() {
+                    Self::fill_bits(validity, dest_offset, num_rows, true);
+                } else {
+                    Self::copy_bits(validity, dest_offset, &validity_buf, num_rows);
+                }
+            }
+            None => {
+                if !validity_buf.is_empty()
+                    && BooleanBuffer::new(Buffer::from_vec(validity_buf), 0, num_rows)
+                        .count_set_bits()
+                        != num_rows
+                {
+                    return Err(Self::nulls_error());
+                }
+            }
+        }
+        Ok(self.rows_to_take)
+    }
 }
 
 impl PrimitiveFieldDecodeTask {
+    fn nulls_error() -> Error {
+        Error::invalid_input(
+            "the decoded data contains nulls but no validity destination was provided",
+            location!(),
+        )
+    }
+
+    // Grabs dest[start..start + len], failing if the caller's buffer is too small
+    fn dest_slice(dest: &mut [u8], start: usize, len: usize) -> Result<&mut [u8]> {
+        let dest_len = dest.len();
+        dest.get_mut(start..start + len).ok_or_else(|| {
+            Error::invalid_input(
+                format!(
+                    "destination buffer of {} bytes is too small, need at least {} bytes",
+                    dest_len,
+                    start + len
+                ),
+                location!(),
+            )
+        })
+    }
+
+    // Sets dest bits [dest_offset, dest_offset + num_bits) to value, the caller must have
+    // checked that dest is large enough
+    fn fill_bits(dest: &mut [u8], dest_offset: usize, num_bits: usize, value: bool) {
+        let end = dest_offset + num_bits;
+        let write_bit = |dest: &mut [u8], idx: usize| {
+            if value {
+                bit_util::set_bit(dest, idx);
+            } else {
+                bit_util::unset_bit(dest, idx);
+            }
+        };
+        // Leading bits up to the first byte boundary, then whole bytes, then trailing bits
+        let first_byte = dest_offset.div_ceil(8);
+        let last_byte = end / 8;
+        if first_byte >= last_byte {
+            (dest_offset..end).for_each(|idx| write_bit(dest, idx));
+            return;
+        }
+        (dest_offset..first_byte * 8).for_each(|idx| write_bit(dest, idx));
+        dest[first_byte..last_byte].fill(if value { 0xFF } else { 0 });
+        (last_byte * 8..end).for_each(|idx| write_bit(dest, idx));
+    }
+
+    // Copies the first num_bits bits of src to dest starting at dest_offset, the caller must
+    // have checked that dest is large enough
+    fn copy_bits(dest: &mut [u8], dest_offset: usize, src: &[u8], num_bits: usize) {
+        // set_bits only sets the unaligned bits, it never clears them
+        Self::fill_bits(dest, dest_offset, num_bits, false);
+        bit_mask::set_bits(dest, src, dest_offset, 0, num_bits);
+    }
+
     // TODO: Does this capability exist upstream somewhere?  I couldn't find
     // it from a simple scan but it seems the ability to convert two buffers
     // into a primitive array is pretty fundamental.
@@ -680,3 +832,37 @@ impl FieldEncoder for PrimitiveFieldEncoder {
         std::future::ready(Ok(vec![EncodedColumn::default()])).boxed()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use arrow_buffer::bit_util;
+
+    use super::PrimitiveFieldDecodeTask;
+
+    #[test]
+    fn test_fill_and_copy_bits() {
+        let src = [0b1011_0110u8, 0b0101_1101, 0b1110_0011, 0b0000_1111];
+        for dest_offset in [0, 3, 8, 13] {
+            for num_bits in [0, 1, 5, 8, 17, 32] {
+                for initial in [0u8, 0xFF] {
+                    let mut dest = vec![initial; 6];
+                    PrimitiveFieldDecodeTask::copy_bits(&mut dest, dest_offset, &src, num_bits);
+                    for idx in 0..dest.len() * 8 {
+                        let expected = if (dest_offset..dest_offset + num_bits).contains(&idx) {
+                            bit_util::get_bit(&src, idx - dest_offset)
+                        } else {
+                            initial != 0
+                        };
+                        assert_eq!(bit_util::get_bit(&dest, idx), expected);
+                    }
+
+                    let value = initial == 0;
+                    PrimitiveFieldDecodeTask::fill_bits(&mut dest, dest_offset, num_bits, value);
+                    for idx in dest_offset..dest_offset + num_bits {
+                        assert_eq!(bit_util::get_bit(&dest, idx), value);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -15,8 +15,8 @@ use snafu::{location, Location};
 
 use crate::{
     decoder::{
-        DecodeArrayTask, DecoderReady, FieldScheduler, FilterExpression, LogicalPageDecoder,
-        NextDecodeTask, ScheduledScanLine, SchedulerContext, SchedulingJob,
+        DecodeArrayTask, DecoderReady, FieldScheduler, FilterExpression, FixedWidthDestination,
+        LogicalPageDecoder, NextDecodeTask, ScheduledScanLine, SchedulerContext, SchedulingJob,
     },
     encoder::{EncodeTask, EncodedArray, EncodedColumn, EncodedPage, FieldEncoder},
     format::pb,
@@ -250,6 +250,15 @@ impl CompositeDecodeTask {
         // where the page size can be smaller.
         Ok(arrow_select::concat::concat(&array_refs)?)
     }
+
+    // Decodes each page's task into consecutive rows of the destination
+    fn decode_into_dest(self, dest: &mut FixedWidthDestination) -> Result<u32> {
+        let mut rows_written = 0;
+        for task in self.tasks {
+            rows_written += task.decode_into_dest(dest, rows_written as u64)?;
+        }
+        Ok(rows_written)
+    }
 }
 
 impl ChildState {
@@ -404,6 +413,44 @@ impl SimpleStructDecoder {
             has_more,
         })
     }
+
+    /// Checks that there is one destination per child, that each child can be decoded into
+    /// its destination, and that each destination has room for `num_rows` rows
+    ///
+    /// This does not change any state, so the rows can still be drained another way if it
+    /// fails.
+    pub fn check_destinations(&self, num_rows: u32, dest: &[FixedWidthDestination]) -> Result<()> {
+        if dest.len() != self.children.len() {
+            return Err(Error::invalid_input(
+                format!(
+                    "Attempt to decode {} fields into {} destinations",
+                    self.children.len(),
+                    dest.len()
+                ),
+                location!(),
+            ));
+        }
+        for (field, dest) in self.child_fields.iter().zip(dest) {
+            dest.check(field.data_type(), num_rows)?;
+        }
+        Ok(())
+    }
+
+    /// Drains `num_rows` rows, decoding each child directly into the corresponding
+    /// destination (see [`crate::decoder::BatchDecodeStream::next_batch_into`])
+    pub fn drain_into(&mut self, num_rows: u32, dest: &mut [FixedWidthDestination]) -> Result<u32> {
+        self.check_destinations(num_rows, dest)?;
+        let child_tasks = self
+            .children
+            .iter_mut()
+            .map(|child| child.drain(num_rows as u64))
+            .collect::<Result<Vec<_>>>()?;
+        let mut rows_written = num_rows;
+        for (child_task, child_dest) in child_tasks.into_iter().zip(dest.iter_mut()) {
+            rows_written = child_task.decode_into_dest(child_dest)?;
+        }
+        Ok(rows_written)
+    }
 }
 
 impl LogicalPageDecoder for SimpleStructDecoder {
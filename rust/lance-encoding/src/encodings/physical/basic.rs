@@ -214,6 +214,37 @@ impl PhysicalPageDecoder for BasicPageDecoder {
         Ok(())
     }
 
+    fn decode_into_slices(
+        &self,
+        rows_to_skip: u32,
+        num_rows: u32,
+        dest_buffers: &mut [&mut [u8]],
+    ) -> Result<()> {
+        match &self.mode {
+            DataNullStatus::Some(decoders) => {
+                decoders.validity.decode_into_slices(
+                    rows_to_skip,
+                    num_rows,
+                    &mut dest_buffers[..1],
+                )?;
+                decoders.values.decode_into_slices(
+                    rows_to_skip,
+                    num_rows,
+                    &mut dest_buffers[1..],
+                )?;
+            }
+            // As with decode_into, the validity slice is empty unless the caller needs it
+            DataNullStatus::All => {
+                dest_buffers[0].fill(0);
+            }
+            DataNullStatus::None(values) => {
+                dest_buffers[0].fill(0xFF);
+                values.decode_into_slices(rows_to_skip, num_rows, &mut dest_buffers[1..])?;
+            }
+        }
+        Ok(())
+    }
+
     fn num_buffers(&self) -> u32 {
         1 + self
             .mode
@@ -3,7 +3,7 @@
 
 use std::{ops::Range, sync::Arc};
 
-use arrow_buffer::BooleanBufferBuilder;
+use arrow_buffer::{bit_mask::set_bits, BooleanBufferBuilder};
 use bytes::{Bytes, BytesMut};
 
 use futures::{future::BoxFuture, FutureExt};
@@ -149,6 +149,45 @@ impl PhysicalPageDecoder for BitmapDecoder {
         Ok(())
     }
 
+    fn decode_into_slices(
+        &self,
+        rows_to_skip: u32,
+        num_rows: u32,
+        dest_buffers: &mut [&mut [u8]],
+    ) -> Result<()> {
+        let mut rows_to_skip = rows_to_skip;
+        let dest = &mut *dest_buffers[0];
+        // set_bits ORs into the destination so it must start zeroed
+        dest.fill(0);
+
+        // Unlike decode_into we can copy the bits straight from the read buffers
+        // into the destination without going through a builder
+        let mut rows_remaining = num_rows;
+        let mut dest_offset = 0;
+        for chunk in &self.chunks {
+            if rows_remaining == 0 {
+                break;
+            }
+            if chunk.length <= rows_to_skip {
+                rows_to_skip -= chunk.length;
+            } else {
+                let start = rows_to_skip + chunk.bit_offset;
+                let num_vals_to_take = rows_remaining.min(chunk.length - rows_to_skip);
+                set_bits(
+                    dest,
+                    &chunk.data,
+                    dest_offset,
+                    start as usize,
+                    num_vals_to_take as usize,
+                );
+                dest_offset += num_vals_to_take as usize;
+                rows_to_skip = 0;
+                rows_remaining -= num_vals_to_take;
+            }
+        }
+        Ok(())
+    }
+
     fn num_buffers(&self) -> u32 {
         1
     }
@@ -2,14 +2,17 @@
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
 use arrow_array::{cast::AsArray, ArrayRef};
+use snafu::{location, Location};
 use std::io::{Cursor, Write};
 
 use arrow_buffer::{BooleanBufferBuilder, Buffer};
 use arrow_schema::DataType;
-use lance_core::Result;
+use lance_core::{Error, Result};
 
 use crate::encoder::{BufferEncoder, EncodedBuffer};
 
+use super::value::CompressionScheme;
+
 #[derive(Debug, Default)]
 pub struct FlatBufferEncoder {}
 
@@ -29,11 +32,20 @@ pub trait BufferCompressor: std::fmt::Debug + Send + Sync {
 }
 
 #[derive(Debug, Default)]
-pub struct ZstdBufferCompressor {}
+pub struct ZstdBufferCompressor {
+    // 0 means "use zstd's default level"
+    compression_level: i32,
+}
+
+impl ZstdBufferCompressor {
+    pub fn new(compression_level: i32) -> Self {
+        Self { compression_level }
+    }
+}
 
 impl BufferCompressor for ZstdBufferCompressor {
     fn compress(&self, input_buf: &[u8], output_buf: &mut Vec<u8>) -> Result<()> {
-        let mut encoder = zstd::Encoder::new(output_buf, 0)?;
+        let mut encoder = zstd::Encoder::new(output_buf, self.compression_level)?;
         encoder.write_all(input_buf)?;
         match encoder.finish() {
             Ok(_) => Ok(()),
@@ -48,6 +60,31 @@ impl BufferCompressor for ZstdBufferCompressor {
     }
 }
 
+/// LZ4 block compression
+///
+/// This compresses worse than zstd but decompresses several times faster and so it
+/// is a good fit for data that is read often from fast storage.
+#[derive(Debug, Default)]
+pub struct Lz4BufferCompressor {}
+
+impl BufferCompressor for Lz4BufferCompressor {
+    fn compress(&self, input_buf: &[u8], output_buf: &mut Vec<u8>) -> Result<()> {
+        output_buf.extend_from_slice(&lz4_flex::block::compress_prepend_size(input_buf));
+        Ok(())
+    }
+
+    fn decompress(&self, input_buf: &[u8], output_buf: &mut Vec<u8>) -> Result<()> {
+        let decompressed = lz4_flex::block::decompress_size_prepended(input_buf).map_err(|e| {
+            Error::io(
+                format!("Failed to decompress lz4 buffer: {}", e),
+                location!(),
+            )
+        })?;
+        output_buf.extend_from_slice(&decompressed);
+        Ok(())
+    }
+}
+
 pub struct GeneralBufferCompressor {}
 
 impl GeneralBufferCompressor {
@@ -55,9 +92,27 @@ impl GeneralBufferCompressor {
         match compression_type {
             "" => Box::<ZstdBufferCompressor>::default(),
             "zstd" => Box::<ZstdBufferCompressor>::default(),
+            "lz4" => Box::<Lz4BufferCompressor>::default(),
             _ => panic!("Unsupported compression type: {}", compression_type),
         }
     }
+
+    /// Creates a compressor for the given scheme and level
+    ///
+    /// The level is ignored by schemes that don't have levels (e.g. lz4)
+    pub fn get_compressor_with_level(
+        compression_scheme: CompressionScheme,
+        compression_level: i32,
+    ) -> Result<Box<dyn BufferCompressor>> {
+        match compression_scheme {
+            CompressionScheme::Zstd => Ok(Box::new(ZstdBufferCompressor::new(compression_level))),
+            CompressionScheme::Lz4 => Ok(Box::<Lz4BufferCompressor>::default()),
+            CompressionScheme::None => Err(Error::invalid_input(
+                "Cannot create a compressor for the compression scheme none",
+                location!(),
+            )),
+        }
+    }
 }
 
 // An encoder which uses lightweight compression, such as zstd/lz4 to encode buffers
@@ -79,20 +134,175 @@ impl CompressedBufferEncoder {
         let compressor = GeneralBufferCompressor::get_compressor(compression_type);
         Self { compressor }
     }
+
+    pub fn with_compressor(compressor: Box<dyn BufferCompressor>) -> Self {
+        Self { compressor }
+    }
 }
 
 impl BufferEncoder for CompressedBufferEncoder {
     fn encode(&self, arrays: &[ArrayRef]) -> Result<EncodedBuffer> {
-        let mut parts = Vec::with_capacity(arrays.len());
-        for arr in arrays {
-            let buffer = arr.to_data().buffers()[0].clone();
-            let buffer_len = buffer.len();
-            let buffer_data = buffer.as_slice();
-            let mut compressed = Vec::with_capacity(buffer_len);
-            self.compressor.compress(buffer_data, &mut compressed)?;
-            parts.push(Buffer::from(compressed));
+        // All arrays are compressed as a single block.  Not every codec (e.g. lz4 blocks)
+        // can decompress several blocks that were written back to back.
+        let buffers = arrays
+            .iter()
+            .map(|arr| arr.to_data().buffers()[0].clone())
+            .collect::<Vec<_>>();
+        let total_len = buffers.iter().map(|buf| buf.len()).sum::<usize>();
+        let mut compressed = Vec::with_capacity(total_len);
+        if buffers.len() == 1 {
+            self.compressor
+                .compress(buffers[0].as_slice(), &mut compressed)?;
+        } else {
+            let mut uncompressed = Vec::with_capacity(total_len);
+            for buffer in &buffers {
+                uncompressed.extend_from_slice(buffer.as_slice());
+            }
+            self.compressor.compress(&uncompressed, &mut compressed)?;
+        }
+        Ok(EncodedBuffer {
+            parts: vec![Buffer::from(compressed)],
+        })
+    }
+}
+
+/// A compression setting that [`CompressionSelector`] may choose
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct CompressionCandidate {
+    pub scheme: CompressionScheme,
+    /// The compression level (ignored by schemes without levels)
+    pub level: i32,
+}
+
+impl CompressionCandidate {
+    pub const NONE: Self = Self {
+        scheme: CompressionScheme::None,
+        level: 0,
+    };
+
+    pub fn new(scheme: CompressionScheme, level: i32) -> Self {
+        Self { scheme, level }
+    }
+
+    /// The typical decompression throughput (in uncompressed bytes per second) of the scheme
+    ///
+    /// These are rough single core figures for common hardware.  They are constants (and not
+    /// measured) so that the same data is always written the same way.  The zstd decode speed
+    /// barely depends on the level.
+    pub fn decode_bytes_per_second(&self) -> f64 {
+        match self.scheme {
+            CompressionScheme::None => f64::INFINITY,
+            CompressionScheme::Lz4 => 4.0 * 1024.0 * 1024.0 * 1024.0,
+            CompressionScheme::Zstd => 1024.0 * 1024.0 * 1024.0,
         }
-        Ok(EncodedBuffer { parts })
+    }
+}
+
+/// Picks a compression scheme for a page by trying candidates on a sample of the page
+///
+/// Each candidate is scored by the estimated time it takes to load and decode the sample:
+/// the compressed size divided by `read_bytes_per_second` plus the uncompressed size divided
+/// by the candidate's [`CompressionCandidate::decode_bytes_per_second`].  The cheapest
+/// candidate wins.  The score only depends on the data so the choice is deterministic.  A low read bandwidth (e.g. object storage) favors
+/// smaller output while a high read bandwidth (e.g. local NVMe) favors fast decoders or no
+/// compression at all.  Incompressible data (e.g. embeddings) is left uncompressed since
+/// compression can only add decode time.
+#[derive(Debug, Clone)]
+pub struct CompressionSelector {
+    pub candidates: Vec<CompressionCandidate>,
+    /// The read bandwidth that the data is expected to be loaded with
+    pub read_bytes_per_second: f64,
+    /// The maximum number of bytes to sample from each page
+    pub sample_size: usize,
+    /// Only one in every `sample_page_interval` pages of a column is sampled, the pages in
+    /// between reuse the last choice (see [`crate::encoder::AdaptiveArrayEncodingStrategy`])
+    pub sample_page_interval: u64,
+}
+
+impl Default for CompressionSelector {
+    fn default() -> Self {
+        Self {
+            candidates: vec![
+                CompressionCandidate::NONE,
+                CompressionCandidate::new(CompressionScheme::Lz4, 0),
+                CompressionCandidate::new(CompressionScheme::Zstd, 1),
+                CompressionCandidate::new(CompressionScheme::Zstd, 3),
+            ],
+            read_bytes_per_second: 1024.0 * 1024.0 * 1024.0,
+            sample_size: 64 * 1024,
+            sample_page_interval: 8,
+        }
+    }
+}
+
+impl CompressionSelector {
+    // The sample is taken from this many evenly spaced chunks of the page
+    const NUM_SAMPLE_CHUNKS: usize = 8;
+
+    /// Chooses the best candidate for a page made up of `arrays`
+    pub fn choose(&self, arrays: &[ArrayRef]) -> Result<CompressionCandidate> {
+        let buffers = arrays
+            .iter()
+            .map(|arr| arr.to_data().buffers()[0].clone())
+            .collect::<Vec<_>>();
+        let sample = Self::sample(&buffers, self.sample_size);
+        if sample.is_empty() {
+            return Ok(CompressionCandidate::NONE);
+        }
+        let mut best = CompressionCandidate::NONE;
+        let mut best_cost = f64::INFINITY;
+        for candidate in &self.candidates {
+            let cost = self.estimate_cost(candidate, &sample)?;
+            if cost < best_cost {
+                best = *candidate;
+                best_cost = cost;
+            }
+        }
+        Ok(best)
+    }
+
+    fn estimate_cost(&self, candidate: &CompressionCandidate, sample: &[u8]) -> Result<f64> {
+        if candidate.scheme == CompressionScheme::None {
+            return Ok(sample.len() as f64 / self.read_bytes_per_second);
+        }
+        let compressor =
+            GeneralBufferCompressor::get_compressor_with_level(candidate.scheme, candidate.level)?;
+        let mut compressed = Vec::with_capacity(sample.len());
+        compressor.compress(sample, &mut compressed)?;
+        let decode_seconds = sample.len() as f64 / candidate.decode_bytes_per_second();
+        Ok(compressed.len() as f64 / self.read_bytes_per_second + decode_seconds)
+    }
+
+    // Copies up to `sample_size` bytes out of the buffers, taken from evenly spaced chunks
+    fn sample(buffers: &[Buffer], sample_size: usize) -> Vec<u8> {
+        let total_len = buffers.iter().map(|buf| buf.len()).sum::<usize>();
+        let mut sample = Vec::with_capacity(total_len.min(sample_size));
+        if total_len <= sample_size {
+            for buffer in buffers {
+                sample.extend_from_slice(buffer.as_slice());
+            }
+            return sample;
+        }
+        let chunk_size = (sample_size / Self::NUM_SAMPLE_CHUNKS).max(1);
+        let stride = total_len / Self::NUM_SAMPLE_CHUNKS;
+        for chunk_idx in 0..Self::NUM_SAMPLE_CHUNKS {
+            let mut start = chunk_idx * stride;
+            let mut remaining = chunk_size;
+            for buffer in buffers {
+                if remaining == 0 {
+                    break;
+                }
+                if start >= buffer.len() {
+                    start -= buffer.len();
+                    continue;
+                }
+                let end = (start + remaining).min(buffer.len());
+                sample.extend_from_slice(&buffer.as_slice()[start..end]);
+                remaining -= end - start;
+                start = 0;
+            }
+        }
+        sample
     }
 }
 
@@ -126,3 +336,70 @@ impl BufferEncoder for BitmapBufferEncoder {
         Ok(buffer)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use std::sync::Arc;
+
+    use arrow_array::{ArrayRef, Int64Array, UInt8Array};
+    use rand::RngCore;
+
+    use crate::encodings::physical::value::CompressionScheme;
+
+    use super::{CompressionCandidate, CompressionSelector, GeneralBufferCompressor};
+
+    #[test]
+    fn test_compressors_round_trip() {
+        let data = (0..10000_u32)
+            .flat_map(|i| (i % 17).to_le_bytes())
+            .collect::<Vec<_>>();
+        for (scheme, level) in [
+            (CompressionScheme::Lz4, 0),
+            (CompressionScheme::Zstd, 1),
+            (CompressionScheme::Zstd, 3),
+        ] {
+            let compressor =
+                GeneralBufferCompressor::get_compressor_with_level(scheme, level).unwrap();
+            let mut compressed = Vec::new();
+            compressor.compress(&data, &mut compressed).unwrap();
+            assert!(compressed.len() < data.len());
+            // Pages are decompressed by name since the level isn't recorded
+            let decompressor = GeneralBufferCompressor::get_compressor(&scheme.to_string());
+            let mut decompressed = Vec::new();
+            decompressor
+                .decompress(&compressed, &mut decompressed)
+                .unwrap();
+            assert_eq!(data, decompressed);
+        }
+    }
+
+    #[test]
+    fn test_selector() {
+        let compressible =
+            Arc::new(Int64Array::from_iter_values((0..100_000).map(|i| i / 1000))) as ArrayRef;
+        let mut random_bytes = vec![0; 100_000];
+        rand::thread_rng().fill_bytes(&mut random_bytes);
+        let incompressible = Arc::new(UInt8Array::from(random_bytes)) as ArrayRef;
+
+        // With slow reads the size dominates and compressible data gets compressed
+        let slow_reads = CompressionSelector {
+            read_bytes_per_second: 1024.0,
+            ..Default::default()
+        };
+        let chosen = slow_reads.choose(&[compressible.clone()]).unwrap();
+        assert_ne!(chosen, CompressionCandidate::NONE);
+        // Random data does not compress so it is not worth paying to decompress it
+        let chosen = slow_reads.choose(&[incompressible.clone()]).unwrap();
+        assert_eq!(chosen.scheme, CompressionScheme::None);
+
+        // With (infinitely) fast reads any decode time is too much
+        let fast_reads = CompressionSelector {
+            read_bytes_per_second: f64::INFINITY,
+            ..Default::default()
+        };
+        let chosen = fast_reads
+            .choose(&[compressible.clone(), compressible])
+            .unwrap();
+        assert_eq!(chosen, CompressionCandidate::NONE);
+    }
+}
@@ -99,6 +99,18 @@ impl PhysicalPageDecoder for FixedListDecoder {
         Ok(())
     }
 
+    fn decode_into_slices(
+        &self,
+        rows_to_skip: u32,
+        num_rows: u32,
+        dest_buffers: &mut [&mut [u8]],
+    ) -> Result<()> {
+        let rows_to_skip = rows_to_skip * self.dimension;
+        let num_rows = num_rows * self.dimension;
+        self.items_decoder
+            .decode_into_slices(rows_to_skip, num_rows, dest_buffers)
+    }
+
     fn num_buffers(&self) -> u32 {
         self.items_decoder.num_buffers()
     }
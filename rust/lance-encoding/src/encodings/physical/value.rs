@@ -29,12 +29,14 @@ use super::buffers::{
 pub enum CompressionScheme {
     None,
     Zstd,
+    Lz4,
 }
 
 impl fmt::Display for CompressionScheme {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
         let scheme_str = match self {
             Self::Zstd => "zstd",
+            Self::Lz4 => "lz4",
             Self::None => "none",
         };
         write!(f, "{}", scheme_str)
@@ -45,6 +47,7 @@ pub fn parse_compression_scheme(scheme: &str) -> Result<CompressionScheme> {
     match scheme {
         "none" => Ok(CompressionScheme::None),
         "zstd" => Ok(CompressionScheme::Zstd),
+        "lz4" => Ok(CompressionScheme::Lz4),
         _ => Err(Error::invalid_input(
             format!("Unknown compression scheme: {}", scheme),
             location!(),
@@ -117,6 +120,7 @@ impl PageScheduler for ValuePageScheduler {
         );
         let bytes = scheduler.submit_request(byte_ranges, top_level_row);
         let bytes_per_value = self.bytes_per_value;
+        let compression_scheme = self.compression_scheme;
 
         let range_offsets = if self.compression_scheme != CompressionScheme::None {
             ranges
@@ -136,6 +140,7 @@ impl PageScheduler for ValuePageScheduler {
 
             Ok(Box::new(ValuePageDecoder {
                 bytes_per_value,
+                compression_scheme,
                 data: bytes,
                 uncompressed_data: Arc::new(Mutex::new(None)),
                 uncompressed_range_offsets: range_offsets,
@@ -147,6 +152,7 @@ impl PageScheduler for ValuePageScheduler {
 
 struct ValuePageDecoder {
     bytes_per_value: u64,
+    compression_scheme: CompressionScheme,
     data: Vec<Bytes>,
     uncompressed_data: Arc<Mutex<Option<Vec<Bytes>>>>,
     uncompressed_range_offsets: Vec<std::ops::Range<usize>>,
@@ -156,7 +162,8 @@ impl ValuePageDecoder {
     fn decompress(&self) -> Result<Vec<Bytes>> {
         // for compressed page, it is guaranteed that only one range is passed
         let bytes_u8: Vec<u8> = self.data[0].to_vec();
-        let buffer_compressor = GeneralBufferCompressor::get_compressor("");
+        let buffer_compressor =
+            GeneralBufferCompressor::get_compressor(&self.compression_scheme.to_string());
         let mut uncompressed_bytes: Vec<u8> = Vec::new();
         buffer_compressor.decompress(&bytes_u8, &mut uncompressed_bytes)?;
 
@@ -201,6 +208,30 @@ impl ValuePageDecoder {
             *bytes_to_skip = 0;
         }
     }
+
+    // Same as decode_buffer but writes into a caller-owned slice at `dest_offset`
+    fn decode_buffer_into_slice(
+        &self,
+        buf: &Bytes,
+        bytes_to_skip: &mut u64,
+        bytes_to_take: &mut u64,
+        dest: &mut [u8],
+        dest_offset: &mut usize,
+    ) {
+        let buf_len = buf.len() as u64;
+        if *bytes_to_skip > buf_len {
+            *bytes_to_skip -= buf_len;
+        } else {
+            let bytes_to_take_here = (buf_len - *bytes_to_skip).min(*bytes_to_take);
+            *bytes_to_take -= bytes_to_take_here;
+            let start = *bytes_to_skip as usize;
+            let end = start + bytes_to_take_here as usize;
+            let dest_end = *dest_offset + bytes_to_take_here as usize;
+            dest[*dest_offset..dest_end].copy_from_slice(&buf[start..end]);
+            *dest_offset = dest_end;
+            *bytes_to_skip = 0;
+        }
+    }
 }
 
 impl PhysicalPageDecoder for ValuePageDecoder {
@@ -241,6 +272,45 @@ impl PhysicalPageDecoder for ValuePageDecoder {
         Ok(())
     }
 
+    fn decode_into_slices(
+        &self,
+        rows_to_skip: u32,
+        num_rows: u32,
+        dest_buffers: &mut [&mut [u8]],
+    ) -> Result<()> {
+        let mut bytes_to_skip = rows_to_skip as u64 * self.bytes_per_value;
+        let mut bytes_to_take = num_rows as u64 * self.bytes_per_value;
+        let mut dest_offset = 0;
+
+        let dest = &mut *dest_buffers[0];
+
+        debug_assert!(dest.len() as u64 >= bytes_to_take);
+
+        if self.is_compressed() {
+            let decoding_data = self.get_uncompressed_bytes()?;
+            for buf in decoding_data.lock().unwrap().as_ref().unwrap() {
+                self.decode_buffer_into_slice(
+                    buf,
+                    &mut bytes_to_skip,
+                    &mut bytes_to_take,
+                    dest,
+                    &mut dest_offset,
+                );
+            }
+        } else {
+            for buf in &self.data {
+                self.decode_buffer_into_slice(
+                    buf,
+                    &mut bytes_to_skip,
+                    &mut bytes_to_take,
+                    dest,
+                    &mut dest_offset,
+                );
+            }
+        }
+        Ok(())
+    }
+
     fn num_buffers(&self) -> u32 {
         1
     }
@@ -254,6 +324,18 @@ pub struct ValueEncoder {
 
 impl ValueEncoder {
     pub fn try_new(data_type: &DataType, compression_scheme: CompressionScheme) -> Result<Self> {
+        Self::try_new_with_level(data_type, compression_scheme, 0)
+    }
+
+    /// Creates an encoder that compresses with the given scheme and level
+    ///
+    /// The level is ignored by schemes without levels and is not recorded in the file since
+    /// decoding does not need it.
+    pub fn try_new_with_level(
+        data_type: &DataType,
+        compression_scheme: CompressionScheme,
+        compression_level: i32,
+    ) -> Result<Self> {
         if *data_type == DataType::Boolean {
             Ok(Self {
                 buffer_encoder: Box::<BitmapBufferEncoder>::default(),
@@ -262,7 +344,12 @@ impl ValueEncoder {
         } else if data_type.is_fixed_stride() {
             Ok(Self {
                 buffer_encoder: if compression_scheme != CompressionScheme::None {
-                    Box::<CompressedBufferEncoder>::default()
+                    Box::new(CompressedBufferEncoder::with_compressor(
+                        GeneralBufferCompressor::get_compressor_with_level(
+                            compression_scheme,
+                            compression_level,
+                        )?,
+                    ))
                 } else {
                     Box::<FlatBufferEncoder>::default()
                 },
@@ -320,9 +407,17 @@ impl ArrayEncoder for ValueEncoder {
 // public tests module because we share the PRIMITIVE_TYPES constant with fixed_size_list
 #[cfg(test)]
 pub(crate) mod tests {
+    use std::sync::Arc;
+
     use arrow_schema::{DataType, Field, TimeUnit};
 
-    use crate::testing::check_round_trip_encoding_random;
+    use crate::{
+        encoder::{AdaptiveArrayEncodingStrategy, FieldEncoder},
+        encodings::{
+            logical::primitive::PrimitiveFieldEncoder, physical::buffers::CompressionSelector,
+        },
+        testing::{check_round_trip_encoding_random, check_round_trip_field_encoding_random},
+    };
 
     const PRIMITIVE_TYPES: &[DataType] = &[
         DataType::FixedSizeBinary(2),
@@ -357,4 +452,26 @@ pub(crate) mod tests {
             check_round_trip_encoding_random(field).await;
         }
     }
+
+    #[test_log::test(tokio::test)]
+    async fn test_value_adaptive_compression() {
+        // A low read bandwidth favors compressing pages (e.g. all-null pages) while an
+        // unlimited bandwidth never compresses
+        for read_bytes_per_second in [1024.0, f64::INFINITY] {
+            let selector = CompressionSelector {
+                read_bytes_per_second,
+                ..Default::default()
+            };
+            for data_type in PRIMITIVE_TYPES {
+                let field = Field::new("", data_type.clone(), false);
+                let encoder_factory = || {
+                    // One strategy per column, like CoreFieldEncodingStrategy creates them
+                    let strategy = Arc::new(AdaptiveArrayEncodingStrategy::new(selector.clone()));
+                    Box::new(PrimitiveFieldEncoder::try_new(4096, true, strategy, 0).unwrap())
+                        as Box<dyn FieldEncoder>
+                };
+                check_round_trip_field_encoding_random(encoder_factory, field).await;
+            }
+        }
+    }
 }
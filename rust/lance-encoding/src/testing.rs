@@ -3,21 +3,23 @@
 
 use std::{collections::HashMap, ops::Range, sync::Arc};
 
-use arrow_array::{Array, UInt64Array};
+use arrow_array::{cast::AsArray, Array, ArrayRef, UInt64Array};
+use arrow_buffer::bit_util;
 use arrow_schema::{DataType, Field, Schema};
 use arrow_select::concat::concat;
 use bytes::{Bytes, BytesMut};
-use futures::{future::BoxFuture, FutureExt, StreamExt};
+use futures::{future::BoxFuture, FutureExt, StreamExt, TryStreamExt};
 use log::{debug, trace};
 use tokio::sync::mpsc::{self, UnboundedSender};
 
-use lance_core::Result;
+use lance_arrow::DataTypeExt;
+use lance_core::{Error, Result};
 use lance_datagen::{array, gen, RowCount, Seed};
 
 use crate::{
     decoder::{
-        BatchDecodeStream, ColumnInfo, DecodeBatchScheduler, DecoderMessage,
-        DecoderMiddlewareChain, FilterExpression, PageInfo,
+        BatchDecodeStream, ColumnInfo, DecodeBatchScheduler, DecodeParallelism, DecoderMessage,
+        DecoderMiddlewareChain, FilterExpression, FixedWidthDestination, PageInfo,
     },
     encoder::{
         ColumnIndexSequence, CoreFieldEncodingStrategy, EncodedBuffer, EncodedPage, FieldEncoder,
@@ -55,9 +57,11 @@ impl EncodingsIo for SimulatedScheduler {
     }
 }
 
+#[allow(clippy::too_many_arguments)]
 async fn test_decode(
     num_rows: u64,
     batch_size: u32,
+    parallelism: Option<DecodeParallelism>,
     schema: &Schema,
     column_infos: &[Arc<ColumnInfo>],
     expected: Option<Arc<dyn Array>>,
@@ -85,11 +89,20 @@ async fn test_decode(
 
     scheduler_fut.await;
 
-    let mut decode_stream = BatchDecodeStream::new(rx, batch_size, num_rows, decoder).into_stream();
+    let decode_stream = BatchDecodeStream::new(rx, batch_size, num_rows, decoder);
+    let mut decode_stream = if let Some(parallelism) = parallelism {
+        decode_stream.into_parallel_stream(parallelism)
+    } else {
+        decode_stream
+            .into_stream()
+            .map(|task| task.task)
+            .buffered(1)
+            .boxed()
+    };
 
     let mut offset = 0;
     while let Some(batch) = decode_stream.next().await {
-        let batch = batch.task.await.unwrap();
+        let batch = batch.unwrap();
         if let Some(expected) = expected.as_ref() {
             let actual = batch.column(0);
             let expected_size = (batch_size as usize).min(expected.len() - offset);
@@ -101,6 +114,136 @@ async fn test_decode(
     }
 }
 
+/// Schedules a full decode of all rows
+async fn full_decode_stream(
+    num_rows: u64,
+    batch_size: u32,
+    schema: &Schema,
+    column_infos: &[Arc<ColumnInfo>],
+    io: &Arc<dyn EncodingsIo>,
+) -> BatchDecodeStream {
+    let lance_schema = lance_core::datatypes::Schema::try_from(schema).unwrap();
+    let mut decode_scheduler = DecodeBatchScheduler::try_new(
+        &lance_schema,
+        column_infos,
+        &Vec::new(),
+        num_rows,
+        &DecoderMiddlewareChain::default(),
+        io,
+    )
+    .await
+    .unwrap();
+
+    let (tx, rx) = mpsc::unbounded_channel();
+    #[allow(clippy::single_range_in_vec_init)]
+    let root_decoder = decode_scheduler.new_root_decoder_ranges(&[0..num_rows]);
+    decode_scheduler.schedule_range(0..num_rows, &FilterExpression::no_filter(), tx, io.clone());
+    BatchDecodeStream::new(rx, batch_size, num_rows, root_decoder)
+}
+
+/// Decodes all rows into caller-owned buffers and compares them with `expected`
+async fn test_decode_into_buffers(
+    num_rows: u64,
+    batch_size: u32,
+    schema: &Schema,
+    column_infos: &[Arc<ColumnInfo>],
+    expected: &ArrayRef,
+    io: &Arc<dyn EncodingsIo>,
+) {
+    let mut decode_stream =
+        full_decode_stream(num_rows, batch_size, schema, column_infos, io).await;
+
+    let data_type = expected.data_type();
+    let is_boolean = *data_type == DataType::Boolean;
+    let bytes_per_value = if is_boolean {
+        0
+    } else {
+        data_type.byte_width()
+    };
+    let mut values = if is_boolean {
+        vec![0; (batch_size as usize).div_ceil(8)]
+    } else {
+        vec![0; batch_size as usize * bytes_per_value]
+    };
+    let mut validity = vec![0; (batch_size as usize).div_ceil(8)];
+
+    let mut offset = 0;
+    loop {
+        let mut dest = [FixedWidthDestination {
+            values: &mut values,
+            validity: Some(&mut validity),
+        }];
+        let rows_written = decode_stream.next_batch_into(&mut dest).await.unwrap() as usize;
+        if rows_written == 0 {
+            break;
+        }
+        let expected = expected.slice(offset, rows_written);
+        let expected_data = expected.to_data();
+        for row in 0..rows_written {
+            assert_eq!(expected.is_valid(row), bit_util::get_bit(&validity, row));
+            if expected.is_null(row) {
+                continue;
+            }
+            if is_boolean {
+                assert_eq!(
+                    expected.as_boolean().value(row),
+                    bit_util::get_bit(&values, row)
+                );
+            } else {
+                let expected_start = (expected_data.offset() + row) * bytes_per_value;
+                let expected_value = &expected_data.buffers()[0].as_slice()
+                    [expected_start..expected_start + bytes_per_value];
+                let actual_value = &values[row * bytes_per_value..(row + 1) * bytes_per_value];
+                assert_eq!(expected_value, actual_value);
+            }
+        }
+        offset += rows_written;
+    }
+    assert_eq!(offset as u64, num_rows);
+}
+
+/// Checks that a type which can't be decoded into caller-owned buffers is rejected without
+/// consuming any rows, so that every row can still be decoded into Arrow arrays
+async fn test_decode_into_rejected(
+    num_rows: u64,
+    batch_size: u32,
+    schema: &Schema,
+    column_infos: &[Arc<ColumnInfo>],
+    expected: Option<&ArrayRef>,
+    io: &Arc<dyn EncodingsIo>,
+) {
+    let mut decode_stream =
+        full_decode_stream(num_rows, batch_size, schema, column_infos, io).await;
+
+    let mut values = vec![0; batch_size as usize * 16];
+    let mut dest = [FixedWidthDestination {
+        values: &mut values,
+        validity: None,
+    }];
+    let err = decode_stream.next_batch_into(&mut dest).await.unwrap_err();
+    assert!(matches!(err, Error::NotSupported { .. }), "{:?}", err);
+
+    let batches = decode_stream
+        .into_stream()
+        .map(|task| task.task)
+        .buffered(1)
+        .try_collect::<Vec<_>>()
+        .await
+        .unwrap();
+    let num_decoded = batches
+        .iter()
+        .map(|batch| batch.num_rows() as u64)
+        .sum::<u64>();
+    assert_eq!(num_decoded, num_rows);
+    if let Some(expected) = expected.filter(|_| !batches.is_empty()) {
+        let arrays = batches
+            .iter()
+            .map(|batch| batch.column(0).as_ref())
+            .collect::<Vec<_>>();
+        assert_eq!(&concat(&arrays).unwrap(), expected);
+    }
+}
+
 /// Given a field this will test the round trip encoding and decoding of random data
 pub async fn check_round_trip_encoding_random(field: Field) {
     let lance_field = lance_core::datatypes::Field::try_from(&field).unwrap();
@@ -300,34 +443,67 @@ async fn check_round_trip_encoding_inner(
         Some(concat(&data.iter().map(|arr| arr.as_ref()).collect::<Vec<_>>()).unwrap())
     };
 
-    // We always try a full decode, regardless of the test cases provided
-    debug!("Testing full decode");
-    let scheduler_copy = scheduler.clone();
-    test_decode(
-        num_rows,
-        test_cases.batch_size,
-        &schema,
-        &column_infos,
-        concat_data.clone(),
-        &scheduler_copy.clone(),
-        |mut decode_scheduler, tx| {
-            #[allow(clippy::single_range_in_vec_init)]
-            let root_decoder = decode_scheduler.new_root_decoder_ranges(&[0..num_rows]);
-            (
-                root_decoder,
-                async move {
-                    decode_scheduler.schedule_range(
-                        0..num_rows,
-                        &FilterExpression::no_filter(),
-                        tx,
-                        scheduler_copy,
-                    )
-                }
-                .boxed(),
-            )
-        },
-    )
-    .await;
+    // We always try a full decode, regardless of the test cases provided.  The full
+    // decode is tested both serially and with the parallel decoder (using sub-tasks
+    // smaller than a batch so that batches are split and reassembled)
+    let parallel = DecodeParallelism {
+        max_in_flight: 4,
+        rows_per_task: test_cases.batch_size.div_ceil(3),
+    };
+    for parallelism in [None, Some(parallel)] {
+        debug!("Testing full decode (parallelism={:?})", parallelism);
+        let scheduler_copy = scheduler.clone();
+        test_decode(
+            num_rows,
+            test_cases.batch_size,
+            parallelism,
+            &schema,
+            &column_infos,
+            concat_data.clone(),
+            &scheduler_copy.clone(),
+            |mut decode_scheduler, tx| {
+                #[allow(clippy::single_range_in_vec_init)]
+                let root_decoder = decode_scheduler.new_root_decoder_ranges(&[0..num_rows]);
+                (
+                    root_decoder,
+                    async move {
+                        decode_scheduler.schedule_range(
+                            0..num_rows,
+                            &FilterExpression::no_filter(),
+                            tx,
+                            scheduler_copy,
+                        )
+                    }
+                    .boxed(),
+                )
+            },
+        )
+        .await;
+    }
+
+    if !FixedWidthDestination::supports(field.data_type()) {
+        debug!("Testing fallback after decode into caller-owned buffers is rejected");
+        test_decode_into_rejected(
+            num_rows,
+            test_cases.batch_size,
+            &schema,
+            &column_infos,
+            concat_data.as_ref(),
+            &scheduler,
+        )
+        .await;
+    } else if let Some(concat_data) = concat_data.as_ref() {
+        debug!("Testing full decode into caller-owned buffers");
+        test_decode_into_buffers(
+            num_rows,
+            test_cases.batch_size,
+            &schema,
+            &column_infos,
+            concat_data,
+            &scheduler,
+        )
+        .await;
+    }
 
     // Test range scheduling
     for range in &test_cases.ranges {
@@ -341,6 +517,7 @@ async fn check_round_trip_encoding_inner(
         test_decode(
             num_rows,
             test_cases.batch_size,
+            None,
             &schema,
             &column_infos,
             expected,
@@ -387,6 +564,7 @@ async fn check_round_trip_encoding_inner(
         test_decode(
             num_rows,
             test_cases.batch_size,
+            None,
             &schema,
             &column_infos,
             expected,
@@ -415,7 +593,7 @@ const NUM_RANDOM_ROWS: u32 = 10000;
 
 /// Generates random data (parameterized by null rate, slicing, and # ingest batches)
 /// and tests with that.
-async fn check_round_trip_field_encoding_random(
+pub(crate) async fn check_round_trip_field_encoding_random(
     encoder_factory: impl Fn() -> Box<dyn FieldEncoder>,
     field: Field,
 ) {
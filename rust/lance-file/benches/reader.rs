@@ -1,75 +1,176 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! File reader benchmarks over a range of realistic data shapes
+//!
+//! Every case reports throughput in bytes of (in-memory) Arrow data.  Set
+//! `LANCE_BENCH_THROUGHPUT=rows` to report rows per second instead.
 use std::sync::Arc;
 
-use arrow_schema::DataType;
-use criterion::{criterion_group, criterion_main, Criterion};
+use arrow_array::{RecordBatch, UInt32Array};
+use arrow_schema::{DataType, Field, Fields};
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
 use futures::StreamExt;
+use lance_datagen::{array, ArrayGenerator, ByteCount, RowCount};
 use lance_encoding::decoder::{DecoderMiddlewareChain, FilterExpression};
 use lance_file::v2::{
     reader::FileReader,
     writer::{FileWriter, FileWriterOptions},
 };
-use lance_io::{object_store::ObjectStore, scheduler::ScanScheduler};
+use lance_io::{object_store::ObjectStore, scheduler::ScanScheduler, ReadBatchParams};
+use object_store::path::Path;
+use rand::{seq::index::sample, SeedableRng};
+use tokio::runtime::Runtime;
 
-fn bench_reader(c: &mut Criterion) {
-    let mut group = c.benchmark_group("reader");
-    let data = lance_datagen::gen()
-        .anon_col(lance_datagen::array::rand_type(&DataType::Int32))
-        .into_batch_rows(lance_datagen::RowCount::from(1024 * 1024))
-        .unwrap();
-    let rt = tokio::runtime::Runtime::new().unwrap();
+const NUM_ROWS: u64 = 1024 * 1024;
+const BATCH_SIZE: u32 = 16 * 1024;
 
-    let tempdir = tempfile::tempdir().unwrap();
-    let test_path = tempdir.path();
-    let (object_store, base_path) =
-        ObjectStore::from_path(test_path.as_os_str().to_str().unwrap()).unwrap();
-    let file_path = base_path.child("foo.lance");
-    let object_writer = rt.block_on(object_store.create(&file_path)).unwrap();
+fn use_row_throughput() -> bool {
+    std::env::var("LANCE_BENCH_THROUGHPUT").is_ok_and(|val| val == "rows")
+}
+
+fn throughput(num_bytes: u64, num_rows: u64) -> Throughput {
+    if use_row_throughput() {
+        Throughput::Elements(num_rows)
+    } else {
+        Throughput::Bytes(num_bytes)
+    }
+}
 
+// (name, generator, number of rows, null rate)
+fn shapes() -> Vec<(&'static str, Box<dyn ArrayGenerator>, u64, f64)> {
+    let vector =
+        DataType::FixedSizeList(Arc::new(Field::new("item", DataType::Float32, true)), 128);
+    let int_list = DataType::List(Arc::new(Field::new("item", DataType::Int32, true)));
+    let flat_struct = DataType::Struct(Fields::from(vec![
+        Field::new("id", DataType::Int64, true),
+        Field::new("score", DataType::Float32, true),
+        Field::new("name", DataType::Utf8, true),
+    ]));
+    vec![
+        ("int32", array::rand_type(&DataType::Int32), NUM_ROWS, 0.0),
+        (
+            "float64_nullable",
+            array::rand_type(&DataType::Float64),
+            NUM_ROWS,
+            0.1,
+        ),
+        (
+            "utf8",
+            array::rand_utf8_var_length(ByteCount::from(16), ByteCount::from(64), false),
+            NUM_ROWS / 4,
+            0.0,
+        ),
+        ("vector", array::rand_type(&vector), NUM_ROWS / 64, 0.0),
+        ("list_int32", array::rand_type(&int_list), NUM_ROWS / 4, 0.0),
+        ("struct", array::rand_type(&flat_struct), NUM_ROWS / 4, 0.0),
+    ]
+}
+
+fn write_file(rt: &Runtime, object_store: &ObjectStore, path: &Path, data: &RecordBatch) {
+    let object_writer = rt.block_on(object_store.create(path)).unwrap();
     let mut writer = FileWriter::try_new(
         object_writer,
-        file_path.to_string(),
+        path.to_string(),
         data.schema().as_ref().try_into().unwrap(),
         FileWriterOptions::default(),
     )
     .unwrap();
-    rt.block_on(writer.write_batch(&data)).unwrap();
+    rt.block_on(writer.write_batch(data)).unwrap();
     rt.block_on(writer.finish()).unwrap();
-    group.throughput(criterion::Throughput::Bytes(
-        data.get_array_memory_size() as u64
-    ));
-    group.bench_function("decode", |b| {
-        b.iter(|| {
-            let object_store = &object_store;
-            let file_path = &file_path;
-            let data = &data;
-            rt.block_on(async move {
-                let store_scheduler = ScanScheduler::new(Arc::new(object_store.clone()), 8);
-                let scheduler = store_scheduler.open_file(file_path).await.unwrap();
-                let reader = FileReader::try_open(
-                    scheduler.clone(),
-                    None,
-                    DecoderMiddlewareChain::default(),
-                )
-                .await
-                .unwrap();
-                let mut stream = reader
-                    .read_stream(
-                        lance_io::ReadBatchParams::RangeFull,
-                        16 * 1024,
+}
+
+/// Reads `params` from the file and returns the number of rows read
+async fn read(
+    object_store: &ObjectStore,
+    path: &Path,
+    params: ReadBatchParams,
+    batch_readahead: u32,
+) -> usize {
+    let store_scheduler = ScanScheduler::new(Arc::new(object_store.clone()), 8);
+    let scheduler = store_scheduler.open_file(path).await.unwrap();
+    let reader = FileReader::try_open(scheduler.clone(), None, DecoderMiddlewareChain::default())
+        .await
+        .unwrap();
+    let mut stream = reader
+        .read_stream(
+            params,
+            BATCH_SIZE,
+            batch_readahead,
+            FilterExpression::no_filter(),
+        )
+        .unwrap();
+    let mut row_count = 0;
+    while let Some(batch) = stream.next().await {
+        row_count += batch.unwrap().num_rows();
+    }
+    row_count
+}
+
+fn bench_reader(c: &mut Criterion) {
+    let mut group = c.benchmark_group("reader");
+    let rt = Runtime::new().unwrap();
+
+    let tempdir = tempfile::tempdir().unwrap();
+    let test_path = tempdir.path();
+    let (object_store, base_path) =
+        ObjectStore::from_path(test_path.as_os_str().to_str().unwrap()).unwrap();
+    let mut rng = rand::rngs::StdRng::seed_from_u64(42);
+
+    for (name, gen, num_rows, null_rate) in shapes() {
+        let mut builder = lance_datagen::gen().anon_col(gen);
+        if null_rate > 0.0 {
+            builder.with_random_nulls(null_rate);
+        }
+        let data = builder.into_batch_rows(RowCount::from(num_rows)).unwrap();
+        let file_path = base_path.child(format!("{}.lance", name));
+        write_file(&rt, &object_store, &file_path, &data);
+        let data_bytes = data.get_array_memory_size() as u64;
+
+        // Full scans, the readahead controls how many batches decode concurrently
+        group.throughput(throughput(data_bytes, num_rows));
+        for batch_readahead in [1, 4, 16] {
+            group.bench_function(
+                format!("{}_scan_readahead_{}", name, batch_readahead),
+                |b| {
+                    b.iter(|| {
+                        let rows_read = rt.block_on(read(
+                            &object_store,
+                            &file_path,
+                            ReadBatchParams::RangeFull,
+                            batch_readahead,
+                        ));
+                        assert_eq!(data.num_rows(), rows_read);
+                    })
+                },
+            );
+        }
+
+        // Random access
+        for num_indices in [1, 100, 10000] {
+            let mut indices = sample(&mut rng, num_rows as usize, num_indices)
+                .into_iter()
+                .map(|idx| idx as u32)
+                .collect::<Vec<_>>();
+            indices.sort_unstable();
+            let indices = UInt32Array::from(indices);
+            group.throughput(throughput(
+                data_bytes / num_rows * num_indices as u64,
+                num_indices as u64,
+            ));
+            group.bench_function(format!("{}_take_{}", name, num_indices), |b| {
+                b.iter(|| {
+                    let rows_read = rt.block_on(read(
+                        &object_store,
+                        &file_path,
+                        ReadBatchParams::Indices(indices.clone()),
                         16,
-                        FilterExpression::no_filter(),
-                    )
-                    .unwrap();
-                let mut row_count = 0;
-                while let Some(batch) = stream.next().await {
-                    row_count += batch.unwrap().num_rows();
-                }
-                assert_eq!(data.num_rows(), row_count);
+                    ));
+                    assert_eq!(num_indices, rows_read);
+                })
             });
-        })
-    });
+        }
+    }
 }
 
 #[cfg(target_os = "linux")]
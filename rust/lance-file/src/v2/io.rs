@@ -1,9 +1,15 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
-use futures::{future::BoxFuture, FutureExt};
+use std::ops::Range;
+use std::sync::{Arc, Mutex};
+
+use bytes::Bytes;
+use futures::{channel::oneshot, future::BoxFuture, FutureExt};
+use lance_core::{error::CloneableError, Error, Result};
 use lance_encoding::EncodingsIo;
 use lance_io::scheduler::FileScheduler;
+use snafu::{location, Location};
 
 #[derive(Debug)]
 pub struct LanceEncodingsIo(pub FileScheduler);
@@ -17,3 +23,273 @@ impl EncodingsIo for LanceEncodingsIo {
         self.0.submit_request(range, priority).boxed()
     }
 }
+
+struct PendingRequest {
+    ranges: Vec<Range<u64>>,
+    priority: u64,
+    tx: oneshot::Sender<Result<Vec<Bytes>>>,
+}
+
+/// The requests held back since the last submission
+#[derive(Default)]
+struct PendingBatch {
+    requests: Vec<PendingRequest>,
+    num_bytes: u64,
+}
+
+impl PendingBatch {
+    /// Submits the requests as one request and routes each its share of the response
+    fn submit(self, inner: &dyn EncodingsIo) {
+        if self.requests.is_empty() {
+            return;
+        }
+        let pending = self.requests;
+        let priority = pending.iter().map(|req| req.priority).min().unwrap();
+        let ranges = pending
+            .iter()
+            .flat_map(|req| req.ranges.iter().cloned())
+            .collect::<Vec<_>>();
+        let response = inner.submit_request(ranges, priority);
+        tokio::task::spawn(async move {
+            match response.await {
+                Ok(bytes) => {
+                    let mut bytes = bytes.into_iter();
+                    for req in pending {
+                        let req_bytes = bytes.by_ref().take(req.ranges.len()).collect();
+                        // We don't care if the receiver has given up so discard the result
+                        let _ = req.tx.send(Ok(req_bytes));
+                    }
+                }
+                Err(err) => {
+                    // The first request gets the original error, the others a copy of it
+                    let err = CloneableError(err);
+                    let mut pending = pending.into_iter();
+                    let first = pending.next().unwrap();
+                    for req in pending {
+                        let _ = req.tx.send(Err(err.clone().0));
+                    }
+                    let _ = first.tx.send(Err(err.0));
+                }
+            }
+        });
+    }
+}
+
+/// The default number of bytes of pending requests that triggers a submission
+pub const DEFAULT_MAX_BATCH_BYTES: u64 = 32 * 1024 * 1024;
+/// The default number of pending requests that triggers a submission
+pub const DEFAULT_MAX_BATCH_REQUESTS: usize = 1024;
+
+/// Holds back the I/O requests made while a take is scheduled and submits them in batches
+///
+/// The page schedulers make one request per page, so on its own the I/O scheduler can only
+/// dedupe and coalesce the reads of rows that share a page.  Pending requests are submitted
+/// together, so that the reads of neighbouring pages (and columns) are coalesced as well,
+/// once they add up to `max_batch_bytes` or `max_batch_requests` and when [`Self::flush`]
+/// is called after every page touched by the take has been planned.  Bounding the batches
+/// keeps large takes from holding all of their data in memory before the first rows can be
+/// decoded.
+///
+/// Requests made after the flush, e.g. the second read of an indirect encoding such as a
+/// list, go straight to the inner scheduler.
+pub struct BatchedEncodingsIo {
+    inner: Arc<dyn EncodingsIo>,
+    pending: Mutex<Option<PendingBatch>>,
+    max_batch_bytes: u64,
+    max_batch_requests: usize,
+}
+
+impl BatchedEncodingsIo {
+    pub fn new(inner: Arc<dyn EncodingsIo>) -> Self {
+        Self::with_max_batch_size(inner, DEFAULT_MAX_BATCH_BYTES, DEFAULT_MAX_BATCH_REQUESTS)
+    }
+
+    pub fn with_max_batch_size(
+        inner: Arc<dyn EncodingsIo>,
+        max_batch_bytes: u64,
+        max_batch_requests: usize,
+    ) -> Self {
+        Self {
+            inner,
+            pending: Mutex::new(Some(PendingBatch::default())),
+            max_batch_bytes,
+            max_batch_requests,
+        }
+    }
+
+    /// Submit the requests that are still pending and stop holding back new requests
+    pub fn flush(&self) {
+        let pending = self.pending.lock().unwrap().take();
+        if let Some(pending) = pending {
+            pending.submit(self.inner.as_ref());
+        }
+    }
+}
+
+impl EncodingsIo for BatchedEncodingsIo {
+    fn submit_request(
+        &self,
+        ranges: Vec<Range<u64>>,
+        priority: u64,
+    ) -> BoxFuture<'static, Result<Vec<Bytes>>> {
+        let mut pending = self.pending.lock().unwrap();
+        let Some(batch) = pending.as_mut() else {
+            return self.inner.submit_request(ranges, priority);
+        };
+
+        let (tx, rx) = oneshot::channel();
+        batch.num_bytes += ranges
+            .iter()
+            .map(|range| range.end - range.start)
+            .sum::<u64>();
+        batch.requests.push(PendingRequest {
+            ranges,
+            priority,
+            tx,
+        });
+        if batch.num_bytes >= self.max_batch_bytes
+            || batch.requests.len() >= self.max_batch_requests
+        {
+            let full_batch = std::mem::take(batch);
+            drop(pending);
+            full_batch.submit(self.inner.as_ref());
+        }
+
+        rx.map(|res| {
+            res.unwrap_or_else(|_| {
+                Err(Error::Internal {
+                    message: "I/O request was dropped before it was submitted".into(),
+                    location: location!(),
+                })
+            })
+        })
+        .boxed()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use lance_encoding::BufferScheduler;
+
+    #[derive(Default)]
+    struct CountingIo {
+        requests: Mutex<Vec<(Vec<Range<u64>>, u64)>>,
+    }
+
+    impl EncodingsIo for CountingIo {
+        fn submit_request(
+            &self,
+            ranges: Vec<Range<u64>>,
+            priority: u64,
+        ) -> BoxFuture<'static, Result<Vec<Bytes>>> {
+            self.requests
+                .lock()
+                .unwrap()
+                .push((ranges.clone(), priority));
+            let data = BufferScheduler::new(Bytes::from_iter(0..=255_u8));
+            data.submit_request(ranges, priority)
+        }
+    }
+
+    #[tokio::test]
+    async fn test_batched_io() {
+        let counting = Arc::new(CountingIo::default());
+        let io = BatchedEncodingsIo::new(counting.clone());
+
+        // One request per page, as the page schedulers would make them
+        let first = io.submit_request(vec![0..4, 10..12], 7);
+        let second = io.submit_request(vec![4..8], 3);
+        assert!(counting.requests.lock().unwrap().is_empty());
+
+        io.flush();
+        {
+            let requests = counting.requests.lock().unwrap();
+            assert_eq!(requests.len(), 1);
+            assert_eq!(requests[0], (vec![0..4, 10..12, 4..8], 3));
+        }
+        assert_eq!(
+            first.await.unwrap(),
+            vec![
+                Bytes::from_static(&[0, 1, 2, 3]),
+                Bytes::from_static(&[10, 11])
+            ]
+        );
+        assert_eq!(
+            second.await.unwrap(),
+            vec![Bytes::from_static(&[4, 5, 6, 7])]
+        );
+
+        // Requests made after the flush are submitted right away
+        let third = io.submit_request(vec![20..21], 1);
+        assert_eq!(counting.requests.lock().unwrap().len(), 2);
+        assert_eq!(third.await.unwrap(), vec![Bytes::from_static(&[20])]);
+    }
+
+    #[tokio::test]
+    async fn test_batched_io_bounded() {
+        let counting = Arc::new(CountingIo::default());
+        let io = BatchedEncodingsIo::with_max_batch_size(counting.clone(), 8, 3);
+
+        // The batch is submitted as soon as it reaches 8 bytes
+        let first = io.submit_request(vec![0..4], 0);
+        let second = io.submit_request(vec![4..8], 0);
+        assert_eq!(counting.requests.lock().unwrap().len(), 1);
+        assert_eq!(
+            second.await.unwrap(),
+            vec![Bytes::from_static(&[4, 5, 6, 7])]
+        );
+        assert_eq!(
+            first.await.unwrap(),
+            vec![Bytes::from_static(&[0, 1, 2, 3])]
+        );
+
+        // ...or 3 requests
+        let small = (0..3)
+            .map(|idx| io.submit_request(vec![idx..idx + 1], 0))
+            .collect::<Vec<_>>();
+        assert_eq!(counting.requests.lock().unwrap().len(), 2);
+        for (idx, small) in small.into_iter().enumerate() {
+            assert_eq!(small.await.unwrap(), vec![Bytes::from(vec![idx as u8])]);
+        }
+
+        // The rest waits for the flush
+        let last = io.submit_request(vec![30..31], 0);
+        assert_eq!(counting.requests.lock().unwrap().len(), 2);
+        io.flush();
+        assert_eq!(counting.requests.lock().unwrap().len(), 3);
+        assert_eq!(last.await.unwrap(), vec![Bytes::from_static(&[30])]);
+    }
+
+    struct FailingIo;
+
+    impl EncodingsIo for FailingIo {
+        fn submit_request(
+            &self,
+            _ranges: Vec<Range<u64>>,
+            _priority: u64,
+        ) -> BoxFuture<'static, Result<Vec<Bytes>>> {
+            futures::future::ready(Err(Error::NotFound {
+                uri: "missing.lance".to_string(),
+                location: location!(),
+            }))
+            .boxed()
+        }
+    }
+
+    #[tokio::test]
+    async fn test_batched_io_error() {
+        let io = BatchedEncodingsIo::new(Arc::new(FailingIo));
+        let first = io.submit_request(vec![0..4], 0);
+        let second = io.submit_request(vec![4..8], 0);
+        io.flush();
+
+        // The original error is passed through
+        assert!(matches!(first.await, Err(Error::NotFound { .. })));
+        let Err(Error::Cloned { message, .. }) = second.await else {
+            panic!("expected a copy of the error");
+        };
+        assert!(message.contains("missing.lance"), "{}", message);
+    }
+}
@@ -37,7 +37,7 @@ use crate::{
     format::{pb, pbfile, MAGIC, MAJOR_VERSION, MINOR_VERSION_NEXT},
 };
 
-use super::io::LanceEncodingsIo;
+use super::io::{BatchedEncodingsIo, LanceEncodingsIo};
 
 // For now, we don't use global buffers for anything other than schema.  If we
 // use these later we should make them lazily loaded and then cached once loaded.
@@ -681,8 +681,17 @@ impl FileReader {
 
         let num_rows_to_read = indices.len() as u64;
 
+        // The reads of every page touched by the take are submitted together so that the
+        // I/O scheduler can coalesce reads across pages and not just within each page
+        let batched_io = Arc::new(BatchedEncodingsIo::new(scheduler));
         tokio::task::spawn(async move {
-            decode_scheduler.schedule_take(&indices, &FilterExpression::no_filter(), tx, scheduler)
+            decode_scheduler.schedule_take(
+                &indices,
+                &FilterExpression::no_filter(),
+                tx,
+                batched_io.clone(),
+            );
+            batched_io.flush();
         });
 
         Ok(BatchDecodeStream::new(rx, batch_size, num_rows_to_read, root_decoder).into_stream())
@@ -1005,7 +1014,7 @@ pub mod tests {
 
     use arrow_array::{
         types::{Float64Type, Int32Type},
-        RecordBatch,
+        RecordBatch, UInt32Array,
     };
     use arrow_schema::{DataType, Field, Fields, Schema as ArrowSchema};
     use bytes::Bytes;
@@ -1391,6 +1400,58 @@ pub mod tests {
         assert_eq!(batches[0].num_rows(), total_rows);
     }
 
+    #[tokio::test]
+    async fn test_take_across_pages() {
+        let fs = FsFixture::default();
+        let location_type = DataType::Struct(Fields::from(vec![
+            Field::new("x", DataType::Float64, true),
+            Field::new("y", DataType::Float64, true),
+        ]));
+        let categories_type = DataType::List(Arc::new(Field::new("item", DataType::Utf8, true)));
+        let reader = gen()
+            .col("score", array::rand::<Float64Type>())
+            .col("location", array::rand_type(&location_type))
+            .col("categories", array::rand_type(&categories_type))
+            .into_reader_rows(RowCount::from(1000), BatchCount::from(100));
+        // A small cache so that every column is split into many pages
+        let options = FileWriterOptions {
+            data_cache_bytes: Some(64 * 1024),
+            ..Default::default()
+        };
+        let (_, data) = write_lance_file(reader, &fs, options).await;
+        let data = arrow_select::concat::concat_batches(&data[0].schema(), &data).unwrap();
+
+        let file_scheduler = fs.scheduler.open_file(&fs.tmp_path).await.unwrap();
+        let file_reader = FileReader::try_open(
+            file_scheduler.clone(),
+            None,
+            DecoderMiddlewareChain::default(),
+        )
+        .await
+        .unwrap();
+
+        // Dense runs of rows within a page and sparse rows across pages, the reads of all
+        // pages are submitted together
+        let indices = (0..2000)
+            .chain((2000..100_000).step_by(997))
+            .collect::<Vec<u32>>();
+        let indices = UInt32Array::from(indices);
+        let batches = file_reader
+            .read_stream(
+                lance_io::ReadBatchParams::Indices(indices.clone()),
+                1024,
+                16,
+                FilterExpression::no_filter(),
+            )
+            .unwrap()
+            .try_collect::<Vec<_>>()
+            .await
+            .unwrap();
+        let actual = arrow_select::concat::concat_batches(&batches[0].schema(), &batches).unwrap();
+        let expected = arrow_select::take::take_record_batch(&data, &indices).unwrap();
+        assert_eq!(actual.columns(), expected.columns());
+    }
+
     #[tokio::test]
     async fn test_global_buffers() {
         let fs = FsFixture::default();
@@ -7,21 +7,33 @@ use std::collections::HashMap;
 use std::{any::Any, ops::Bound, sync::Arc};
 
 use arrow_array::{RecordBatch, UInt64Array};
-use arrow_schema::Schema;
+use arrow_schema::{DataType, Schema};
 use async_trait::async_trait;
+use datafusion::functions_array::expr_fn::{array_has_all, array_has_any};
 use datafusion::physical_plan::SendableRecordBatchStream;
 use datafusion_common::{scalar::ScalarValue, Column};
 
-use datafusion_expr::Expr;
+use datafusion_expr::{
+    expr::{BinaryExpr, Like},
+    Expr, Operator,
+};
 use deepsize::DeepSizeOf;
-use lance_core::Result;
+use lance_core::{utils::mask::RowIdTreeMap, Result};
 
 use crate::Index;
 
+use self::inverted::InvertedIndex;
+
+pub mod bitmap;
+pub mod bloom_filter;
 pub mod btree;
 pub mod expression;
 pub mod flat;
+pub mod inverted;
+pub mod label_list;
 pub mod lance_format;
+pub mod ngram;
+pub mod zonemap;
 
 /// Trait for storing an index (or parts of an index) into storage
 #[async_trait]
@@ -63,6 +75,67 @@ pub trait IndexStore: std::fmt::Debug + Send + Sync + DeepSizeOf {
     ///
     /// This is often useful when remapping or updating
     async fn copy_index_file(&self, name: &str, dest_store: &dyn IndexStore) -> Result<()>;
+
+    /// Look up a previously loaded page of a file in the store's page cache
+    ///
+    /// Stores without a page cache always return None
+    fn cached_page(&self, _name: &str, _page: u32) -> Option<Arc<dyn ScalarIndex>> {
+        None
+    }
+
+    /// Add a loaded page of a file to the store's page cache, if it has one
+    fn cache_page(&self, _name: &str, _page: u32, _page_index: Arc<dyn ScalarIndex>) {}
+}
+
+/// The kinds of scalar index
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum ScalarIndexType {
+    /// A btree over pages of sorted values, a good general purpose choice
+    #[default]
+    BTree,
+    /// A bitmap of row ids per distinct value, best for columns with few distinct values
+    Bitmap,
+    /// An inverted index over the tokens of a string column, for full text search
+    Inverted,
+    /// A map from the ngrams of a string column to row ids, for substring filters
+    NGram,
+    /// A bitmap of row ids per distinct list element, for array_has_any / array_has_all filters
+    LabelList,
+    /// The min / max of every zone of rows, for pruning columns clustered by insertion order
+    ZoneMap,
+}
+
+impl ScalarIndexType {
+    /// The name recorded in the index metadata
+    pub fn name(&self) -> &'static str {
+        match self {
+            Self::BTree => "btree",
+            Self::Bitmap => "bitmap",
+            Self::Inverted => "inverted",
+            Self::NGram => "ngram",
+            Self::LabelList => "label_list",
+            Self::ZoneMap => "zonemap",
+        }
+    }
+
+    /// Parses a name returned by [`Self::name`]
+    pub fn from_name(name: &str) -> Option<Self> {
+        [
+            Self::BTree,
+            Self::Bitmap,
+            Self::Inverted,
+            Self::NGram,
+            Self::LabelList,
+            Self::ZoneMap,
+        ]
+        .into_iter()
+        .find(|index_type| index_type.name() == name)
+    }
+
+    /// True if the index can exactly answer comparison, IN and IS NULL queries
+    pub fn supports_exact_queries(&self) -> bool {
+        matches!(self, Self::BTree | Self::Bitmap)
+    }
 }
 
 /// A query that a scalar index can satisfy
@@ -84,6 +157,64 @@ pub enum ScalarQuery {
     Equals(ScalarValue),
     /// Retrieve all row ids where the value is null
     IsNull(),
+    /// Retrieve the row ids of the documents that match a full text query
+    ///
+    /// Only inverted indices can answer this query
+    FullTextSearch(FullTextSearchQuery),
+    /// Retrieve the row ids of all values that might contain every one of the given substrings
+    ///
+    /// The result is a set of candidates and may include values that do not contain the
+    /// substrings so it must always be followed by a refine step.  Matching is case
+    /// insensitive.  Only ngram indices can answer this query.
+    ContainsCandidates(Vec<String>),
+    /// Retrieve the row ids of all lists that contain at least one of the given values
+    ///
+    /// Only label list indices can answer this query
+    HasAnyLabel(Vec<ScalarValue>),
+    /// Retrieve the row ids of all lists that contain every one of the given values
+    ///
+    /// Only label list indices can answer this query
+    HasAllLabels(Vec<ScalarValue>),
+}
+
+/// A full text search against an inverted index
+#[derive(Debug, Clone, PartialEq)]
+pub struct FullTextSearchQuery {
+    /// The text to search for, this is tokenized the same way as the indexed documents
+    pub query: String,
+    /// If Some, only the `limit` best (by BM25 score) documents are returned.  Otherwise
+    /// every document that contains at least one of the query tokens is returned.
+    pub limit: Option<usize>,
+}
+
+impl FullTextSearchQuery {
+    pub fn new(query: impl Into<String>) -> Self {
+        Self {
+            query: query.into(),
+            limit: None,
+        }
+    }
+
+    pub fn limit(mut self, limit: usize) -> Self {
+        self.limit = Some(limit);
+        self
+    }
+}
+
+fn labels_literal(labels: &[ScalarValue]) -> Expr {
+    let data_type = labels
+        .first()
+        .map(|label| label.data_type())
+        .unwrap_or(DataType::Null);
+    Expr::Literal(ScalarValue::List(ScalarValue::new_list(labels, &data_type)))
+}
+
+fn fmt_labels(labels: &[ScalarValue]) -> String {
+    labels
+        .iter()
+        .map(|label| label.to_string())
+        .collect::<Vec<_>>()
+        .join(",")
 }
 
 impl ScalarQuery {
@@ -127,6 +258,50 @@ impl ScalarQuery {
             ),
             Self::IsNull() => col_expr.is_null(),
             Self::Equals(value) => col_expr.eq(Expr::Literal(value.clone())),
+            // Every row that contains one of the query tokens as a whole token matches.  This
+            // is exactly what the index returns without a limit.  Ranking is not expressible
+            // as a filter so with a limit this is a superset of the index results, which is
+            // why the scanner's hybrid prefilter never sets one.
+            Self::FullTextSearch(query) => {
+                let tokens = InvertedIndex::query_tokens(&query.query);
+                if tokens.is_empty() {
+                    Expr::Literal(ScalarValue::Boolean(Some(false)))
+                } else {
+                    // Tokens are runs of alphanumeric characters so they need no escaping and
+                    // the case insensitive match mirrors the lowercasing tokenizer
+                    let pattern = format!(
+                        r"(^|[^\p{{Alphabetic}}\p{{N}}])({})([^\p{{Alphabetic}}\p{{N}}]|$)",
+                        tokens.join("|")
+                    );
+                    Expr::BinaryExpr(BinaryExpr::new(
+                        Box::new(col_expr),
+                        Operator::RegexIMatch,
+                        Box::new(Expr::Literal(ScalarValue::Utf8(Some(pattern)))),
+                    ))
+                }
+            }
+            Self::ContainsCandidates(substrings) => substrings
+                .iter()
+                .map(|substring| {
+                    let escaped = substring
+                        .replace('\\', "\\\\")
+                        .replace('%', "\\%")
+                        .replace('_', "\\_");
+                    Expr::Like(Like::new(
+                        false,
+                        Box::new(col_expr.clone()),
+                        Box::new(Expr::Literal(ScalarValue::Utf8(Some(format!(
+                            "%{}%",
+                            escaped
+                        ))))),
+                        Some('\\'),
+                        true,
+                    ))
+                })
+                .reduce(Expr::and)
+                .unwrap_or(Expr::Literal(ScalarValue::Boolean(Some(true)))),
+            Self::HasAnyLabel(labels) => array_has_any(col_expr, labels_literal(labels)),
+            Self::HasAllLabels(labels) => array_has_all(col_expr, labels_literal(labels)),
         }
     }
 
@@ -168,6 +343,15 @@ impl ScalarQuery {
             Self::Equals(val) => {
                 format!("{} = {}", col, val)
             }
+            Self::HasAnyLabel(labels) => format!("{} HAS ANY [{}]", col, fmt_labels(labels)),
+            Self::HasAllLabels(labels) => format!("{} HAS ALL [{}]", col, fmt_labels(labels)),
+            Self::ContainsCandidates(substrings) => {
+                format!("{} CONTAINS [{}]", col, substrings.join(","))
+            }
+            Self::FullTextSearch(query) => match query.limit {
+                Some(limit) => format!("{} MATCH '{}' LIMIT {}", col, query.query, limit),
+                None => format!("{} MATCH '{}'", col, query.query),
+            },
         }
     }
 }
@@ -180,6 +364,15 @@ pub trait ScalarIndex: Send + Sync + std::fmt::Debug + Index + DeepSizeOf {
     /// Returns all row ids that satisfy the query, these row ids are not neccesarily ordered
     async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array>;
 
+    /// Search the scalar index, returning the matching row ids as a set
+    ///
+    /// Indices that already store sets of row ids (e.g. bitmap indices) should override this
+    /// so that results can be combined without materializing a list of row ids first.
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        let row_ids = self.search(query).await?;
+        Ok(RowIdTreeMap::from_iter(row_ids.values().iter()))
+    }
+
     /// Load the scalar index from storage
     async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>>
     where
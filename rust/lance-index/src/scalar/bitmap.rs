@@ -0,0 +1,406 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+use std::{
+    any::Any,
+    collections::{BTreeMap, HashMap},
+    ops::Bound,
+    sync::Arc,
+};
+
+use arrow_array::{
+    builder::BinaryBuilder, cast::AsArray, new_empty_array, types::UInt64Type, Array, RecordBatch,
+    UInt64Array,
+};
+use arrow_schema::{DataType, Field, Schema};
+use async_trait::async_trait;
+use datafusion::physical_plan::SendableRecordBatchStream;
+use datafusion_common::ScalarValue;
+use deepsize::DeepSizeOf;
+use futures::TryStreamExt;
+use lance_core::{utils::mask::RowIdTreeMap, Error, Result};
+use roaring::RoaringBitmap;
+use serde::Serialize;
+use snafu::{location, Location};
+
+use crate::{Index, IndexType};
+
+use super::{
+    btree::{wrap_bound, OrderableScalarValue},
+    IndexStore, ScalarIndex, ScalarQuery,
+};
+
+pub const BITMAP_LOOKUP_NAME: &str = "bitmap_page_lookup.lance";
+
+/// A scalar index that stores a bitmap of row ids for each distinct value
+///
+/// This is a good fit for columns with a small number of distinct values (e.g. a status,
+/// country, or tenant column).  The entire index is kept in memory and every query is
+/// answered by combining bitmaps, so there is no need to read or materialize lists of row
+/// ids and the results can be AND'd / OR'd with other index results cheaply.
+///
+/// The index is stored as a single batch with one row per distinct value.  The first
+/// column "keys" has the values (a null key holds the row ids of null values) and the
+/// second column "bitmaps" has the serialized [`RowIdTreeMap`] for each value.
+#[derive(Clone, Debug)]
+pub struct BitmapIndex {
+    index_map: BTreeMap<OrderableScalarValue, RowIdTreeMap>,
+    null_map: RowIdTreeMap,
+    value_type: DataType,
+    // The serialized size of the bitmaps, a good estimate of their size in memory
+    bitmaps_size_bytes: usize,
+    // The name of the file the bitmaps are stored in, other indices (e.g. the label list
+    // index) store a bitmap index under their own name
+    lookup_name: &'static str,
+    store: Arc<dyn IndexStore>,
+}
+
+impl DeepSizeOf for BitmapIndex {
+    fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
+        self.index_map
+            .keys()
+            .map(|key| key.deep_size_of_children(context))
+            .sum::<usize>()
+            + self.bitmaps_size_bytes
+            + self.store.deep_size_of_children(context)
+    }
+}
+
+impl BitmapIndex {
+    fn new(
+        index_map: BTreeMap<OrderableScalarValue, RowIdTreeMap>,
+        null_map: RowIdTreeMap,
+        value_type: DataType,
+        lookup_name: &'static str,
+        store: Arc<dyn IndexStore>,
+    ) -> Self {
+        let bitmaps_size_bytes = index_map
+            .values()
+            .chain(std::iter::once(&null_map))
+            .map(|bitmap| bitmap.serialized_size())
+            .sum();
+        Self {
+            index_map,
+            null_map,
+            value_type,
+            bitmaps_size_bytes,
+            lookup_name,
+            store,
+        }
+    }
+
+    fn try_from_serialized(
+        data: RecordBatch,
+        lookup_name: &'static str,
+        store: Arc<dyn IndexStore>,
+    ) -> Result<Self> {
+        let keys = data.column(0);
+        let bitmaps = data
+            .column(1)
+            .as_binary_opt::<i32>()
+            .ok_or_else(|| Error::Internal {
+                message: "bitmap index was not serialized with a binary bitmaps column".into(),
+                location: location!(),
+            })?;
+
+        let mut index_map = BTreeMap::new();
+        let mut null_map = RowIdTreeMap::default();
+        for idx in 0..data.num_rows() {
+            let bitmap = RowIdTreeMap::deserialize_from(bitmaps.value(idx))?;
+            if keys.is_null(idx) {
+                null_map = bitmap;
+            } else {
+                let key = OrderableScalarValue(ScalarValue::try_from_array(keys, idx)?);
+                index_map.insert(key, bitmap);
+            }
+        }
+
+        Ok(Self::new(
+            index_map,
+            null_map,
+            keys.data_type().clone(),
+            lookup_name,
+            store,
+        ))
+    }
+
+    /// Loads a bitmap index that was written to the file `lookup_name`
+    pub(crate) async fn load_from(
+        store: Arc<dyn IndexStore>,
+        lookup_name: &'static str,
+    ) -> Result<Arc<Self>> {
+        let lookup_file = store.open_index_file(lookup_name).await?;
+        let serialized = lookup_file.read_record_batch(0).await?;
+        Ok(Arc::new(Self::try_from_serialized(
+            serialized,
+            lookup_name,
+            store,
+        )?))
+    }
+
+    fn bitmap_for_value(&self, value: &ScalarValue) -> Option<&RowIdTreeMap> {
+        if value.is_null() {
+            Some(&self.null_map)
+        } else {
+            self.index_map.get(&OrderableScalarValue(value.clone()))
+        }
+    }
+
+    fn union<'a>(bitmaps: impl Iterator<Item = &'a RowIdTreeMap>) -> RowIdTreeMap {
+        let mut result = RowIdTreeMap::default();
+        for bitmap in bitmaps {
+            result |= bitmap;
+        }
+        result
+    }
+
+    fn into_builder(self) -> BitmapIndexBuilder {
+        BitmapIndexBuilder {
+            index_map: self.index_map,
+            null_map: self.null_map,
+            value_type: self.value_type,
+            lookup_name: self.lookup_name,
+        }
+    }
+}
+
+// BTreeMap::range panics on ranges like (5, 3) or (5, 5) so we need to check for them first
+fn is_empty_range(range: &(Bound<OrderableScalarValue>, Bound<OrderableScalarValue>)) -> bool {
+    match range {
+        (Bound::Included(start), Bound::Included(end)) => start > end,
+        (Bound::Included(start), Bound::Excluded(end))
+        | (Bound::Excluded(start), Bound::Included(end))
+        | (Bound::Excluded(start), Bound::Excluded(end)) => start >= end,
+        _ => false,
+    }
+}
+
+fn row_ids_to_array(row_ids: &RowIdTreeMap) -> Result<UInt64Array> {
+    let row_ids = row_ids.row_ids().ok_or_else(|| Error::Internal {
+        message: "bitmap index unexpectedly contained an entire fragment".into(),
+        location: location!(),
+    })?;
+    Ok(UInt64Array::from_iter_values(row_ids.map(u64::from)))
+}
+
+#[derive(Serialize)]
+struct BitmapStatistics {
+    num_bitmaps: usize,
+}
+
+#[async_trait]
+impl Index for BitmapIndex {
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn as_index(self: Arc<Self>) -> Arc<dyn Index> {
+        self
+    }
+
+    fn index_type(&self) -> IndexType {
+        IndexType::Scalar
+    }
+
+    fn statistics(&self) -> Result<serde_json::Value> {
+        serde_json::to_value(&BitmapStatistics {
+            num_bitmaps: self.index_map.len() + usize::from(!self.null_map.is_empty()),
+        })
+        .map_err(|err| err.into())
+    }
+
+    async fn calculate_included_frags(&self) -> Result<RoaringBitmap> {
+        let mut frag_ids = RoaringBitmap::default();
+        for bitmap in self
+            .index_map
+            .values()
+            .chain(std::iter::once(&self.null_map))
+        {
+            let row_ids = row_ids_to_array(bitmap)?;
+            frag_ids.extend(row_ids.values().iter().map(|row_id| (row_id >> 32) as u32));
+        }
+        Ok(frag_ids)
+    }
+}
+
+#[async_trait]
+impl ScalarIndex for BitmapIndex {
+    async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
+        row_ids_to_array(&self.search_row_ids(query).await?)
+    }
+
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        Ok(match query {
+            ScalarQuery::Equals(value) => self.bitmap_for_value(value).cloned().unwrap_or_default(),
+            ScalarQuery::IsIn(values) => Self::union(
+                values
+                    .iter()
+                    .filter_map(|value| self.bitmap_for_value(value)),
+            ),
+            ScalarQuery::IsNull() => self.null_map.clone(),
+            ScalarQuery::Range(start, end) => {
+                let range = (wrap_bound(start), wrap_bound(end));
+                if is_empty_range(&range) {
+                    RowIdTreeMap::default()
+                } else {
+                    Self::union(self.index_map.range(range).map(|(_, bitmap)| bitmap))
+                }
+            }
+            ScalarQuery::FullTextSearch(_)
+            | ScalarQuery::ContainsCandidates(_)
+            | ScalarQuery::HasAnyLabel(_)
+            | ScalarQuery::HasAllLabels(_) => {
+                return Err(Error::NotSupported {
+                    source: "a bitmap index can only answer comparison, IN and IS NULL queries"
+                        .into(),
+                    location: location!(),
+                })
+            }
+        })
+    }
+
+    async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>> {
+        Self::load_from(store, BITMAP_LOOKUP_NAME).await
+    }
+
+    async fn remap(
+        &self,
+        mapping: &HashMap<u64, Option<u64>>,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let remap_bitmap = |bitmap: &RowIdTreeMap| -> Result<RowIdTreeMap> {
+            let row_ids = row_ids_to_array(bitmap)?;
+            Ok(RowIdTreeMap::from_iter(row_ids.values().iter().filter_map(
+                |row_id| mapping.get(row_id).copied().unwrap_or(Some(*row_id)),
+            )))
+        };
+        let mut index_map = BTreeMap::new();
+        for (key, bitmap) in &self.index_map {
+            let remapped = remap_bitmap(bitmap)?;
+            if !remapped.is_empty() {
+                index_map.insert(key.clone(), remapped);
+            }
+        }
+        let builder = BitmapIndexBuilder {
+            index_map,
+            null_map: remap_bitmap(&self.null_map)?,
+            value_type: self.value_type.clone(),
+            lookup_name: self.lookup_name,
+        };
+        builder.write(dest_store).await
+    }
+
+    async fn update(
+        &self,
+        new_data: SendableRecordBatchStream,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let mut builder = self.clone().into_builder();
+        builder.add_stream(new_data).await?;
+        builder.write(dest_store).await
+    }
+}
+
+/// Accumulates the bitmaps of a bitmap index in memory before writing them out
+struct BitmapIndexBuilder {
+    index_map: BTreeMap<OrderableScalarValue, RowIdTreeMap>,
+    null_map: RowIdTreeMap,
+    value_type: DataType,
+    lookup_name: &'static str,
+}
+
+impl BitmapIndexBuilder {
+    fn new(value_type: DataType, lookup_name: &'static str) -> Self {
+        Self {
+            index_map: BTreeMap::new(),
+            null_map: RowIdTreeMap::default(),
+            value_type,
+            lookup_name,
+        }
+    }
+
+    fn add_batch(&mut self, batch: &RecordBatch) -> Result<()> {
+        debug_assert_eq!(batch.num_columns(), 2);
+        debug_assert_eq!(*batch.column(1).data_type(), DataType::UInt64);
+        // Sorting the batch turns each distinct value into a single run of rows so we only
+        // need to convert one value per run into a ScalarValue
+        let sort_indices = arrow_ord::sort::sort_to_indices(batch.column(0), None, None)?;
+        let values = arrow_select::take::take(batch.column(0), &sort_indices, None)?;
+        let row_ids = arrow_select::take::take(batch.column(1), &sort_indices, None)?;
+        let row_ids = row_ids.as_primitive::<UInt64Type>().values();
+        for range in arrow_ord::partition::partition(&[values.clone()])?.ranges() {
+            let run_row_ids = &row_ids[range.clone()];
+            if values.is_null(range.start) {
+                self.null_map.extend(run_row_ids);
+            } else {
+                let key = OrderableScalarValue(ScalarValue::try_from_array(&values, range.start)?);
+                self.index_map.entry(key).or_default().extend(run_row_ids);
+            }
+        }
+        Ok(())
+    }
+
+    async fn add_stream(&mut self, mut data: SendableRecordBatchStream) -> Result<()> {
+        while let Some(batch) = data.try_next().await? {
+            self.add_batch(&batch)?;
+        }
+        Ok(())
+    }
+
+    async fn write(self, index_store: &dyn IndexStore) -> Result<()> {
+        let mut keys = Vec::with_capacity(self.index_map.len() + 1);
+        let mut bitmaps = BinaryBuilder::new();
+        let mut add_bitmap = |key: ScalarValue, bitmap: &RowIdTreeMap| -> Result<()> {
+            let mut serialized = Vec::with_capacity(bitmap.serialized_size());
+            bitmap.serialize_into(&mut serialized)?;
+            bitmaps.append_value(serialized);
+            keys.push(key);
+            Ok(())
+        };
+        if !self.null_map.is_empty() {
+            add_bitmap(ScalarValue::try_from(&self.value_type)?, &self.null_map)?;
+        }
+        for (key, bitmap) in &self.index_map {
+            add_bitmap(key.0.clone(), bitmap)?;
+        }
+
+        let keys = if keys.is_empty() {
+            new_empty_array(&self.value_type)
+        } else {
+            ScalarValue::iter_to_array(keys)?
+        };
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("keys", self.value_type.clone(), true),
+            Field::new("bitmaps", DataType::Binary, false),
+        ]));
+        let batch = RecordBatch::try_new(schema.clone(), vec![keys, Arc::new(bitmaps.finish())])?;
+
+        let mut lookup_file = index_store.new_index_file(self.lookup_name, schema).await?;
+        lookup_file.write_record_batch(batch).await?;
+        lookup_file.finish().await
+    }
+}
+
+/// Trains a bitmap index from a stream of values and row ids
+///
+/// The stream must have two columns.  The first column has the values to index and may have
+/// any name or type.  The second column must be the row ids (UInt64).  Unlike the btree index
+/// the data does not need to be sorted.
+pub async fn train_bitmap_index(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+) -> Result<()> {
+    train_bitmap_index_to(data, index_store, BITMAP_LOOKUP_NAME).await
+}
+
+/// Trains a bitmap index like [`train_bitmap_index`] but writes it to the file `lookup_name`
+pub(crate) async fn train_bitmap_index_to(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+    lookup_name: &'static str,
+) -> Result<()> {
+    let value_type = data.schema().field(0).data_type().clone();
+    let mut builder = BitmapIndexBuilder::new(value_type, lookup_name);
+    builder.add_stream(data).await?;
+    builder.write(index_store).await
+}
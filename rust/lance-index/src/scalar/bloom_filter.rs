@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! A bloom filter over scalar values
+//!
+//! Btree indices can store one of these per page so that a point lookup for a value that
+//! falls within a page's [min, max] range, but is not actually in the page, can skip loading
+//! the page.
+
+use arrow_schema::{DataType, TimeUnit};
+use datafusion_common::ScalarValue;
+use deepsize::DeepSizeOf;
+use lance_core::{Error, Result};
+use snafu::{location, Location};
+
+/// The number of bits to allocate per value, ~1% false positive rate with 7 hashes
+const BITS_PER_VALUE: usize = 10;
+const NUM_HASHES: u32 = 7;
+
+/// A fixed size bloom filter
+///
+/// Values are hashed with a stable hash (the filter is persisted) of their logical value so
+/// that, for example, an Int32 and an Int64 with the same value hash identically.
+#[derive(Debug, Clone, PartialEq, Eq, DeepSizeOf)]
+pub struct BloomFilter {
+    bits: Vec<u64>,
+    num_hashes: u32,
+}
+
+impl BloomFilter {
+    /// Create an empty filter sized for `num_values` values
+    pub fn with_capacity(num_values: usize) -> Self {
+        let num_words = (num_values.max(1) * BITS_PER_VALUE).div_ceil(64);
+        Self {
+            bits: vec![0; num_words],
+            num_hashes: NUM_HASHES,
+        }
+    }
+
+    /// True if values of the given type can be added to a bloom filter
+    pub fn supports_type(data_type: &DataType) -> bool {
+        matches!(
+            data_type,
+            DataType::Boolean
+                | DataType::Int8
+                | DataType::Int16
+                | DataType::Int32
+                | DataType::Int64
+                | DataType::UInt8
+                | DataType::UInt16
+                | DataType::UInt32
+                | DataType::UInt64
+                | DataType::Float32
+                | DataType::Float64
+                | DataType::Utf8
+                | DataType::LargeUtf8
+                | DataType::Binary
+                | DataType::LargeBinary
+                | DataType::Date32
+                | DataType::Date64
+                | DataType::Timestamp(_, _)
+        )
+    }
+
+    fn bit_positions(&self, hash: u64) -> impl Iterator<Item = usize> {
+        // Double hashing (Kirsch & Mitzenmacher), the second hash must be odd so that it
+        // cycles through every position
+        let num_bits = self.bits.len() as u64 * 64;
+        let step = splitmix64(hash) | 1;
+        (0..self.num_hashes as u64)
+            .map(move |i| (hash.wrapping_add(i.wrapping_mul(step)) % num_bits) as usize)
+    }
+
+    /// Add a value to the filter
+    ///
+    /// Nulls and values of unsupported types are ignored
+    pub fn insert(&mut self, value: &ScalarValue) {
+        if let Some(hash) = hash_scalar(value) {
+            let positions = self.bit_positions(hash).collect::<Vec<_>>();
+            for position in positions {
+                self.bits[position / 64] |= 1 << (position % 64);
+            }
+        }
+    }
+
+    /// Returns false if the value is definitely not in the filter
+    ///
+    /// Values that cannot be hashed (nulls and unsupported types) might always be present
+    pub fn might_contain(&self, value: &ScalarValue) -> bool {
+        match hash_scalar(value) {
+            Some(hash) => self
+                .bit_positions(hash)
+                .all(|position| self.bits[position / 64] & (1 << (position % 64)) != 0),
+            None => true,
+        }
+    }
+
+    /// Serialize the filter as the number of hashes followed by the little endian bit words
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut bytes = Vec::with_capacity(4 + self.bits.len() * 8);
+        bytes.extend_from_slice(&self.num_hashes.to_le_bytes());
+        for word in &self.bits {
+            bytes.extend_from_slice(&word.to_le_bytes());
+        }
+        bytes
+    }
+
+    pub fn try_from_bytes(bytes: &[u8]) -> Result<Self> {
+        if bytes.len() < 12 || (bytes.len() - 4) % 8 != 0 {
+            return Err(Error::Internal {
+                message: format!("invalid serialized bloom filter of {} bytes", bytes.len()),
+                location: location!(),
+            });
+        }
+        let num_hashes = u32::from_le_bytes(bytes[..4].try_into().unwrap());
+        let bits = bytes[4..]
+            .chunks_exact(8)
+            .map(|word| u64::from_le_bytes(word.try_into().unwrap()))
+            .collect();
+        Ok(Self { bits, num_hashes })
+    }
+}
+
+fn splitmix64(mut x: u64) -> u64 {
+    x = x.wrapping_add(0x9E3779B97F4A7C15);
+    x = (x ^ (x >> 30)).wrapping_mul(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)).wrapping_mul(0x94D049BB133111EB);
+    x ^ (x >> 31)
+}
+
+// FNV-1a, prefixed with a tag for the kind of value so that e.g. the string "1" and the
+// integer 1 do not collide
+fn hash_bytes(tag: u8, bytes: &[u8]) -> u64 {
+    let mut hash = 0xcbf29ce484222325_u64;
+    for byte in std::iter::once(&tag).chain(bytes) {
+        hash ^= *byte as u64;
+        hash = hash.wrapping_mul(0x100000001b3);
+    }
+    // FNV alone mixes the last bytes poorly
+    splitmix64(hash)
+}
+
+fn hash_int(value: i128) -> u64 {
+    hash_bytes(b'i', &value.to_le_bytes())
+}
+
+fn hash_float(value: f64) -> u64 {
+    // -0.0 == 0.0 so they must hash the same
+    let value = if value == 0.0 { 0.0 } else { value };
+    hash_bytes(b'f', &value.to_bits().to_le_bytes())
+}
+
+fn hash_timestamp(unit: TimeUnit, value: i64) -> u64 {
+    let tag = match unit {
+        TimeUnit::Second => b'S',
+        TimeUnit::Millisecond => b'M',
+        TimeUnit::Microsecond => b'U',
+        TimeUnit::Nanosecond => b'N',
+    };
+    hash_bytes(tag, &value.to_le_bytes())
+}
+
+/// A stable hash of the logical value of a scalar, None for nulls and unsupported types
+fn hash_scalar(value: &ScalarValue) -> Option<u64> {
+    match value {
+        ScalarValue::Boolean(Some(val)) => Some(hash_bytes(b'b', &[*val as u8])),
+        ScalarValue::Int8(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::Int16(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::Int32(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::Int64(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::UInt8(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::UInt16(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::UInt32(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::UInt64(Some(val)) => Some(hash_int(*val as i128)),
+        ScalarValue::Float32(Some(val)) => Some(hash_float(*val as f64)),
+        ScalarValue::Float64(Some(val)) => Some(hash_float(*val)),
+        ScalarValue::Utf8(Some(val)) | ScalarValue::LargeUtf8(Some(val)) => {
+            Some(hash_bytes(b's', val.as_bytes()))
+        }
+        ScalarValue::Binary(Some(val)) | ScalarValue::LargeBinary(Some(val)) => {
+            Some(hash_bytes(b'y', val))
+        }
+        ScalarValue::Date32(Some(val)) => Some(hash_bytes(b'd', &val.to_le_bytes())),
+        ScalarValue::Date64(Some(val)) => Some(hash_bytes(b'D', &val.to_le_bytes())),
+        ScalarValue::TimestampSecond(Some(val), _) => Some(hash_timestamp(TimeUnit::Second, *val)),
+        ScalarValue::TimestampMillisecond(Some(val), _) => {
+            Some(hash_timestamp(TimeUnit::Millisecond, *val))
+        }
+        ScalarValue::TimestampMicrosecond(Some(val), _) => {
+            Some(hash_timestamp(TimeUnit::Microsecond, *val))
+        }
+        ScalarValue::TimestampNanosecond(Some(val), _) => {
+            Some(hash_timestamp(TimeUnit::Nanosecond, *val))
+        }
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bloom_filter() {
+        let mut filter = BloomFilter::with_capacity(1000);
+        for i in (0..2000).step_by(2) {
+            filter.insert(&ScalarValue::Int32(Some(i)));
+        }
+
+        // No false negatives, and the same logical value matches across integer types
+        for i in (0..2000).step_by(2) {
+            assert!(filter.might_contain(&ScalarValue::Int32(Some(i))));
+            assert!(filter.might_contain(&ScalarValue::Int64(Some(i as i64))));
+        }
+        let false_positives = (1..2000)
+            .step_by(2)
+            .filter(|i| filter.might_contain(&ScalarValue::Int32(Some(*i))))
+            .count();
+        assert!(false_positives < 50, "{} false positives", false_positives);
+
+        // Nulls and unhashable values can't be ruled out
+        assert!(filter.might_contain(&ScalarValue::Int32(None)));
+
+        let roundtrip = BloomFilter::try_from_bytes(&filter.to_bytes()).unwrap();
+        assert_eq!(roundtrip, filter);
+        assert!(BloomFilter::try_from_bytes(&[1, 2, 3]).is_err());
+    }
+
+    #[test]
+    fn test_bloom_filter_strings_and_floats() {
+        let mut filter = BloomFilter::with_capacity(2);
+        filter.insert(&ScalarValue::Utf8(Some("apple".to_string())));
+        filter.insert(&ScalarValue::Float64(Some(-0.0)));
+
+        assert!(filter.might_contain(&ScalarValue::LargeUtf8(Some("apple".to_string()))));
+        assert!(filter.might_contain(&ScalarValue::Float64(Some(0.0))));
+        assert!(!filter.might_contain(&ScalarValue::Utf8(Some("banana".to_string()))));
+    }
+}
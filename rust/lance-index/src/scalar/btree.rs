@@ -4,13 +4,13 @@
 use std::{
     any::Any,
     cmp::Ordering,
-    collections::{BTreeMap, BinaryHeap, HashMap},
+    collections::{BTreeMap, HashMap, HashSet},
     fmt::{Debug, Display},
     ops::Bound,
     sync::Arc,
 };
 
-use arrow_array::{Array, RecordBatch, UInt32Array, UInt64Array};
+use arrow_array::{cast::AsArray, Array, BinaryArray, RecordBatch, UInt32Array, UInt64Array};
 use arrow_schema::{DataType, Field, Schema, SortOptions};
 use async_trait::async_trait;
 use datafusion::physical_plan::{
@@ -41,15 +41,17 @@ use snafu::{location, Location};
 use crate::{Index, IndexType};
 
 use super::{
-    flat::FlatIndexMetadata, IndexReader, IndexStore, IndexWriter, ScalarIndex, ScalarQuery,
+    bloom_filter::BloomFilter, flat::FlatIndexMetadata, IndexReader, IndexStore, IndexWriter,
+    ScalarIndex, ScalarQuery,
 };
 
-const BTREE_LOOKUP_NAME: &str = "page_lookup.lance";
+pub const BTREE_LOOKUP_NAME: &str = "page_lookup.lance";
 const BTREE_PAGES_NAME: &str = "page_data.lance";
+const BLOOM_FILTER_COLUMN: &str = "bloom_filter";
 
 /// Wraps a ScalarValue and implements Ord (ScalarValue only implements PartialOrd)
 #[derive(Clone, Debug)]
-struct OrderableScalarValue(ScalarValue);
+pub(crate) struct OrderableScalarValue(pub(crate) ScalarValue);
 
 impl DeepSizeOf for OrderableScalarValue {
     fn deep_size_of_children(&self, _context: &mut deepsize::Context) -> usize {
@@ -533,11 +535,33 @@ pub struct BTreeLookup {
     tree: BTreeMap<OrderableScalarValue, Vec<PageRecord>>,
     /// Pages where the value may be null
     null_pages: Vec<u32>,
+    /// Bloom filters of the values in each page, empty if the index was trained without them
+    page_blooms: HashMap<u32, BloomFilter>,
 }
 
 impl BTreeLookup {
-    fn new(tree: BTreeMap<OrderableScalarValue, Vec<PageRecord>>, null_pages: Vec<u32>) -> Self {
-        Self { tree, null_pages }
+    fn new(
+        tree: BTreeMap<OrderableScalarValue, Vec<PageRecord>>,
+        null_pages: Vec<u32>,
+        page_blooms: HashMap<u32, BloomFilter>,
+    ) -> Self {
+        Self {
+            tree,
+            null_pages,
+            page_blooms,
+        }
+    }
+
+    fn has_bloom_filters(&self) -> bool {
+        !self.page_blooms.is_empty()
+    }
+
+    // False if the page definitely does not contain the value
+    fn page_might_contain(&self, page_number: u32, value: &ScalarValue) -> bool {
+        self.page_blooms
+            .get(&page_number)
+            .map(|bloom| bloom.might_contain(value))
+            .unwrap_or(true)
     }
 
     fn all_page_ids(&self) -> Vec<u32> {
@@ -556,20 +580,31 @@ impl BTreeLookup {
         self.pages_between((Bound::Included(query), Bound::Excluded(query)))
     }
 
-    // All pages that could have a value equal to one of the values
-    fn pages_in(&self, values: impl IntoIterator<Item = OrderableScalarValue>) -> Vec<u32> {
-        let page_lists = values
-            .into_iter()
-            .map(|val| self.pages_eq(&val))
-            .collect::<Vec<_>>();
-        let total_size = page_lists.iter().map(|set| set.len()).sum();
-        let mut heap = BinaryHeap::with_capacity(total_size);
-        for page_list in page_lists {
-            heap.extend(page_list);
+    // All pages that could have a value equal to val, skipping pages whose bloom filter
+    // rules the value out
+    fn pages_containing(&self, value: &ScalarValue) -> Vec<u32> {
+        let mut pages = self.pages_eq(&OrderableScalarValue(value.clone()));
+        pages.retain(|page_number| self.page_might_contain(*page_number, value));
+        pages
+    }
+
+    // All pages that could have a value equal to one of the values, in page order, along with
+    // the values that could be in each page
+    fn pages_in(&self, values: &[ScalarValue]) -> BTreeMap<u32, Vec<ScalarValue>> {
+        let mut page_values = BTreeMap::<u32, Vec<ScalarValue>>::new();
+        let mut seen = HashSet::with_capacity(values.len());
+        for value in values {
+            if !seen.insert(value) {
+                continue;
+            }
+            for page_number in self.pages_containing(value) {
+                page_values
+                    .entry(page_number)
+                    .or_default()
+                    .push(value.clone());
+            }
         }
-        let mut all_pages = heap.into_sorted_vec();
-        all_pages.dedup();
-        all_pages
+        page_values
     }
 
     // All pages that could have a value in the range
@@ -659,10 +694,11 @@ impl BTreeIndex {
     fn new(
         tree: BTreeMap<OrderableScalarValue, Vec<PageRecord>>,
         null_pages: Vec<u32>,
+        page_blooms: HashMap<u32, BloomFilter>,
         store: Arc<dyn IndexStore>,
         sub_index: Arc<dyn BTreeSubIndex>,
     ) -> Self {
-        let page_lookup = Arc::new(BTreeLookup::new(tree, null_pages));
+        let page_lookup = Arc::new(BTreeLookup::new(tree, null_pages, page_blooms));
         Self {
             page_lookup,
             store,
@@ -670,18 +706,38 @@ impl BTreeIndex {
         }
     }
 
+    // Load a page from the pages file and add it to the store's page cache
+    async fn load_page(
+        &self,
+        page_number: u32,
+        index_reader: &dyn IndexReader,
+    ) -> Result<Arc<dyn ScalarIndex>> {
+        let serialized_page = index_reader.read_record_batch(page_number).await?;
+        let subindex = self.sub_index.load_subindex(serialized_page).await?;
+        self.store
+            .cache_page(BTREE_PAGES_NAME, page_number, subindex.clone());
+        Ok(subindex)
+    }
+
     async fn search_page(
         &self,
         query: &ScalarQuery,
         page_number: u32,
-        index_reader: Arc<dyn IndexReader>,
+        cached_page: Option<Arc<dyn ScalarIndex>>,
+        index_reader: Option<Arc<dyn IndexReader>>,
     ) -> Result<UInt64Array> {
-        let serialized_page = index_reader.read_record_batch(page_number).await?;
-        let subindex = self.sub_index.load_subindex(serialized_page).await?;
-        // TODO: If this is an IN query we can perhaps simplify the subindex query by restricting it to the
-        // values that might be in the page.  E.g. if we are searching for X IN [5, 3, 7] and five is in pages
-        // 1 and 2 and three is in page 2 and seven is in pages 8 and 9 then when we search page 2 we only need
-        // to search for X IN [5, 3]
+        let subindex = match (cached_page, index_reader) {
+            (Some(subindex), _) => subindex,
+            (None, Some(index_reader)) => {
+                self.load_page(page_number, index_reader.as_ref()).await?
+            }
+            (None, None) => {
+                return Err(Error::Internal {
+                    message: format!("btree page {} is neither cached nor readable", page_number),
+                    location: location!(),
+                })
+            }
+        };
         subindex.search(query).await
     }
 
@@ -708,6 +764,11 @@ impl BTreeIndex {
             .as_any()
             .downcast_ref::<UInt32Array>()
             .unwrap();
+        // Indices trained without bloom filters (or before they existed) lack this column
+        let blooms = data
+            .column_by_name(BLOOM_FILTER_COLUMN)
+            .map(|blooms| blooms.as_binary::<i32>());
+        let mut page_blooms = HashMap::new();
 
         for idx in 0..data.num_rows() {
             let min = OrderableScalarValue(ScalarValue::try_from_array(&mins, idx)?);
@@ -721,6 +782,12 @@ impl BTreeIndex {
             if null_count > 0 {
                 null_pages.push(page_number);
             }
+            if let Some(blooms) = blooms {
+                if blooms.is_valid(idx) {
+                    page_blooms
+                        .insert(page_number, BloomFilter::try_from_bytes(blooms.value(idx))?);
+                }
+            }
         }
 
         let last_max = ScalarValue::try_from_array(&maxs, data.num_rows() - 1)?;
@@ -731,7 +798,7 @@ impl BTreeIndex {
         // TODO: Support other page types?
         let sub_index = Arc::new(FlatIndexMetadata::new(data_type.clone()));
 
-        Ok(Self::new(map, null_pages, store, sub_index))
+        Ok(Self::new(map, null_pages, page_blooms, store, sub_index))
     }
 
     /// Create a stream of all the data in the index, in the same format used to train the index
@@ -751,7 +818,7 @@ impl BTreeIndex {
     }
 }
 
-fn wrap_bound(bound: &Bound<ScalarValue>) -> Bound<OrderableScalarValue> {
+pub(crate) fn wrap_bound(bound: &Bound<ScalarValue>) -> Bound<OrderableScalarValue> {
     match bound {
         Bound::Unbounded => Bound::Unbounded,
         Bound::Included(val) => Bound::Included(OrderableScalarValue(val.clone())),
@@ -829,24 +896,65 @@ impl Index for BTreeIndex {
 #[async_trait]
 impl ScalarIndex for BTreeIndex {
     async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
-        let pages = match query {
+        let page_queries = match query {
             ScalarQuery::Equals(val) => self
                 .page_lookup
-                .pages_eq(&OrderableScalarValue(val.clone())),
+                .pages_containing(val)
+                .into_iter()
+                .map(|page_number| (page_number, query.clone()))
+                .collect::<Vec<_>>(),
             ScalarQuery::Range(start, end) => self
                 .page_lookup
-                .pages_between((wrap_bound(start).as_ref(), wrap_bound(end).as_ref())),
+                .pages_between((wrap_bound(start).as_ref(), wrap_bound(end).as_ref()))
+                .into_iter()
+                .map(|page_number| (page_number, query.clone()))
+                .collect(),
+            // Each page only needs to be searched for the values that might be in it
             ScalarQuery::IsIn(values) => self
                 .page_lookup
-                .pages_in(values.iter().map(|val| OrderableScalarValue(val.clone()))),
-            ScalarQuery::IsNull() => self.page_lookup.pages_null(),
+                .pages_in(values)
+                .into_iter()
+                .map(|(page_number, values)| (page_number, ScalarQuery::IsIn(values)))
+                .collect(),
+            ScalarQuery::IsNull() => self
+                .page_lookup
+                .pages_null()
+                .into_iter()
+                .map(|page_number| (page_number, query.clone()))
+                .collect(),
+            ScalarQuery::FullTextSearch(_)
+            | ScalarQuery::ContainsCandidates(_)
+            | ScalarQuery::HasAnyLabel(_)
+            | ScalarQuery::HasAllLabels(_) => {
+                return Err(Error::NotSupported {
+                    source: "a btree index can only answer comparison, IN and IS NULL queries"
+                        .into(),
+                    location: location!(),
+                })
+            }
         };
-        let sub_index_reader = self.store.open_index_file(BTREE_PAGES_NAME).await?;
-        let page_tasks = pages
+        let page_queries = page_queries
             .into_iter()
-            .map(|page_index| {
-                self.search_page(query, page_index, sub_index_reader.clone())
-                    .boxed()
+            .map(|(page_number, query)| {
+                let cached_page = self.store.cached_page(BTREE_PAGES_NAME, page_number);
+                (page_number, query, cached_page)
+            })
+            .collect::<Vec<_>>();
+        // Only open the pages file if some page has to be read from it
+        let sub_index_reader = if page_queries.iter().any(|(_, _, cached)| cached.is_none()) {
+            Some(self.store.open_index_file(BTREE_PAGES_NAME).await?)
+        } else {
+            None
+        };
+        let page_tasks = page_queries
+            .into_iter()
+            .map(|(page_number, query, cached_page)| {
+                let sub_index_reader = sub_index_reader.clone();
+                async move {
+                    self.search_page(&query, page_number, cached_page, sub_index_reader)
+                        .await
+                }
+                .boxed()
             })
             .collect::<Vec<_>>();
         let row_id_lists = stream::iter(page_tasks)
@@ -909,7 +1017,16 @@ impl ScalarIndex for BTreeIndex {
     ) -> Result<()> {
         // Merge the existing index data with the new data and then retrain the index on the merged stream
         let merged_data_source = Box::new(BTreeUpdater::new(self.clone(), new_data));
-        train_btree_index(merged_data_source, self.sub_index.as_ref(), dest_store).await
+        let options = BTreeTrainingOptions {
+            bloom_filters: self.page_lookup.has_bloom_filters(),
+        };
+        train_btree_index_with_options(
+            merged_data_source,
+            self.sub_index.as_ref(),
+            dest_store,
+            &options,
+        )
+        .await
     }
 }
 
@@ -936,13 +1053,13 @@ fn check_for_nan(value: ScalarValue) -> Result<ScalarValue> {
     }
 }
 
-fn min_val(array: &Arc<dyn Array>) -> Result<ScalarValue> {
+pub(crate) fn min_val(array: &Arc<dyn Array>) -> Result<ScalarValue> {
     let mut acc = MinAccumulator::try_new(array.data_type())?;
     acc.update_batch(&[array.clone()])?;
     check_for_nan(acc.evaluate()?)
 }
 
-fn max_val(array: &Arc<dyn Array>) -> Result<ScalarValue> {
+pub(crate) fn max_val(array: &Arc<dyn Array>) -> Result<ScalarValue> {
     let mut acc = MaxAccumulator::try_new(array.data_type())?;
     acc.update_batch(&[array.clone()])?;
     check_for_nan(acc.evaluate()?)
@@ -989,20 +1106,38 @@ pub trait BTreeSubIndex: Debug + Send + Sync + DeepSizeOf {
 
 struct EncodedBatch {
     stats: BatchStats,
+    bloom: Option<BloomFilter>,
     page_number: u32,
 }
 
+fn train_page_bloom(values: &dyn Array) -> Result<BloomFilter> {
+    let mut bloom = BloomFilter::with_capacity(values.len() - values.null_count());
+    for idx in 0..values.len() {
+        if values.is_valid(idx) {
+            bloom.insert(&ScalarValue::try_from_array(values, idx)?);
+        }
+    }
+    Ok(bloom)
+}
+
 async fn train_btree_page(
     batch: RecordBatch,
     batch_idx: u32,
     sub_index_trainer: &dyn BTreeSubIndex,
     writer: &mut dyn IndexWriter,
+    bloom_filter: bool,
 ) -> Result<EncodedBatch> {
     let stats = analyze_batch(&batch)?;
+    let bloom = if bloom_filter {
+        Some(train_page_bloom(batch.column(0).as_ref())?)
+    } else {
+        None
+    };
     let trained = sub_index_trainer.train(batch).await?;
     writer.write_record_batch(trained).await?;
     Ok(EncodedBatch {
         stats,
+        bloom,
         page_number: batch_idx,
     })
 }
@@ -1013,21 +1148,31 @@ fn btree_stats_as_batch(stats: Vec<EncodedBatch>) -> Result<RecordBatch> {
     let null_counts = UInt32Array::from_iter_values(stats.iter().map(|stat| stat.stats.null_count));
     let page_numbers = UInt32Array::from_iter_values(stats.iter().map(|stat| stat.page_number));
 
-    let schema = Arc::new(Schema::new(vec![
+    let mut fields = vec![
         // min and max can be null if the entire batch is null values
         Field::new("min", mins.data_type().clone(), true),
         Field::new("max", maxs.data_type().clone(), true),
         Field::new("null_count", null_counts.data_type().clone(), false),
         Field::new("page_idx", page_numbers.data_type().clone(), false),
-    ]));
-
-    let columns = vec![
+    ];
+    let mut columns = vec![
         mins,
         maxs,
         Arc::new(null_counts) as Arc<dyn Array>,
         Arc::new(page_numbers) as Arc<dyn Array>,
     ];
 
+    if stats.iter().any(|stat| stat.bloom.is_some()) {
+        let blooms = BinaryArray::from_iter(
+            stats
+                .iter()
+                .map(|stat| stat.bloom.as_ref().map(|bloom| bloom.to_bytes())),
+        );
+        fields.push(Field::new(BLOOM_FILTER_COLUMN, DataType::Binary, true));
+        columns.push(Arc::new(blooms));
+    }
+    let schema = Arc::new(Schema::new(fields));
+
     Ok(RecordBatch::try_new(schema, columns)?)
 }
 
@@ -1046,6 +1191,18 @@ pub trait BtreeTrainingSource: Send {
     ) -> Result<SendableRecordBatchStream>;
 }
 
+/// Options for training a btree index
+#[derive(Debug, Clone, Default)]
+pub struct BTreeTrainingOptions {
+    /// Store a bloom filter of the values of each page
+    ///
+    /// A point lookup (equality or IN) for a value that is not in a page but falls within the
+    /// page's min/max range can then skip loading the page.  This helps high cardinality columns
+    /// with many misses but costs a little over one byte of memory per indexed value so it is
+    /// off by default.  Ignored for value types that cannot be hashed.
+    pub bloom_filters: bool,
+}
+
 /// Train a btree index from a stream of sorted page-size batches of values and row ids
 ///
 /// Note: This is likely to change.  It is unreasonable to expect the caller to do the sorting
@@ -1055,6 +1212,22 @@ pub async fn train_btree_index(
     data_source: Box<dyn BtreeTrainingSource + Send>,
     sub_index_trainer: &dyn BTreeSubIndex,
     index_store: &dyn IndexStore,
+) -> Result<()> {
+    train_btree_index_with_options(
+        data_source,
+        sub_index_trainer,
+        index_store,
+        &BTreeTrainingOptions::default(),
+    )
+    .await
+}
+
+/// Train a btree index, see [`train_btree_index`]
+pub async fn train_btree_index_with_options(
+    data_source: Box<dyn BtreeTrainingSource + Send>,
+    sub_index_trainer: &dyn BTreeSubIndex,
+    index_store: &dyn IndexStore,
+    options: &BTreeTrainingOptions,
 ) -> Result<()> {
     let mut sub_index_file = index_store
         .new_index_file(BTREE_PAGES_NAME, sub_index_trainer.schema().clone())
@@ -1062,11 +1235,20 @@ pub async fn train_btree_index(
     let mut encoded_batches = Vec::new();
     let mut batch_idx = 0;
     let mut batches_source = data_source.scan_ordered_chunks(4096).await?;
+    let bloom_filters = options.bloom_filters
+        && BloomFilter::supports_type(batches_source.schema().field(0).data_type());
     while let Some(batch) = batches_source.try_next().await? {
         debug_assert_eq!(batch.num_columns(), 2);
         debug_assert_eq!(*batch.column(1).data_type(), DataType::UInt64);
         encoded_batches.push(
-            train_btree_page(batch, batch_idx, sub_index_trainer, sub_index_file.as_mut()).await?,
+            train_btree_page(
+                batch,
+                batch_idx,
+                sub_index_trainer,
+                sub_index_file.as_mut(),
+                bloom_filters,
+            )
+            .await?,
         );
         batch_idx += 1;
     }
@@ -3,21 +3,22 @@
 
 use std::{ops::Bound, sync::Arc};
 
+use arrow_array::Array;
 use arrow_schema::DataType;
 use async_recursion::async_recursion;
 use async_trait::async_trait;
 use datafusion_common::ScalarValue;
-use datafusion_expr::{expr::InList, Between, BinaryExpr, Expr, Operator};
+use datafusion_expr::{
+    expr::{InList, Like, ScalarFunction},
+    Between, BinaryExpr, Expr, Operator,
+};
 
 use futures::join;
-use lance_core::{
-    utils::mask::{RowIdMask, RowIdTreeMap},
-    Result,
-};
+use lance_core::{utils::mask::RowIdMask, Result};
 use lance_datafusion::expr::safe_coerce_scalar;
 use tracing::instrument;
 
-use super::{ScalarIndex, ScalarQuery};
+use super::{ngram::NGRAM_LENGTH, ScalarIndex, ScalarIndexType, ScalarQuery};
 
 /// An indexed expression consists of a scalar index query with a post-scan filter
 ///
@@ -236,8 +237,7 @@ impl ScalarIndexExpr {
             }
             Self::Query(column, query) => {
                 let index = index_loader.load_index(column).await?;
-                let allow_list = index.search(query).await?;
-                let allow_list = RowIdTreeMap::from_iter(allow_list.values().iter());
+                let allow_list = index.search_row_ids(query).await?;
                 Ok(RowIdMask {
                     block_list: None,
                     allow_list: Some(allow_list),
@@ -272,14 +272,84 @@ fn maybe_column(expr: &Expr) -> Option<&str> {
     }
 }
 
-// Extract a column from the expression, if it is a column, and we have an index for that column, or None
+// Extract a column from the expression, if it is a column, and we have an index for that column
+// which can exactly answer comparison queries, or None
 fn maybe_indexed_column<'a, 'b>(
     expr: &'a Expr,
     index_info: &'b dyn IndexInformationProvider,
 ) -> Option<(&'a str, &'b DataType)> {
     let col = maybe_column(expr)?;
-    let data_type = index_info.get_index(col);
-    data_type.map(|ty| (col, ty))
+    let (data_type, index_type) = index_info.get_index(col)?;
+    if index_type.supports_exact_queries() {
+        Some((col, data_type))
+    } else {
+        None
+    }
+}
+
+// Extract a column from the expression, if it is a column, and we have an ngram index for that
+// column, or None
+fn maybe_ngram_indexed_column<'a>(
+    expr: &'a Expr,
+    index_info: &dyn IndexInformationProvider,
+) -> Option<&'a str> {
+    let col = maybe_column(expr)?;
+    match index_info.get_index(col)? {
+        (_, ScalarIndexType::NGram) => Some(col),
+        _ => None,
+    }
+}
+
+// Extract a column from the expression, if it is a column, and we have a label list index for
+// that column, or None.  The data type returned is the type of the list items.
+fn maybe_label_list_indexed_column<'a, 'b>(
+    expr: &'a Expr,
+    index_info: &'b dyn IndexInformationProvider,
+) -> Option<(&'a str, &'b DataType)> {
+    let col = maybe_column(expr)?;
+    match index_info.get_index(col)? {
+        (DataType::List(item) | DataType::LargeList(item), ScalarIndexType::LabelList) => {
+            Some((col, item.data_type()))
+        }
+        _ => None,
+    }
+}
+
+// Extract the values of a list literal (e.g. `['a', 'b']`), if it is a non-empty list literal
+// with no nulls, or None
+fn maybe_list_literal(expr: &Expr, item_type: &DataType) -> Option<Vec<ScalarValue>> {
+    let list = match expr {
+        Expr::Literal(ScalarValue::List(list)) => list,
+        _ => return None,
+    };
+    if list.len() != 1 || list.is_null(0) {
+        return None;
+    }
+    let items = list.value(0);
+    let values = (0..items.len())
+        .map(|idx| {
+            let value = ScalarValue::try_from_array(&items, idx).ok()?;
+            if value.is_null() {
+                None
+            } else {
+                safe_coerce_scalar(&value, item_type)
+            }
+        })
+        .collect::<Option<Vec<_>>>()?;
+    if values.is_empty() {
+        None
+    } else {
+        Some(values)
+    }
+}
+
+// Extract a string from the expression, if it is a string literal, or None
+fn maybe_string_literal(expr: &Expr) -> Option<&str> {
+    match expr {
+        Expr::Literal(ScalarValue::Utf8(Some(value)))
+        | Expr::Literal(ScalarValue::LargeUtf8(Some(value))) => Some(value),
+        _ => None,
+    }
 }
 
 // Extract a literal scalar value from an expression, if it is a literal, or None
@@ -457,6 +527,191 @@ fn visit_or(
     }
 }
 
+// Splits a LIKE pattern into the literal runs between its wildcards
+//
+// Every value that matches the pattern contains every one of the runs.  Like arrow we treat
+// backslash as the escape character if no escape character is given.
+fn like_pattern_substrings(pattern: &str, escape_char: Option<char>) -> Vec<String> {
+    let escape_char = escape_char.unwrap_or('\\');
+    let mut substrings = Vec::new();
+    let mut current = String::new();
+    let mut chars = pattern.chars();
+    while let Some(c) = chars.next() {
+        if c == escape_char {
+            match chars.next() {
+                Some(escaped) if escaped == '%' || escaped == '_' || escaped == escape_char => {
+                    current.push(escaped)
+                }
+                // We don't know what this means so don't assume anything about it
+                _ => substrings.push(std::mem::take(&mut current)),
+            }
+        } else if c == '%' || c == '_' {
+            substrings.push(std::mem::take(&mut current));
+        } else {
+            current.push(c);
+        }
+    }
+    substrings.push(current);
+    substrings
+}
+
+// Skips past the closing `close` char, returns false if there is no closing char
+fn skip_regex_group(
+    chars: &mut std::iter::Peekable<std::str::Chars>,
+    open: char,
+    close: char,
+) -> bool {
+    let mut depth = 1;
+    // A closing bracket right after the opening bracket (or a negation) is a literal
+    if open == '[' {
+        if chars.peek() == Some(&'^') {
+            chars.next();
+        }
+        if chars.peek() == Some(&']') {
+            chars.next();
+        }
+    }
+    while let Some(c) = chars.next() {
+        if c == '\\' {
+            chars.next();
+        } else if c == close {
+            depth -= 1;
+            if depth == 0 {
+                return true;
+            }
+        } else if c == open && open != '[' {
+            depth += 1;
+        }
+    }
+    false
+}
+
+// Finds literal substrings that every match of a regular expression must contain
+//
+// This is deliberately conservative.  Groups, character classes and anything we don't
+// understand are treated as "could be anything".  Alternation is not supported at all (None is
+// returned) because a match only needs to contain the literals of one branch.
+fn regex_required_substrings(pattern: &str) -> Option<Vec<String>> {
+    if pattern.contains('|') {
+        return None;
+    }
+    let mut substrings = Vec::new();
+    let mut current = String::new();
+    let mut chars = pattern.chars().peekable();
+    while let Some(c) = chars.next() {
+        match c {
+            '\\' => match chars.next()? {
+                // Perl classes and assertions
+                'd' | 'D' | 'w' | 'W' | 's' | 'S' | 'b' | 'B' | 'A' | 'z' => {
+                    substrings.push(std::mem::take(&mut current))
+                }
+                // Hex, unicode, and other escapes we don't decode
+                escaped if escaped.is_alphanumeric() => return None,
+                escaped => current.push(escaped),
+            },
+            '(' => {
+                substrings.push(std::mem::take(&mut current));
+                if !skip_regex_group(&mut chars, '(', ')') {
+                    return None;
+                }
+            }
+            '[' => {
+                substrings.push(std::mem::take(&mut current));
+                if !skip_regex_group(&mut chars, '[', ']') {
+                    return None;
+                }
+            }
+            // The previous character is optional
+            '*' | '?' => {
+                current.pop();
+                substrings.push(std::mem::take(&mut current));
+            }
+            '{' => {
+                current.pop();
+                substrings.push(std::mem::take(&mut current));
+                if !skip_regex_group(&mut chars, '{', '}') {
+                    return None;
+                }
+            }
+            // The previous character is required but may repeat
+            '+' | '.' | '^' | '$' => substrings.push(std::mem::take(&mut current)),
+            ')' | ']' | '}' => return None,
+            c => current.push(c),
+        }
+    }
+    substrings.push(current);
+    Some(substrings)
+}
+
+// Creates a candidate search for values containing `substrings` followed by a refine with the
+// original expression.  Substrings too short to have an ngram are ignored.
+fn visit_contains(column: &str, substrings: Vec<String>, expr: &Expr) -> Option<IndexedExpression> {
+    let substrings = substrings
+        .into_iter()
+        .filter(|substring| substring.chars().count() >= NGRAM_LENGTH)
+        .collect::<Vec<_>>();
+    if substrings.is_empty() {
+        return None;
+    }
+    Some(
+        IndexedExpression::index_query(
+            column.to_string(),
+            ScalarQuery::ContainsCandidates(substrings),
+        )
+        .refine(expr.clone()),
+    )
+}
+
+fn visit_like(
+    like: &Like,
+    expr: &Expr,
+    index_info: &dyn IndexInformationProvider,
+) -> Option<IndexedExpression> {
+    // The candidates for a negated pattern would be nearly every row
+    if like.negated {
+        return None;
+    }
+    let column = maybe_ngram_indexed_column(&like.expr, index_info)?;
+    let pattern = maybe_string_literal(&like.pattern)?;
+    visit_contains(
+        column,
+        like_pattern_substrings(pattern, like.escape_char),
+        expr,
+    )
+}
+
+fn visit_regex_match(
+    expr: &BinaryExpr,
+    index_info: &dyn IndexInformationProvider,
+) -> Option<IndexedExpression> {
+    let column = maybe_ngram_indexed_column(&expr.left, index_info)?;
+    let pattern = maybe_string_literal(&expr.right)?;
+    visit_contains(
+        column,
+        regex_required_substrings(pattern)?,
+        &Expr::BinaryExpr(expr.clone()),
+    )
+}
+
+fn visit_scalar_function(
+    func: &ScalarFunction,
+    index_info: &dyn IndexInformationProvider,
+) -> Option<IndexedExpression> {
+    if func.args.len() != 2 {
+        return None;
+    }
+    let (column, item_type) = maybe_label_list_indexed_column(&func.args[0], index_info)?;
+    let query = match func.name() {
+        "array_has" => ScalarQuery::HasAnyLabel(vec![
+            maybe_scalar(&func.args[1], item_type).filter(|value| !value.is_null())?
+        ]),
+        "array_has_any" => ScalarQuery::HasAnyLabel(maybe_list_literal(&func.args[1], item_type)?),
+        "array_has_all" => ScalarQuery::HasAllLabels(maybe_list_literal(&func.args[1], item_type)?),
+        _ => return None,
+    };
+    Some(IndexedExpression::index_query(column.to_string(), query))
+}
+
 fn visit_binary_expr(
     expr: &BinaryExpr,
     index_info: &dyn IndexInformationProvider,
@@ -469,11 +724,52 @@ fn visit_binary_expr(
         Operator::NotEq => visit_comparison(expr, index_info).and_then(|node| node.maybe_not()),
         Operator::And => visit_and(expr, index_info),
         Operator::Or => visit_or(expr, index_info),
+        Operator::RegexMatch | Operator::RegexIMatch => visit_regex_match(expr, index_info),
         _ => None,
     }
 }
 
+// Presents only the columns with a zone map index, as if their index were exact, so that the
+// comparison visitors can be reused for zone maps
+struct ZoneMapColumns<'a>(&'a dyn IndexInformationProvider);
+
+impl IndexInformationProvider for ZoneMapColumns<'_> {
+    fn get_index(&self, col: &str) -> Option<(&DataType, ScalarIndexType)> {
+        match self.0.get_index(col)? {
+            (data_type, ScalarIndexType::ZoneMap) => Some((data_type, ScalarIndexType::BTree)),
+            _ => None,
+        }
+    }
+}
+
+// A zone map only narrows a comparison down to the zones that might match so the original
+// expression is always applied as a refine.  Negations can't be narrowed down this way.
+fn visit_zone_map(
+    expr: &Expr,
+    index_info: &dyn IndexInformationProvider,
+) -> Option<IndexedExpression> {
+    let zone_maps = ZoneMapColumns(index_info);
+    let indexed_expr = match expr {
+        Expr::Between(between) if !between.negated => visit_between(between, &zone_maps),
+        Expr::InList(in_list) if !in_list.negated => visit_in_list(in_list, &zone_maps),
+        Expr::IsNull(expr) => visit_is_null(expr.as_ref(), &zone_maps, false),
+        Expr::BinaryExpr(binary_expr)
+            if matches!(
+                binary_expr.op,
+                Operator::Lt | Operator::LtEq | Operator::Gt | Operator::GtEq | Operator::Eq
+            ) =>
+        {
+            visit_comparison(binary_expr, &zone_maps)
+        }
+        _ => None,
+    }?;
+    Some(indexed_expr.refine(expr.clone()))
+}
+
 fn visit_node(expr: &Expr, index_info: &dyn IndexInformationProvider) -> Option<IndexedExpression> {
+    if let Some(indexed_expr) = visit_zone_map(expr, index_info) {
+        return Some(indexed_expr);
+    }
     match expr {
         Expr::Between(between) => visit_between(between, index_info),
         Expr::Column(_) => visit_column(expr, index_info),
@@ -483,6 +779,8 @@ fn visit_node(expr: &Expr, index_info: &dyn IndexInformationProvider) -> Option<
         Expr::IsNull(expr) => visit_is_null(expr.as_ref(), index_info, false),
         Expr::IsNotNull(expr) => visit_is_null(expr.as_ref(), index_info, true),
         Expr::Not(expr) => visit_not(expr.as_ref(), index_info),
+        Expr::Like(like) => visit_like(like, expr, index_info),
+        Expr::ScalarFunction(func) => visit_scalar_function(func, index_info),
         Expr::BinaryExpr(binary_expr) => visit_binary_expr(binary_expr, index_info),
         _ => None,
     }
@@ -490,8 +788,9 @@ fn visit_node(expr: &Expr, index_info: &dyn IndexInformationProvider) -> Option<
 
 /// A trait to be used in `apply_scalar_indices` to inform the function which columns are indexeds
 pub trait IndexInformationProvider {
-    /// Check if an index exists for `col` and, if so, return the data type of col
-    fn get_index(&self, col: &str) -> Option<&DataType>;
+    /// Check if an index exists for `col` and, if so, return the data type of col and the
+    /// kind of index
+    fn get_index(&self, col: &str) -> Option<(&DataType, ScalarIndexType)>;
 }
 
 /// Attempt to split a filter expression into a search of scalar indexes and an
@@ -518,7 +817,7 @@ mod tests {
     use super::*;
 
     struct MockIndexInfoProvider {
-        indexed_columns: HashMap<String, DataType>,
+        indexed_columns: HashMap<String, (DataType, ScalarIndexType)>,
     }
 
     impl MockIndexInfoProvider {
@@ -527,15 +826,22 @@ mod tests {
                 indexed_columns: HashMap::from_iter(
                     indexed_columns
                         .into_iter()
-                        .map(|(s, ty)| (s.to_string(), ty)),
+                        .map(|(s, ty)| (s.to_string(), (ty, ScalarIndexType::BTree))),
                 ),
             }
         }
+
+        fn with_index_type(mut self, col: &str, index_type: ScalarIndexType) -> Self {
+            self.indexed_columns.get_mut(col).unwrap().1 = index_type;
+            self
+        }
     }
 
     impl IndexInformationProvider for MockIndexInfoProvider {
-        fn get_index(&self, col: &str) -> Option<&DataType> {
-            self.indexed_columns.get(col)
+        fn get_index(&self, col: &str) -> Option<(&DataType, ScalarIndexType)> {
+            self.indexed_columns
+                .get(col)
+                .map(|(data_type, index_type)| (data_type, *index_type))
         }
     }
 
@@ -580,11 +886,7 @@ mod tests {
         }
     }
 
-    fn check(
-        index_info: &dyn IndexInformationProvider,
-        expr: &str,
-        expected: Option<IndexedExpression>,
-    ) {
+    fn parse_expr(expr: &str) -> Expr {
         let schema = Schema::new(vec![
             Field::new("color", DataType::Utf8, false),
             Field::new("size", DataType::Float32, false),
@@ -599,10 +901,17 @@ mod tests {
         let planner = SqlToRel::new(&context_provider);
         let df_schema: DFSchema = schema.try_into().unwrap();
         let mut planner_context = PlannerContext::new();
-        let expr = planner
+        planner
             .sql_to_expr(expr, &df_schema, &mut planner_context)
-            .unwrap();
+            .unwrap()
+    }
 
+    fn check(
+        index_info: &dyn IndexInformationProvider,
+        expr: &str,
+        expected: Option<IndexedExpression>,
+    ) {
+        let expr = parse_expr(expr);
         let actual = apply_scalar_indices(expr.clone(), index_info);
         if let Some(expected) = expected {
             assert_eq!(actual, expected);
@@ -846,4 +1155,106 @@ mod tests {
         // Non-normalized arithmetic (can use expression simplification)
         check_no_index(&index_info, "aisle + 3 < 10")
     }
+
+    #[test]
+    fn test_zone_map_expressions() {
+        let index_info = MockIndexInfoProvider::new(vec![("aisle", DataType::UInt32)])
+            .with_index_type("aisle", ScalarIndexType::ZoneMap);
+
+        let check_zones = |expr: &str, query: ScalarQuery| {
+            check(
+                &index_info,
+                expr,
+                Some(
+                    IndexedExpression::index_query("aisle".to_string(), query)
+                        .refine(parse_expr(expr)),
+                ),
+            );
+        };
+
+        check_zones(
+            "aisle > 10",
+            ScalarQuery::Range(
+                Bound::Excluded(ScalarValue::UInt32(Some(10))),
+                Bound::Unbounded,
+            ),
+        );
+        check_zones(
+            "aisle BETWEEN 5 AND 10",
+            ScalarQuery::Range(
+                Bound::Included(ScalarValue::UInt32(Some(5))),
+                Bound::Included(ScalarValue::UInt32(Some(10))),
+            ),
+        );
+        check_zones(
+            "aisle IN (5, 10)",
+            ScalarQuery::IsIn(vec![
+                ScalarValue::UInt32(Some(5)),
+                ScalarValue::UInt32(Some(10)),
+            ]),
+        );
+        check_zones("aisle IS NULL", ScalarQuery::IsNull());
+        // The refine is kept when combined with other filters
+        check(
+            &index_info,
+            "aisle = 3 AND size > 30",
+            Some(
+                IndexedExpression::index_query(
+                    "aisle".to_string(),
+                    ScalarQuery::Equals(ScalarValue::UInt32(Some(3))),
+                )
+                .refine(parse_expr("aisle = 3"))
+                .refine(parse_expr("size > 30")),
+            ),
+        );
+
+        // Zones that might match can't be negated
+        check_no_index(&index_info, "aisle != 3");
+        check_no_index(&index_info, "aisle NOT IN (5, 10)");
+        check_no_index(&index_info, "aisle NOT BETWEEN 5 AND 10");
+        check_no_index(&index_info, "aisle IS NOT NULL");
+    }
+
+    #[test]
+    fn test_substring_expressions() {
+        let index_info = MockIndexInfoProvider::new(vec![
+            ("color", DataType::Utf8),
+            ("aisle", DataType::UInt32),
+        ])
+        .with_index_type("color", ScalarIndexType::NGram);
+
+        let check_contains = |expr: &str, substrings: &[&str]| {
+            check(
+                &index_info,
+                expr,
+                Some(
+                    IndexedExpression::index_query(
+                        "color".to_string(),
+                        ScalarQuery::ContainsCandidates(
+                            substrings.iter().map(|s| s.to_string()).collect(),
+                        ),
+                    )
+                    .refine(parse_expr(expr)),
+                ),
+            );
+        };
+
+        check_contains("color LIKE '%blue%'", &["blue"]);
+        check_contains("color ILIKE 'dark%blue_green'", &["dark", "blue", "green"]);
+        // Runs shorter than an ngram are dropped and escaped wildcards are literals
+        check_contains("color LIKE '%ab%100\\%%'", &["100%"]);
+        check_contains("color ~ 'navy.*blue'", &["navy", "blue"]);
+        check_contains("color ~* '^light(er)? greys?$'", &["light", " grey"]);
+        check_contains("color ~ 'te[ae]l+ish'", &["ish"]);
+
+        // Nothing long enough to search for
+        check_no_index(&index_info, "color LIKE '%bl%'");
+        // Negations and alternations would match nearly everything
+        check_no_index(&index_info, "color NOT LIKE '%blue%'");
+        check_no_index(&index_info, "color ~ 'navy|blue'");
+        // An ngram index cannot answer exact queries
+        check_no_index(&index_info, "color = 'blue'");
+        // Only ngram indices can answer substring queries
+        check_no_index(&index_info, "CAST(aisle AS VARCHAR) LIKE '%123%'");
+    }
 }
@@ -14,8 +14,9 @@ use datafusion::physical_plan::SendableRecordBatchStream;
 use datafusion_physical_expr::expressions::{in_list, lit, Column};
 use deepsize::DeepSizeOf;
 use lance_core::utils::address::RowAddress;
-use lance_core::Result;
+use lance_core::{Error, Result};
 use roaring::RoaringBitmap;
+use snafu::{location, Location};
 
 use crate::{Index, IndexType};
 
@@ -188,6 +189,16 @@ impl ScalarIndex for FlatIndex {
         let predicate = match query {
             ScalarQuery::Equals(value) => arrow_ord::cmp::eq(self.values(), &value.to_scalar()?)?,
             ScalarQuery::IsNull() => arrow::compute::is_null(self.values())?,
+            ScalarQuery::FullTextSearch(_)
+            | ScalarQuery::ContainsCandidates(_)
+            | ScalarQuery::HasAnyLabel(_)
+            | ScalarQuery::HasAllLabels(_) => {
+                return Err(Error::NotSupported {
+                    source: "a flat index can only answer comparison, IN and IS NULL queries"
+                        .into(),
+                    location: location!(),
+                })
+            }
             ScalarQuery::IsIn(values) => {
                 let choices = values
                     .iter()
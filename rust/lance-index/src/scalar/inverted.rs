@@ -0,0 +1,898 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! An inverted index for full text search
+//!
+//! Documents are split into tokens and, for every token, the index keeps a posting list with
+//! the row ids of the documents that contain the token and the number of times the token
+//! appears in each document.  Queries are ranked with BM25 and the top-k documents are found
+//! with block-max WAND which skips over documents (and whole blocks of postings) that cannot
+//! make it into the results.
+
+use std::{
+    any::Any,
+    cmp::{Ordering, Reverse},
+    collections::{BinaryHeap, HashMap, HashSet},
+    sync::Arc,
+};
+
+use arrow_array::{
+    builder::{BinaryBuilder, StringBuilder},
+    cast::AsArray,
+    types::{UInt32Type, UInt64Type},
+    Array, RecordBatch, UInt32Array, UInt64Array,
+};
+use arrow_schema::{DataType, Field, Schema};
+use async_trait::async_trait;
+use datafusion::physical_plan::SendableRecordBatchStream;
+use deepsize::DeepSizeOf;
+use futures::TryStreamExt;
+use lance_core::{utils::mask::RowIdTreeMap, Error, Result};
+use roaring::RoaringBitmap;
+use serde::Serialize;
+use snafu::{location, Location};
+
+use crate::{Index, IndexType};
+
+use super::{FullTextSearchQuery, IndexStore, ScalarIndex, ScalarQuery};
+
+pub const INVERTED_POSTINGS_NAME: &str = "inverted_postings.lance";
+pub const INVERTED_DOCS_NAME: &str = "inverted_docs.lance";
+
+/// The name of the column with the BM25 score in full text search results
+pub const SCORE_COL: &str = "_score";
+
+// BM25 parameters, these are the values most search engines default to
+const BM25_K1: f32 = 1.2;
+const BM25_B: f32 = 0.75;
+
+// The number of postings summarized by a single block-max score
+const POSTING_BLOCK_SIZE: usize = 128;
+
+/// Splits text into lowercase tokens
+///
+/// Tokens are maximal runs of alphanumeric characters.  The same tokenizer is used for
+/// documents and queries.
+pub fn tokenize(text: &str) -> impl Iterator<Item = String> + '_ {
+    text.split(|c: char| !c.is_alphanumeric())
+        .filter(|token| !token.is_empty())
+        .map(|token| token.to_lowercase())
+}
+
+fn encode_varint(mut value: u64, buf: &mut Vec<u8>) {
+    while value >= 0x80 {
+        buf.push((value as u8) | 0x80);
+        value >>= 7;
+    }
+    buf.push(value as u8);
+}
+
+fn decode_varint(buf: &[u8], pos: &mut usize) -> Result<u64> {
+    let mut value = 0_u64;
+    let mut shift = 0;
+    loop {
+        let byte = *buf.get(*pos).ok_or_else(|| Error::Internal {
+            message: "inverted index posting list was truncated".into(),
+            location: location!(),
+        })?;
+        *pos += 1;
+        value |= ((byte & 0x7F) as u64) << shift;
+        if byte & 0x80 == 0 {
+            return Ok(value);
+        }
+        shift += 7;
+    }
+}
+
+/// The documents that contain a single token, sorted by row id
+#[derive(Debug, Clone, Default, DeepSizeOf)]
+struct PostingList {
+    row_ids: Vec<u64>,
+    frequencies: Vec<u32>,
+    // The highest (idf-less) BM25 score in each block of POSTING_BLOCK_SIZE postings
+    block_max_scores: Vec<f32>,
+    max_score: f32,
+}
+
+impl PostingList {
+    /// Posting lists are stored as delta encoded row ids and frequencies, both as varints
+    fn encode(&self) -> (Vec<u8>, Vec<u8>) {
+        let mut row_ids = Vec::with_capacity(self.row_ids.len() * 2);
+        let mut last_row_id = 0;
+        for row_id in &self.row_ids {
+            encode_varint(row_id - last_row_id, &mut row_ids);
+            last_row_id = *row_id;
+        }
+        let mut frequencies = Vec::with_capacity(self.frequencies.len());
+        for frequency in &self.frequencies {
+            encode_varint(*frequency as u64, &mut frequencies);
+        }
+        (row_ids, frequencies)
+    }
+
+    fn decode(num_docs: usize, row_ids_buf: &[u8], frequencies_buf: &[u8]) -> Result<Self> {
+        let mut row_ids = Vec::with_capacity(num_docs);
+        let mut frequencies = Vec::with_capacity(num_docs);
+        let mut last_row_id = 0;
+        let (mut row_ids_pos, mut frequencies_pos) = (0, 0);
+        for _ in 0..num_docs {
+            last_row_id += decode_varint(row_ids_buf, &mut row_ids_pos)?;
+            row_ids.push(last_row_id);
+            frequencies.push(decode_varint(frequencies_buf, &mut frequencies_pos)? as u32);
+        }
+        Ok(Self {
+            row_ids,
+            frequencies,
+            ..Default::default()
+        })
+    }
+
+    fn compute_block_max_scores(&mut self, docs: &DocSet) {
+        self.block_max_scores = self
+            .row_ids
+            .chunks(POSTING_BLOCK_SIZE)
+            .zip(self.frequencies.chunks(POSTING_BLOCK_SIZE))
+            .map(|(row_ids, frequencies)| {
+                row_ids
+                    .iter()
+                    .zip(frequencies)
+                    .map(|(row_id, frequency)| docs.term_score(*row_id, *frequency))
+                    .fold(0.0, f32::max)
+            })
+            .collect();
+        self.max_score = self.block_max_scores.iter().copied().fold(0.0, f32::max);
+    }
+}
+
+/// The number of tokens in each indexed document
+#[derive(Debug, Clone, Default, DeepSizeOf)]
+struct DocSet {
+    num_tokens: HashMap<u64, u32>,
+    total_tokens: u64,
+}
+
+impl DocSet {
+    fn len(&self) -> usize {
+        self.num_tokens.len()
+    }
+
+    fn add(&mut self, row_id: u64, num_tokens: u32) {
+        self.num_tokens.insert(row_id, num_tokens);
+        self.total_tokens += num_tokens as u64;
+    }
+
+    fn avg_num_tokens(&self) -> f32 {
+        if self.num_tokens.is_empty() {
+            0.0
+        } else {
+            self.total_tokens as f32 / self.num_tokens.len() as f32
+        }
+    }
+
+    /// The part of the BM25 score that depends on the document (everything but the idf)
+    fn term_score(&self, row_id: u64, frequency: u32) -> f32 {
+        let doc_len = self.num_tokens.get(&row_id).copied().unwrap_or_default();
+        self.term_score_with_len(doc_len, frequency)
+    }
+
+    /// Like [`Self::term_score`] for a document with `doc_len` tokens that may not be indexed
+    fn term_score_with_len(&self, doc_len: u32, frequency: u32) -> f32 {
+        let doc_len = doc_len as f32;
+        let avg_len = self.avg_num_tokens().max(1.0);
+        let frequency = frequency as f32;
+        frequency * (BM25_K1 + 1.0)
+            / (frequency + BM25_K1 * (1.0 - BM25_B + BM25_B * doc_len / avg_len))
+    }
+
+    fn idf(&self, num_docs_with_token: usize) -> f32 {
+        let num_docs = self.len() as f32;
+        let num_docs_with_token = num_docs_with_token as f32;
+        (1.0 + (num_docs - num_docs_with_token + 0.5) / (num_docs_with_token + 0.5)).ln()
+    }
+}
+
+/// A cursor over a posting list used while searching
+struct PostingIterator<'a> {
+    list: &'a PostingList,
+    idf: f32,
+    position: usize,
+}
+
+impl<'a> PostingIterator<'a> {
+    fn doc(&self) -> Option<u64> {
+        self.list.row_ids.get(self.position).copied()
+    }
+
+    fn max_score(&self) -> f32 {
+        self.idf * self.list.max_score
+    }
+
+    fn block_max_score(&self) -> f32 {
+        self.idf * self.list.block_max_scores[self.position / POSTING_BLOCK_SIZE]
+    }
+
+    /// The last row id in the block that contains the current posting
+    fn block_last_doc(&self) -> u64 {
+        let block_end = (self.position / POSTING_BLOCK_SIZE + 1) * POSTING_BLOCK_SIZE;
+        self.list.row_ids[block_end.min(self.list.row_ids.len()) - 1]
+    }
+
+    fn score(&self, docs: &DocSet) -> f32 {
+        let (row_id, frequency) = (
+            self.list.row_ids[self.position],
+            self.list.frequencies[self.position],
+        );
+        self.idf * docs.term_score(row_id, frequency)
+    }
+
+    fn next(&mut self) {
+        self.position += 1;
+    }
+
+    /// Advance to the first posting with a row id >= `target`
+    fn seek(&mut self, target: u64) {
+        let remaining = &self.list.row_ids[self.position..];
+        self.position += remaining.partition_point(|row_id| *row_id < target);
+    }
+}
+
+struct ScoredDoc {
+    score: f32,
+    row_id: u64,
+}
+
+impl PartialEq for ScoredDoc {
+    fn eq(&self, other: &Self) -> bool {
+        self.cmp(other) == Ordering::Equal
+    }
+}
+
+impl Eq for ScoredDoc {}
+
+impl PartialOrd for ScoredDoc {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for ScoredDoc {
+    fn cmp(&self, other: &Self) -> Ordering {
+        self.score
+            .total_cmp(&other.score)
+            .then_with(|| other.row_id.cmp(&self.row_id))
+    }
+}
+
+/// A full text search index
+///
+/// The index is stored in two files.  The postings file has one row per token with the token,
+/// the number of documents that contain it, and the (compressed) posting list.  The docs file
+/// has the number of tokens in each document, which BM25 needs to normalize for length.
+#[derive(Clone, Debug)]
+pub struct InvertedIndex {
+    tokens: HashMap<String, usize>,
+    postings: Vec<PostingList>,
+    docs: DocSet,
+    store: Arc<dyn IndexStore>,
+}
+
+impl DeepSizeOf for InvertedIndex {
+    fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
+        self.tokens.deep_size_of_children(context)
+            + self.postings.deep_size_of_children(context)
+            + self.docs.deep_size_of_children(context)
+            + self.store.deep_size_of_children(context)
+    }
+}
+
+impl InvertedIndex {
+    /// The distinct tokens of a query, in the order they first appear
+    pub(crate) fn query_tokens(query: &str) -> Vec<String> {
+        let mut seen = HashSet::new();
+        tokenize(query)
+            .filter(|token| seen.insert(token.clone()))
+            .collect()
+    }
+
+    fn posting_iterators(&self, query: &str) -> Vec<PostingIterator<'_>> {
+        Self::query_tokens(query)
+            .iter()
+            .filter_map(|token| self.tokens.get(token))
+            .map(|token_id| {
+                let list = &self.postings[*token_id];
+                PostingIterator {
+                    list,
+                    idf: self.docs.idf(list.row_ids.len()),
+                    position: 0,
+                }
+            })
+            .collect()
+    }
+
+    /// Finds the `limit` documents with the highest BM25 score for `query`
+    ///
+    /// Returns the row ids and scores, sorted by descending score.  Documents that do not
+    /// contain any of the query tokens are never returned.
+    pub fn bm25_search(&self, query: &str, limit: usize) -> (Vec<u64>, Vec<f32>) {
+        self.bm25_search_filtered(query, limit, |_| true)
+    }
+
+    /// Like [`Self::bm25_search`] but only documents for which `filter` returns true are
+    /// considered (e.g. to skip deleted rows without returning fewer than `limit` results)
+    pub fn bm25_search_filtered(
+        &self,
+        query: &str,
+        limit: usize,
+        mut filter: impl FnMut(u64) -> bool,
+    ) -> (Vec<u64>, Vec<f32>) {
+        let mut iters = self.posting_iterators(query);
+        let mut top_k =
+            BinaryHeap::<Reverse<ScoredDoc>>::with_capacity(limit.min(self.docs.len()) + 1);
+        let threshold = |top_k: &BinaryHeap<Reverse<ScoredDoc>>| {
+            if top_k.len() < limit {
+                0.0
+            } else {
+                top_k.peek().map(|doc| doc.0.score).unwrap_or_default()
+            }
+        };
+
+        while limit > 0 {
+            iters.retain(|iter| iter.doc().is_some());
+            iters.sort_unstable_by_key(|iter| iter.doc());
+            let threshold = threshold(&top_k);
+
+            // Find the first document whose upper bound could beat the current threshold.  No
+            // document before it can make the top-k because only the preceding lists contain it.
+            let mut upper_bound = 0.0;
+            let Some(mut pivot) = iters.iter().position(|iter| {
+                upper_bound += iter.max_score();
+                upper_bound > threshold
+            }) else {
+                break;
+            };
+            let pivot_doc = iters[pivot].doc();
+            while pivot + 1 < iters.len() && iters[pivot + 1].doc() == pivot_doc {
+                pivot += 1;
+            }
+
+            if iters[0].doc() == pivot_doc {
+                // Every list up to the pivot is positioned on the pivot document.  The block
+                // maxes give a tighter bound which often lets us skip whole blocks at once.
+                let block_bound = iters[..=pivot]
+                    .iter()
+                    .map(|iter| iter.block_max_score())
+                    .sum::<f32>();
+                if block_bound <= threshold {
+                    // No document before the end of the current blocks can beat the threshold
+                    // (lists past the pivot only start later) so skip the rest of the blocks
+                    let mut target = iters[..=pivot]
+                        .iter()
+                        .map(|iter| iter.block_last_doc() + 1)
+                        .min()
+                        .unwrap();
+                    if let Some(next_doc) = iters.get(pivot + 1).and_then(|iter| iter.doc()) {
+                        target = target.min(next_doc);
+                    }
+                    iters[..=pivot]
+                        .iter_mut()
+                        .for_each(|iter| iter.seek(target));
+                    continue;
+                }
+                if filter(pivot_doc.unwrap()) {
+                    let score = iters[..=pivot]
+                        .iter()
+                        .map(|iter| iter.score(&self.docs))
+                        .sum::<f32>();
+                    if score > threshold {
+                        top_k.push(Reverse(ScoredDoc {
+                            score,
+                            row_id: pivot_doc.unwrap(),
+                        }));
+                        if top_k.len() > limit {
+                            top_k.pop();
+                        }
+                    }
+                }
+                iters[..=pivot].iter_mut().for_each(|iter| iter.next());
+            } else {
+                let target = pivot_doc.unwrap();
+                iters[..pivot].iter_mut().for_each(|iter| iter.seek(target));
+            }
+        }
+
+        top_k
+            .into_sorted_vec()
+            .into_iter()
+            .map(|doc| (doc.0.row_id, doc.0.score))
+            .unzip()
+    }
+
+    /// All documents that contain at least one of the query tokens
+    fn matching_row_ids(&self, query: &str) -> RowIdTreeMap {
+        let mut row_ids = RowIdTreeMap::default();
+        for iter in self.posting_iterators(query) {
+            row_ids.extend(iter.list.row_ids.iter().copied());
+        }
+        row_ids
+    }
+
+    /// A scorer for documents that are not in the index (e.g. rows appended after it was
+    /// trained)
+    ///
+    /// The scores use the statistics of the indexed documents so they can be compared with
+    /// the scores returned by [`Self::bm25_search`].
+    pub fn unindexed_scorer(&self, query: &str) -> UnindexedScorer<'_> {
+        let tokens = Self::query_tokens(query)
+            .into_iter()
+            .map(|token| {
+                let num_docs = self
+                    .tokens
+                    .get(&token)
+                    .map(|token_id| self.postings[*token_id].row_ids.len())
+                    .unwrap_or_default();
+                (token, self.docs.idf(num_docs))
+            })
+            .collect();
+        UnindexedScorer {
+            docs: &self.docs,
+            tokens,
+        }
+    }
+
+    fn search_full_text(&self, query: &FullTextSearchQuery) -> RowIdTreeMap {
+        match query.limit {
+            Some(limit) => RowIdTreeMap::from_iter(self.bm25_search(&query.query, limit).0),
+            None => self.matching_row_ids(&query.query),
+        }
+    }
+
+    fn try_from_serialized(
+        postings: RecordBatch,
+        docs: RecordBatch,
+        store: Arc<dyn IndexStore>,
+    ) -> Result<Self> {
+        let doc_row_ids = docs.column(0).as_primitive::<UInt64Type>();
+        let doc_num_tokens = docs.column(1).as_primitive::<UInt32Type>();
+        let mut doc_set = DocSet::default();
+        for (row_id, num_tokens) in doc_row_ids.values().iter().zip(doc_num_tokens.values()) {
+            doc_set.add(*row_id, *num_tokens);
+        }
+
+        let tokens_arr = postings.column(0).as_string::<i32>();
+        let num_docs = postings.column(1).as_primitive::<UInt32Type>();
+        let row_ids = postings.column(2).as_binary::<i32>();
+        let frequencies = postings.column(3).as_binary::<i32>();
+        let mut tokens = HashMap::with_capacity(postings.num_rows());
+        let mut posting_lists = Vec::with_capacity(postings.num_rows());
+        for idx in 0..postings.num_rows() {
+            let mut list = PostingList::decode(
+                num_docs.value(idx) as usize,
+                row_ids.value(idx),
+                frequencies.value(idx),
+            )?;
+            list.compute_block_max_scores(&doc_set);
+            tokens.insert(tokens_arr.value(idx).to_string(), idx);
+            posting_lists.push(list);
+        }
+
+        Ok(Self {
+            tokens,
+            postings: posting_lists,
+            docs: doc_set,
+            store,
+        })
+    }
+
+    fn into_builder(self) -> InvertedIndexBuilder {
+        let mut builder = InvertedIndexBuilder::default();
+        for (token, token_id) in self.tokens {
+            let list = &self.postings[token_id];
+            builder.postings.insert(
+                token,
+                list.row_ids
+                    .iter()
+                    .copied()
+                    .zip(list.frequencies.iter().copied())
+                    .collect(),
+            );
+        }
+        builder.docs = self.docs;
+        builder
+    }
+}
+
+/// Scores documents that are not in an [`InvertedIndex`] with BM25
+///
+/// See [`InvertedIndex::unindexed_scorer`]
+pub struct UnindexedScorer<'a> {
+    docs: &'a DocSet,
+    /// The idf of each distinct query token
+    tokens: HashMap<String, f32>,
+}
+
+impl UnindexedScorer<'_> {
+    /// The BM25 score of `text`, 0 if it does not contain any of the query tokens
+    pub fn score(&self, text: &str) -> f32 {
+        let mut num_tokens = 0;
+        let mut frequencies = HashMap::<String, u32>::new();
+        for token in tokenize(text) {
+            num_tokens += 1;
+            if self.tokens.contains_key(&token) {
+                *frequencies.entry(token).or_default() += 1;
+            }
+        }
+        frequencies
+            .iter()
+            .map(|(token, frequency)| {
+                self.tokens[token] * self.docs.term_score_with_len(num_tokens, *frequency)
+            })
+            .sum()
+    }
+}
+
+#[derive(Serialize)]
+struct InvertedStatistics {
+    num_tokens: usize,
+    num_docs: usize,
+}
+
+#[async_trait]
+impl Index for InvertedIndex {
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn as_index(self: Arc<Self>) -> Arc<dyn Index> {
+        self
+    }
+
+    fn index_type(&self) -> IndexType {
+        IndexType::Scalar
+    }
+
+    fn statistics(&self) -> Result<serde_json::Value> {
+        serde_json::to_value(&InvertedStatistics {
+            num_tokens: self.tokens.len(),
+            num_docs: self.docs.len(),
+        })
+        .map_err(|err| err.into())
+    }
+
+    async fn calculate_included_frags(&self) -> Result<RoaringBitmap> {
+        Ok(RoaringBitmap::from_iter(
+            self.docs
+                .num_tokens
+                .keys()
+                .map(|row_id| (row_id >> 32) as u32),
+        ))
+    }
+}
+
+#[async_trait]
+impl ScalarIndex for InvertedIndex {
+    async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
+        let row_ids = self.search_row_ids(query).await?;
+        let row_ids = row_ids.row_ids().ok_or_else(|| Error::Internal {
+            message: "inverted index unexpectedly matched an entire fragment".into(),
+            location: location!(),
+        })?;
+        Ok(UInt64Array::from_iter_values(row_ids.map(u64::from)))
+    }
+
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        match query {
+            ScalarQuery::FullTextSearch(query) => Ok(self.search_full_text(query)),
+            _ => Err(Error::NotSupported {
+                source: format!(
+                    "an inverted index can only answer full text queries, not {:?}",
+                    query
+                )
+                .into(),
+                location: location!(),
+            }),
+        }
+    }
+
+    async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>> {
+        let postings_file = store.open_index_file(INVERTED_POSTINGS_NAME).await?;
+        let docs_file = store.open_index_file(INVERTED_DOCS_NAME).await?;
+        let postings = postings_file.read_record_batch(0).await?;
+        let docs = docs_file.read_record_batch(0).await?;
+        Ok(Arc::new(Self::try_from_serialized(postings, docs, store)?))
+    }
+
+    async fn remap(
+        &self,
+        mapping: &HashMap<u64, Option<u64>>,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let remap_row_id = |row_id: u64| mapping.get(&row_id).copied().unwrap_or(Some(row_id));
+        let mut builder = InvertedIndexBuilder::default();
+        for (token, token_id) in &self.tokens {
+            let list = &self.postings[*token_id];
+            let remapped = list
+                .row_ids
+                .iter()
+                .zip(list.frequencies.iter())
+                .filter_map(|(row_id, frequency)| {
+                    remap_row_id(*row_id).map(|row_id| (row_id, *frequency))
+                })
+                .collect::<Vec<_>>();
+            if !remapped.is_empty() {
+                builder.postings.insert(token.clone(), remapped);
+            }
+        }
+        for (row_id, num_tokens) in &self.docs.num_tokens {
+            if let Some(row_id) = remap_row_id(*row_id) {
+                builder.docs.add(row_id, *num_tokens);
+            }
+        }
+        builder.write(dest_store).await
+    }
+
+    async fn update(
+        &self,
+        new_data: SendableRecordBatchStream,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let mut builder = self.clone().into_builder();
+        builder.add_stream(new_data).await?;
+        builder.write(dest_store).await
+    }
+}
+
+/// Accumulates the posting lists of an inverted index in memory before writing them out
+#[derive(Default)]
+struct InvertedIndexBuilder {
+    // token -> (row id, frequency), not necessarily sorted
+    postings: HashMap<String, Vec<(u64, u32)>>,
+    docs: DocSet,
+}
+
+impl InvertedIndexBuilder {
+    fn add_batch(&mut self, batch: &RecordBatch) -> Result<()> {
+        debug_assert_eq!(batch.num_columns(), 2);
+        let docs = batch.column(0);
+        let docs = match docs.data_type() {
+            DataType::Utf8 => docs.as_string::<i32>().iter().collect::<Vec<_>>(),
+            DataType::LargeUtf8 => docs.as_string::<i64>().iter().collect::<Vec<_>>(),
+            data_type => {
+                return Err(Error::InvalidInput {
+                    source: format!(
+                        "an inverted index can only be built on string columns, not {}",
+                        data_type
+                    )
+                    .into(),
+                    location: location!(),
+                })
+            }
+        };
+        let row_ids = batch.column(1).as_primitive::<UInt64Type>();
+
+        let mut frequencies = HashMap::new();
+        for (doc, row_id) in docs.into_iter().zip(row_ids.values().iter()) {
+            // Null documents have no tokens and are not indexed
+            let Some(doc) = doc else {
+                continue;
+            };
+            let mut num_tokens = 0;
+            for token in tokenize(doc) {
+                *frequencies.entry(token).or_insert(0_u32) += 1;
+                num_tokens += 1;
+            }
+            for (token, frequency) in frequencies.drain() {
+                self.postings
+                    .entry(token)
+                    .or_default()
+                    .push((*row_id, frequency));
+            }
+            self.docs.add(*row_id, num_tokens);
+        }
+        Ok(())
+    }
+
+    async fn add_stream(&mut self, mut data: SendableRecordBatchStream) -> Result<()> {
+        while let Some(batch) = data.try_next().await? {
+            self.add_batch(&batch)?;
+        }
+        Ok(())
+    }
+
+    async fn write(self, index_store: &dyn IndexStore) -> Result<()> {
+        let mut tokens = self.postings.into_iter().collect::<Vec<_>>();
+        tokens.sort_unstable_by(|(left, _), (right, _)| left.cmp(right));
+
+        let mut token_builder = StringBuilder::new();
+        let mut num_docs = Vec::with_capacity(tokens.len());
+        let mut row_ids_builder = BinaryBuilder::new();
+        let mut frequencies_builder = BinaryBuilder::new();
+        for (token, mut postings) in tokens {
+            postings.sort_unstable_by_key(|(row_id, _)| *row_id);
+            let (row_ids, frequencies) = postings.into_iter().unzip();
+            let list = PostingList {
+                row_ids,
+                frequencies,
+                ..Default::default()
+            };
+            let (row_ids, frequencies) = list.encode();
+            token_builder.append_value(token);
+            num_docs.push(list.row_ids.len() as u32);
+            row_ids_builder.append_value(row_ids);
+            frequencies_builder.append_value(frequencies);
+        }
+        let postings_schema = Arc::new(Schema::new(vec![
+            Field::new("tokens", DataType::Utf8, false),
+            Field::new("num_docs", DataType::UInt32, false),
+            Field::new("row_ids", DataType::Binary, false),
+            Field::new("frequencies", DataType::Binary, false),
+        ]));
+        let postings = RecordBatch::try_new(
+            postings_schema.clone(),
+            vec![
+                Arc::new(token_builder.finish()),
+                Arc::new(UInt32Array::from(num_docs)),
+                Arc::new(row_ids_builder.finish()),
+                Arc::new(frequencies_builder.finish()),
+            ],
+        )?;
+
+        let mut docs = self.docs.num_tokens.into_iter().collect::<Vec<_>>();
+        docs.sort_unstable();
+        let (doc_row_ids, doc_num_tokens): (Vec<_>, Vec<_>) = docs.into_iter().unzip();
+        let docs_schema = Arc::new(Schema::new(vec![
+            Field::new("row_ids", DataType::UInt64, false),
+            Field::new("num_tokens", DataType::UInt32, false),
+        ]));
+        let docs = RecordBatch::try_new(
+            docs_schema.clone(),
+            vec![
+                Arc::new(UInt64Array::from(doc_row_ids)),
+                Arc::new(UInt32Array::from(doc_num_tokens)),
+            ],
+        )?;
+
+        let mut postings_file = index_store
+            .new_index_file(INVERTED_POSTINGS_NAME, postings_schema)
+            .await?;
+        postings_file.write_record_batch(postings).await?;
+        postings_file.finish().await?;
+
+        let mut docs_file = index_store
+            .new_index_file(INVERTED_DOCS_NAME, docs_schema)
+            .await?;
+        docs_file.write_record_batch(docs).await?;
+        docs_file.finish().await
+    }
+}
+
+/// Trains an inverted index from a stream of documents and row ids
+///
+/// The stream must have two columns.  The first column has the documents (Utf8 or LargeUtf8)
+/// and may have any name.  The second column must be the row ids (UInt64).  The data does
+/// not need to be sorted.
+pub async fn train_inverted_index(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+) -> Result<()> {
+    let mut builder = InvertedIndexBuilder::default();
+    builder.add_stream(data).await?;
+    builder.write(index_store).await
+}
+
+#[cfg(test)]
+mod tests {
+    use arrow_array::StringArray;
+    use lance_io::object_store::ObjectStore;
+
+    use crate::scalar::lance_format::LanceIndexStore;
+
+    use super::*;
+
+    #[test]
+    fn test_tokenize() {
+        let tokens = tokenize("Hello, World! It's 2024-ish.").collect::<Vec<_>>();
+        assert_eq!(tokens, vec!["hello", "world", "it", "s", "2024", "ish"]);
+    }
+
+    #[test]
+    fn test_posting_list_round_trip() {
+        let list = PostingList {
+            row_ids: vec![0, 5, 300, 1 << 32, (1 << 32) + 7],
+            frequencies: vec![1, 2, 1000, 1, 3],
+            ..Default::default()
+        };
+        let (row_ids, frequencies) = list.encode();
+        let decoded = PostingList::decode(5, &row_ids, &frequencies).unwrap();
+        assert_eq!(decoded.row_ids, list.row_ids);
+        assert_eq!(decoded.frequencies, list.frequencies);
+    }
+
+    /// Scores every document, the answer WAND must agree with
+    fn exhaustive_scores(
+        index: &InvertedIndex,
+        query: &str,
+        limit: usize,
+        filter: impl Fn(u64) -> bool,
+    ) -> Vec<f32> {
+        let mut scores = HashMap::<u64, f32>::new();
+        for iter in index.posting_iterators(query) {
+            for (row_id, frequency) in iter.list.row_ids.iter().zip(&iter.list.frequencies) {
+                *scores.entry(*row_id).or_default() +=
+                    iter.idf * index.docs.term_score(*row_id, *frequency);
+            }
+        }
+        let mut scores = scores
+            .into_iter()
+            .filter(|(row_id, _)| filter(*row_id))
+            .map(|(_, score)| score)
+            .collect::<Vec<_>>();
+        scores.sort_unstable_by(|left, right| right.total_cmp(left));
+        scores.truncate(limit);
+        scores
+    }
+
+    #[tokio::test]
+    async fn test_bm25_search_matches_exhaustive() {
+        let tempdir = tempfile::tempdir().unwrap();
+        let (object_store, path) =
+            ObjectStore::from_path(tempdir.path().as_os_str().to_str().unwrap()).unwrap();
+        let store: Arc<dyn IndexStore> = Arc::new(LanceIndexStore::new(object_store, path, None));
+
+        // Enough documents that every common token spans many posting blocks
+        let docs = (0..5000_u64)
+            .map(|i| {
+                let mut doc = format!("common filler{}", i % 13);
+                if i % 97 == 0 {
+                    doc.push_str(" rare");
+                }
+                for _ in 0..(i % 7) {
+                    doc.push_str(" mid");
+                }
+                doc
+            })
+            .collect::<Vec<_>>();
+        let batch = RecordBatch::try_new(
+            Arc::new(Schema::new(vec![
+                Field::new("text", DataType::Utf8, false),
+                Field::new("row_ids", DataType::UInt64, false),
+            ])),
+            vec![
+                Arc::new(StringArray::from(docs.clone())),
+                Arc::new(UInt64Array::from_iter_values(0..5000)),
+            ],
+        )
+        .unwrap();
+        let mut builder = InvertedIndexBuilder::default();
+        builder.add_batch(&batch).unwrap();
+        builder.write(store.as_ref()).await.unwrap();
+        let index = InvertedIndex::load(store).await.unwrap();
+
+        for query in ["common rare mid", "rare", "mid filler3", "common"] {
+            for limit in [1, 10, 100] {
+                let (_, scores) = index.bm25_search(query, limit);
+                let expected = exhaustive_scores(&index, query, limit, |_| true);
+                assert_eq!(scores.len(), expected.len());
+                for (score, expected) in scores.iter().zip(&expected) {
+                    assert!((score - expected).abs() < 1e-4, "{} {}", score, expected);
+                }
+
+                // Scoring the text of the indexed documents from scratch gives the same scores
+                let (row_ids, scores) = index.bm25_search(query, limit);
+                let scorer = index.unindexed_scorer(query);
+                for (row_id, score) in row_ids.iter().zip(&scores) {
+                    let rescored = scorer.score(docs[*row_id as usize].as_str());
+                    assert!((rescored - score).abs() < 1e-4, "{} {}", rescored, score);
+                }
+
+                let (row_ids, scores) =
+                    index.bm25_search_filtered(query, limit, |row_id| row_id % 3 == 0);
+                assert!(row_ids.iter().all(|row_id| row_id % 3 == 0));
+                let expected = exhaustive_scores(&index, query, limit, |row_id| row_id % 3 == 0);
+                assert_eq!(scores.len(), expected.len());
+                for (score, expected) in scores.iter().zip(&expected) {
+                    assert!((score - expected).abs() < 1e-4, "{} {}", score, expected);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+use std::{any::Any, collections::HashMap, sync::Arc};
+
+use arrow_array::{cast::AsArray, types::UInt64Type, Array, RecordBatch, UInt64Array};
+use arrow_schema::{DataType, Field, Schema};
+use async_trait::async_trait;
+use datafusion::physical_plan::{stream::RecordBatchStreamAdapter, SendableRecordBatchStream};
+use datafusion_common::ScalarValue;
+use deepsize::DeepSizeOf;
+use futures::StreamExt;
+use lance_core::{utils::mask::RowIdTreeMap, Error, Result};
+use roaring::RoaringBitmap;
+use snafu::{location, Location};
+
+use crate::{Index, IndexType};
+
+use super::{
+    bitmap::{train_bitmap_index_to, BitmapIndex},
+    IndexStore, ScalarIndex, ScalarQuery,
+};
+
+pub const LABEL_LIST_LOOKUP_NAME: &str = "label_list_lookup.lance";
+
+/// A scalar index on a list column that stores a bitmap of row ids for each distinct element
+///
+/// This answers "does the list contain any / all of these values" filters (e.g. on a tags
+/// column) by combining the bitmaps of the requested values instead of scanning every list.
+/// The bitmaps are stored as a bitmap index over the unnested list elements.
+#[derive(Clone, Debug, DeepSizeOf)]
+pub struct LabelListIndex {
+    values_index: Arc<BitmapIndex>,
+}
+
+impl LabelListIndex {
+    async fn search_values(&self, values: &[ScalarValue]) -> Result<Vec<RowIdTreeMap>> {
+        let mut bitmaps = Vec::with_capacity(values.len());
+        for value in values {
+            bitmaps.push(
+                self.values_index
+                    .search_row_ids(&ScalarQuery::Equals(value.clone()))
+                    .await?,
+            );
+        }
+        Ok(bitmaps)
+    }
+}
+
+#[async_trait]
+impl Index for LabelListIndex {
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn as_index(self: Arc<Self>) -> Arc<dyn Index> {
+        self
+    }
+
+    fn index_type(&self) -> IndexType {
+        IndexType::Scalar
+    }
+
+    fn statistics(&self) -> Result<serde_json::Value> {
+        self.values_index.statistics()
+    }
+
+    async fn calculate_included_frags(&self) -> Result<RoaringBitmap> {
+        self.values_index.calculate_included_frags().await
+    }
+}
+
+#[async_trait]
+impl ScalarIndex for LabelListIndex {
+    async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
+        let row_ids = self.search_row_ids(query).await?;
+        let row_ids = row_ids.row_ids().ok_or_else(|| Error::Internal {
+            message: "label list index unexpectedly contained an entire fragment".into(),
+            location: location!(),
+        })?;
+        Ok(UInt64Array::from_iter_values(row_ids.map(u64::from)))
+    }
+
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        match query {
+            ScalarQuery::HasAnyLabel(labels) => {
+                self.values_index
+                    .search_row_ids(&ScalarQuery::IsIn(labels.clone()))
+                    .await
+            }
+            ScalarQuery::HasAllLabels(labels) => Ok(self
+                .search_values(labels)
+                .await?
+                .into_iter()
+                .reduce(|acc, bitmap| acc & bitmap)
+                .unwrap_or_default()),
+            _ => Err(Error::NotSupported {
+                source: "a label list index can only answer has any / has all queries".into(),
+                location: location!(),
+            }),
+        }
+    }
+
+    async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>> {
+        let values_index = BitmapIndex::load_from(store, LABEL_LIST_LOOKUP_NAME).await?;
+        Ok(Arc::new(Self { values_index }))
+    }
+
+    async fn remap(
+        &self,
+        mapping: &HashMap<u64, Option<u64>>,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        self.values_index.remap(mapping, dest_store).await
+    }
+
+    async fn update(
+        &self,
+        new_data: SendableRecordBatchStream,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        self.values_index
+            .update(unnest_lists(new_data)?, dest_store)
+            .await
+    }
+}
+
+// Converts a batch of (list, row id) into a batch of (element, row id) with one row per
+// element.  Null lists have no elements.
+fn unnest_batch(batch: &RecordBatch, schema: Arc<Schema>) -> Result<RecordBatch> {
+    let lists = batch.column(0);
+    let (values, offsets) = match lists.data_type() {
+        DataType::List(_) => {
+            let lists = lists.as_list::<i32>();
+            let offsets = lists
+                .offsets()
+                .iter()
+                .map(|offset| *offset as u64)
+                .collect::<Vec<_>>();
+            (lists.values().clone(), offsets)
+        }
+        DataType::LargeList(_) => {
+            let lists = lists.as_list::<i64>();
+            let offsets = lists
+                .offsets()
+                .iter()
+                .map(|offset| *offset as u64)
+                .collect::<Vec<_>>();
+            (lists.values().clone(), offsets)
+        }
+        data_type => {
+            return Err(Error::InvalidInput {
+                source: format!(
+                    "a label list index can only be built on list columns, not {}",
+                    data_type
+                )
+                .into(),
+                location: location!(),
+            })
+        }
+    };
+    let row_ids = batch.column(1).as_primitive::<UInt64Type>();
+
+    let mut value_indices = Vec::with_capacity(values.len());
+    let mut value_row_ids = Vec::with_capacity(values.len());
+    for (idx, row_id) in row_ids.values().iter().enumerate() {
+        if lists.is_null(idx) {
+            continue;
+        }
+        for value_idx in offsets[idx]..offsets[idx + 1] {
+            value_indices.push(value_idx);
+            value_row_ids.push(*row_id);
+        }
+    }
+    let values = arrow_select::take::take(&values, &UInt64Array::from(value_indices), None)?;
+    Ok(RecordBatch::try_new(
+        schema,
+        vec![values, Arc::new(UInt64Array::from(value_row_ids))],
+    )?)
+}
+
+fn unnest_lists(data: SendableRecordBatchStream) -> Result<SendableRecordBatchStream> {
+    let value_type = match data.schema().field(0).data_type() {
+        DataType::List(item) | DataType::LargeList(item) => item.data_type().clone(),
+        data_type => {
+            return Err(Error::InvalidInput {
+                source: format!(
+                    "a label list index can only be built on list columns, not {}",
+                    data_type
+                )
+                .into(),
+                location: location!(),
+            })
+        }
+    };
+    let schema = Arc::new(Schema::new(vec![
+        Field::new("values", value_type, true),
+        Field::new("row_ids", DataType::UInt64, false),
+    ]));
+    let unnested_schema = schema.clone();
+    let unnested = data.map(move |batch| -> datafusion_common::Result<RecordBatch> {
+        let batch = batch?;
+        Ok(unnest_batch(&batch, unnested_schema.clone())?)
+    });
+    Ok(Box::pin(RecordBatchStreamAdapter::new(schema, unnested)))
+}
+
+/// Trains a label list index from a stream of lists and row ids
+///
+/// The stream must have two columns.  The first column has the lists to index (List or
+/// LargeList of any scalar type) and may have any name.  The second column must be the row
+/// ids (UInt64).  The data does not need to be sorted.
+pub async fn train_label_list_index(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+) -> Result<()> {
+    train_bitmap_index_to(unnest_lists(data)?, index_store, LABEL_LIST_LOOKUP_NAME).await
+}
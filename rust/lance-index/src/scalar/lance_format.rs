@@ -15,12 +15,15 @@ use lance_file::{
 };
 use snafu::{location, Location};
 
-use lance_core::{cache::FileMetadataCache, Error, Result};
+use lance_core::{
+    cache::{FileMetadataCache, IndexPageCache},
+    Error, Result,
+};
 use lance_io::{object_store::ObjectStore, ReadBatchParams};
 use lance_table::{format::SelfDescribingFileReader, io::manifest::ManifestDescribing};
 use object_store::path::Path;
 
-use super::{IndexReader, IndexStore, IndexWriter};
+use super::{IndexReader, IndexStore, IndexWriter, ScalarIndex};
 
 /// An index store that serializes scalar indices using the lance format
 ///
@@ -32,6 +35,7 @@ pub struct LanceIndexStore {
     object_store: ObjectStore,
     index_dir: Path,
     metadata_cache: Option<FileMetadataCache>,
+    page_cache: Option<IndexPageCache>,
 }
 
 impl DeepSizeOf for LanceIndexStore {
@@ -53,8 +57,17 @@ impl LanceIndexStore {
             object_store,
             index_dir,
             metadata_cache,
+            page_cache: None,
         }
     }
+
+    /// Cache loaded index pages in `page_cache`
+    ///
+    /// The cache is shared and not counted in the size of this store
+    pub fn with_page_cache(mut self, page_cache: IndexPageCache) -> Self {
+        self.page_cache = Some(page_cache);
+        self
+    }
 }
 
 #[async_trait]
@@ -150,24 +163,47 @@ impl IndexStore for LanceIndexStore {
             Ok(())
         }
     }
+
+    fn cached_page(&self, name: &str, page: u32) -> Option<Arc<dyn ScalarIndex>> {
+        let page_cache = self.page_cache.as_ref()?;
+        page_cache
+            .get::<Arc<dyn ScalarIndex>>(&self.index_dir.child(name), page)
+            .map(|page_index| page_index.as_ref().clone())
+    }
+
+    fn cache_page(&self, name: &str, page: u32, page_index: Arc<dyn ScalarIndex>) {
+        if let Some(page_cache) = &self.page_cache {
+            page_cache.insert(self.index_dir.child(name), page, Arc::new(page_index));
+        }
+    }
 }
 
 #[cfg(test)]
 mod tests {
 
-    use std::{ops::Bound, path::Path};
+    use std::{collections::HashMap, ops::Bound, path::Path};
 
     use crate::scalar::{
-        btree::{train_btree_index, BTreeIndex, BtreeTrainingSource},
+        bitmap::{train_bitmap_index, BitmapIndex},
+        btree::{
+            train_btree_index, train_btree_index_with_options, BTreeIndex, BTreeTrainingOptions,
+            BtreeTrainingSource,
+        },
         flat::FlatIndexMetadata,
-        ScalarIndex, ScalarQuery,
+        inverted::{train_inverted_index, InvertedIndex},
+        label_list::{train_label_list_index, LabelListIndex},
+        ngram::{train_ngram_index, NGramIndex},
+        zonemap::{train_zone_map_index, ZoneMapIndex},
+        FullTextSearchQuery, ScalarIndex, ScalarQuery,
     };
 
     use super::*;
+    use crate::Index;
     use arrow_array::{
         cast::AsArray,
         types::{Float32Type, Int32Type, UInt64Type},
-        RecordBatchIterator, RecordBatchReader, UInt64Array,
+        Array, Int32Array, ListArray, RecordBatchIterator, RecordBatchReader, StringArray,
+        UInt64Array,
     };
     use arrow_schema::{DataType, Field, TimeUnit};
     use arrow_select::take::TakeOptions;
@@ -301,6 +337,91 @@ mod tests {
         );
     }
 
+    #[tokio::test]
+    async fn test_btree_bloom_filters_and_page_cache() {
+        let tempdir = tempdir().unwrap();
+        let (object_store, path) =
+            ObjectStore::from_path(tempdir.path().as_os_str().to_str().unwrap()).unwrap();
+        let page_cache = IndexPageCache::new(64 * 1024 * 1024);
+        let index_store: Arc<dyn IndexStore> = Arc::new(
+            LanceIndexStore::new(object_store, path, None).with_page_cache(page_cache.clone()),
+        );
+        // Only even values so every odd value is within some page's range but not in the page
+        let data = gen()
+            .col("values", array::step_custom::<Int32Type>(0, 2))
+            .col("row_ids", array::step::<UInt64Type>())
+            .into_reader_rows(RowCount::from(4096), BatchCount::from(10));
+        let data = Box::new(MockTrainingSource::new(data).await);
+        let options = BTreeTrainingOptions {
+            bloom_filters: true,
+        };
+        train_btree_index_with_options(
+            data,
+            &FlatIndexMetadata::new(DataType::Int32),
+            index_store.as_ref(),
+            &options,
+        )
+        .await
+        .unwrap();
+        let index = BTreeIndex::load(index_store).await.unwrap();
+
+        // The bloom filter rules out the page so it is never loaded
+        let row_ids = index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(10001))))
+            .await
+            .unwrap();
+        assert_eq!(0, row_ids.len());
+        assert!(page_cache.is_empty());
+
+        let row_ids = index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(10000))))
+            .await
+            .unwrap();
+        assert_eq!(&[5000], row_ids.values().as_ref());
+        assert_eq!(1, page_cache.len());
+
+        // The second lookup in the same page is served from the cache
+        let row_ids = index
+            .search(&ScalarQuery::IsIn(vec![
+                ScalarValue::Int32(Some(10002)),
+                ScalarValue::Int32(Some(10003)),
+                ScalarValue::Int32(Some(10002)),
+                ScalarValue::Int32(Some(30000)),
+            ]))
+            .await
+            .unwrap();
+        assert_eq!(&[5001, 15000], row_ids.values().as_ref());
+        assert_eq!(2, page_cache.len());
+        assert!(page_cache.size_bytes() > 0);
+
+        // Updating keeps the bloom filters
+        let updated_dir = tempdir().unwrap();
+        let (object_store, path) =
+            ObjectStore::from_path(updated_dir.path().as_os_str().to_str().unwrap()).unwrap();
+        let updated_cache = IndexPageCache::new(64 * 1024 * 1024);
+        let updated_store: Arc<dyn IndexStore> = Arc::new(
+            LanceIndexStore::new(object_store, path, None).with_page_cache(updated_cache.clone()),
+        );
+        let new_data = gen()
+            .col("values", array::step_custom::<Int32Type>(100000, 2))
+            .col("row_ids", array::step_custom::<UInt64Type>(100000, 1))
+            .into_reader_rows(RowCount::from(4096), BatchCount::from(1));
+        index
+            .update(
+                lance_datafusion::utils::reader_to_stream(Box::new(new_data)),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = BTreeIndex::load(updated_store).await.unwrap();
+        let row_ids = updated_index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(10001))))
+            .await
+            .unwrap();
+        assert_eq!(0, row_ids.len());
+        assert!(updated_cache.is_empty());
+    }
+
     async fn check(index: &BTreeIndex, query: ScalarQuery, expected: &[u64]) {
         let results = index.search(&query).await.unwrap();
         let expected_arr = UInt64Array::from_iter_values(expected.iter().copied());
@@ -654,4 +775,651 @@ mod tests {
         let row_ids = index.search(&ScalarQuery::IsNull()).await.unwrap();
         assert_eq!(row_ids.len(), 4096);
     }
+
+    async fn train_bitmap(
+        index_store: &Arc<dyn IndexStore>,
+        data: impl RecordBatchReader + Send + Sync + 'static,
+    ) {
+        train_bitmap_index(
+            lance_datafusion::utils::reader_to_stream(Box::new(data)),
+            index_store.as_ref(),
+        )
+        .await
+        .unwrap();
+    }
+
+    async fn check_bitmap(index: &BitmapIndex, query: ScalarQuery, expected: &[u64]) {
+        let mut results = index.search(&query).await.unwrap().values().to_vec();
+        results.sort();
+        assert_eq!(results, expected);
+    }
+
+    fn status_data() -> impl RecordBatchReader + Send + Sync + 'static {
+        // 0 -> "active", 1 -> "deleted", 2 -> null, 3 -> "pending", 4 -> "active", ...
+        gen()
+            .col(
+                "values",
+                array::cycle_utf8_literals(&["active", "deleted", "", "pending"])
+                    .with_nulls(&[false, false, true, false]),
+            )
+            .col("row_ids", array::step::<UInt64Type>())
+            .into_reader_rows(RowCount::from(10), BatchCount::from(4))
+    }
+
+    fn utf8(value: &str) -> ScalarValue {
+        ScalarValue::Utf8(Some(value.to_string()))
+    }
+
+    #[tokio::test]
+    async fn test_bitmap_basic() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_bitmap(&index_store, status_data()).await;
+        let index = BitmapIndex::load(index_store).await.unwrap();
+
+        let every_fourth = |offset: u64| (0..40).filter(move |i| i % 4 == offset);
+        let active = every_fourth(0).collect::<Vec<_>>();
+        check_bitmap(&index, ScalarQuery::Equals(utf8("active")), &active).await;
+        check_bitmap(&index, ScalarQuery::Equals(utf8("missing")), &[]).await;
+        check_bitmap(
+            &index,
+            ScalarQuery::IsNull(),
+            &every_fourth(2).collect::<Vec<_>>(),
+        )
+        .await;
+
+        let mut active_or_pending = every_fourth(0).chain(every_fourth(3)).collect::<Vec<_>>();
+        active_or_pending.sort();
+        check_bitmap(
+            &index,
+            ScalarQuery::IsIn(vec![utf8("active"), utf8("pending"), utf8("missing")]),
+            &active_or_pending,
+        )
+        .await;
+
+        // Ranges exclude nulls
+        let mut up_to_deleted = every_fourth(0).chain(every_fourth(1)).collect::<Vec<_>>();
+        up_to_deleted.sort();
+        check_bitmap(
+            &index,
+            ScalarQuery::Range(Bound::Unbounded, Bound::Included(utf8("deleted"))),
+            &up_to_deleted,
+        )
+        .await;
+        check_bitmap(
+            &index,
+            ScalarQuery::Range(
+                Bound::Excluded(utf8("pending")),
+                Bound::Excluded(utf8("active")),
+            ),
+            &[],
+        )
+        .await;
+
+        // The row id sets can be combined directly
+        let active = index
+            .search_row_ids(&ScalarQuery::Equals(utf8("active")))
+            .await
+            .unwrap();
+        let active_or_pending_set = index
+            .search_row_ids(&ScalarQuery::IsIn(vec![utf8("active"), utf8("pending")]))
+            .await
+            .unwrap();
+        assert_eq!(active.clone() & active_or_pending_set.clone(), active);
+        assert_eq!(
+            active | active_or_pending_set.clone(),
+            active_or_pending_set
+        );
+    }
+
+    #[tokio::test]
+    async fn test_bitmap_update() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_bitmap(&index_store, status_data()).await;
+        let index = BitmapIndex::load(index_store).await.unwrap();
+
+        let new_data = gen()
+            .col(
+                "values",
+                array::cycle_utf8_literals(&["archived", "active"]),
+            )
+            .col("row_ids", array::step_custom::<UInt64Type>(100, 1))
+            .into_reader_rows(RowCount::from(2), BatchCount::from(1));
+        let updated_dir = tempdir().unwrap();
+        let updated_store = test_store(&updated_dir);
+        index
+            .update(
+                lance_datafusion::utils::reader_to_stream(Box::new(new_data)),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = BitmapIndex::load(updated_store).await.unwrap();
+
+        check_bitmap(
+            &updated_index,
+            ScalarQuery::Equals(utf8("archived")),
+            &[100],
+        )
+        .await;
+        let mut active = (0..40).filter(|i| i % 4 == 0).collect::<Vec<_>>();
+        active.push(101);
+        check_bitmap(&updated_index, ScalarQuery::Equals(utf8("active")), &active).await;
+    }
+
+    #[tokio::test]
+    async fn test_bitmap_remap() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_bitmap(&index_store, status_data()).await;
+        let index = BitmapIndex::load(index_store).await.unwrap();
+
+        // Move row 0 to 1000, delete row 4 and leave the rest as-is
+        let mapping = HashMap::<u64, Option<u64>>::from_iter(vec![(0, Some(1000)), (4, None)]);
+        let remapped_dir = tempdir().unwrap();
+        let remapped_store = test_store(&remapped_dir);
+        index
+            .remap(&mapping, remapped_store.as_ref())
+            .await
+            .unwrap();
+        let remapped_index = BitmapIndex::load(remapped_store).await.unwrap();
+
+        let mut active = (8..40).filter(|i| i % 4 == 0).collect::<Vec<_>>();
+        active.push(1000);
+        check_bitmap(
+            &remapped_index,
+            ScalarQuery::Equals(utf8("active")),
+            &active,
+        )
+        .await;
+    }
+
+    fn docs_data(
+        docs: Vec<Option<&str>>,
+        first_row_id: u64,
+    ) -> impl RecordBatchReader + Send + Sync {
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("docs", DataType::Utf8, true),
+            Field::new("row_ids", DataType::UInt64, false),
+        ]));
+        let row_ids = (first_row_id..first_row_id + docs.len() as u64).collect::<Vec<_>>();
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(StringArray::from(docs)),
+                Arc::new(UInt64Array::from(row_ids)),
+            ],
+        )
+        .unwrap();
+        RecordBatchIterator::new(vec![Ok(batch)], schema)
+    }
+
+    fn animal_docs() -> impl RecordBatchReader + Send + Sync {
+        docs_data(
+            vec![
+                Some("The quick brown fox"),
+                Some("the lazy dog"),
+                Some("Quick, quick, QUICK fox jumps"),
+                Some("a dog and a fox"),
+                None,
+                Some("completely unrelated text"),
+            ],
+            0,
+        )
+    }
+
+    async fn train_inverted(
+        index_store: &Arc<dyn IndexStore>,
+        data: impl RecordBatchReader + Send + Sync + 'static,
+    ) {
+        train_inverted_index(
+            lance_datafusion::utils::reader_to_stream(Box::new(data)),
+            index_store.as_ref(),
+        )
+        .await
+        .unwrap();
+    }
+
+    async fn check_full_text(index: &InvertedIndex, query: FullTextSearchQuery, expected: &[u64]) {
+        let mut results = index
+            .search(&ScalarQuery::FullTextSearch(query))
+            .await
+            .unwrap()
+            .values()
+            .to_vec();
+        results.sort();
+        assert_eq!(results, expected);
+    }
+
+    #[tokio::test]
+    async fn test_inverted_basic() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_inverted(&index_store, animal_docs()).await;
+        let index = InvertedIndex::load(index_store).await.unwrap();
+
+        // Docs with more (and more frequent) query tokens rank higher
+        let (row_ids, scores) = index.bm25_search("quick fox", 10);
+        assert_eq!(row_ids, vec![2, 0, 3]);
+        assert!(scores.windows(2).all(|pair| pair[0] >= pair[1]));
+        let (row_ids, _) = index.bm25_search("quick fox", 2);
+        assert_eq!(row_ids, vec![2, 0]);
+        let (row_ids, _) = index.bm25_search("missing", 2);
+        assert!(row_ids.is_empty());
+
+        check_full_text(&index, FullTextSearchQuery::new("DOG"), &[1, 3]).await;
+        // fox appears once in docs 0, 2 and 3 so the shortest doc scores best
+        check_full_text(&index, FullTextSearchQuery::new("fox").limit(1), &[0]).await;
+        check_full_text(&index, FullTextSearchQuery::new("text dog"), &[1, 3, 5]).await;
+
+        // Inverted indices only answer full text queries
+        assert!(index
+            .search(&ScalarQuery::Equals(utf8("the lazy dog")))
+            .await
+            .is_err());
+    }
+
+    #[tokio::test]
+    async fn test_inverted_wand_matches_exhaustive() {
+        use rand::{seq::SliceRandom, Rng, SeedableRng};
+
+        let words = ["apple", "banana", "cherry", "date", "elder", "fig", "grape"];
+        let mut rng = rand::rngs::StdRng::seed_from_u64(42);
+        let docs = (0..2000)
+            .map(|_| {
+                let num_words = rng.gen_range(1..20);
+                (0..num_words)
+                    .map(|_| *words.choose(&mut rng).unwrap())
+                    .collect::<Vec<_>>()
+                    .join(" ")
+            })
+            .collect::<Vec<_>>();
+
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_inverted(
+            &index_store,
+            docs_data(docs.iter().map(|doc| Some(doc.as_str())).collect(), 0),
+        )
+        .await;
+        let index = InvertedIndex::load(index_store).await.unwrap();
+
+        for query in ["apple", "banana fig", "cherry date elder grape"] {
+            // With a limit larger than the number of docs nothing can be skipped
+            let (_, all_scores) = index.bm25_search(query, docs.len() + 1);
+            for k in [1, 10, 100] {
+                let (_, scores) = index.bm25_search(query, k);
+                assert_eq!(scores.len(), k);
+                for (score, expected) in scores.iter().zip(&all_scores) {
+                    assert!((score - expected).abs() < 1e-5);
+                }
+            }
+        }
+    }
+
+    #[tokio::test]
+    async fn test_inverted_update_and_remap() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_inverted(&index_store, animal_docs()).await;
+        let index = InvertedIndex::load(index_store).await.unwrap();
+
+        let updated_dir = tempdir().unwrap();
+        let updated_store = test_store(&updated_dir);
+        index
+            .update(
+                lance_datafusion::utils::reader_to_stream(Box::new(docs_data(
+                    vec![Some("a fox in a box")],
+                    100,
+                ))),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = InvertedIndex::load(updated_store).await.unwrap();
+        check_full_text(
+            &updated_index,
+            FullTextSearchQuery::new("fox"),
+            &[0, 2, 3, 100],
+        )
+        .await;
+        check_full_text(&updated_index, FullTextSearchQuery::new("box"), &[100]).await;
+
+        // Move row 0 to 1000 and delete row 2
+        let mapping = HashMap::<u64, Option<u64>>::from_iter(vec![(0, Some(1000)), (2, None)]);
+        let remapped_dir = tempdir().unwrap();
+        let remapped_store = test_store(&remapped_dir);
+        updated_index
+            .remap(&mapping, remapped_store.as_ref())
+            .await
+            .unwrap();
+        let remapped_index = InvertedIndex::load(remapped_store).await.unwrap();
+        check_full_text(
+            &remapped_index,
+            FullTextSearchQuery::new("fox"),
+            &[3, 100, 1000],
+        )
+        .await;
+        check_full_text(&remapped_index, FullTextSearchQuery::new("jumps"), &[]).await;
+    }
+
+    async fn train_ngram(
+        index_store: &Arc<dyn IndexStore>,
+        data: impl RecordBatchReader + Send + Sync + 'static,
+    ) {
+        train_ngram_index(
+            lance_datafusion::utils::reader_to_stream(Box::new(data)),
+            index_store.as_ref(),
+        )
+        .await
+        .unwrap();
+    }
+
+    async fn check_contains(index: &NGramIndex, substrings: &[&str], expected: &[u64]) {
+        let query =
+            ScalarQuery::ContainsCandidates(substrings.iter().map(|s| s.to_string()).collect());
+        let mut results = index.search(&query).await.unwrap().values().to_vec();
+        results.sort();
+        assert_eq!(results, expected);
+    }
+
+    fn url_docs() -> impl RecordBatchReader + Send + Sync {
+        docs_data(
+            vec![
+                Some("/api/Checkout/confirm"),
+                Some("/api/cart/items"),
+                Some("/static/check/knockout.css"),
+                Some("/api/checkout"),
+                None,
+                Some("ok"),
+            ],
+            0,
+        )
+    }
+
+    #[tokio::test]
+    async fn test_ngram_basic() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_ngram(&index_store, url_docs()).await;
+        let index = NGramIndex::load(index_store).await.unwrap();
+
+        // Matching ignores case
+        check_contains(&index, &["Confirm"], &[0]).await;
+        check_contains(&index, &["/api/", "out"], &[0, 3]).await;
+        check_contains(&index, &["items"], &[1]).await;
+        check_contains(&index, &["missing"], &[]).await;
+        // The results are only candidates, row 2 has every trigram of "checkout" (spread
+        // over "check" and "knockout") but not "checkout" itself
+        check_contains(&index, &["checkout"], &[0, 2, 3]).await;
+
+        // Substrings too short to have a trigram cannot be searched
+        assert!(index
+            .search(&ScalarQuery::ContainsCandidates(vec!["ok".to_string()]))
+            .await
+            .is_err());
+        // Ngram indices only answer substring queries
+        assert!(index
+            .search(&ScalarQuery::Equals(utf8("ok")))
+            .await
+            .is_err());
+    }
+
+    #[tokio::test]
+    async fn test_ngram_update_and_remap() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_ngram(&index_store, url_docs()).await;
+        let index = NGramIndex::load(index_store).await.unwrap();
+
+        let updated_dir = tempdir().unwrap();
+        let updated_store = test_store(&updated_dir);
+        index
+            .update(
+                lance_datafusion::utils::reader_to_stream(Box::new(docs_data(
+                    vec![Some("/api/checkout/cancel")],
+                    100,
+                ))),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = NGramIndex::load(updated_store).await.unwrap();
+        check_contains(&updated_index, &["checkout"], &[0, 2, 3, 100]).await;
+        check_contains(&updated_index, &["cancel"], &[100]).await;
+
+        // Move row 0 to 1000 and delete row 3
+        let mapping = HashMap::<u64, Option<u64>>::from_iter(vec![(0, Some(1000)), (3, None)]);
+        let remapped_dir = tempdir().unwrap();
+        let remapped_store = test_store(&remapped_dir);
+        updated_index
+            .remap(&mapping, remapped_store.as_ref())
+            .await
+            .unwrap();
+        let remapped_index = NGramIndex::load(remapped_store).await.unwrap();
+        check_contains(&remapped_index, &["checkout"], &[2, 100, 1000]).await;
+        check_contains(&remapped_index, &["confirm"], &[1000]).await;
+    }
+
+    fn label_data(
+        labels: Vec<Option<Vec<Option<i32>>>>,
+        first_row_id: u64,
+    ) -> impl RecordBatchReader + Send + Sync {
+        let labels = ListArray::from_iter_primitive::<Int32Type, _, _>(labels);
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("labels", labels.data_type().clone(), true),
+            Field::new("row_ids", DataType::UInt64, false),
+        ]));
+        let row_ids = (first_row_id..first_row_id + labels.len() as u64).collect::<Vec<_>>();
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(labels), Arc::new(UInt64Array::from(row_ids))],
+        )
+        .unwrap();
+        RecordBatchIterator::new(vec![Ok(batch)], schema)
+    }
+
+    async fn train_label_list(
+        index_store: &Arc<dyn IndexStore>,
+        data: impl RecordBatchReader + Send + Sync + 'static,
+    ) {
+        train_label_list_index(
+            lance_datafusion::utils::reader_to_stream(Box::new(data)),
+            index_store.as_ref(),
+        )
+        .await
+        .unwrap();
+    }
+
+    async fn check_labels(index: &LabelListIndex, query: ScalarQuery, expected: &[u64]) {
+        let mut results = index.search(&query).await.unwrap().values().to_vec();
+        results.sort();
+        assert_eq!(results, expected);
+    }
+
+    fn int_labels(labels: &[i32]) -> Vec<ScalarValue> {
+        labels
+            .iter()
+            .map(|label| ScalarValue::Int32(Some(*label)))
+            .collect()
+    }
+
+    #[tokio::test]
+    async fn test_label_list() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        train_label_list(
+            &index_store,
+            label_data(
+                vec![
+                    Some(vec![Some(1), Some(2)]),
+                    Some(vec![Some(2), Some(3), Some(2)]),
+                    None,
+                    Some(vec![]),
+                    Some(vec![Some(1), None, Some(3)]),
+                ],
+                0,
+            ),
+        )
+        .await;
+        let index = LabelListIndex::load(index_store).await.unwrap();
+
+        check_labels(&index, ScalarQuery::HasAnyLabel(int_labels(&[2])), &[0, 1]).await;
+        check_labels(
+            &index,
+            ScalarQuery::HasAnyLabel(int_labels(&[1, 3])),
+            &[0, 1, 4],
+        )
+        .await;
+        check_labels(&index, ScalarQuery::HasAllLabels(int_labels(&[1, 3])), &[4]).await;
+        check_labels(&index, ScalarQuery::HasAllLabels(int_labels(&[1, 7])), &[]).await;
+        assert!(index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(1))))
+            .await
+            .is_err());
+
+        let updated_dir = tempdir().unwrap();
+        let updated_store = test_store(&updated_dir);
+        index
+            .update(
+                lance_datafusion::utils::reader_to_stream(Box::new(label_data(
+                    vec![Some(vec![Some(3), Some(4)])],
+                    100,
+                ))),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = LabelListIndex::load(updated_store).await.unwrap();
+        check_labels(
+            &updated_index,
+            ScalarQuery::HasAnyLabel(int_labels(&[3])),
+            &[1, 4, 100],
+        )
+        .await;
+
+        // Move row 1 to 1000 and delete row 4
+        let mapping = HashMap::<u64, Option<u64>>::from_iter(vec![(1, Some(1000)), (4, None)]);
+        let remapped_dir = tempdir().unwrap();
+        let remapped_store = test_store(&remapped_dir);
+        updated_index
+            .remap(&mapping, remapped_store.as_ref())
+            .await
+            .unwrap();
+        let remapped_index = LabelListIndex::load(remapped_store).await.unwrap();
+        check_labels(
+            &remapped_index,
+            ScalarQuery::HasAnyLabel(int_labels(&[3])),
+            &[100, 1000],
+        )
+        .await;
+    }
+
+    fn zone_map_batch(row_ids: Vec<u64>, values: Vec<Option<i32>>) -> SendableRecordBatchStream {
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("values", DataType::Int32, true),
+            Field::new("row_ids", DataType::UInt64, false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(Int32Array::from(values)),
+                Arc::new(UInt64Array::from(row_ids)),
+            ],
+        )
+        .unwrap();
+        lance_datafusion::utils::reader_to_stream(Box::new(RecordBatchIterator::new(
+            vec![Ok(batch)],
+            schema,
+        )))
+    }
+
+    #[tokio::test]
+    async fn test_zone_map() {
+        let tempdir = tempdir().unwrap();
+        let index_store = test_store(&tempdir);
+        // Two fragments of 20000 rows where the value increases with the row
+        let row_ids = (0..2_u64)
+            .flat_map(|frag| (0..20000_u64).map(move |offset| (frag << 32) | offset))
+            .collect::<Vec<_>>();
+        let values = (0..40000).map(Some).collect::<Vec<_>>();
+        train_zone_map_index(zone_map_batch(row_ids, values), index_store.as_ref())
+            .await
+            .unwrap();
+        let index = ZoneMapIndex::load(index_store).await.unwrap();
+
+        // The candidates are every row of the zones that might match
+        let row_ids = index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(10000))))
+            .await
+            .unwrap();
+        assert_eq!(row_ids.len(), 8192);
+        assert_eq!(row_ids.value(0), 8192);
+        let row_ids = index
+            .search(&ScalarQuery::Range(
+                Bound::Included(ScalarValue::Int32(Some(19000))),
+                Bound::Excluded(ScalarValue::Int32(Some(21000))),
+            ))
+            .await
+            .unwrap();
+        // The last (partial) zone of the first fragment and first zone of the second
+        assert_eq!(row_ids.len(), 3616 + 8192);
+        let row_ids = index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(50050))))
+            .await
+            .unwrap();
+        assert!(row_ids.is_empty());
+        let row_ids = index.search(&ScalarQuery::IsNull()).await.unwrap();
+        assert!(row_ids.is_empty());
+
+        // Updating adds the zones of the new fragment
+        let updated_dir = tempdir().unwrap();
+        let updated_store = test_store(&updated_dir);
+        let new_row_ids = (0..100_u64).map(|offset| (2 << 32) | offset).collect();
+        let new_values = (0..100)
+            .map(|i| if i == 0 { None } else { Some(50000 + i) })
+            .collect();
+        index
+            .update(
+                zone_map_batch(new_row_ids, new_values),
+                updated_store.as_ref(),
+            )
+            .await
+            .unwrap();
+        let updated_index = ZoneMapIndex::load(updated_store.clone()).await.unwrap();
+        assert_eq!(updated_index.statistics().unwrap()["num_zones"], 7);
+        for query in [
+            ScalarQuery::Equals(ScalarValue::Int32(Some(50050))),
+            ScalarQuery::IsNull(),
+        ] {
+            let row_ids = updated_index.search(&query).await.unwrap();
+            assert_eq!(row_ids.len(), 100);
+        }
+
+        // Remapping moves the third fragment and drops the (deleted) first fragment
+        let mut mapping = (0..20000_u64)
+            .map(|offset| (offset, None))
+            .collect::<HashMap<_, _>>();
+        mapping.extend((0..100_u64).map(|offset| ((2 << 32) | offset, Some((3 << 32) | offset))));
+        let remapped_dir = tempdir().unwrap();
+        let remapped_store = test_store(&remapped_dir);
+        updated_index
+            .remap(&mapping, remapped_store.as_ref())
+            .await
+            .unwrap();
+        let remapped_index = ZoneMapIndex::load(remapped_store).await.unwrap();
+        assert_eq!(remapped_index.statistics().unwrap()["num_fragments"], 2);
+        let row_ids = remapped_index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(10000))))
+            .await
+            .unwrap();
+        assert!(row_ids.is_empty());
+        let row_ids = remapped_index
+            .search(&ScalarQuery::Equals(ScalarValue::Int32(Some(50050))))
+            .await
+            .unwrap();
+        assert_eq!(row_ids.len(), 100);
+        assert_eq!(row_ids.value(0), 3 << 32);
+    }
 }
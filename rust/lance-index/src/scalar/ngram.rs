@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! An n-gram index for substring filters
+//!
+//! Every string is broken into its (lowercased) trigrams and the index stores a bitmap of
+//! row ids for each trigram.  A string can only contain a substring if it contains every
+//! trigram of that substring, so intersecting the trigram bitmaps gives a (usually small)
+//! set of candidate rows for filters like `LIKE '%foo%'`, `contains` or a regular
+//! expression.  The candidates are a superset of the matching rows and must be verified by
+//! evaluating the original filter.
+
+use std::{
+    any::Any,
+    collections::{HashMap, HashSet},
+    sync::Arc,
+};
+
+use arrow_array::{
+    builder::{BinaryBuilder, StringBuilder},
+    cast::AsArray,
+    types::UInt64Type,
+    RecordBatch, UInt64Array,
+};
+use arrow_schema::{DataType, Field, Schema};
+use async_trait::async_trait;
+use datafusion::physical_plan::SendableRecordBatchStream;
+use deepsize::DeepSizeOf;
+use futures::TryStreamExt;
+use lance_core::{utils::mask::RowIdTreeMap, Error, Result};
+use roaring::RoaringBitmap;
+use serde::Serialize;
+use snafu::{location, Location};
+
+use crate::{Index, IndexType};
+
+use super::{IndexStore, ScalarIndex, ScalarQuery};
+
+pub const NGRAM_POSTINGS_NAME: &str = "ngram_postings.lance";
+
+/// The number of characters in each n-gram
+pub const NGRAM_LENGTH: usize = 3;
+
+/// Returns the distinct n-grams of `text`
+///
+/// The text is lowercased first so the index can answer case insensitive queries.  Text
+/// shorter than [`NGRAM_LENGTH`] characters has no n-grams.
+pub fn ngrams(text: &str) -> HashSet<String> {
+    let chars = text
+        .chars()
+        .flat_map(char::to_lowercase)
+        .collect::<Vec<_>>();
+    chars
+        .windows(NGRAM_LENGTH)
+        .map(|window| window.iter().collect())
+        .collect()
+}
+
+/// A scalar index that maps the trigrams of a string column to the rows containing them
+///
+/// The index is stored as a single batch with one row per trigram.  The first column
+/// "ngrams" has the trigrams and the second column "bitmaps" has the serialized
+/// [`RowIdTreeMap`] of the rows that contain each trigram.
+#[derive(Clone, Debug)]
+pub struct NGramIndex {
+    postings: HashMap<String, RowIdTreeMap>,
+    // The serialized size of the bitmaps, a good estimate of their size in memory
+    bitmaps_size_bytes: usize,
+    store: Arc<dyn IndexStore>,
+}
+
+impl DeepSizeOf for NGramIndex {
+    fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
+        self.postings
+            .keys()
+            .map(|ngram| ngram.deep_size_of_children(context))
+            .sum::<usize>()
+            + self.bitmaps_size_bytes
+            + self.store.deep_size_of_children(context)
+    }
+}
+
+impl NGramIndex {
+    fn new(postings: HashMap<String, RowIdTreeMap>, store: Arc<dyn IndexStore>) -> Self {
+        let bitmaps_size_bytes = postings
+            .values()
+            .map(|bitmap| bitmap.serialized_size())
+            .sum();
+        Self {
+            postings,
+            bitmaps_size_bytes,
+            store,
+        }
+    }
+
+    fn try_from_serialized(data: RecordBatch, store: Arc<dyn IndexStore>) -> Result<Self> {
+        let ngrams = data
+            .column(0)
+            .as_string_opt::<i32>()
+            .ok_or_else(|| Error::Internal {
+                message: "ngram index was not serialized with a string ngrams column".into(),
+                location: location!(),
+            })?;
+        let bitmaps = data
+            .column(1)
+            .as_binary_opt::<i32>()
+            .ok_or_else(|| Error::Internal {
+                message: "ngram index was not serialized with a binary bitmaps column".into(),
+                location: location!(),
+            })?;
+        let mut postings = HashMap::with_capacity(data.num_rows());
+        for (ngram, bitmap) in ngrams.iter().zip(bitmaps.iter()) {
+            if let (Some(ngram), Some(bitmap)) = (ngram, bitmap) {
+                postings.insert(ngram.to_string(), RowIdTreeMap::deserialize_from(bitmap)?);
+            }
+        }
+        Ok(Self::new(postings, store))
+    }
+
+    /// Returns the rows that might contain every one of `substrings`
+    fn candidates(&self, substrings: &[String]) -> Result<RowIdTreeMap> {
+        let query_ngrams = substrings
+            .iter()
+            .flat_map(|substring| ngrams(substring))
+            .collect::<HashSet<_>>();
+        if query_ngrams.is_empty() {
+            return Err(Error::InvalidInput {
+                source: format!(
+                    "an ngram index can only search for substrings with at least {} characters",
+                    NGRAM_LENGTH
+                )
+                .into(),
+                location: location!(),
+            });
+        }
+        let mut bitmaps = Vec::with_capacity(query_ngrams.len());
+        for ngram in &query_ngrams {
+            match self.postings.get(ngram) {
+                Some(bitmap) => bitmaps.push(bitmap),
+                // No row has this ngram so no row can match
+                None => return Ok(RowIdTreeMap::default()),
+            }
+        }
+        // Start with the rarest ngrams so the intermediate results stay small
+        bitmaps.sort_by_key(|bitmap| bitmap.serialized_size());
+        let mut bitmaps = bitmaps.into_iter();
+        let mut result = bitmaps.next().cloned().unwrap_or_default();
+        for bitmap in bitmaps {
+            if result.is_empty() {
+                break;
+            }
+            result = result & bitmap.clone();
+        }
+        Ok(result)
+    }
+
+    fn into_builder(self) -> NGramIndexBuilder {
+        NGramIndexBuilder {
+            postings: self.postings,
+        }
+    }
+}
+
+fn row_ids_to_array(row_ids: &RowIdTreeMap) -> Result<UInt64Array> {
+    let row_ids = row_ids.row_ids().ok_or_else(|| Error::Internal {
+        message: "ngram index unexpectedly contained an entire fragment".into(),
+        location: location!(),
+    })?;
+    Ok(UInt64Array::from_iter_values(row_ids.map(u64::from)))
+}
+
+#[derive(Serialize)]
+struct NGramStatistics {
+    num_ngrams: usize,
+}
+
+#[async_trait]
+impl Index for NGramIndex {
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn as_index(self: Arc<Self>) -> Arc<dyn Index> {
+        self
+    }
+
+    fn index_type(&self) -> IndexType {
+        IndexType::Scalar
+    }
+
+    fn statistics(&self) -> Result<serde_json::Value> {
+        serde_json::to_value(&NGramStatistics {
+            num_ngrams: self.postings.len(),
+        })
+        .map_err(|err| err.into())
+    }
+
+    async fn calculate_included_frags(&self) -> Result<RoaringBitmap> {
+        let mut frag_ids = RoaringBitmap::default();
+        for bitmap in self.postings.values() {
+            let row_ids = row_ids_to_array(bitmap)?;
+            frag_ids.extend(row_ids.values().iter().map(|row_id| (row_id >> 32) as u32));
+        }
+        Ok(frag_ids)
+    }
+}
+
+#[async_trait]
+impl ScalarIndex for NGramIndex {
+    async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
+        row_ids_to_array(&self.search_row_ids(query).await?)
+    }
+
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        match query {
+            ScalarQuery::ContainsCandidates(substrings) => self.candidates(substrings),
+            _ => Err(Error::NotSupported {
+                source: "an ngram index can only answer substring queries".into(),
+                location: location!(),
+            }),
+        }
+    }
+
+    async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>> {
+        let postings_file = store.open_index_file(NGRAM_POSTINGS_NAME).await?;
+        let serialized = postings_file.read_record_batch(0).await?;
+        Ok(Arc::new(Self::try_from_serialized(serialized, store)?))
+    }
+
+    async fn remap(
+        &self,
+        mapping: &HashMap<u64, Option<u64>>,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let mut postings = HashMap::with_capacity(self.postings.len());
+        for (ngram, bitmap) in &self.postings {
+            let row_ids = row_ids_to_array(bitmap)?;
+            let remapped = RowIdTreeMap::from_iter(
+                row_ids
+                    .values()
+                    .iter()
+                    .filter_map(|row_id| mapping.get(row_id).copied().unwrap_or(Some(*row_id))),
+            );
+            if !remapped.is_empty() {
+                postings.insert(ngram.clone(), remapped);
+            }
+        }
+        NGramIndexBuilder { postings }.write(dest_store).await
+    }
+
+    async fn update(
+        &self,
+        new_data: SendableRecordBatchStream,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let mut builder = self.clone().into_builder();
+        builder.add_stream(new_data).await?;
+        builder.write(dest_store).await
+    }
+}
+
+/// Accumulates the bitmaps of an ngram index in memory before writing them out
+#[derive(Default)]
+struct NGramIndexBuilder {
+    postings: HashMap<String, RowIdTreeMap>,
+}
+
+impl NGramIndexBuilder {
+    fn add_batch(&mut self, batch: &RecordBatch) -> Result<()> {
+        debug_assert_eq!(batch.num_columns(), 2);
+        let values = batch.column(0);
+        let values = match values.data_type() {
+            DataType::Utf8 => values.as_string::<i32>().iter().collect::<Vec<_>>(),
+            DataType::LargeUtf8 => values.as_string::<i64>().iter().collect::<Vec<_>>(),
+            data_type => {
+                return Err(Error::InvalidInput {
+                    source: format!(
+                        "an ngram index can only be built on string columns, not {}",
+                        data_type
+                    )
+                    .into(),
+                    location: location!(),
+                })
+            }
+        };
+        let row_ids = batch.column(1).as_primitive::<UInt64Type>();
+        for (value, row_id) in values.into_iter().zip(row_ids.values().iter()) {
+            // Nulls never match a LIKE or regex filter so they are not indexed
+            let Some(value) = value else {
+                continue;
+            };
+            for ngram in ngrams(value) {
+                self.postings.entry(ngram).or_default().extend([*row_id]);
+            }
+        }
+        Ok(())
+    }
+
+    async fn add_stream(&mut self, mut data: SendableRecordBatchStream) -> Result<()> {
+        while let Some(batch) = data.try_next().await? {
+            self.add_batch(&batch)?;
+        }
+        Ok(())
+    }
+
+    async fn write(self, index_store: &dyn IndexStore) -> Result<()> {
+        // Sorted so that the written index is deterministic
+        let mut postings = self.postings.into_iter().collect::<Vec<_>>();
+        postings.sort_unstable_by(|(left, _), (right, _)| left.cmp(right));
+
+        let mut ngrams = StringBuilder::with_capacity(postings.len(), postings.len() * 4);
+        let mut bitmaps = BinaryBuilder::new();
+        for (ngram, bitmap) in &postings {
+            let mut serialized = Vec::with_capacity(bitmap.serialized_size());
+            bitmap.serialize_into(&mut serialized)?;
+            ngrams.append_value(ngram);
+            bitmaps.append_value(serialized);
+        }
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("ngrams", DataType::Utf8, false),
+            Field::new("bitmaps", DataType::Binary, false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(ngrams.finish()), Arc::new(bitmaps.finish())],
+        )?;
+
+        let mut postings_file = index_store
+            .new_index_file(NGRAM_POSTINGS_NAME, schema)
+            .await?;
+        postings_file.write_record_batch(batch).await?;
+        postings_file.finish().await
+    }
+}
+
+/// Trains an ngram index from a stream of strings and row ids
+///
+/// The stream must have two columns.  The first column has the strings to index (Utf8 or
+/// LargeUtf8) and may have any name.  The second column must be the row ids (UInt64).  The
+/// data does not need to be sorted.
+pub async fn train_ngram_index(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+) -> Result<()> {
+    let mut builder = NGramIndexBuilder::default();
+    builder.add_stream(data).await?;
+    builder.write(index_store).await
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_ngrams() {
+        let mut grams = ngrams("AbCdA").into_iter().collect::<Vec<_>>();
+        grams.sort();
+        assert_eq!(grams, vec!["abc", "bcd", "cda"]);
+        assert!(ngrams("ab").is_empty());
+        // Repeated ngrams are only reported once
+        assert_eq!(ngrams("aaaa").len(), 1);
+    }
+}
@@ -0,0 +1,525 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! A zone map index for coarse pruning
+//!
+//! Each fragment is divided into zones of [`ZONE_SIZE`] consecutive rows and the index stores
+//! the min, max and null count of every zone.  A filter can only match rows in zones whose
+//! [min, max] range overlaps the filter so, for columns that are clustered by ingestion order
+//! (e.g. timestamps), most zones and often entire fragments can be skipped.  The index is tiny
+//! (one row per zone) and new data only adds zones, nothing is retrained.
+//!
+//! The rows in the matching zones are a superset of the matching rows and must be verified by
+//! evaluating the original filter.  Since a result is always a set of whole zones, scans read
+//! the matching zones as row ranges rather than taking their rows.
+//!
+//! Appending data adds the zones of the new fragments to the index.  Fragments written any
+//! other way (e.g. by an update) have no zones until the index is optimized, they are not
+//! covered by the index and might match any filter, so they are scanned in full.
+
+use std::{
+    any::Any,
+    collections::{BTreeMap, HashMap},
+    ops::Bound,
+    sync::Arc,
+};
+
+use arrow_array::{
+    cast::AsArray,
+    types::{UInt32Type, UInt64Type},
+    Array, RecordBatch, UInt32Array, UInt64Array,
+};
+use arrow_schema::{DataType, Field, Schema};
+use async_trait::async_trait;
+use datafusion::physical_plan::SendableRecordBatchStream;
+use datafusion_common::ScalarValue;
+use deepsize::DeepSizeOf;
+use futures::TryStreamExt;
+use lance_core::{utils::mask::RowIdTreeMap, Error, Result};
+use roaring::RoaringBitmap;
+use serde::Serialize;
+use snafu::{location, Location};
+
+use crate::{Index, IndexType};
+
+use super::{
+    btree::{max_val, min_val, wrap_bound, OrderableScalarValue},
+    IndexStore, ScalarIndex, ScalarQuery,
+};
+
+pub const ZONEMAP_NAME: &str = "zonemap.lance";
+
+/// The number of rows (by offset within the fragment) covered by each zone
+pub const ZONE_SIZE: u32 = 8192;
+
+/// The statistics of the values in a zone
+///
+/// If every value is null then min and max are null
+#[derive(Clone, Debug, DeepSizeOf)]
+struct ZoneStats {
+    min: OrderableScalarValue,
+    max: OrderableScalarValue,
+    null_count: u32,
+}
+
+impl ZoneStats {
+    fn has_values(&self) -> bool {
+        !self.min.0.is_null()
+    }
+
+    fn merge(&mut self, other: &Self) {
+        if !self.has_values() {
+            self.min = other.min.clone();
+            self.max = other.max.clone();
+        } else if other.has_values() {
+            if other.min < self.min {
+                self.min = other.min.clone();
+            }
+            if other.max > self.max {
+                self.max = other.max.clone();
+            }
+        }
+        self.null_count += other.null_count;
+    }
+
+    fn might_equal(&self, value: &OrderableScalarValue) -> bool {
+        self.has_values() && self.min <= *value && *value <= self.max
+    }
+
+    fn might_be_in_range(
+        &self,
+        lower: Bound<&OrderableScalarValue>,
+        upper: Bound<&OrderableScalarValue>,
+    ) -> bool {
+        let above_lower = match lower {
+            Bound::Unbounded => true,
+            Bound::Included(lower) => self.max >= *lower,
+            Bound::Excluded(lower) => self.max > *lower,
+        };
+        let below_upper = match upper {
+            Bound::Unbounded => true,
+            Bound::Included(upper) => self.min <= *upper,
+            Bound::Excluded(upper) => self.min < *upper,
+        };
+        self.has_values() && above_lower && below_upper
+    }
+
+    fn might_match(&self, query: &ZoneQuery) -> bool {
+        match query {
+            ZoneQuery::Equals(value) => self.might_equal(value),
+            ZoneQuery::Range(lower, upper) => {
+                self.might_be_in_range(lower.as_ref(), upper.as_ref())
+            }
+            ZoneQuery::IsIn(values) => values.iter().any(|value| self.might_equal(value)),
+            ZoneQuery::IsNull => self.null_count > 0,
+        }
+    }
+}
+
+/// A [`ScalarQuery`] with the values wrapped for comparison against zone stats
+enum ZoneQuery {
+    Equals(OrderableScalarValue),
+    Range(Bound<OrderableScalarValue>, Bound<OrderableScalarValue>),
+    IsIn(Vec<OrderableScalarValue>),
+    IsNull,
+}
+
+impl ZoneQuery {
+    fn try_new(query: &ScalarQuery) -> Result<Self> {
+        match query {
+            ScalarQuery::Equals(value) => Ok(Self::Equals(OrderableScalarValue(value.clone()))),
+            ScalarQuery::Range(lower, upper) => {
+                Ok(Self::Range(wrap_bound(lower), wrap_bound(upper)))
+            }
+            ScalarQuery::IsIn(values) => Ok(Self::IsIn(
+                values
+                    .iter()
+                    .map(|value| OrderableScalarValue(value.clone()))
+                    .collect(),
+            )),
+            ScalarQuery::IsNull() => Ok(Self::IsNull),
+            ScalarQuery::FullTextSearch(_)
+            | ScalarQuery::ContainsCandidates(_)
+            | ScalarQuery::HasAnyLabel(_)
+            | ScalarQuery::HasAllLabels(_) => Err(Error::NotSupported {
+                source: "a zone map index can only answer comparison, IN and IS NULL queries"
+                    .into(),
+                location: location!(),
+            }),
+        }
+    }
+}
+
+/// The rows [start, start + length) of a fragment
+#[derive(Clone, Debug, DeepSizeOf)]
+struct Zone {
+    start: u32,
+    length: u32,
+    stats: ZoneStats,
+}
+
+/// The zones of a single fragment and their combined stats
+#[derive(Clone, Debug, DeepSizeOf)]
+struct FragmentZones {
+    stats: ZoneStats,
+    zones: Vec<Zone>,
+}
+
+/// A scalar index that stores the min, max and null count of fixed size zones of rows
+///
+/// The index is stored as a single batch with one row per zone, sorted by fragment and zone.
+/// The columns are "fragment_id", "zone_start", "zone_length", "min", "max" and "null_count".
+#[derive(Clone, Debug)]
+pub struct ZoneMapIndex {
+    fragments: BTreeMap<u32, FragmentZones>,
+    value_type: DataType,
+    store: Arc<dyn IndexStore>,
+}
+
+impl DeepSizeOf for ZoneMapIndex {
+    fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
+        self.fragments.deep_size_of_children(context) + self.store.deep_size_of_children(context)
+    }
+}
+
+impl ZoneMapIndex {
+    fn try_from_serialized(data: RecordBatch, store: Arc<dyn IndexStore>) -> Result<Self> {
+        let value_type = data.schema().field(3).data_type().clone();
+        let mut builder = ZoneMapBuilder::new(value_type);
+        builder.add_serialized(&data)?;
+        Ok(builder.into_index(store))
+    }
+
+    /// Returns the rows of all zones that might have a value matching the query
+    fn candidates(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        let query = ZoneQuery::try_new(query)?;
+        let mut row_ids = RowIdTreeMap::new();
+        for (fragment_id, fragment) in &self.fragments {
+            // Most fragments of a well clustered column can be ruled out without visiting zones
+            if !fragment.stats.might_match(&query) {
+                continue;
+            }
+            let mut rows = RoaringBitmap::new();
+            for zone in &fragment.zones {
+                if zone.stats.might_match(&query) {
+                    rows.insert_range(zone.start..zone.start + zone.length);
+                }
+            }
+            if !rows.is_empty() {
+                row_ids.insert_bitmap(*fragment_id, rows);
+            }
+        }
+        Ok(row_ids)
+    }
+
+    fn into_builder(self) -> ZoneMapBuilder {
+        let mut builder = ZoneMapBuilder::new(self.value_type);
+        for (fragment_id, fragment) in self.fragments {
+            for zone in fragment.zones {
+                builder.merge_zone(
+                    fragment_id,
+                    zone.start,
+                    zone.start + zone.length,
+                    &zone.stats,
+                );
+            }
+        }
+        builder
+    }
+}
+
+fn row_ids_to_array(row_ids: &RowIdTreeMap) -> Result<UInt64Array> {
+    let row_ids = row_ids.row_ids().ok_or_else(|| Error::Internal {
+        message: "zone map index unexpectedly contained an entire fragment".into(),
+        location: location!(),
+    })?;
+    Ok(UInt64Array::from_iter_values(row_ids.map(u64::from)))
+}
+
+#[derive(Serialize)]
+struct ZoneMapStatistics {
+    num_fragments: usize,
+    num_zones: usize,
+}
+
+#[async_trait]
+impl Index for ZoneMapIndex {
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn as_index(self: Arc<Self>) -> Arc<dyn Index> {
+        self
+    }
+
+    fn index_type(&self) -> IndexType {
+        IndexType::Scalar
+    }
+
+    fn statistics(&self) -> Result<serde_json::Value> {
+        serde_json::to_value(&ZoneMapStatistics {
+            num_fragments: self.fragments.len(),
+            num_zones: self
+                .fragments
+                .values()
+                .map(|fragment| fragment.zones.len())
+                .sum(),
+        })
+        .map_err(|err| err.into())
+    }
+
+    async fn calculate_included_frags(&self) -> Result<RoaringBitmap> {
+        Ok(RoaringBitmap::from_iter(self.fragments.keys().copied()))
+    }
+}
+
+#[async_trait]
+impl ScalarIndex for ZoneMapIndex {
+    async fn search(&self, query: &ScalarQuery) -> Result<UInt64Array> {
+        row_ids_to_array(&self.search_row_ids(query).await?)
+    }
+
+    async fn search_row_ids(&self, query: &ScalarQuery) -> Result<RowIdTreeMap> {
+        self.candidates(query)
+    }
+
+    async fn load(store: Arc<dyn IndexStore>) -> Result<Arc<Self>> {
+        let zones_file = store.open_index_file(ZONEMAP_NAME).await?;
+        let serialized = zones_file.read_record_batch(0).await?;
+        Ok(Arc::new(Self::try_from_serialized(serialized, store)?))
+    }
+
+    async fn remap(
+        &self,
+        mapping: &HashMap<u64, Option<u64>>,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        // We no longer have the values so each zone's stats are merged into every zone its rows
+        // move to.  This can only widen the zones, which is safe.
+        let mut builder = ZoneMapBuilder::new(self.value_type.clone());
+        for (fragment_id, fragment) in &self.fragments {
+            for zone in &fragment.zones {
+                // The last row offset that lands in each destination zone
+                let mut destinations = BTreeMap::<(u32, u32), u32>::new();
+                for offset in zone.start..zone.start + zone.length {
+                    let row_id = ((*fragment_id as u64) << 32) | offset as u64;
+                    let Some(new_row_id) = mapping.get(&row_id).copied().unwrap_or(Some(row_id))
+                    else {
+                        continue;
+                    };
+                    let (new_fragment, new_offset) = ((new_row_id >> 32) as u32, new_row_id as u32);
+                    let last_offset = destinations
+                        .entry((new_fragment, new_offset / ZONE_SIZE * ZONE_SIZE))
+                        .or_insert(new_offset);
+                    *last_offset = (*last_offset).max(new_offset);
+                }
+                for ((new_fragment, start), last_offset) in destinations {
+                    builder.merge_zone(new_fragment, start, last_offset + 1, &zone.stats);
+                }
+            }
+        }
+        builder.write(dest_store).await
+    }
+
+    async fn update(
+        &self,
+        new_data: SendableRecordBatchStream,
+        dest_store: &dyn IndexStore,
+    ) -> Result<()> {
+        let mut builder = self.clone().into_builder();
+        builder.add_stream(new_data).await?;
+        builder.write(dest_store).await
+    }
+}
+
+/// Accumulates the zones of a zone map index in memory before writing them out
+struct ZoneMapBuilder {
+    // Keyed by fragment id and zone start
+    zones: BTreeMap<(u32, u32), Zone>,
+    value_type: DataType,
+}
+
+impl ZoneMapBuilder {
+    fn new(value_type: DataType) -> Self {
+        Self {
+            zones: BTreeMap::new(),
+            value_type,
+        }
+    }
+
+    // Adds the stats of the rows [start, end) of a fragment, all of which must be in one zone
+    fn merge_zone(&mut self, fragment_id: u32, start: u32, end: u32, stats: &ZoneStats) {
+        let zone_start = start / ZONE_SIZE * ZONE_SIZE;
+        debug_assert!(end <= zone_start + ZONE_SIZE);
+        match self.zones.get_mut(&(fragment_id, zone_start)) {
+            Some(zone) => {
+                zone.length = zone.length.max(end - zone_start);
+                zone.stats.merge(stats);
+            }
+            None => {
+                self.zones.insert(
+                    (fragment_id, zone_start),
+                    Zone {
+                        start: zone_start,
+                        length: end - zone_start,
+                        stats: stats.clone(),
+                    },
+                );
+            }
+        }
+    }
+
+    fn add_batch(&mut self, batch: &RecordBatch) -> Result<()> {
+        debug_assert_eq!(batch.num_columns(), 2);
+        let values = batch.column(0);
+        let row_ids = batch.column(1).as_primitive::<UInt64Type>().values();
+        let zone_of = |row_id: u64| ((row_id >> 32) as u32, row_id as u32 / ZONE_SIZE);
+
+        // Rows normally arrive in row id order so the batch splits into a few runs of rows
+        // from the same zone and the stats of each run can be computed in one pass
+        let mut run_start = 0;
+        while run_start < row_ids.len() {
+            let zone = zone_of(row_ids[run_start]);
+            let mut run_end = run_start + 1;
+            let mut last_offset = row_ids[run_start] as u32;
+            while run_end < row_ids.len() && zone_of(row_ids[run_end]) == zone {
+                last_offset = last_offset.max(row_ids[run_end] as u32);
+                run_end += 1;
+            }
+            let run_values = values.slice(run_start, run_end - run_start);
+            let stats = ZoneStats {
+                min: OrderableScalarValue(min_val(&run_values)?),
+                max: OrderableScalarValue(max_val(&run_values)?),
+                null_count: run_values.null_count() as u32,
+            };
+            self.merge_zone(zone.0, zone.1 * ZONE_SIZE, last_offset + 1, &stats);
+            run_start = run_end;
+        }
+        Ok(())
+    }
+
+    async fn add_stream(&mut self, mut data: SendableRecordBatchStream) -> Result<()> {
+        while let Some(batch) = data.try_next().await? {
+            self.add_batch(&batch)?;
+        }
+        Ok(())
+    }
+
+    fn add_serialized(&mut self, data: &RecordBatch) -> Result<()> {
+        let column = |idx: usize| -> Result<&UInt32Array> {
+            data.column(idx)
+                .as_primitive_opt::<UInt32Type>()
+                .ok_or_else(|| Error::Internal {
+                    message: format!(
+                        "zone map index column {} was not serialized as UInt32",
+                        data.schema().field(idx).name()
+                    ),
+                    location: location!(),
+                })
+        };
+        let (fragment_ids, starts, lengths) = (column(0)?, column(1)?, column(2)?);
+        let null_counts = column(5)?;
+        let (mins, maxs) = (data.column(3), data.column(4));
+        for idx in 0..data.num_rows() {
+            let start = starts.value(idx);
+            let stats = ZoneStats {
+                min: OrderableScalarValue(ScalarValue::try_from_array(mins, idx)?),
+                max: OrderableScalarValue(ScalarValue::try_from_array(maxs, idx)?),
+                null_count: null_counts.value(idx),
+            };
+            self.merge_zone(
+                fragment_ids.value(idx),
+                start,
+                start + lengths.value(idx),
+                &stats,
+            );
+        }
+        Ok(())
+    }
+
+    fn into_index(self, store: Arc<dyn IndexStore>) -> ZoneMapIndex {
+        let mut fragments = BTreeMap::<u32, FragmentZones>::new();
+        for ((fragment_id, _), zone) in self.zones {
+            match fragments.get_mut(&fragment_id) {
+                Some(fragment) => {
+                    fragment.stats.merge(&zone.stats);
+                    fragment.zones.push(zone);
+                }
+                None => {
+                    fragments.insert(
+                        fragment_id,
+                        FragmentZones {
+                            stats: zone.stats.clone(),
+                            zones: vec![zone],
+                        },
+                    );
+                }
+            }
+        }
+        ZoneMapIndex {
+            fragments,
+            value_type: self.value_type,
+            store,
+        }
+    }
+
+    async fn write(self, index_store: &dyn IndexStore) -> Result<()> {
+        let zones = self.zones.into_iter().collect::<Vec<_>>();
+        let fragment_ids = UInt32Array::from_iter_values(zones.iter().map(|((frag, _), _)| *frag));
+        let starts = UInt32Array::from_iter_values(zones.iter().map(|(_, zone)| zone.start));
+        let lengths = UInt32Array::from_iter_values(zones.iter().map(|(_, zone)| zone.length));
+        let null_counts =
+            UInt32Array::from_iter_values(zones.iter().map(|(_, zone)| zone.stats.null_count));
+        let (mins, maxs) = if zones.is_empty() {
+            (
+                arrow_array::new_empty_array(&self.value_type),
+                arrow_array::new_empty_array(&self.value_type),
+            )
+        } else {
+            (
+                ScalarValue::iter_to_array(zones.iter().map(|(_, zone)| zone.stats.min.0.clone()))?,
+                ScalarValue::iter_to_array(zones.iter().map(|(_, zone)| zone.stats.max.0.clone()))?,
+            )
+        };
+
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("fragment_id", DataType::UInt32, false),
+            Field::new("zone_start", DataType::UInt32, false),
+            Field::new("zone_length", DataType::UInt32, false),
+            // min and max are null if every value in the zone is null
+            Field::new("min", self.value_type.clone(), true),
+            Field::new("max", self.value_type.clone(), true),
+            Field::new("null_count", DataType::UInt32, false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(fragment_ids),
+                Arc::new(starts),
+                Arc::new(lengths),
+                mins,
+                maxs,
+                Arc::new(null_counts),
+            ],
+        )?;
+
+        let mut zones_file = index_store.new_index_file(ZONEMAP_NAME, schema).await?;
+        zones_file.write_record_batch(batch).await?;
+        zones_file.finish().await?;
+        Ok(())
+    }
+}
+
+/// Trains a zone map index from a stream of values and row ids
+///
+/// The stream must have two columns.  The first column has the values to index and may have
+/// any name.  The second column must be the row ids (UInt64).  The data does not need to be
+/// sorted but zones are computed most efficiently when rows arrive in row id order.
+pub async fn train_zone_map_index(
+    data: SendableRecordBatchStream,
+    index_store: &dyn IndexStore,
+) -> Result<()> {
+    let mut builder = ZoneMapBuilder::new(data.schema().field(0).data_type().clone());
+    builder.add_stream(data).await?;
+    builder.write(index_store).await
+}
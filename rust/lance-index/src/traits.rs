@@ -80,4 +80,13 @@ pub trait DatasetIndexExt {
     ///
     /// If the index does not exist, return Error.
     async fn index_statistics(&self, index_name: &str) -> Result<String>;
+
+    /// Load the index with the given name, and all parts of it that are normally loaded
+    /// lazily (e.g. IVF partitions), into the session cache.
+    ///
+    /// The parts are fetched in parallel.  Calling this when a process starts means the
+    /// first queries don't pay for fetching and decoding the index from storage.
+    ///
+    /// If the index does not exist, return Error.
+    async fn prewarm_index(&self, index_name: &str) -> Result<()>;
 }
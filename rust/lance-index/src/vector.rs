@@ -155,6 +155,30 @@ pub trait VectorIndex: Send + Sync + std::fmt::Debug + Index {
         self.load(reader, offset, length).await
     }
 
+    /// Load everything that would otherwise be loaded on demand (e.g. the partitions of an
+    /// IVF index) into the cache, so that later searches don't need any I/O.
+    async fn prewarm(&self) -> Result<()> {
+        let partition_ids = (0..self.num_partitions()).collect::<Vec<_>>();
+        self.prewarm_partitions(&partition_ids).await
+    }
+
+    /// Load the given partitions into the cache
+    async fn prewarm_partitions(&self, _partition_ids: &[usize]) -> Result<()> {
+        Ok(())
+    }
+
+    /// The number of partitions that are loaded on demand, 0 if the index is loaded at once
+    fn num_partitions(&self) -> usize {
+        0
+    }
+
+    /// The partitions that the index keeps in a cache of its own
+    ///
+    /// Indices that cache their partitions in the session cache don't report them here.
+    fn cached_partitions(&self) -> Vec<usize> {
+        vec![]
+    }
+
     /// Return the IDs of rows in the index.
     fn row_ids(&self) -> Box<dyn Iterator<Item = &'_ u64> + '_>;
 
@@ -126,14 +126,22 @@ async fn run_io_loop(
     }
 }
 
+/// Coalesced reads are not allowed to grow beyond this size, so that a long run of
+/// nearby reads is still split into requests that can run in parallel
+const MAX_COALESCED_READ_SIZE: u64 = 8 * 1024 * 1024;
+
 /// An I/O scheduler which wraps an ObjectStore and throttles the amount of
 /// parallel I/O that can be run.
 ///
-/// TODO: This will also add coalescing
+/// The ranges of a single request are deduplicated and coalesced before they are
+/// read: ranges that overlap, or are separated by no more than the coalesce gap,
+/// are served by one read.  This matters for random access, where many requested
+/// rows can share a page.
 pub struct ScanScheduler {
     object_store: Arc<ObjectStore>,
     io_submitter: async_priority_channel::Sender<IoTask, Reverse<u128>>,
     file_counter: Mutex<u32>,
+    coalesce_gap: u64,
 }
 
 impl Debug for ScanScheduler {
@@ -141,6 +149,7 @@ impl Debug for ScanScheduler {
         f.debug_struct("ScanScheduler")
             .field("object_store", &self.object_store)
             .field("file_counter", &self.file_counter)
+            .field("coalesce_gap", &self.coalesce_gap)
             .finish()
     }
 }
@@ -153,6 +162,24 @@ impl ScanScheduler {
     /// * object_store - the store to wrap
     /// * io_capacity - the maximum number of parallel requests that will be allowed
     pub fn new(object_store: Arc<ObjectStore>, io_capacity: u32) -> Arc<Self> {
+        // Reading up to one block extra costs about the same as reading the block
+        let coalesce_gap = object_store.block_size() as u64;
+        Self::new_with_coalesce_gap(object_store, io_capacity, coalesce_gap)
+    }
+
+    /// Create a new scheduler with the given I/O capacity and coalesce gap
+    ///
+    /// # Arguments
+    ///
+    /// * object_store - the store to wrap
+    /// * io_capacity - the maximum number of parallel requests that will be allowed
+    /// * coalesce_gap - ranges in a request that are at most this many bytes apart are
+    ///   read together.  Use 0 to only merge ranges that overlap or touch.
+    pub fn new_with_coalesce_gap(
+        object_store: Arc<ObjectStore>,
+        io_capacity: u32,
+        coalesce_gap: u64,
+    ) -> Arc<Self> {
         // TODO: we don't have any backpressure in place if the compute thread falls
         // behind.  The scheduler thread will schedule ALL of the I/O and then the
         // loaded data will eventually pile up.
@@ -168,6 +195,7 @@ impl ScanScheduler {
             object_store,
             io_submitter: reg_tx,
             file_counter: Mutex::new(0),
+            coalesce_gap,
         };
         tokio::task::spawn(async move { run_io_loop(reg_rx, io_capacity).await });
         Arc::new(scheduler)
@@ -229,12 +257,53 @@ impl ScanScheduler {
     ) -> impl Future<Output = Result<Vec<Bytes>>> + Send {
         let (tx, rx) = oneshot::channel::<Result<Vec<Bytes>>>();
 
-        self.do_submit_request(reader, request, tx, priority);
+        let (coalesced, slices) = coalesce_ranges(&request, self.coalesce_gap);
+        self.do_submit_request(reader, coalesced, tx, priority);
 
         // Right now, it isn't possible for I/O to be cancelled so a cancel error should
         // not occur
         rx.map(|wrapped_err| wrapped_err.unwrap())
+            .map_ok(move |bytes| {
+                slices
+                    .into_iter()
+                    .map(|(read_idx, range)| bytes[read_idx].slice(range))
+                    .collect()
+            })
+    }
+}
+
+/// Merge ranges that overlap or are within `gap` bytes of each other
+///
+/// Returns the ranges to read, in sorted order, and for each of the input ranges the
+/// index of the read that covers it and its position within that read.
+fn coalesce_ranges(
+    ranges: &[Range<u64>],
+    gap: u64,
+) -> (Vec<Range<u64>>, Vec<(usize, Range<usize>)>) {
+    let mut order = (0..ranges.len()).collect::<Vec<_>>();
+    order.sort_unstable_by_key(|&idx| ranges[idx].start);
+
+    let mut reads: Vec<Range<u64>> = Vec::with_capacity(ranges.len());
+    let mut slices = vec![(0, 0..0); ranges.len()];
+    for idx in order {
+        let range = &ranges[idx];
+        match reads.last_mut() {
+            Some(read)
+                if range.start <= read.end.saturating_add(gap)
+                    && range.end.max(read.end) - read.start <= MAX_COALESCED_READ_SIZE =>
+            {
+                read.end = read.end.max(range.end);
+            }
+            _ => reads.push(range.clone()),
+        }
+        let read_idx = reads.len() - 1;
+        let read_start = reads[read_idx].start;
+        slices[idx] = (
+            read_idx,
+            (range.start - read_start) as usize..(range.end - read_start) as usize,
+        );
     }
+    (reads, slices)
 }
 
 /// A throttled file reader
@@ -345,6 +414,58 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_coalesce_ranges() {
+        let ranges = vec![100..110, 0..10, 5..15, 0..10, 20..30, 1000..1010];
+        let (reads, slices) = coalesce_ranges(&ranges, 10);
+        // 0..10, 5..15 and the duplicate 0..10 overlap and 20..30 is within the gap
+        assert_eq!(reads, vec![0..30, 100..110, 1000..1010]);
+        assert_eq!(
+            slices,
+            vec![
+                (1, 0..10),
+                (0, 0..10),
+                (0, 5..15),
+                (0, 0..10),
+                (0, 20..30),
+                (2, 0..10)
+            ]
+        );
+
+        // Ranges separated by more than the gap are read separately
+        let (reads, _) = coalesce_ranges(&ranges, 0);
+        assert_eq!(reads, vec![0..15, 20..30, 100..110, 1000..1010]);
+
+        // Coalesced reads are capped in size
+        let ranges = vec![
+            0..MAX_COALESCED_READ_SIZE,
+            MAX_COALESCED_READ_SIZE..MAX_COALESCED_READ_SIZE + 1,
+        ];
+        let (reads, _) = coalesce_ranges(&ranges, 0);
+        assert_eq!(reads.len(), 2);
+    }
+
+    #[tokio::test]
+    async fn test_coalesced_read() {
+        let some_path = Path::parse("foo").unwrap();
+        let data = (0..=255).cycle().take(10_000).collect::<Vec<u8>>();
+        let obj_store = Arc::new(ObjectStore::memory());
+        obj_store.put(&some_path, &data).await.unwrap();
+
+        let scheduler = ScanScheduler::new_with_coalesce_gap(obj_store, 16, 100);
+        let file_scheduler = scheduler.open_file(&some_path).await.unwrap();
+
+        let ranges = vec![5000..5010, 0..10, 50..60, 5000..5010, 9000..10_000];
+        let bytes = file_scheduler
+            .submit_request(ranges.clone(), 0)
+            .await
+            .unwrap();
+        assert_eq!(bytes.len(), ranges.len());
+        for (range, actual) in ranges.into_iter().zip(bytes) {
+            assert_eq!(&data[range.start as usize..range.end as usize], &actual);
+        }
+    }
+
     #[tokio::test]
     async fn test_priority() {
         let some_path = Path::parse("foo").unwrap();
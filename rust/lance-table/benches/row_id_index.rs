@@ -8,6 +8,7 @@
 // - [ ] Create a benchmark for the get method
 //   - [x] Average over all valid values
 //   - [ ] Time to get a value that is not in the index
+// - [x] Create a benchmark for batch lookups
 // - [ ] Create a benchmark for the new method (building the in-memory index)
 // Optional:
 // - [ ] Create in-memory size measurement (if possible)
@@ -241,11 +242,79 @@ fn bench_get_single(c: &mut Criterion) {
     group.finish();
 }
 
+fn bench_get_many(c: &mut Criterion) {
+    let mut group = c.benchmark_group("row_id_index_get_many");
+
+    for percent_deletions in [0.0, 0.25, 0.8] {
+        let sequences = make_frag_sequences(num_rows(), 100, percent_deletions);
+        let index = RowIdIndex::new(&sequences).unwrap();
+
+        // A batch of scattered ids, as a take would ask for
+        let total_rows = num_rows();
+        let row_ids = (0..10_000u64)
+            .map(|i| (i * 241861) % total_rows)
+            .collect::<Vec<_>>();
+
+        group.bench_with_input(
+            BenchmarkId::new("GetMany", percent_deletions),
+            &percent_deletions,
+            |b, _| {
+                b.iter(|| index.get_many(&row_ids));
+            },
+        );
+        group.bench_with_input(
+            BenchmarkId::new("GetEach", percent_deletions),
+            &percent_deletions,
+            |b, _| {
+                b.iter(|| {
+                    row_ids
+                        .iter()
+                        .map(|row_id| index.get(*row_id))
+                        .collect::<Vec<_>>()
+                });
+            },
+        );
+    }
+
+    group.finish();
+}
+
+fn bench_apply_fragment_changes(c: &mut Criterion) {
+    let mut group = c.benchmark_group("row_id_index_update");
+
+    // Replace one of the 100 fragments, as compacting a single fragment would
+    let sequences = make_frag_sequences(num_rows(), 100, 0.25);
+    let index = RowIdIndex::new(&sequences).unwrap();
+    let (_, replaced) = sequences[50].clone();
+    let mut updated_sequences = sequences.clone();
+    updated_sequences[50] = (100, replaced.clone());
+
+    group.bench_function("ApplyFragmentChanges", |b| {
+        b.iter(|| {
+            let mut index = index.clone();
+            index
+                .apply_fragment_changes(&[50], &[(100, replaced.clone())])
+                .unwrap();
+        });
+    });
+    group.bench_function("Rebuild", |b| {
+        b.iter(|| RowIdIndex::new(&updated_sequences).unwrap());
+    });
+
+    group.finish();
+}
+
 #[cfg(target_os = "linux")]
 criterion_group!(
     name = benches;
     config=Criterion::default().with_profiler(pprof::criterion::PProfProfiler::new(100, pprof::criterion::Output::Flamegraph(None)));
-    targets=bench_creation, bench_get_single);
+    targets=bench_creation, bench_get_single, bench_get_many, bench_apply_fragment_changes);
 #[cfg(not(target_os = "linux"))]
-criterion_group!(benches, bench_creation, bench_get_single);
+criterion_group!(
+    benches,
+    bench_creation,
+    bench_get_single,
+    bench_get_many,
+    bench_apply_fragment_changes
+);
 criterion_main!(benches);
@@ -17,8 +17,11 @@ pub const FLAG_MOVE_STABLE_ROW_IDS: u64 = 2;
 /// Files are written with the new v2 format (temporary flag, will be removed
 /// once v2 is the default format)
 pub const FLAG_USE_V2_FORMAT: u64 = 4;
+/// The fragment list is stored in separate chunk files that are shared between
+/// versions, rather than inline in the manifest.
+pub const FLAG_FRAGMENT_CHUNKS: u64 = 8;
 /// The first bit that is unknown as a feature flag
-pub const FLAG_UNKNOWN: u64 = 8;
+pub const FLAG_UNKNOWN: u64 = 16;
 
 /// Set the reader and writer feature flags in the manifest based on the contents of the manifest.
 pub fn apply_feature_flags(manifest: &mut Manifest) -> Result<()> {
@@ -56,6 +59,12 @@ pub fn apply_feature_flags(manifest: &mut Manifest) -> Result<()> {
         manifest.writer_feature_flags |= FLAG_MOVE_STABLE_ROW_IDS;
     }
 
+    // Once enabled, fragment chunks are carried over from version to version.
+    if manifest.uses_fragment_chunks() {
+        manifest.reader_feature_flags |= FLAG_FRAGMENT_CHUNKS;
+        manifest.writer_feature_flags |= FLAG_FRAGMENT_CHUNKS;
+    }
+
     Ok(())
 }
 
@@ -81,6 +90,7 @@ mod tests {
         assert!(can_read_dataset(super::FLAG_DELETION_FILES));
         assert!(can_read_dataset(super::FLAG_MOVE_STABLE_ROW_IDS));
         assert!(can_read_dataset(super::FLAG_USE_V2_FORMAT));
+        assert!(can_read_dataset(super::FLAG_FRAGMENT_CHUNKS));
         assert!(can_read_dataset(
             super::FLAG_DELETION_FILES | super::FLAG_MOVE_STABLE_ROW_IDS
         ));
@@ -93,10 +103,12 @@ mod tests {
         assert!(can_write_dataset(super::FLAG_DELETION_FILES));
         assert!(can_write_dataset(super::FLAG_MOVE_STABLE_ROW_IDS));
         assert!(can_read_dataset(super::FLAG_USE_V2_FORMAT));
+        assert!(can_write_dataset(super::FLAG_FRAGMENT_CHUNKS));
         assert!(can_write_dataset(
             super::FLAG_DELETION_FILES
                 | super::FLAG_MOVE_STABLE_ROW_IDS
                 | super::FLAG_USE_V2_FORMAT
+                | super::FLAG_FRAGMENT_CHUNKS
         ));
         assert!(!can_write_dataset(super::FLAG_UNKNOWN));
     }
@@ -30,6 +30,11 @@ pub struct Index {
     ///
     /// If this is None, then this is unknown.
     pub fragment_bitmap: Option<RoaringBitmap>,
+
+    /// The kind of scalar index (e.g. "btree").
+    ///
+    /// If this is None, then this is unknown (vector indices and older scalar indices).
+    pub index_type: Option<String>,
 }
 
 impl DeepSizeOf for Index {
@@ -38,6 +43,7 @@ impl DeepSizeOf for Index {
             + self.fields.deep_size_of_children(context)
             + self.name.deep_size_of_children(context)
             + self.dataset_version.deep_size_of_children(context)
+            + self.index_type.deep_size_of_children(context)
             + self
                 .fragment_bitmap
                 .as_ref()
@@ -69,6 +75,7 @@ impl TryFrom<pb::IndexMetadata> for Index {
             fields: proto.fields,
             dataset_version: proto.dataset_version,
             fragment_bitmap,
+            index_type: (!proto.index_type.is_empty()).then_some(proto.index_type),
         })
     }
 }
@@ -91,6 +98,7 @@ impl From<&Index> for pb::IndexMetadata {
             fields: idx.fields.clone(),
             dataset_version: idx.dataset_version,
             fragment_bitmap,
+            index_type: idx.index_type.clone().unwrap_or_default(),
         }
     }
 }
@@ -1,7 +1,8 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
-use std::ops::Range;
+use std::collections::BTreeSet;
+use std::ops::{Range, RangeInclusive};
 use std::sync::Arc;
 
 use async_trait::async_trait;
@@ -14,7 +15,7 @@ use prost::Message;
 use prost_types::Timestamp;
 
 use super::Fragment;
-use crate::feature_flags::FLAG_MOVE_STABLE_ROW_IDS;
+use crate::feature_flags::{FLAG_FRAGMENT_CHUNKS, FLAG_MOVE_STABLE_ROW_IDS};
 use crate::format::pb;
 use lance_core::cache::FileMetadataCache;
 use lance_core::datatypes::Schema;
@@ -73,6 +74,65 @@ pub struct Manifest {
 
     /// The max row id used so far.
     pub next_row_id: u64,
+
+    /// The chunk files storing the fragment list, if the dataset keeps its
+    /// fragments in chunk files (see [`FLAG_FRAGMENT_CHUNKS`]).
+    ///
+    /// The chunks describe `chunked_fragments`, which is the fragment list
+    /// they were loaded from or written for.  They are only written into the
+    /// manifest while that is still the current fragment list; otherwise the
+    /// chunks must be rewritten first.
+    pub fragment_chunks: Option<Vec<FragmentChunk>>,
+
+    /// The fragments stored in `fragment_chunks`.
+    chunked_fragments: Arc<Vec<Fragment>>,
+
+    /// Whether only some of the fragments in `fragment_chunks` were loaded.
+    fragments_pruned: bool,
+}
+
+/// A contiguous run of the fragment list that is stored in its own file.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct FragmentChunk {
+    /// Path of the chunk file, relative to `{root}/_fragments`
+    pub path: String,
+
+    /// The number of fragments in the chunk.
+    pub num_fragments: u64,
+
+    /// The smallest and largest fragment id in the chunk.
+    pub fragment_ids: RangeInclusive<u64>,
+}
+
+impl FragmentChunk {
+    /// Whether the chunk may hold any of the fragments in `fragment_ids`.
+    pub fn may_contain_any(&self, fragment_ids: &BTreeSet<u64>) -> bool {
+        fragment_ids
+            .range(self.fragment_ids.clone())
+            .next()
+            .is_some()
+    }
+}
+
+impl From<pb::manifest::FragmentChunk> for FragmentChunk {
+    fn from(p: pb::manifest::FragmentChunk) -> Self {
+        Self {
+            path: p.path,
+            num_fragments: p.num_fragments,
+            fragment_ids: p.min_fragment_id..=p.max_fragment_id,
+        }
+    }
+}
+
+impl From<&FragmentChunk> for pb::manifest::FragmentChunk {
+    fn from(chunk: &FragmentChunk) -> Self {
+        Self {
+            path: chunk.path.clone(),
+            num_fragments: chunk.num_fragments,
+            min_fragment_id: *chunk.fragment_ids.start(),
+            max_fragment_id: *chunk.fragment_ids.end(),
+        }
+    }
 }
 
 fn compute_fragment_offsets(fragments: &[Fragment]) -> Vec<usize> {
@@ -106,6 +166,9 @@ impl Manifest {
             transaction_file: None,
             fragment_offsets,
             next_row_id: 0,
+            fragment_chunks: None,
+            chunked_fragments: Arc::new(vec![]),
+            fragments_pruned: false,
         }
     }
 
@@ -131,6 +194,10 @@ impl Manifest {
             transaction_file: None,
             fragment_offsets,
             next_row_id: previous.next_row_id,
+            // Kept so that unchanged chunks can be reused when this is written.
+            fragment_chunks: previous.fragment_chunks.clone(),
+            chunked_fragments: previous.chunked_fragments.clone(),
+            fragments_pruned: previous.fragments_pruned,
         }
     }
 
@@ -259,10 +326,65 @@ impl Manifest {
         self.reader_feature_flags & FLAG_MOVE_STABLE_ROW_IDS != 0
     }
 
+    /// Whether the fragment list is stored in chunk files.
+    pub fn uses_fragment_chunks(&self) -> bool {
+        self.fragment_chunks.is_some()
+    }
+
+    /// The fragments stored in [`Self::fragment_chunks`].
+    ///
+    /// This is the fragment list the chunks were loaded from or written for,
+    /// which may differ from [`Self::fragments`] if the fragments have been
+    /// modified since.
+    pub fn chunked_fragments(&self) -> &[Fragment] {
+        &self.chunked_fragments
+    }
+
+    /// Whether [`Self::fragment_chunks`] store the current fragment list.
+    pub fn fragment_chunks_up_to_date(&self) -> bool {
+        Arc::ptr_eq(&self.fragments, &self.chunked_fragments)
+    }
+
+    /// Set the fragment list loaded from the chunk files.
+    pub fn set_chunked_fragments(&mut self, fragments: Vec<Fragment>) {
+        self.fragments = Arc::new(fragments);
+        self.fragment_offsets = compute_fragment_offsets(&self.fragments);
+        self.chunked_fragments = self.fragments.clone();
+    }
+
+    /// Set the fragments loaded from some of the chunk files.
+    ///
+    /// The manifest then only describes part of the dataset, so no new version
+    /// can be built from it.
+    pub fn set_pruned_fragments(&mut self, fragments: Vec<Fragment>) {
+        self.set_chunked_fragments(fragments);
+        self.fragments_pruned = true;
+    }
+
+    /// Whether only some of the fragments were loaded from the chunk files,
+    /// see [`Self::set_pruned_fragments`].
+    pub fn fragments_pruned(&self) -> bool {
+        self.fragments_pruned
+    }
+
+    /// Record the chunk files that now store the current fragment list.
+    pub fn set_fragment_chunks(&mut self, chunks: Vec<FragmentChunk>) {
+        self.fragment_chunks = Some(chunks);
+        self.chunked_fragments = self.fragments.clone();
+    }
+
     /// Creates a serialized copy of the manifest, suitable for IPC or temp storage
     /// and can be used to create a dataset
+    ///
+    /// The fragments are serialized inline, so the copy does not depend on any
+    /// fragment chunk files.  The exception is a manifest with pruned fragments,
+    /// which refers to its chunk files so that the copy has all of the fragments.
     pub fn serialized(&self) -> Vec<u8> {
-        let pb_manifest: pb::Manifest = self.into();
+        let mut pb_manifest: pb::Manifest = self.into();
+        if !pb_manifest.fragment_chunks.is_empty() && !self.fragments_pruned {
+            pb_manifest.fragment_chunks.clear();
+            pb_manifest.fragments = self.fragments.iter().map(pb::DataFragment::from).collect();
+        }
         pb_manifest.encode_to_vec()
     }
 }
@@ -403,6 +525,16 @@ impl TryFrom<pb::Manifest> for Manifest {
             },
             fragment_offsets,
             next_row_id: p.next_row_id,
+            // The fragments in the chunks are loaded separately, see
+            // `lance_table::io::manifest::load_fragment_chunks`.
+            fragment_chunks: (p.reader_feature_flags & FLAG_FRAGMENT_CHUNKS != 0).then(|| {
+                p.fragment_chunks
+                    .into_iter()
+                    .map(FragmentChunk::from)
+                    .collect()
+            }),
+            chunked_fragments: Arc::new(vec![]),
+            fragments_pruned: false,
         })
     }
 }
@@ -420,6 +552,13 @@ impl From<&Manifest> for pb::Manifest {
             })
         };
         let fields_with_meta: FieldsWithMeta = (&m.schema).into();
+        // Chunks that are out of date are not written; the fragments are
+        // written inline instead, which readers of chunked manifests accept too.
+        let fragment_chunks = m.fragment_chunks.as_ref().filter(|chunks| {
+            !chunks.is_empty()
+                && m.fragment_chunks_up_to_date()
+                && m.reader_feature_flags & FLAG_FRAGMENT_CHUNKS != 0
+        });
         Self {
             fields: fields_with_meta.fields.0,
             version: m.version,
@@ -430,7 +569,11 @@ impl From<&Manifest> for pb::Manifest {
                     library: wv.library.clone(),
                     version: wv.version.clone(),
                 }),
-            fragments: m.fragments.iter().map(pb::DataFragment::from).collect(),
+            fragments: if fragment_chunks.is_some() {
+                vec![]
+            } else {
+                m.fragments.iter().map(pb::DataFragment::from).collect()
+            },
             metadata: fields_with_meta.metadata,
             version_aux_data: m.version_aux_data as u64,
             index_section: m.index_section.map(|i| i as u64),
@@ -441,6 +584,14 @@ impl From<&Manifest> for pb::Manifest {
             max_fragment_id: m.max_fragment_id,
             transaction_file: m.transaction_file.clone().unwrap_or_default(),
             next_row_id: m.next_row_id,
+            fragment_chunks: fragment_chunks
+                .map(|chunks| {
+                    chunks
+                        .iter()
+                        .map(pb::manifest::FragmentChunk::from)
+                        .collect()
+                })
+                .unwrap_or_default(),
         }
     }
 }
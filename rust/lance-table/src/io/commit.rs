@@ -25,6 +25,7 @@
 use std::io;
 use std::sync::atomic::AtomicBool;
 use std::sync::Arc;
+use std::time::Duration;
 use std::{fmt::Debug, fs::DirEntry};
 
 use futures::{
@@ -59,7 +60,7 @@ use {
 use crate::format::{Index, Manifest};
 
 const LATEST_MANIFEST_NAME: &str = "_latest.manifest";
-const VERSIONS_DIR: &str = "_versions";
+pub(crate) const VERSIONS_DIR: &str = "_versions";
 const MANIFEST_EXTENSION: &str = "manifest";
 
 /// Function that writes the manifest to the object store.
@@ -707,12 +708,35 @@ impl Debug for RenameCommitHandler {
 
 #[derive(Debug, Clone)]
 pub struct CommitConfig {
+    /// How many times to retry when another writer commits the same version first
     pub num_retries: u32,
+    /// Upper bound of the delay before the first retry, doubled on each further retry
+    pub backoff_base: Duration,
+    /// Upper bound of the delay before any retry
+    pub backoff_max: Duration,
     // TODO: add isolation_level
 }
 
 impl Default for CommitConfig {
     fn default() -> Self {
-        Self { num_retries: 5 }
+        Self {
+            num_retries: 20,
+            backoff_base: Duration::from_millis(10),
+            backoff_max: Duration::from_secs(1),
+        }
+    }
+}
+
+impl CommitConfig {
+    /// The delay before retry number `attempt`, starting from 0
+    ///
+    /// The delay is drawn uniformly below an exponentially growing bound, so that
+    /// writers that conflicted with each other spread out instead of colliding again.
+    pub fn backoff(&self, attempt: u32) -> Duration {
+        let bound = self
+            .backoff_base
+            .saturating_mul(1 << attempt.min(16))
+            .min(self.backoff_max);
+        bound.mul_f64(rand::random::<f64>())
     }
 }
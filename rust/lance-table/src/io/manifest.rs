@@ -1,19 +1,26 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
-use std::{ops::Range, sync::Arc};
+use std::{
+    collections::{BTreeSet, HashMap},
+    ops::Range,
+    sync::Arc,
+};
 
 use async_trait::async_trait;
 use byteorder::{ByteOrder, LittleEndian};
 use bytes::{Bytes, BytesMut};
+use deepsize::{Context, DeepSizeOf};
+use futures::{stream, StreamExt, TryStreamExt};
 use lance_arrow::DataTypeExt;
 use lance_file::writer::ManifestProvider;
 use object_store::path::Path;
 use prost::Message;
 use snafu::{location, Location};
 use tracing::instrument;
+use uuid::Uuid;
 
-use lance_core::{datatypes::Schema, Error, Result};
+use lance_core::{cache::FileMetadataCache, datatypes::Schema, Error, Result};
 use lance_io::{
     encodings::{binary::BinaryEncoder, plain::PlainEncoder, Encoder},
     object_store::ObjectStore,
@@ -22,13 +29,57 @@ use lance_io::{
     utils::read_message,
 };
 
-use crate::format::{pb, Index, Manifest, MAGIC};
+use super::commit::VERSIONS_DIR;
+use crate::format::{pb, Fragment, FragmentChunk, Index, Manifest, MAGIC};
+
+/// The directory, relative to the dataset root, that holds the fragment chunk files.
+pub const FRAGMENT_CHUNKS_DIR: &str = "_fragments";
+/// The extension of fragment chunk files.
+pub const FRAGMENT_CHUNK_EXTENSION: &str = "chunk";
+/// The number of fragments new chunk files are filled up to.
+///
+/// Chunks of less than half this size are not reused, but merged with their
+/// neighbours when a new version is written, so appends keep rewriting the
+/// last chunk until it is large enough.
+pub const FRAGMENTS_PER_CHUNK: usize = 4096;
+
+/// The number of fragment chunk files read or written concurrently.
+const CHUNK_IO_PARALLELISM: usize = 16;
 
 /// Read Manifest on URI.
 ///
 /// This only reads manifest files. It does not read data files.
 #[instrument(level = "debug", skip(object_store))]
 pub async fn read_manifest(object_store: &ObjectStore, path: &Path) -> Result<Manifest> {
+    read_manifest_with_cache(object_store, path, None).await
+}
+
+/// Read Manifest on URI, looking up fragment chunk files in the cache first.
+///
+/// Fragment chunks are shared between versions, so checking out another
+/// version of the dataset only needs to read the chunks that changed.
+#[instrument(level = "debug", skip(object_store, cache))]
+pub async fn read_manifest_with_cache(
+    object_store: &ObjectStore,
+    path: &Path,
+    cache: Option<&FileMetadataCache>,
+) -> Result<Manifest> {
+    let mut manifest = read_manifest_without_fragment_chunks(object_store, path).await?;
+    load_fragment_chunks(object_store, path, &mut manifest, cache).await?;
+    Ok(manifest)
+}
+
+/// Read Manifest on URI, without reading its fragment chunk files.
+///
+/// If the manifest stores its fragments in chunk files then the fragment list
+/// is left empty.  This is enough for anything that only needs the version
+/// information, such as listing the versions of a dataset, and costs a single
+/// read no matter how many fragments the version has.
+#[instrument(level = "debug", skip(object_store))]
+pub async fn read_manifest_without_fragment_chunks(
+    object_store: &ObjectStore,
+    path: &Path,
+) -> Result<Manifest> {
     let file_size = object_store.inner.head(path).await?.size;
     const PREFETCH_SIZE: usize = 64 * 1024;
     let initial_start = std::cmp::max(file_size as i64 - PREFETCH_SIZE as i64, 0) as usize;
@@ -93,6 +144,227 @@ pub async fn read_manifest(object_store: &ObjectStore, path: &Path) -> Result<Ma
     Manifest::try_from(proto)
 }
 
+/// The decoded contents of a fragment chunk file, as kept in the metadata cache.
+struct CachedFragmentChunk {
+    fragments: Vec<Fragment>,
+    /// Size of the chunk file, used to approximate the size of the fragments.
+    file_size: usize,
+}
+
+impl DeepSizeOf for CachedFragmentChunk {
+    fn deep_size_of_children(&self, _: &mut Context) -> usize {
+        self.fragments.capacity() * std::mem::size_of::<Fragment>() + self.file_size
+    }
+}
+
+/// The directory holding the fragment chunk files of the dataset that the
+/// manifest at `manifest_path` belongs to.
+fn fragment_chunks_dir(manifest_path: &Path) -> Path {
+    let mut parts = manifest_path.parts().collect::<Vec<_>>();
+    // Manifests are stored in `{root}/_versions`, except for `{root}/_latest.manifest`
+    parts.pop();
+    if parts.last().map(|part| part.as_ref()) == Some(VERSIONS_DIR) {
+        parts.pop();
+    }
+    Path::from_iter(parts).child(FRAGMENT_CHUNKS_DIR)
+}
+
+async fn read_fragment_chunk(
+    object_store: &ObjectStore,
+    path: &Path,
+    chunk: &FragmentChunk,
+) -> Result<CachedFragmentChunk> {
+    let data = object_store.inner.get(path).await?.bytes().await?;
+    let file_size = data.len();
+    let fragments = pb::FragmentList::decode(data)?
+        .fragments
+        .into_iter()
+        .map(Fragment::try_from)
+        .collect::<Result<Vec<_>>>()?;
+    if fragments.len() as u64 != chunk.num_fragments {
+        return Err(Error::corrupt_file(
+            path.clone(),
+            format!(
+                "Expected {} fragments in fragment chunk, got {}",
+                chunk.num_fragments,
+                fragments.len()
+            ),
+            location!(),
+        ));
+    }
+    Ok(CachedFragmentChunk {
+        fragments,
+        file_size,
+    })
+}
+
+/// Load the fragments of a manifest that stores them in chunk files.
+///
+/// This is a no-op if the manifest stores its fragments inline.
+pub async fn load_fragment_chunks(
+    object_store: &ObjectStore,
+    manifest_path: &Path,
+    manifest: &mut Manifest,
+    cache: Option<&FileMetadataCache>,
+) -> Result<()> {
+    load_fragment_chunks_pruned(object_store, manifest_path, manifest, cache, None).await
+}
+
+/// Load the fragments of a manifest that stores them in chunk files, keeping
+/// only the fragments in `fragment_ids` (if given).
+///
+/// Only the chunks whose fragment id range overlaps `fragment_ids` are read, so
+/// the cost depends on the number of fragments needed rather than on the size
+/// of the dataset.  If `fragment_ids` is given the manifest is marked as pruned
+/// (see [`Manifest::set_pruned_fragments`]), unless it stores its fragments
+/// inline, in which case they are all kept.
+pub async fn load_fragment_chunks_pruned(
+    object_store: &ObjectStore,
+    manifest_path: &Path,
+    manifest: &mut Manifest,
+    cache: Option<&FileMetadataCache>,
+    fragment_ids: Option<&BTreeSet<u64>>,
+) -> Result<()> {
+    let chunks = match &manifest.fragment_chunks {
+        Some(chunks) if !chunks.is_empty() => chunks,
+        _ => return Ok(()),
+    };
+    let dir = fragment_chunks_dir(manifest_path);
+    let needed = chunks
+        .iter()
+        .filter(|chunk| fragment_ids.map_or(true, |ids| chunk.may_contain_any(ids)));
+    let loaded: Vec<Arc<CachedFragmentChunk>> = stream::iter(needed)
+        .map(|chunk| {
+            let path = dir.child(chunk.path.as_str());
+            async move {
+                match cache {
+                    Some(cache) => {
+                        cache
+                            .get_or_insert(&path, |_| {
+                                read_fragment_chunk(object_store, &path, chunk)
+                            })
+                            .await
+                    }
+                    None => Ok(Arc::new(
+                        read_fragment_chunk(object_store, &path, chunk).await?,
+                    )),
+                }
+            }
+        })
+        .buffered(CHUNK_IO_PARALLELISM)
+        .try_collect()
+        .await?;
+
+    let fragments = loaded.iter().flat_map(|chunk| chunk.fragments.iter());
+    match fragment_ids {
+        Some(ids) => manifest.set_pruned_fragments(
+            fragments
+                .filter(|fragment| ids.contains(&fragment.id))
+                .cloned()
+                .collect(),
+        ),
+        None => manifest.set_chunked_fragments(fragments.cloned().collect()),
+    }
+    Ok(())
+}
+
+/// Write the fragments of a manifest that stores them in chunk files.
+///
+/// Chunks of the previous version whose fragments are unchanged, and that are
+/// at least half full, are reused as they are.  The remaining fragments are
+/// written to new chunk files of up to [`FRAGMENTS_PER_CHUNK`] fragments.
+///
+/// This is a no-op if the manifest stores its fragments inline, or if the
+/// chunks are already up to date.  It must be called before writing a manifest
+/// that uses fragment chunks, otherwise the fragments are written inline.
+pub async fn write_fragment_chunks(
+    object_store: &ObjectStore,
+    base: &Path,
+    manifest: &mut Manifest,
+) -> Result<()> {
+    let Some(previous_chunks) = &manifest.fragment_chunks else {
+        return Ok(());
+    };
+    if manifest.fragment_chunks_up_to_date() {
+        return Ok(());
+    }
+
+    // Index the reusable chunks of the previous version by their first fragment id.
+    let previous_fragments = manifest.chunked_fragments();
+    let mut reusable = HashMap::new();
+    let mut offset = 0;
+    for chunk in previous_chunks {
+        let end = offset + chunk.num_fragments as usize;
+        if end > previous_fragments.len() {
+            // The chunks were never loaded, so nothing can be reused.
+            reusable.clear();
+            break;
+        }
+        if chunk.num_fragments as usize >= FRAGMENTS_PER_CHUNK / 2 {
+            reusable.insert(previous_fragments[offset].id, (chunk, offset..end));
+        }
+        offset = end;
+    }
+
+    let fragments = manifest.fragments.as_slice();
+    let mut chunks = Vec::new();
+    let mut new_chunks = Vec::new();
+    let mut new_chunk = |range: Range<usize>, chunks: &mut Vec<FragmentChunk>| {
+        let path = format!("{}.{}", Uuid::new_v4(), FRAGMENT_CHUNK_EXTENSION);
+        let ids = fragments[range.clone()].iter().map(|fragment| fragment.id);
+        chunks.push(FragmentChunk {
+            path: path.clone(),
+            num_fragments: range.len() as u64,
+            fragment_ids: ids.clone().min().unwrap_or_default()..=ids.max().unwrap_or_default(),
+        });
+        new_chunks.push((path, range));
+    };
+    let mut pending_start = 0;
+    let mut pos = 0;
+    while pos < fragments.len() {
+        let reused = reusable.get(&fragments[pos].id).filter(|(_, range)| {
+            fragments.get(pos..pos + range.len()) == Some(&previous_fragments[range.clone()])
+        });
+        if let Some((chunk, range)) = reused {
+            if pending_start < pos {
+                new_chunk(pending_start..pos, &mut chunks);
+            }
+            chunks.push(FragmentChunk::clone(chunk));
+            pos += range.len();
+            pending_start = pos;
+        } else {
+            pos += 1;
+            if pos - pending_start == FRAGMENTS_PER_CHUNK {
+                new_chunk(pending_start..pos, &mut chunks);
+                pending_start = pos;
+            }
+        }
+    }
+    if pending_start < pos {
+        new_chunk(pending_start..pos, &mut chunks);
+    }
+
+    let dir = base.child(FRAGMENT_CHUNKS_DIR);
+    stream::iter(new_chunks)
+        .map(|(path, range)| {
+            let path = dir.child(path.as_str());
+            let data = pb::FragmentList {
+                fragments: fragments[range]
+                    .iter()
+                    .map(pb::DataFragment::from)
+                    .collect(),
+            }
+            .encode_to_vec();
+            async move { object_store.inner.put(&path, data.into()).await }
+        })
+        .buffer_unordered(CHUNK_IO_PARALLELISM)
+        .try_collect::<Vec<_>>()
+        .await?;
+
+    manifest.set_fragment_chunks(chunks);
+    Ok(())
+}
+
 #[instrument(level = "debug", skip(object_store, manifest))]
 pub async fn read_manifest_indexes(
     object_store: &ObjectStore,
@@ -208,6 +480,7 @@ mod test {
     use arrow_array::{Int32Array, RecordBatch};
     use std::collections::HashMap;
 
+    use crate::feature_flags::FLAG_FRAGMENT_CHUNKS;
     use crate::format::SelfDescribingFileReader;
     use arrow_schema::{DataType, Field as ArrowField, Schema as ArrowSchema};
     use lance_file::format::{MAGIC, MAJOR_VERSION, MINOR_VERSION};
@@ -263,6 +536,79 @@ mod test {
         test_roundtrip_manifest(1000, 1000).await;
     }
 
+    async fn write_and_read_manifest(store: &ObjectStore, manifest: &mut Manifest) -> Manifest {
+        let path = Path::from(format!("/chunks/_versions/{}.manifest", manifest.version));
+        let mut writer = store.create(&path).await.unwrap();
+        let pos = write_manifest(&mut writer, manifest, None).await.unwrap();
+        writer
+            .write_magics(pos, MAJOR_VERSION, MINOR_VERSION, MAGIC)
+            .await
+            .unwrap();
+        writer.shutdown().await.unwrap();
+        read_manifest(store, &path).await.unwrap()
+    }
+
+    #[tokio::test]
+    async fn test_fragment_chunks() {
+        let store = ObjectStore::memory();
+        let base = Path::from("/chunks");
+        let arrow_schema = ArrowSchema::new(vec![ArrowField::new("i", DataType::Int64, false)]);
+        let schema = Schema::try_from(&arrow_schema).unwrap();
+
+        let num_fragments = 2 * FRAGMENTS_PER_CHUNK as u64 + 10;
+        let fragments = (0..num_fragments).map(Fragment::new).collect::<Vec<_>>();
+        let mut manifest = Manifest::new(schema.clone(), Arc::new(fragments));
+        manifest.fragment_chunks = Some(vec![]);
+        manifest.reader_feature_flags |= FLAG_FRAGMENT_CHUNKS;
+        write_fragment_chunks(&store, &base, &mut manifest)
+            .await
+            .unwrap();
+        let chunks = manifest.fragment_chunks.clone().unwrap();
+        let sizes = chunks.iter().map(|c| c.num_fragments).collect::<Vec<_>>();
+        assert_eq!(sizes, vec![4096, 4096, 10]);
+
+        // The fragments are only stored in the chunk files
+        let encoded = pb::Manifest::from(&manifest);
+        assert!(encoded.fragments.is_empty());
+        assert_eq!(encoded.fragment_chunks.len(), 3);
+
+        let read = write_and_read_manifest(&store, &mut manifest).await;
+        assert_eq!(read.fragments, manifest.fragments);
+        assert_eq!(read.fragment_chunks, manifest.fragment_chunks);
+        assert!(read.fragment_chunks_up_to_date());
+
+        // Modify a fragment in the first chunk and append two more
+        let mut fragments = read.fragments.as_ref().clone();
+        fragments[5].physical_rows = Some(100);
+        fragments.extend((num_fragments..num_fragments + 2).map(Fragment::new));
+        let mut next = Manifest::new_from_previous(&read, schema, Arc::new(fragments));
+        next.reader_feature_flags |= FLAG_FRAGMENT_CHUNKS;
+        assert!(!next.fragment_chunks_up_to_date());
+        write_fragment_chunks(&store, &base, &mut next)
+            .await
+            .unwrap();
+        let next_chunks = next.fragment_chunks.clone().unwrap();
+        let sizes = next_chunks
+            .iter()
+            .map(|c| c.num_fragments)
+            .collect::<Vec<_>>();
+        // The small last chunk is merged with the new fragments
+        assert_eq!(sizes, vec![4096, 4096, 12]);
+        assert_ne!(next_chunks[0], chunks[0]);
+        assert_eq!(next_chunks[1], chunks[1]);
+        assert_ne!(next_chunks[2], chunks[2]);
+
+        let read_next = write_and_read_manifest(&store, &mut next).await;
+        assert_eq!(read_next.fragments, next.fragments);
+        assert_eq!(read_next.fragments[5].physical_rows, Some(100));
+
+        // Serialized manifests don't depend on the chunk files
+        let copy =
+            Manifest::try_from(pb::Manifest::decode(read_next.serialized().as_slice()).unwrap())
+                .unwrap();
+        assert_eq!(copy.fragments, read_next.fragments);
+    }
+
     #[tokio::test]
     async fn test_update_schema_metadata() {
         let store = ObjectStore::memory();
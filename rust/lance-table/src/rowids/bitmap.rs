@@ -1,8 +1,16 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
+use arrow_buffer::bit_chunk_iterator::UnalignedBitChunk;
+use arrow_buffer::bit_util;
 use deepsize::DeepSizeOf;
 
+/// A bitmap that owns its bytes, laid out the same way as an Arrow validity buffer
+///
+/// The bit manipulation is done with the Arrow buffer utilities.  The bytes are kept in a
+/// `Vec` rather than an Arrow `BooleanBuffer` because they are written to and read from
+/// the row id protobuf messages as is, and bits are cleared one at a time while a segment
+/// is built.
 #[derive(PartialEq, Eq, Clone, DeepSizeOf)]
 pub struct Bitmap {
     pub data: Vec<u8>,
@@ -21,35 +29,29 @@ impl std::fmt::Debug for Bitmap {
 
 impl Bitmap {
     pub fn new_empty(len: usize) -> Self {
-        let data = vec![0; (len + 7) / 8];
+        let data = vec![0; bit_util::ceil(len, 8)];
         Self { data, len }
     }
 
     pub fn new_full(len: usize) -> Self {
-        let mut data = vec![0xff; (len + 7) / 8];
+        let mut data = vec![0xff; bit_util::ceil(len, 8)];
         // Zero past the end of len
-        let remainder = len % 8;
-        if remainder != 0 {
-            let last_byte = data.last_mut().unwrap();
-            let bits_to_clear = 8 - remainder;
-            for offset_from_end in 0..bits_to_clear {
-                let i = 7 - offset_from_end;
-                *last_byte &= !(1 << i);
-            }
+        for i in len..data.len() * 8 {
+            bit_util::unset_bit(&mut data, i);
         }
         Self { data, len }
     }
 
     pub fn set(&mut self, i: usize) {
-        self.data[i / 8] |= 1 << (i % 8);
+        bit_util::set_bit(&mut self.data, i);
     }
 
     pub fn clear(&mut self, i: usize) {
-        self.data[i / 8] &= !(1 << (i % 8));
+        bit_util::unset_bit(&mut self.data, i);
     }
 
     pub fn get(&self, i: usize) -> bool {
-        self.data[i / 8] & (1 << (i % 8)) != 0
+        bit_util::get_bit(&self.data, i)
     }
 
     pub fn len(&self) -> usize {
@@ -65,7 +67,7 @@ impl Bitmap {
     }
 
     pub fn count_ones(&self) -> usize {
-        self.data.iter().map(|&x| x.count_ones() as usize).sum()
+        self.slice(0, self.len).count_ones()
     }
 
     pub fn count_zeros(&self) -> usize {
@@ -94,43 +96,8 @@ pub struct BitmapSlice<'a> {
 
 impl<'a> BitmapSlice<'a> {
     pub fn count_ones(&self) -> usize {
-        if self.len == 0 {
-            return 0;
-        }
-        let first_byte = self.start / 8;
-        let last_byte = (self.start + self.len - 1) / 8;
-        if first_byte == last_byte {
-            let byte = self.bitmap.data[first_byte];
-            let mut count = 0;
-            for i in self.start % 8..((self.start + self.len - 1) % 8 + 1) {
-                if byte & (1 << i) != 0 {
-                    count += 1;
-                }
-            }
-            count
-        } else {
-            let mut count = 0;
-            // Handle first byte
-            for i in self.start % 8..8 {
-                if self.bitmap.data[first_byte] & (1 << i) != 0 {
-                    count += 1;
-                }
-            }
-
-            // Handle last bytes
-            for i in 0..((self.start + self.len - 1) % 8 + 1) {
-                if self.bitmap.data[last_byte] & (1 << i) != 0 {
-                    count += 1;
-                }
-            }
-
-            // Middle bytes can just use count_ones
-            count += self.bitmap.data[first_byte + 1..last_byte]
-                .iter()
-                .map(|&x| x.count_ones() as usize)
-                .sum::<usize>();
-            count
-        }
+        // Counts a word at a time, handling the unaligned start and end
+        UnalignedBitChunk::new(&self.bitmap.data, self.start, self.len).count_ones()
     }
 
     pub fn count_zeros(&self) -> usize {
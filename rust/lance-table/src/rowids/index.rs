@@ -23,8 +23,10 @@ use super::{RowIdSequence, U64Segment};
 // (Implementation)
 // Disjoint ranges of row ids are stored as the keys of the map. The values are
 // a pair of segments. The first segment is the row ids, and the second segment
-// is the addresses.
-pub struct RowIdIndex(RangeInclusiveMap<u64, (U64Segment, U64Segment)>);
+// is the addresses. The pairs are shared so that cloning the index, to update it
+// for a new version, doesn't copy the segments of unchanged fragments.
+#[derive(Clone)]
+pub struct RowIdIndex(RangeInclusiveMap<u64, Arc<(U64Segment, U64Segment)>>);
 
 impl RowIdIndex {
     /// Create a new index from a list of fragment ids and their corresponding row id sequences.
@@ -52,18 +54,89 @@ impl RowIdIndex {
     ///
     /// Will return None if the row id does not exist in the index.
     pub fn get(&self, row_id: u64) -> Option<RowAddress> {
-        let (row_id_segment, address_segment) = self.0.get(&row_id)?;
+        let (row_id_segment, address_segment) = self.0.get(&row_id)?.as_ref();
         let pos = row_id_segment.position(row_id)?;
         let address = address_segment.get(pos)?;
         Some(RowAddress::new_from_id(address))
     }
+
+    /// Get the addresses for a batch of row ids.
+    ///
+    /// The result is in the same order as `row_ids`, with None for row ids that do not
+    /// exist in the index.  The ids are visited in sorted order so that consecutive ids
+    /// that fall into the same segment only need one search of the map.
+    pub fn get_many(&self, row_ids: &[u64]) -> Vec<Option<RowAddress>> {
+        let mut order = (0..row_ids.len()).collect::<Vec<_>>();
+        order.sort_unstable_by_key(|&i| row_ids[i]);
+
+        let mut addresses = vec![None; row_ids.len()];
+        let mut current: Option<(&RangeInclusive<u64>, &Arc<(U64Segment, U64Segment)>)> = None;
+        for i in order {
+            let row_id = row_ids[i];
+            if !current.is_some_and(|(range, _)| range.contains(&row_id)) {
+                current = self.0.get_key_value(&row_id);
+            }
+            addresses[i] = current.and_then(|(_, segments)| {
+                let (row_id_segment, address_segment) = segments.as_ref();
+                let pos = row_id_segment.position(row_id)?;
+                address_segment.get(pos).map(RowAddress::new_from_id)
+            });
+        }
+        addresses
+    }
+
+    /// Update the index in place after fragments were removed, added or rewritten.
+    ///
+    /// Entries pointing into `removed_fragments` are dropped and the sequences of
+    /// `new_fragments` are added.  A fragment that was rewritten (e.g. by an update or
+    /// compaction) should appear in both.  This only touches the changed fragments, the
+    /// other sequences don't need to be loaded again.
+    pub fn apply_fragment_changes(
+        &mut self,
+        removed_fragments: &[u32],
+        new_fragments: &[(u32, Arc<RowIdSequence>)],
+    ) -> Result<()> {
+        if !removed_fragments.is_empty() {
+            let removed_ranges = self
+                .0
+                .iter()
+                .filter(|(_, segments)| {
+                    segments.1.range().is_some_and(|addresses| {
+                        let fragment_id = RowAddress::new_from_id(*addresses.start()).fragment_id();
+                        removed_fragments.contains(&fragment_id)
+                    })
+                })
+                .map(|(range, _)| range.clone())
+                .collect::<Vec<_>>();
+            for range in removed_ranges {
+                self.0.remove(range);
+            }
+        }
+
+        let pieces = new_fragments
+            .iter()
+            .flat_map(|(fragment_id, sequence)| decompose_sequence(*fragment_id, sequence))
+            .collect::<Vec<_>>();
+        // Same restriction as in `new`
+        if pieces.iter().any(|(range, _)| self.0.overlaps(range)) {
+            return Err(Error::NotSupported {
+                source: "Overlapping ranges are not yet supported".into(),
+                location: location!(),
+            });
+        }
+        for (range, segments) in pieces {
+            self.0.insert(range, segments);
+        }
+        Ok(())
+    }
 }
 
 impl DeepSizeOf for RowIdIndex {
     fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
         self.0
             .iter()
-            .map(|(_, (row_id_segment, address_segment))| {
+            .map(|(_, segments)| {
+                let (row_id_segment, address_segment) = segments.as_ref();
                 (2 * std::mem::size_of::<u64>())
                     + std::mem::size_of::<(U64Segment, U64Segment)>()
                     + row_id_segment.deep_size_of_children(context)
@@ -76,7 +149,7 @@ impl DeepSizeOf for RowIdIndex {
 fn decompose_sequence(
     fragment_id: u32,
     sequence: &RowIdSequence,
-) -> Vec<(RangeInclusive<u64>, (U64Segment, U64Segment))> {
+) -> Vec<(RangeInclusive<u64>, Arc<(U64Segment, U64Segment)>)> {
     let mut start_address: u64 = RowAddress::first_row(fragment_id).into();
     sequence
         .0
@@ -88,7 +161,7 @@ fn decompose_sequence(
 
             let coverage = segment.range()?;
 
-            Some((coverage, (segment.clone(), address_segment)))
+            Some((coverage, Arc::new((segment.clone(), address_segment))))
         })
         .collect()
 }
@@ -134,5 +207,71 @@ mod tests {
         assert_eq!(index.get(40), Some(RowAddress::new_from_parts(20, 2)));
         assert_eq!(index.get(60), Some(RowAddress::new_from_parts(20, 4)));
         assert_eq!(index.get(61), None);
+
+        let queries = [60, 15, 0, 61, 25, 16, 17];
+        let expected = queries.iter().map(|id| index.get(*id)).collect::<Vec<_>>();
+        assert_eq!(index.get_many(&queries), expected);
+    }
+
+    #[test]
+    fn test_apply_fragment_changes() {
+        let mut index = RowIdIndex::new(&[
+            (0, Arc::new(RowIdSequence::from(0..10))),
+            (1, Arc::new(RowIdSequence::from(10..20))),
+        ])
+        .unwrap();
+
+        // Compact fragment 1 into fragment 2, dropping the deleted row 15
+        let mut compacted = RowIdSequence::from(10..20);
+        compacted.delete(vec![15]);
+        index
+            .apply_fragment_changes(&[1], &[(2, Arc::new(compacted))])
+            .unwrap();
+        assert_eq!(index.get(3), Some(RowAddress::new_from_parts(0, 3)));
+        assert_eq!(index.get(10), Some(RowAddress::new_from_parts(2, 0)));
+        assert_eq!(index.get(15), None);
+        assert_eq!(index.get(16), Some(RowAddress::new_from_parts(2, 5)));
+
+        // Same result as building from scratch
+        let mut compacted = RowIdSequence::from(10..20);
+        compacted.delete(vec![15]);
+        let rebuilt = RowIdIndex::new(&[
+            (0, Arc::new(RowIdSequence::from(0..10))),
+            (2, Arc::new(compacted)),
+        ])
+        .unwrap();
+        let all_ids = (0..25).collect::<Vec<_>>();
+        assert_eq!(index.get_many(&all_ids), rebuilt.get_many(&all_ids));
+
+        // Row ids must stay unique
+        assert!(index
+            .apply_fragment_changes(&[], &[(3, Arc::new(RowIdSequence::from(5..6)))])
+            .is_err());
+    }
+
+    #[test]
+    fn test_clone_shares_segments() {
+        let index = RowIdIndex::new(&[
+            (0, Arc::new(RowIdSequence::from(0..10))),
+            (1, Arc::new(RowIdSequence::from(10..20))),
+        ])
+        .unwrap();
+
+        let mut updated = index.clone();
+        updated
+            .apply_fragment_changes(&[1], &[(2, Arc::new(RowIdSequence::from(10..20)))])
+            .unwrap();
+
+        // The unchanged fragment is shared, the rewritten one is not
+        assert!(Arc::ptr_eq(
+            index.0.get(&0).unwrap(),
+            updated.0.get(&0).unwrap()
+        ));
+        assert!(!Arc::ptr_eq(
+            index.0.get(&10).unwrap(),
+            updated.0.get(&10).unwrap()
+        ));
+        assert_eq!(index.get(10), Some(RowAddress::new_from_parts(1, 0)));
+        assert_eq!(updated.get(10), Some(RowAddress::new_from_parts(2, 0)));
     }
 }
@@ -196,35 +196,54 @@ pub fn apply_row_id_and_deletes(
         batch.num_columns() > 0 || config.with_row_id || config.with_row_addr || has_deletions
     );
 
-    let should_fetch_row_id = config.with_row_id || has_deletions;
-
     let num_rows = batch.num_rows() as u32;
+    let batch_params = config
+        .params
+        .slice(batch_offset as usize, num_rows as usize)
+        .unwrap();
+    // When the batch covers a contiguous range of rows the deletion mask can be built
+    // directly from the range without materializing the row addresses
+    let deletion_range = match &batch_params {
+        ReadBatchParams::Range(range) => Some(range.start as u32..range.end as u32),
+        _ => None,
+    };
 
-    let row_addrs =
-        if config.with_row_addr || (should_fetch_row_id && config.row_id_sequence.is_none()) {
-            let ids_in_batch = config
-                .params
-                .slice(batch_offset as usize, num_rows as usize)
-                .unwrap()
-                .to_offsets()
-                .unwrap();
-            let row_addrs: UInt64Array = ids_in_batch
-                .values()
-                .iter()
-                .map(|row_id| u64::from(RowAddress::new_from_parts(fragment_id, *row_id)))
-                .collect();
-
-            Some(Arc::new(row_addrs))
-        } else {
-            None
-        };
+    let row_addrs = if config.with_row_addr
+        || (config.with_row_id && config.row_id_sequence.is_none())
+        || (has_deletions && deletion_range.is_none())
+    {
+        let ids_in_batch = batch_params.to_offsets().unwrap();
+        let row_addrs: UInt64Array = ids_in_batch
+            .values()
+            .iter()
+            .map(|row_id| u64::from(RowAddress::new_from_parts(fragment_id, *row_id)))
+            .collect();
+
+        Some(Arc::new(row_addrs))
+    } else {
+        None
+    };
 
-    let row_ids = if should_fetch_row_id {
+    let row_ids = if config.with_row_id {
         if let Some(row_id_sequence) = &config.row_id_sequence {
-            let row_ids = row_id_sequence
-                .slice(batch_offset as usize, num_rows as usize)
-                .iter()
-                .collect::<UInt64Array>();
+            // The sequence is indexed by the offset of the row in the fragment
+            let row_ids = match &batch_params {
+                ReadBatchParams::Range(range) => row_id_sequence
+                    .slice(range.start, range.len())
+                    .iter()
+                    .collect::<UInt64Array>(),
+                params => params
+                    .to_offsets()
+                    .unwrap()
+                    .values()
+                    .iter()
+                    .map(|offset| {
+                        row_id_sequence
+                            .get(*offset as usize)
+                            .expect("row offset out of range of the row id sequence")
+                    })
+                    .collect::<UInt64Array>(),
+            };
             Some(Arc::new(row_ids))
         } else {
             // If we don't have a row id sequence, can assume the row ids are
@@ -243,9 +262,12 @@ pub fn apply_row_id_and_deletes(
     // We should try to move this to later.
     let span = tracing::span!(tracing::Level::DEBUG, "apply_deletions");
     let _enter = span.enter();
-    let deletion_mask = deletion_vector.and_then(|v| {
-        let row_addrs: &[u64] = row_addrs.as_ref().unwrap().values();
-        v.build_predicate(row_addrs.iter())
+    let deletion_mask = deletion_vector.and_then(|v| match &deletion_range {
+        Some(range) => v.build_predicate_for_range(range.clone()),
+        None => {
+            let row_addrs: &[u64] = row_addrs.as_ref().unwrap().values();
+            v.build_predicate(row_addrs.iter())
+        }
     });
 
     let batch = if config.with_row_id {
@@ -264,6 +286,8 @@ pub fn apply_row_id_and_deletes(
 
     match (deletion_mask, config.make_deletions_null) {
         (None, _) => Ok(batch),
+        // Every row in the batch was deleted, no need to run the filter kernel
+        (Some(mask), false) if mask.true_count() == 0 => Ok(batch.slice(0, 0)),
         (Some(mask), false) => Ok(arrow::compute::filter_record_batch(&batch, &mask)?),
         (Some(mask), true) => Ok(apply_deletions_as_nulls(batch, &mask)?),
     }
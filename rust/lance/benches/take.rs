@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! Benchmark of taking random rows from a dataset with many fragments.
+//!
+//! Run benchmark.
+//! ```
+//! cargo bench --bench take
+//! ```.
+
+use arrow_array::{Float32Array, Int32Array, RecordBatch, RecordBatchIterator};
+use arrow_schema::{DataType, Field, Schema as ArrowSchema};
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion};
+#[cfg(target_os = "linux")]
+use pprof::criterion::{Output, PProfProfiler};
+use rand::Rng;
+use std::sync::Arc;
+
+use lance::dataset::{Dataset, WriteMode, WriteParams};
+
+const NUM_ROWS: usize = 1_000_000;
+const ROWS_PER_FRAGMENT: usize = 200;
+
+fn bench_take(c: &mut Criterion) {
+    // default tokio runtime
+    let rt = tokio::runtime::Runtime::new().unwrap();
+    let dataset = rt.block_on(create_dataset("./take_test.lance"));
+    let projection = dataset.schema().clone();
+
+    let mut rng = rand::thread_rng();
+    for num_indices in [100, 10_000, 100_000] {
+        let indices = (0..num_indices)
+            .map(|_| rng.gen_range(0..NUM_ROWS as u64))
+            .collect::<Vec<_>>();
+        c.bench_with_input(
+            BenchmarkId::new(
+                format!("Take from {} fragments", NUM_ROWS / ROWS_PER_FRAGMENT),
+                num_indices,
+            ),
+            &indices,
+            |b, indices| {
+                b.to_async(&rt).iter(|| async {
+                    let batch = dataset.take(indices, &projection).await.unwrap();
+                    assert_eq!(batch.num_rows(), indices.len());
+                })
+            },
+        );
+    }
+}
+
+async fn create_dataset(path: &str) -> Dataset {
+    let schema = Arc::new(ArrowSchema::new(vec![
+        Field::new("i", DataType::Int32, false),
+        Field::new("f", DataType::Float32, false),
+    ]));
+    let batch_size = 10_000;
+    let batches: Vec<RecordBatch> = (0..(NUM_ROWS / batch_size) as i32)
+        .map(|i| {
+            let range = i * batch_size as i32..(i + 1) * batch_size as i32;
+            RecordBatch::try_new(
+                schema.clone(),
+                vec![
+                    Arc::new(Int32Array::from_iter_values(range.clone())),
+                    Arc::new(Float32Array::from_iter_values(range.map(|x| x as f32))),
+                ],
+            )
+            .unwrap()
+        })
+        .collect();
+
+    std::fs::remove_dir_all(path).map_or_else(|_| println!("{} not exists", path), |_| {});
+    let write_params = WriteParams {
+        max_rows_per_file: ROWS_PER_FRAGMENT,
+        max_rows_per_group: ROWS_PER_FRAGMENT,
+        mode: WriteMode::Create,
+        ..Default::default()
+    };
+    let reader = RecordBatchIterator::new(batches.into_iter().map(Ok), schema.clone());
+    Dataset::write(reader, path, Some(write_params))
+        .await
+        .unwrap()
+}
+
+#[cfg(target_os = "linux")]
+criterion_group!(
+    name=benches;
+    config = Criterion::default().significance_level(0.1).sample_size(10)
+        .with_profiler(PProfProfiler::new(100, Output::Flamegraph(None)));
+    targets = bench_take);
+#[cfg(not(target_os = "linux"))]
+criterion_group!(
+    name=benches;
+    config = Criterion::default().significance_level(0.1).sample_size(10);
+    targets = bench_take);
+criterion_main!(benches);
@@ -68,7 +68,7 @@ impl TableProvider for LanceTableProvider {
 
     async fn scan(
         &self,
-        _state: &SessionState,
+        state: &SessionState,
         projection: Option<&Vec<usize>>,
         filters: &[Expr],
         limit: Option<usize>,
@@ -102,8 +102,14 @@ impl TableProvider for LanceTableProvider {
             scan.filter_expr(combined_filter);
         }
         scan.limit(limit.map(|l| l as i64), None)?;
-
-        scan.create_plan().await.map_err(DataFusionError::from)
+        // DataFusion doesn't promise any order without a sort, so let it read
+        // the table in parallel partitions
+        scan.scan_in_order(false);
+        scan.target_partitions(state.config().target_partitions());
+
+        scan.create_partitioned_plan()
+            .await
+            .map_err(DataFusionError::from)
     }
 
     // Since we are using datafusion itself to apply the filters it should
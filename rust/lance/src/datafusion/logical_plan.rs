@@ -40,7 +40,7 @@ impl TableProvider for Dataset {
 
     async fn scan(
         &self,
-        _: &SessionState,
+        state: &SessionState,
         projection: Option<&Vec<usize>>,
         _: &[Expr],
         limit: Option<usize>,
@@ -63,7 +63,16 @@ impl TableProvider for Dataset {
         if let Some(limit) = limit {
             scanner.limit(Some(limit as i64), None)?;
         }
-        let plan: Arc<dyn ExecutionPlan> = scanner.scan(false, false, false, projections.into());
+        // DataFusion doesn't promise any order without a sort, so the scan can
+        // be split into one partition per target partition.
+        scanner.scan_in_order(false);
+        let plan: Arc<dyn ExecutionPlan> = scanner.scan(
+            false,
+            false,
+            false,
+            projections.into(),
+            state.config().target_partitions(),
+        );
 
         Ok(plan)
     }
@@ -14,6 +14,7 @@ use futures::{FutureExt, Stream};
 use lance_core::{datatypes::SchemaCompareOptions, traits::DatasetTakeRows};
 use lance_datafusion::utils::{peek_reader_schema, reader_to_stream};
 use lance_file::datatypes::populate_schema_dictionary;
+use lance_index::DatasetIndexExt;
 use lance_io::object_store::{ObjectStore, ObjectStoreParams};
 use lance_io::object_writer::ObjectWriter;
 use lance_io::traits::WriteExt;
@@ -22,12 +23,15 @@ use lance_table::format::{Fragment, Index, Manifest, MAGIC, MAJOR_VERSION, MINOR
 use lance_table::io::commit::{
     commit_handler_from_url, CommitError, CommitHandler, CommitLock, ManifestLocation,
 };
-use lance_table::io::manifest::{read_manifest, write_manifest};
+use lance_table::io::manifest::{
+    load_fragment_chunks_pruned, read_manifest_with_cache, read_manifest_without_fragment_chunks,
+    write_fragment_chunks, write_manifest,
+};
 use log::warn;
 use object_store::path::Path;
 use prost::Message;
 use snafu::{location, Location};
-use std::collections::{BTreeMap, HashMap};
+use std::collections::{BTreeMap, BTreeSet, HashMap};
 use std::ops::Range;
 use std::pin::Pin;
 use std::sync::Arc;
@@ -43,6 +47,7 @@ pub mod progress;
 mod rowids;
 pub mod scanner;
 mod schema_evolution;
+mod shuffle;
 mod take;
 pub mod transaction;
 pub mod updater;
@@ -57,6 +62,9 @@ use self::transaction::{Operation, Transaction};
 use self::write::write_fragments_internal;
 use crate::datatypes::Schema;
 use crate::error::box_error;
+use crate::index::{
+    prewarm_index_uuid, update_zone_maps, warn_if_not_cached, IndexCacheStats, IndexHotSet,
+};
 use crate::io::commit::{commit_new_dataset, commit_transaction};
 use crate::session::Session;
 use crate::utils::temporal::{timestamp_to_nanos, utc_now, SystemTime};
@@ -70,6 +78,7 @@ use lance_table::feature_flags::{
 pub use schema_evolution::{
     BatchInfo, BatchUDF, ColumnAlteration, NewColumnTransform, UDFCheckpointStore,
 };
+pub use shuffle::ShuffleParams;
 pub use write::merge_insert::{
     MergeInsertBuilder, MergeInsertJob, WhenMatched, WhenNotMatched, WhenNotMatchedBySource,
 };
@@ -287,7 +296,13 @@ impl Dataset {
             path: manifest_file,
             size: None,
         };
-        let manifest = Self::load_manifest(self.object_store.as_ref(), &manifest_location).await?;
+        let manifest = Self::load_manifest(
+            self.object_store.as_ref(),
+            &manifest_location,
+            &self.session,
+            None,
+        )
+        .await?;
         Self::checkout_manifest(
             self.object_store.clone(),
             base_path,
@@ -299,9 +314,15 @@ impl Dataset {
         .await
     }
 
+    /// Load the manifest at `manifest_location`.
+    ///
+    /// If `fragment_ids` is given then only those fragments are loaded, see
+    /// [`DatasetBuilder::with_fragment_ids`].
     async fn load_manifest(
         object_store: &ObjectStore,
         manifest_location: &ManifestLocation,
+        session: &Session,
+        fragment_ids: Option<&BTreeSet<u64>>,
     ) -> Result<Manifest> {
         let object_reader = if let Some(size) = manifest_location.size {
             object_store
@@ -361,6 +382,14 @@ impl Dataset {
         }
 
         populate_schema_dictionary(&mut manifest.schema, object_reader.as_ref()).await?;
+        load_fragment_chunks_pruned(
+            object_store,
+            &manifest_location.path,
+            &mut manifest,
+            Some(&session.file_metadata_cache),
+            fragment_ids,
+        )
+        .await?;
 
         Ok(manifest)
     }
@@ -499,6 +528,7 @@ impl Dataset {
         let manifest_config = ManifestWriteConfig {
             use_move_stable_row_ids: params.enable_move_stable_row_ids,
             use_legacy_format: Some(params.use_legacy_format),
+            use_fragment_chunks: params.enable_fragment_chunks,
             ..Default::default()
         };
         let manifest = if let Some(dataset) = &dataset {
@@ -522,14 +552,18 @@ impl Dataset {
             .await?
         };
 
-        Ok(Self {
+        let mut new_dataset = Self {
             object_store,
             base,
             uri: uri.to_string(),
             manifest: Arc::new(manifest.clone()),
             session: Arc::new(Session::default()),
             commit_handler,
-        })
+        };
+        if dataset.is_some() && matches!(params.mode, WriteMode::Append) {
+            new_dataset.update_zone_maps_after_append().await;
+        }
+        Ok(new_dataset)
     }
 
     /// Write to or Create a [Dataset] with a stream of [RecordBatch]s.
@@ -603,10 +637,24 @@ impl Dataset {
         .await?;
 
         self.manifest = Arc::new(new_manifest);
+        self.update_zone_maps_after_append().await;
 
         Ok(())
     }
 
+    /// Add the appended fragments to the zone map indices
+    ///
+    /// The append is already committed so a failure here is only logged, the new fragments
+    /// are then scanned in full until the indices are optimized.
+    async fn update_zone_maps_after_append(&mut self) {
+        if let Err(err) = update_zone_maps(self).await {
+            warn!(
+                "Failed to add appended fragments to the zone map indices of {}: {}",
+                self.uri, err
+            );
+        }
+    }
+
     /// Append to existing [Dataset] with a stream of [RecordBatch]s
     ///
     /// Returns void result or Returns [Error]
@@ -632,12 +680,13 @@ impl Dataset {
     }
 
     pub async fn latest_manifest(&self) -> Result<Manifest> {
-        read_manifest(
+        read_manifest_with_cache(
             &self.object_store,
             &self
                 .commit_handler
                 .resolve_latest_version(&self.base, &self.object_store)
                 .await?,
+            Some(&self.session.file_metadata_cache),
         )
         .await
     }
@@ -990,6 +1039,19 @@ impl Dataset {
         take::take_scan(self, row_ranges, projection, batch_readahead)
     }
 
+    /// Get a stream of batches in a seeded, block-shuffled order for training loops.
+    ///
+    /// Fragments are read in a random order in blocks of consecutive rows, and the rows
+    /// of several blocks are shuffled together before they are returned.  See
+    /// [`ShuffleParams`] for the options, including sharding between several readers.
+    pub async fn shuffled_scan(
+        &self,
+        projection: Arc<Schema>,
+        params: ShuffleParams,
+    ) -> Result<DatasetRecordBatchStream> {
+        shuffle::shuffled_scan(self, projection, params).await
+    }
+
     /// Sample `n` rows from the dataset.
     pub(crate) async fn sample(&self, n: usize, projection: &Schema) -> Result<RecordBatch> {
         use rand::seq::IteratorRandom;
@@ -1091,6 +1153,60 @@ impl Dataset {
         self.session.index_cache.hit_rate()
     }
 
+    /// Hits, misses, evictions and current size of the index cache, by kind of entry
+    pub fn index_cache_stats(&self) -> IndexCacheStats {
+        self.session.index_cache.stats()
+    }
+
+    /// The indices of this dataset, and their partitions, that are in the session cache
+    ///
+    /// Save this before a process stops and pass it to [`Self::prewarm_index_hot_set`] when
+    /// the next one starts, to load only the parts of the indices that were in use.
+    pub async fn index_hot_set(&self) -> Result<IndexHotSet> {
+        let indices = self.load_indices().await?;
+        let mut hot_set = self.session.index_cache.hot_set();
+        Ok(IndexHotSet {
+            indices: indices
+                .iter()
+                .filter_map(|index| {
+                    let uuid = index.uuid.to_string();
+                    let partitions = hot_set.remove(&uuid)?;
+                    Some((uuid, partitions.into_iter().collect()))
+                })
+                .collect(),
+        })
+    }
+
+    /// Load the indices and partitions of a hot set into the session cache
+    ///
+    /// Indices that are not part of this version of the dataset (e.g. because they were
+    /// replaced when the indices were optimized) are skipped.
+    pub async fn prewarm_index_hot_set(&self, hot_set: &IndexHotSet) -> Result<()> {
+        let indices = self.load_indices().await?;
+        let loaded = stream::iter(indices.iter().filter_map(|index| {
+            let uuid = index.uuid.to_string();
+            let partitions = hot_set.indices.get(&uuid)?;
+            Some((index, uuid, partitions))
+        }))
+        .map(|(index, uuid, partitions)| async move {
+            let column =
+                self.schema()
+                    .field_by_id(index.fields[0])
+                    .ok_or_else(|| Error::IndexNotFound {
+                        identity: index.name.clone(),
+                        location: location!(),
+                    })?;
+            let num_partitions =
+                prewarm_index_uuid(self, &column.name, &uuid, Some(partitions)).await?;
+            Ok::<_, Error>((uuid, num_partitions))
+        })
+        .buffer_unordered(num_cpus::get())
+        .try_collect::<Vec<_>>()
+        .await?;
+        warn_if_not_cached(self, "the hot set", &loaded);
+        Ok(())
+    }
+
     pub fn cache_size_bytes(&self) -> u64 {
         self.session.deep_size_of() as u64
     }
@@ -1102,7 +1218,8 @@ impl Dataset {
             .list_manifests(&self.base, &self.object_store.inner)
             .await?
             .try_filter_map(|path| async move {
-                match read_manifest(&self.object_store, &path).await {
+                // The fragments are not needed, so don't read their chunk files
+                match read_manifest_without_fragment_chunks(&self.object_store, &path).await {
                     Ok(manifest) => Ok(Some(Version::from(&manifest))),
                     Err(e) => Err(e),
                 }
@@ -1253,6 +1370,7 @@ pub(crate) struct ManifestWriteConfig {
     timestamp: Option<SystemTime>,   // default None
     use_move_stable_row_ids: bool,   // default false
     use_legacy_format: Option<bool>, // default None
+    use_fragment_chunks: bool,       // default false
 }
 
 impl Default for ManifestWriteConfig {
@@ -1262,6 +1380,7 @@ impl Default for ManifestWriteConfig {
             timestamp: None,
             use_move_stable_row_ids: false,
             use_legacy_format: None,
+            use_fragment_chunks: false,
         }
     }
 }
@@ -1276,6 +1395,9 @@ pub(crate) async fn write_manifest_file(
     config: &ManifestWriteConfig,
 ) -> std::result::Result<(), CommitError> {
     let was_using_legacy = should_use_legacy_format(manifest.writer_feature_flags);
+    if config.use_fragment_chunks && !manifest.uses_fragment_chunks() {
+        manifest.fragment_chunks = Some(vec![]);
+    }
     if config.auto_set_feature_flags {
         apply_feature_flags(manifest)?;
     }
@@ -1294,6 +1416,8 @@ pub(crate) async fn write_manifest_file(
 
     manifest.update_max_fragment_id();
 
+    write_fragment_chunks(object_store, base_path, manifest).await?;
+
     commit_handler
         .commit(
             manifest,
@@ -1332,7 +1456,7 @@ mod tests {
     use crate::arrow::FixedSizeListArrayExt;
     use crate::dataset::optimize::{compact_files, CompactionOptions};
     use crate::dataset::WriteMode::Overwrite;
-    use crate::index::scalar::ScalarIndexParams;
+    use crate::index::scalar::{ScalarIndexParams, ScalarIndexType};
     use crate::index::vector::VectorIndexParams;
     use crate::utils::test::TestDatasetGenerator;
 
@@ -1356,6 +1480,7 @@ mod tests {
     use lance_table::format::WriterVersion;
     use lance_table::io::commit::RenameCommitHandler;
     use lance_table::io::deletion::read_deletion_file;
+    use lance_table::io::manifest::{read_manifest, FRAGMENT_CHUNKS_DIR};
     use lance_testing::datagen::generate_random_array;
     use pretty_assertions::assert_eq;
     use rstest::rstest;
@@ -1759,6 +1884,7 @@ mod tests {
                 timestamp: None,
                 use_move_stable_row_ids: false,
                 use_legacy_format: None,
+                use_fragment_chunks: false,
             },
         )
         .await
@@ -1789,6 +1915,166 @@ mod tests {
         assert!(matches!(write_result, Err(Error::NotSupported { .. })));
     }
 
+    #[tokio::test]
+    async fn test_fragment_chunks() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let data = gen()
+            .col("i", array::step::<Int32Type>())
+            .into_reader_rows(RowCount::from(100), BatchCount::from(3));
+        let mut dataset = Dataset::write(
+            data,
+            test_uri,
+            Some(WriteParams {
+                max_rows_per_file: 100,
+                enable_fragment_chunks: true,
+                ..Default::default()
+            }),
+        )
+        .await
+        .unwrap();
+        assert!(dataset.manifest.uses_fragment_chunks());
+
+        // The flag sticks for appends and deletes, which don't ask for it
+        let data = gen()
+            .col("i", array::step_custom::<Int32Type>(300, 1))
+            .into_reader_rows(RowCount::from(100), BatchCount::from(1));
+        dataset.append(data, None).await.unwrap();
+        dataset.delete("i < 50").await.unwrap();
+        dataset.validate().await.unwrap();
+
+        let manifest = read_manifest(
+            dataset.object_store(),
+            &dataset
+                .commit_handler
+                .resolve_latest_version(&dataset.base, dataset.object_store())
+                .await
+                .unwrap(),
+        )
+        .await
+        .unwrap();
+        assert_ne!(
+            manifest.reader_feature_flags & feature_flags::FLAG_FRAGMENT_CHUNKS,
+            0
+        );
+        assert_eq!(manifest.fragments.len(), 4);
+        assert_eq!(manifest.fragment_chunks.as_ref().unwrap().len(), 1);
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 350);
+
+        let first = dataset.checkout_version(1).await.unwrap();
+        assert_eq!(first.count_rows(None).await.unwrap(), 300);
+
+        // Cleanup keeps the chunks of the latest version
+        dataset
+            .cleanup_old_versions(Duration::zero(), Some(true))
+            .await
+            .unwrap();
+        let dataset = Dataset::open(test_uri).await.unwrap();
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 350);
+        assert_eq!(dataset.manifest.fragments.len(), 4);
+    }
+
+    #[tokio::test]
+    async fn test_versions_skip_fragment_chunks() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let data = gen()
+            .col("i", array::step::<Int32Type>())
+            .into_reader_rows(RowCount::from(100), BatchCount::from(3));
+        let mut dataset = Dataset::write(
+            data,
+            test_uri,
+            Some(WriteParams {
+                max_rows_per_file: 100,
+                enable_fragment_chunks: true,
+                ..Default::default()
+            }),
+        )
+        .await
+        .unwrap();
+        dataset.delete("i < 50").await.unwrap();
+
+        let path = dataset
+            .commit_handler
+            .resolve_latest_version(&dataset.base, dataset.object_store())
+            .await
+            .unwrap();
+        let manifest = read_manifest_without_fragment_chunks(dataset.object_store(), &path)
+            .await
+            .unwrap();
+        assert_eq!(manifest.version, 2);
+        assert!(manifest.fragments.is_empty());
+        assert_eq!(manifest.fragment_chunks.as_ref().unwrap().len(), 1);
+
+        // Listing versions doesn't need the chunk files at all
+        std::fs::remove_dir_all(test_dir.path().join(FRAGMENT_CHUNKS_DIR)).unwrap();
+        let versions = dataset.versions().await.unwrap();
+        assert_eq!(
+            versions.iter().map(|v| v.version).collect::<Vec<_>>(),
+            vec![1, 2]
+        );
+    }
+
+    #[tokio::test]
+    async fn test_open_pruned_fragment_chunks() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let data = gen()
+            .col("i", array::step::<Int32Type>())
+            .into_reader_rows(RowCount::from(100), BatchCount::from(3));
+        Dataset::write(
+            data,
+            test_uri,
+            Some(WriteParams {
+                max_rows_per_file: 100,
+                enable_fragment_chunks: true,
+                ..Default::default()
+            }),
+        )
+        .await
+        .unwrap();
+
+        // Only the requested fragments are loaded
+        let mut dataset = DatasetBuilder::from_uri(test_uri)
+            .with_fragment_ids([1, 2, 10])
+            .load()
+            .await
+            .unwrap();
+        assert!(dataset.manifest.fragments_pruned());
+        assert_eq!(
+            dataset
+                .get_fragments()
+                .iter()
+                .map(|f| f.id())
+                .collect::<Vec<_>>(),
+            vec![1, 2]
+        );
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 200);
+
+        // The other fragments would be lost, so the dataset can't be modified
+        let result = dataset.delete("i < 150").await;
+        assert!(matches!(result, Err(Error::NotSupported { .. })));
+
+        // A serialized copy loads all of the fragments
+        let copy = DatasetBuilder::from_uri(test_uri)
+            .with_serialized_manifest(&dataset.manifest.serialized())
+            .unwrap()
+            .load()
+            .await
+            .unwrap();
+        assert!(!copy.manifest.fragments_pruned());
+        assert_eq!(copy.count_rows(None).await.unwrap(), 300);
+
+        // Chunks that can't hold the requested fragments aren't read at all
+        std::fs::remove_dir_all(test_dir.path().join(FRAGMENT_CHUNKS_DIR)).unwrap();
+        let dataset = DatasetBuilder::from_uri(test_uri)
+            .with_fragment_ids([10])
+            .load()
+            .await
+            .unwrap();
+        assert!(dataset.get_fragments().is_empty());
+    }
+
     #[rstest]
     #[tokio::test]
     async fn append_dataset(#[values(false, true)] use_legacy_format: bool) {
@@ -2358,6 +2644,258 @@ mod tests {
         dataset.index_statistics(&index_name).await.unwrap();
     }
 
+    #[tokio::test]
+    async fn test_create_bitmap_index() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let data = gen().col(
+            "category",
+            array::cycle_utf8_literals(&["red", "green", "blue", "yellow"]),
+        );
+        let mut dataset = Dataset::write(
+            data.into_reader_rows(RowCount::from(1024), BatchCount::from(4)),
+            test_uri,
+            None,
+        )
+        .await
+        .unwrap();
+
+        dataset
+            .create_index(
+                &["category"],
+                IndexType::Scalar,
+                Some("category_idx".to_string()),
+                &ScalarIndexParams::new(ScalarIndexType::Bitmap),
+                false,
+            )
+            .await
+            .unwrap();
+
+        // The kind of index is recorded so it doesn't have to be detected on open
+        let indices = dataset.load_indices().await.unwrap();
+        assert_eq!(indices[0].index_type.as_deref(), Some("bitmap"));
+
+        for (filter, expected) in [
+            ("category = 'red' OR category = 'blue'", 2048),
+            ("category != 'red'", 3072),
+        ] {
+            let mut scan = dataset.scan();
+            scan.filter(filter).unwrap();
+            let plan = scan.explain_plan(false).await.unwrap();
+            assert!(plan.contains("ScalarIndexQuery"), "{}", plan);
+            assert_eq!(scan.count_rows().await.unwrap(), expected, "{}", filter);
+        }
+    }
+
+    #[tokio::test]
+    async fn test_create_ngram_index() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let data = gen().col(
+            "path",
+            array::cycle_utf8_literals(&[
+                "/api/checkout/confirm",
+                "/api/cart",
+                "/static/check/knockout.css",
+                "/api/CHECKOUT",
+            ]),
+        );
+        let mut dataset = Dataset::write(
+            data.into_reader_rows(RowCount::from(1024), BatchCount::from(4)),
+            test_uri,
+            None,
+        )
+        .await
+        .unwrap();
+
+        dataset
+            .create_index(
+                &["path"],
+                IndexType::Scalar,
+                Some("path_idx".to_string()),
+                &ScalarIndexParams::new(ScalarIndexType::NGram),
+                false,
+            )
+            .await
+            .unwrap();
+
+        // The index returns candidates (e.g. the knockout path) which are then verified
+        for (filter, expected) in [
+            ("path LIKE '%checkout%'", 1024),
+            ("path ILIKE '%checkout%'", 2048),
+            ("path ~ 'check.*out'", 2048),
+            ("path LIKE '/api/%' AND path ILIKE '%checkout%'", 2048),
+        ] {
+            let mut scan = dataset.scan();
+            scan.filter(filter).unwrap();
+            let plan = scan.explain_plan(false).await.unwrap();
+            assert!(plan.contains("ScalarIndexQuery"), "{}", plan);
+            assert_eq!(scan.count_rows().await.unwrap(), expected, "{}", filter);
+        }
+    }
+
+    #[tokio::test]
+    async fn test_create_label_list_index() {
+        use arrow_array::builder::{ListBuilder, StringBuilder};
+        use arrow_array::{cast::AsArray, Array};
+
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let num_rows = 1000;
+        let tag_cycle: [&[&str]; 4] = [&["red", "blue"], &["blue"], &["green", "red"], &[]];
+        let mut tags = ListBuilder::new(StringBuilder::new());
+        for i in 0..num_rows {
+            for tag in tag_cycle[i % 4] {
+                tags.values().append_value(tag);
+            }
+            tags.append(true);
+        }
+        let tags = tags.finish();
+        let vectors = FixedSizeListArray::try_new_from_values(
+            Float32Array::from_iter_values((0..num_rows * 4).map(|v| (v / 4) as f32)),
+            4,
+        )
+        .unwrap();
+        let schema = Arc::new(ArrowSchema::new(vec![
+            ArrowField::new("i", DataType::Int32, false),
+            ArrowField::new("tags", tags.data_type().clone(), true),
+            ArrowField::new("vec", vectors.data_type().clone(), false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(Int32Array::from_iter_values(0..num_rows as i32)),
+                Arc::new(tags),
+                Arc::new(vectors),
+            ],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        let mut dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+
+        dataset
+            .create_index(
+                &["tags"],
+                IndexType::Scalar,
+                Some("tags_idx".to_string()),
+                &ScalarIndexParams::new(ScalarIndexType::LabelList),
+                false,
+            )
+            .await
+            .unwrap();
+
+        for (filter, expected) in [
+            ("array_has_any(tags, ['red'])", 500),
+            ("array_has_any(tags, ['blue', 'green'])", 750),
+            ("array_has_all(tags, ['red', 'blue'])", 250),
+            ("array_has(tags, 'green')", 250),
+        ] {
+            let mut scan = dataset.scan();
+            scan.filter(filter).unwrap();
+            let plan = scan.explain_plan(false).await.unwrap();
+            assert!(plan.contains("ScalarIndexQuery"), "{}", plan);
+            assert_eq!(scan.count_rows().await.unwrap(), expected, "{}", filter);
+        }
+
+        // The index is also used as a KNN prefilter
+        let results = dataset
+            .scan()
+            .nearest("vec", &Float32Array::from(vec![0.0; 4]), 10)
+            .unwrap()
+            .prefilter(true)
+            .filter("array_has_all(tags, ['red', 'blue'])")
+            .unwrap()
+            .try_into_batch()
+            .await
+            .unwrap();
+        let mut ids = results
+            .column_by_name("i")
+            .unwrap()
+            .as_primitive::<Int32Type>()
+            .values()
+            .to_vec();
+        ids.sort();
+        assert_eq!(ids, (0..40).step_by(4).collect::<Vec<_>>());
+    }
+
+    #[tokio::test]
+    async fn test_create_zone_map_index() {
+        use arrow_array::types::Int64Type;
+
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        // Timestamps increase with ingestion order so each fragment covers a narrow range
+        let write_params = WriteParams {
+            max_rows_per_file: 10_000,
+            ..Default::default()
+        };
+        let mut dataset = Dataset::write(
+            gen()
+                .col("ts", array::step::<Int64Type>())
+                .into_reader_rows(RowCount::from(1000), BatchCount::from(30)),
+            test_uri,
+            Some(write_params.clone()),
+        )
+        .await
+        .unwrap();
+        assert_eq!(dataset.get_fragments().len(), 3);
+
+        dataset
+            .create_index(
+                &["ts"],
+                IndexType::Scalar,
+                Some("ts_idx".to_string()),
+                &ScalarIndexParams::new(ScalarIndexType::ZoneMap),
+                false,
+            )
+            .await
+            .unwrap();
+
+        let check_filters = |dataset: Dataset| async move {
+            for (filter, expected) in [
+                ("ts >= 12000 AND ts < 12010", 10),
+                ("ts BETWEEN 9995 AND 10004", 10),
+                ("ts IN (5, 25000, 99999)", 2),
+                ("ts > 30500", 499),
+            ] {
+                let mut scan = dataset.scan();
+                scan.filter(filter).unwrap();
+                // The candidate zones are scanned as row ranges, not taken row by row
+                let plan = scan.explain_plan(false).await.unwrap();
+                assert!(plan.contains("ranges="), "{}", plan);
+                assert!(!plan.contains("MaterializeIndex"), "{}", plan);
+                assert_eq!(scan.count_rows().await.unwrap(), expected, "{}", filter);
+            }
+        };
+
+        // Appending adds the zones of the new fragment right away
+        let dataset = Dataset::write(
+            gen()
+                .col("ts", array::step_custom::<Int64Type>(30000, 1))
+                .into_reader_rows(RowCount::from(1000), BatchCount::from(1)),
+            test_uri,
+            Some(WriteParams {
+                mode: WriteMode::Append,
+                ..write_params
+            }),
+        )
+        .await
+        .unwrap();
+        let stats: serde_json::Value =
+            serde_json::from_str(&dataset.index_statistics("ts_idx").await.unwrap()).unwrap();
+        assert_eq!(stats["num_unindexed_rows"], 0);
+        check_filters(dataset.clone()).await;
+        let mut scan = dataset.scan();
+        scan.filter("ts > 30500").unwrap();
+        let plan = scan.explain_plan(false).await.unwrap();
+        // Only the zone of the appended fragment is read
+        assert!(plan.contains("ranges=1"), "{}", plan);
+    }
+
     async fn create_bad_file(use_legacy_format: bool) -> Result<Dataset> {
         let test_dir = tempdir().unwrap();
 
@@ -1,12 +1,17 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
-use std::{collections::HashMap, sync::Arc, time::Duration};
+use std::{
+    collections::{BTreeSet, HashMap},
+    sync::Arc,
+    time::Duration,
+};
 
 use lance_file::datatypes::populate_schema_dictionary;
 use lance_io::object_store::{ObjectStore, ObjectStoreParams};
 use lance_table::{
     format::Manifest,
     io::commit::{commit_handler_from_url, CommitHandler, ManifestLocation},
+    io::manifest::load_fragment_chunks_pruned,
 };
 use object_store::{aws::AwsCredentialProvider, path::Path, DynObjectStore};
 use prost::Message;
@@ -25,6 +30,9 @@ use crate::{
 pub struct DatasetBuilder {
     /// Cache size for index cache. If it is zero, index cache is disabled.
     index_cache_size: usize,
+    /// If set, the index cache is bounded by this many bytes instead of by
+    /// `index_cache_size` entries.
+    index_cache_size_bytes: Option<usize>,
     /// Metadata cache size for the fragment metadata. If it is zero, metadata
     /// cache is disabled.
     metadata_cache_size: usize,
@@ -34,6 +42,8 @@ pub struct DatasetBuilder {
     commit_handler: Option<Arc<dyn CommitHandler>>,
     options: ObjectStoreParams,
     version: Option<u64>,
+    /// If set, only these fragments are loaded.
+    fragment_ids: Option<BTreeSet<u64>>,
     table_uri: String,
 }
 
@@ -41,12 +51,14 @@ impl DatasetBuilder {
     pub fn from_uri<T: AsRef<str>>(table_uri: T) -> Self {
         Self {
             index_cache_size: DEFAULT_INDEX_CACHE_SIZE,
+            index_cache_size_bytes: None,
             metadata_cache_size: DEFAULT_METADATA_CACHE_SIZE,
             table_uri: table_uri.as_ref().to_string(),
             options: ObjectStoreParams::default(),
             commit_handler: None,
             session: None,
             version: None,
+            fragment_ids: None,
             manifest: None,
         }
     }
@@ -61,6 +73,13 @@ impl DatasetBuilder {
         self
     }
 
+    /// Bound the index cache by the total size of the cached indices, in bytes, instead
+    /// of by the number of indices.  This takes precedence over `with_index_cache_size`.
+    pub fn with_index_cache_size_bytes(mut self, cache_size_bytes: usize) -> Self {
+        self.index_cache_size_bytes = Some(cache_size_bytes);
+        self
+    }
+
     /// Set the cache size for the file metadata. Set to zero to disable this cache.
     pub fn with_metadata_cache_size(mut self, cache_size: usize) -> Self {
         self.metadata_cache_size = cache_size;
@@ -82,6 +101,20 @@ impl DatasetBuilder {
         self
     }
 
+    /// Only load the fragments with these ids.
+    ///
+    /// If the dataset stores its fragments in chunk files (see
+    /// [`WriteParams::enable_fragment_chunks`]) then only the chunks that
+    /// can hold these fragments are read, so opening the dataset costs about the
+    /// same no matter how many fragments it has.  The dataset then only has the
+    /// given fragments (ids that don't exist are ignored) and can be read, but
+    /// not modified.  If the fragments are stored inline then they are all loaded
+    /// anyways and this has no effect.
+    pub fn with_fragment_ids(mut self, fragment_ids: impl IntoIterator<Item = u64>) -> Self {
+        self.fragment_ids = Some(fragment_ids.into_iter().collect());
+        self
+    }
+
     pub fn with_commit_handler(mut self, commit_handler: Arc<dyn CommitHandler>) -> Self {
         self.commit_handler = Some(commit_handler);
         self
@@ -222,27 +255,47 @@ impl DatasetBuilder {
     pub async fn load(mut self) -> Result<Dataset> {
         let session = match self.session.take() {
             Some(session) => session,
-            None => Arc::new(Session::new(
-                self.index_cache_size,
-                self.metadata_cache_size,
-            )),
+            None => {
+                let session = Session::new(self.index_cache_size, self.metadata_cache_size);
+                let session = match self.index_cache_size_bytes {
+                    Some(cache_size_bytes) => session.with_index_cache_size_bytes(cache_size_bytes),
+                    None => session,
+                };
+                Arc::new(session)
+            }
         };
 
         let version = self.version;
         let table_uri = self.table_uri.clone();
 
         let manifest = self.manifest.take();
+        let fragment_ids = self.fragment_ids.take();
 
         let (object_store, base_path, commit_handler) = self.build_object_store().await?;
 
         let manifest = if manifest.is_some() {
             let mut manifest = manifest.unwrap();
-            if manifest.schema.has_dictionary_types() {
+            // Serialized manifests only refer to chunk files if they were pruned
+            let has_chunks = manifest
+                .fragment_chunks
+                .as_ref()
+                .is_some_and(|chunks| !chunks.is_empty());
+            if manifest.schema.has_dictionary_types() || has_chunks {
                 let path = commit_handler
                     .resolve_version(&base_path, manifest.version, &object_store.inner)
                     .await?;
-                let reader = object_store.open(&path).await?;
-                populate_schema_dictionary(&mut manifest.schema, reader.as_ref()).await?;
+                if manifest.schema.has_dictionary_types() {
+                    let reader = object_store.open(&path).await?;
+                    populate_schema_dictionary(&mut manifest.schema, reader.as_ref()).await?;
+                }
+                load_fragment_chunks_pruned(
+                    &object_store,
+                    &path,
+                    &mut manifest,
+                    Some(&session.file_metadata_cache),
+                    fragment_ids.as_ref(),
+                )
+                .await?;
             }
             manifest
         } else {
@@ -267,7 +320,13 @@ impl DatasetBuilder {
                     })?,
             };
 
-            Dataset::load_manifest(&object_store, &manifest_location).await?
+            Dataset::load_manifest(
+                &object_store,
+                &manifest_location,
+                &session,
+                fragment_ids.as_ref(),
+            )
+            .await?
         };
 
         Dataset::checkout_manifest(
@@ -41,7 +41,9 @@ use lance_table::{
     format::{Index, Manifest},
     io::{
         deletion::deletion_file_path,
-        manifest::{read_manifest, read_manifest_indexes},
+        manifest::{
+            read_manifest, read_manifest_indexes, FRAGMENT_CHUNKS_DIR, FRAGMENT_CHUNK_EXTENSION,
+        },
     },
 };
 use object_store::path::Path;
@@ -58,6 +60,7 @@ struct ReferencedFiles {
     data_paths: HashSet<Path>,
     delete_paths: HashSet<Path>,
     tx_paths: HashSet<Path>,
+    chunk_paths: HashSet<Path>,
     index_uuids: HashSet<String>,
 }
 
@@ -140,6 +143,8 @@ impl<'a> CleanupTask<'a> {
         // ignore it then we might delete valid data files thinking they are not
         // referenced.
 
+        // Cleanup visits every old version once, so caching their fragment chunks
+        // would only evict the chunks of the versions that are actually in use.
         let manifest = read_manifest(&self.dataset.object_store, &path).await?;
         let dataset_version = self.dataset.version().version;
         // Don't delete the latest version, even if it is old.  Also don't delete manifests
@@ -193,6 +198,11 @@ impl<'a> CleanupTask<'a> {
                 .tx_paths
                 .insert(Path::parse("_transactions")?.child(relative_tx_path.as_str()));
         }
+        for chunk in manifest.fragment_chunks.iter().flatten() {
+            referenced_files
+                .chunk_paths
+                .insert(Path::parse(FRAGMENT_CHUNKS_DIR)?.child(chunk.path.as_str()));
+        }
 
         for index in indexes {
             let uuid_str = index.uuid.to_string();
@@ -368,6 +378,28 @@ impl<'a> CleanupTask<'a> {
                     Ok(None)
                 }
             }
+            Some(FRAGMENT_CHUNK_EXTENSION) => {
+                if relative_path.as_ref().starts_with(FRAGMENT_CHUNKS_DIR) {
+                    if inspection
+                        .referenced_files
+                        .chunk_paths
+                        .contains(&relative_path)
+                    {
+                        Ok(None)
+                    } else if !maybe_in_progress
+                        || inspection
+                            .verified_files
+                            .chunk_paths
+                            .contains(&relative_path)
+                    {
+                        Ok(Some(path))
+                    } else {
+                        Ok(None)
+                    }
+                } else {
+                    Ok(None)
+                }
+            }
             _ => Ok(None),
         }
     }
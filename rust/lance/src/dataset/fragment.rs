@@ -603,15 +603,13 @@ impl FileFragment {
                 num_deleted_rows: Some(num_deleted),
                 ..
             }) => Ok(*num_deleted),
-            _ => {
-                read_deletion_file(
-                    &self.dataset.base,
-                    &self.metadata,
-                    self.dataset.object_store(),
-                )
-                .map_ok(|v| v.map(|v| v.len()).unwrap_or_default())
-                .await
-            }
+            // Goes through the session cache, the deletion vector is likely to be needed
+            // again by a scan of this fragment
+            _ => Ok(self
+                .get_deletion_vector()
+                .await?
+                .map(|v| v.len())
+                .unwrap_or_default()),
         }
     }
 
@@ -1607,7 +1605,47 @@ impl FragmentReader {
         )
     }
 
+    /// The parts of `range` that still need to be read once deleted rows are removed
+    ///
+    /// The range is split into batches and batches in which every row is deleted are left
+    /// out, so that they are never scheduled.  Adjacent batches are merged back together.
+    /// Deleted rows are only left out when they are filtered, not when they are made null.
+    fn live_ranges(&self, range: Range<u32>, batch_size: u32) -> Vec<Range<u32>> {
+        let deletion_vec = match &self.deletion_vec {
+            Some(deletion_vec) if !self.make_deletions_null => deletion_vec,
+            _ => return vec![range],
+        };
+        let batch_size = batch_size.max(1);
+        let mut live_ranges: Vec<Range<u32>> = Vec::new();
+        let mut start = range.start;
+        while start < range.end {
+            let end = start.saturating_add(batch_size).min(range.end);
+            let fully_deleted = deletion_vec.len() >= (end - start) as usize
+                && deletion_vec.contains_range(start..end);
+            if !fully_deleted {
+                match live_ranges.last_mut() {
+                    Some(last) if last.end == start => last.end = end,
+                    _ => live_ranges.push(start..end),
+                }
+            }
+            start = end;
+        }
+        live_ranges
+    }
+
     pub fn read_range(&self, range: Range<u32>, batch_size: u32) -> Result<ReadBatchFutStream> {
+        let live_ranges = self.live_ranges(range.clone(), batch_size);
+        if live_ranges.len() == 1 && live_ranges[0] == range {
+            return self.read_live_range(range, batch_size);
+        }
+        let streams = live_ranges
+            .into_iter()
+            .map(|range| self.read_live_range(range, batch_size))
+            .collect::<Result<Vec<_>>>()?;
+        Ok(stream::iter(streams).flatten().boxed())
+    }
+
+    fn read_live_range(&self, range: Range<u32>, batch_size: u32) -> Result<ReadBatchFutStream> {
         self.new_read_impl(
             ReadBatchParams::Range(range.start as usize..range.end as usize),
             batch_size,
@@ -1622,6 +1660,11 @@ impl FragmentReader {
     }
 
     pub fn read_all(&self, batch_size: u32) -> Result<ReadBatchFutStream> {
+        if self.deletion_vec.is_some() && !self.make_deletions_null {
+            // Plan the read around fully deleted batches
+            let total_num_rows = self.readers[0].0.len();
+            return self.read_range(0..total_num_rows, batch_size);
+        }
         self.new_read_impl(
             ReadBatchParams::RangeFull,
             batch_size,
@@ -1900,6 +1943,48 @@ mod tests {
         );
     }
 
+    #[rstest]
+    #[tokio::test]
+    async fn test_fragment_read_skips_deleted_batches(
+        #[values(false, true)] use_legacy_format: bool,
+    ) {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let mut dataset = create_dataset(test_uri, use_legacy_format).await;
+        // Rows 10..30 of the first fragment, two whole batches of 10 rows, are deleted
+        dataset.delete("i >= 10 and i < 30").await.unwrap();
+
+        let fragment = &dataset.get_fragments()[0];
+        let reader = fragment.open(dataset.schema(), true, false).await.unwrap();
+        for batches in [
+            reader.read_range(0..40, 10).unwrap(),
+            reader.read_all(10).unwrap(),
+        ] {
+            let batches = batches.buffered(1).try_collect::<Vec<_>>().await.unwrap();
+            // The deleted batches are never read, rather than read and emptied
+            assert_eq!(batches.len(), 2);
+            let row_ids = batches
+                .iter()
+                .flat_map(|batch| {
+                    let row_ids: &UInt64Array = as_primitive_array(&batch[ROW_ID]);
+                    row_ids.values().to_vec()
+                })
+                .collect::<Vec<_>>();
+            assert_eq!(row_ids, (0..10).chain(30..40).collect::<Vec<u64>>());
+        }
+
+        // Partially deleted batches are still read
+        let batches = reader
+            .read_range(5..35, 10)
+            .unwrap()
+            .buffered(1)
+            .try_collect::<Vec<_>>()
+            .await
+            .unwrap();
+        let num_rows = batches.iter().map(|b| b.num_rows()).sum::<usize>();
+        assert_eq!(num_rows, 10);
+    }
+
     #[tokio::test]
     async fn test_fragment_take_indices() {
         let test_dir = tempdir().unwrap();
@@ -82,5 +82,6 @@ impl LanceIndexStoreExt for LanceIndexStore {
             index_dir,
             Some(dataset.session.file_metadata_cache.clone()),
         )
+        .with_page_cache(dataset.session.index_page_cache.clone())
     }
 }
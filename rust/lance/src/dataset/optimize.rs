@@ -80,10 +80,17 @@
 //! the successful tasks can be committed. You can also commit in batches if
 //! you wish. As long as the tasks don't rewrite any of the same fragments,
 //! they can be committed in any order.
+//!
+//! ## Background compaction
+//!
+//! [AutoCompaction] runs [auto_compact] at a regular interval. Each round scores
+//! the planned tasks by the scan cost they save, runs the best ones within a row
+//! budget.  When a concurrent writer commits a conflicting change, the commit is
+//! retried without the rewrites of the fragments that writer modified.
 use std::borrow::Cow;
 use std::collections::HashMap;
 use std::ops::{AddAssign, Range};
-use std::sync::{Arc, RwLock};
+use std::sync::{Arc, Mutex, RwLock};
 
 use async_trait::async_trait;
 use datafusion::physical_plan::SendableRecordBatchStream;
@@ -102,9 +109,15 @@ use lance_table::format::Fragment;
 use super::fragment::FileFragment;
 use super::index::DatasetIndexRemapperOptions;
 use super::transaction::{Operation, RewriteGroup, RewrittenIndex, Transaction};
-use super::utils::make_rowid_capture_stream;
+use super::utils::{make_rowid_capture_stream, make_rowid_list_capture_stream};
 use super::{write_fragments_internal, WriteMode, WriteParams};
 
+mod auto;
+mod cluster;
+
+pub use auto::{auto_compact, AutoCompaction, AutoCompactionOptions};
+pub use cluster::Clustering;
+
 #[derive(Debug, Clone, Serialize, Deserialize, PartialEq, Eq)]
 pub struct RemappedIndex {
     original: Uuid,
@@ -162,6 +175,12 @@ pub struct CompactionOptions {
     pub materialize_deletions_threshold: f32,
     /// The number of threads to use. Defaults to the number of cores.
     pub num_threads: usize,
+    /// Rewrite the rows in this order instead of insertion order. Defaults to None.
+    ///
+    /// Clustering rewrites every fragment, not just the ones that need compaction,
+    /// and splits the rows evenly into fragments of up to `target_rows_per_fragment`.
+    #[serde(default)]
+    pub clustering: Option<Clustering>,
 }
 
 impl Default for CompactionOptions {
@@ -173,6 +192,7 @@ impl Default for CompactionOptions {
             materialize_deletions: true,
             materialize_deletions_threshold: 0.1,
             num_threads: num_cpus::get(),
+            clustering: None,
         }
     }
 }
@@ -476,6 +496,45 @@ async fn load_index_fragmaps(dataset: &Dataset) -> Result<Vec<RoaringBitmap>> {
     Ok(index_fragmaps)
 }
 
+fn indices_containing_frag(index_fragmaps: &[RoaringBitmap], frag_id: u32) -> Vec<usize> {
+    index_fragmaps
+        .iter()
+        .enumerate()
+        .filter(|(_, bitmap)| bitmap.contains(frag_id))
+        .map(|(pos, _)| pos)
+        .collect()
+}
+
+/// Plan a clustered rewrite of every fragment
+///
+/// Fragments covered by different sets of indices can't be mixed, so there is one
+/// task for each set of indices.
+async fn plan_clustering(
+    dataset: &Dataset,
+    options: &CompactionOptions,
+    clustering: &Clustering,
+) -> Result<CompactionPlan> {
+    clustering.validate(dataset)?;
+
+    let index_fragmaps = load_index_fragmaps(dataset).await?;
+    let mut groups: Vec<(Vec<usize>, Vec<Fragment>)> = Vec::new();
+    for fragment in dataset.get_fragments() {
+        let indices = indices_containing_frag(&index_fragmaps, fragment.id() as u32);
+        match groups.iter_mut().find(|(group, _)| *group == indices) {
+            Some((_, fragments)) => fragments.push(fragment.metadata),
+            None => groups.push((indices, vec![fragment.metadata])),
+        }
+    }
+
+    let mut compaction_plan = CompactionPlan::new(dataset.manifest.version, options.clone());
+    compaction_plan.extend_tasks(
+        groups
+            .into_iter()
+            .map(|(_, fragments)| TaskData { fragments }),
+    );
+    Ok(compaction_plan)
+}
+
 /// Formulate a plan to compact the files in a dataset
 ///
 /// The compaction plan will contain a list of tasks to execute. Each task
@@ -484,10 +543,16 @@ async fn load_index_fragmaps(dataset: &Dataset) -> Result<Vec<RoaringBitmap>> {
 /// tasks may contain a single fragment when that fragment has deletions that
 /// are being materialized and doesn't have any neighbors that need to be
 /// compacted.
+///
+/// If [CompactionOptions::clustering] is set then every fragment is rewritten.
 pub async fn plan_compaction(
     dataset: &Dataset,
     options: &CompactionOptions,
 ) -> Result<CompactionPlan> {
+    if let Some(clustering) = &options.clustering {
+        return plan_clustering(dataset, options, clustering).await;
+    }
+
     // get_fragments should be returning fragments in sorted order (by id)
     // and fragment ids should be unique
     debug_assert!(
@@ -507,14 +572,6 @@ pub async fn plan_compaction(
         .buffered(num_cpus::get() * 2);
 
     let index_fragmaps = load_index_fragmaps(dataset).await?;
-    let indices_containing_frag = |frag_id: u32| {
-        index_fragmaps
-            .iter()
-            .enumerate()
-            .filter(|(_, bitmap)| bitmap.contains(frag_id))
-            .map(|(pos, _)| pos)
-            .collect::<Vec<_>>()
-    };
 
     let mut candidate_bins: Vec<CandidateBin> = Vec::new();
     let mut current_bin: Option<CandidateBin> = None;
@@ -536,7 +593,7 @@ pub async fn plan_compaction(
             None
         };
 
-        let indices = indices_containing_frag(fragment.id as u32);
+        let indices = indices_containing_frag(&index_fragmaps, fragment.id as u32);
 
         match (candidacy, &mut current_bin) {
             (None, None) => {} // keep searching
@@ -685,8 +742,13 @@ impl<'a, I: Iterator<Item = u64>> Iterator for MissingIds<'a, I> {
     }
 }
 
+/// Map the old row ids to the new ones
+///
+/// `written_row_ids` are the old row ids in the order the rows were written and
+/// `row_ids` holds the same ids, used to find the rows that were deleted.
 fn transpose_row_ids(
-    row_ids: RoaringTreemap,
+    written_row_ids: impl Iterator<Item = u64>,
+    row_ids: &RoaringTreemap,
     old_fragments: &Vec<Fragment>,
     new_fragments: &[Fragment],
 ) -> HashMap<u64, Option<u64>> {
@@ -714,8 +776,8 @@ fn transpose_row_ids(
     // The default hasher is designed to be resistance to DoS attacks, which is
     // more than we need for this use case.
     let mut mapping: HashMap<u64, Option<u64>> = HashMap::with_capacity(expected_size);
-    mapping.extend(row_ids.iter().zip(new_ids));
-    MissingIds::new(row_ids.into_iter(), old_fragments).for_each(|id| {
+    mapping.extend(written_row_ids.zip(new_ids));
+    MissingIds::new(row_ids.iter(), old_fragments).for_each(|id| {
         mapping.insert(id, None);
     });
     mapping
@@ -782,18 +844,33 @@ async fn rewrite_files(
     // num deletions recorded. If that's the case, we need to grab and set that
     // information.
     let fragments = migrate_fragments(dataset.as_ref(), &task.fragments, recompute_stats).await?;
-    let mut scanner = dataset.scan();
-    scanner
-        .with_fragments(fragments.clone())
-        .scan_in_order(true)
-        .with_row_id();
-
-    let data = SendableRecordBatchStream::from(scanner.try_into_stream().await?);
+    let mut max_rows_per_file = options.target_rows_per_fragment;
     let row_ids = Arc::new(RwLock::new(RoaringTreemap::new()));
-    let data_no_row_ids = make_rowid_capture_stream(row_ids.clone(), data)?;
+    let written_row_ids = Arc::new(Mutex::new(Vec::new()));
+    let data_no_row_ids = if let Some(clustering) = &options.clustering {
+        // Split the rows evenly instead of leaving a small fragment at the end
+        let num_rows = fragments
+            .iter()
+            .map(|f| f.num_rows().or(f.physical_rows).unwrap_or_default())
+            .sum::<usize>();
+        let num_files = num_rows.div_ceil(max_rows_per_file.max(1)).max(1);
+        max_rows_per_file = num_rows.div_ceil(num_files).max(1);
+
+        let data = cluster::scan_clustered(dataset.as_ref(), fragments.clone(), clustering).await?;
+        make_rowid_list_capture_stream(written_row_ids.clone(), data)?
+    } else {
+        let mut scanner = dataset.scan();
+        scanner
+            .with_fragments(fragments.clone())
+            .scan_in_order(true)
+            .with_row_id();
+
+        let data = SendableRecordBatchStream::from(scanner.try_into_stream().await?);
+        make_rowid_capture_stream(row_ids.clone(), data)?
+    };
 
     let params = WriteParams {
-        max_rows_per_file: options.target_rows_per_fragment,
+        max_rows_per_file,
         max_rows_per_group: options.max_rows_per_group,
         mode: WriteMode::Append,
         ..Default::default()
@@ -808,15 +885,28 @@ async fn rewrite_files(
     )
     .await?;
 
-    let row_ids = Arc::try_unwrap(row_ids)
+    let mut row_ids = Arc::try_unwrap(row_ids)
+        .expect("Row ids lock still owned")
+        .into_inner()
+        .expect("Row ids mutex still locked");
+    let written_row_ids = Arc::try_unwrap(written_row_ids)
         .expect("Row ids lock still owned")
         .into_inner()
         .expect("Row ids mutex still locked");
 
     reserve_fragment_ids(&dataset, &mut new_fragments).await?;
 
-    let row_id_map: HashMap<u64, Option<u64>> =
-        transpose_row_ids(row_ids, &fragments, &new_fragments);
+    let row_id_map: HashMap<u64, Option<u64>> = if options.clustering.is_some() {
+        row_ids.extend(written_row_ids.iter().copied());
+        transpose_row_ids(
+            written_row_ids.into_iter(),
+            &row_ids,
+            &fragments,
+            &new_fragments,
+        )
+    } else {
+        transpose_row_ids(row_ids.iter(), &row_ids, &fragments, &new_fragments)
+    };
 
     metrics.files_removed = task
         .fragments
@@ -913,6 +1003,8 @@ pub async fn commit_compaction(
 #[cfg(test)]
 mod tests {
 
+    use arrow_array::cast::AsArray;
+    use arrow_array::types::Int64Type;
     use arrow_array::{Float32Array, Int64Array, RecordBatch, RecordBatchIterator};
     use arrow_schema::{DataType, Field, Schema};
     use arrow_select::concat::concat_batches;
@@ -1611,4 +1703,142 @@ mod tests {
             .collect::<Vec<u64>>();
         assert_eq!(result, expected);
     }
+
+    async fn clustering_dataset(uri: &str) -> Dataset {
+        // Neither column is correlated with the insertion order
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("x", DataType::Int64, false),
+            Field::new("y", DataType::Int64, false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(Int64Array::from_iter_values(
+                    (0..1000).map(|i| (i * 7919) % 1000),
+                )),
+                Arc::new(Int64Array::from_iter_values(
+                    (0..1000).map(|i| (i * 7907 + 13) % 1000),
+                )),
+            ],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        let write_params = WriteParams {
+            max_rows_per_file: 100,
+            ..Default::default()
+        };
+        Dataset::write(reader, uri, Some(write_params))
+            .await
+            .unwrap()
+    }
+
+    /// The number of fragments whose range of x and y overlaps x < 250 and y < 250
+    async fn fragments_overlapping_corner(dataset: &Dataset) -> usize {
+        let mut overlapping = 0;
+        for fragment in dataset.get_fragments() {
+            let mut scanner = dataset.scan();
+            scanner.with_fragments(vec![fragment.metadata().clone()]);
+            let batch = scanner.try_into_batch().await.unwrap();
+            let min = |col: &str| {
+                arrow::compute::min(
+                    batch
+                        .column_by_name(col)
+                        .unwrap()
+                        .as_primitive::<Int64Type>(),
+                )
+                .unwrap()
+            };
+            if min("x") < 250 && min("y") < 250 {
+                overlapping += 1;
+            }
+        }
+        overlapping
+    }
+
+    #[tokio::test]
+    async fn test_compact_sorted() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let mut dataset = clustering_dataset(test_uri).await;
+        dataset
+            .create_index(
+                &["y"],
+                lance_index::IndexType::Scalar,
+                None,
+                &crate::index::scalar::ScalarIndexParams::default(),
+                false,
+            )
+            .await
+            .unwrap();
+
+        let options = CompactionOptions {
+            target_rows_per_fragment: 300,
+            clustering: Some(Clustering::Sort {
+                column: "x".to_string(),
+            }),
+            ..Default::default()
+        };
+        let metrics = compact_files(&mut dataset, options, None).await.unwrap();
+        assert_eq!(metrics.fragments_removed, 10);
+        assert_eq!(metrics.fragments_added, 4);
+
+        // The fragments are balanced and together hold the rows in order of x
+        let fragments = dataset.get_fragments();
+        assert!(fragments
+            .iter()
+            .all(|f| f.metadata().physical_rows == Some(250)));
+        let batch = dataset.scan().try_into_batch().await.unwrap();
+        assert_eq!(
+            batch
+                .column_by_name("x")
+                .unwrap()
+                .as_primitive::<Int64Type>()
+                .values()
+                .to_vec(),
+            (0..1000).collect::<Vec<_>>()
+        );
+
+        // The index was remapped to the new row ids
+        let mut scanner = dataset.scan();
+        scanner.filter("y = 13").unwrap();
+        let batch = scanner.try_into_batch().await.unwrap();
+        assert_eq!(batch.num_rows(), 1);
+        assert_eq!(
+            batch
+                .column_by_name("x")
+                .unwrap()
+                .as_primitive::<Int64Type>()
+                .value(0),
+            0
+        );
+
+        let bad_column = CompactionOptions {
+            clustering: Some(Clustering::Sort {
+                column: "z".to_string(),
+            }),
+            ..Default::default()
+        };
+        assert!(compact_files(&mut dataset, bad_column, None).await.is_err());
+    }
+
+    #[tokio::test]
+    async fn test_compact_zorder() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let mut dataset = clustering_dataset(test_uri).await;
+        dataset.delete("x = 0").await.unwrap();
+        assert_eq!(fragments_overlapping_corner(&dataset).await, 10);
+
+        let options = CompactionOptions {
+            target_rows_per_fragment: 250,
+            clustering: Some(Clustering::ZOrder {
+                columns: vec!["x".to_string(), "y".to_string()],
+            }),
+            ..Default::default()
+        };
+        let metrics = compact_files(&mut dataset, options, None).await.unwrap();
+        assert_eq!(metrics.fragments_added, 4);
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 999);
+        assert!(fragments_overlapping_corner(&dataset).await <= 2);
+    }
 }
@@ -0,0 +1,527 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! Background compaction
+//!
+//! Streaming appends leave behind many small fragments, and every scan pays a fixed
+//! cost to open each of them.  [AutoCompaction] periodically plans a compaction,
+//! ranks the resulting tasks by how much scan cost they save per row rewritten, and
+//! runs the best ones within an I/O budget.  Writers are never blocked: if a
+//! concurrent commit conflicts with a round, the rewrites whose fragments were not
+//! modified are committed on top of the latest version and the others are discarded.
+
+use std::borrow::Cow;
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::Duration;
+
+use futures::{StreamExt, TryStreamExt};
+use lance_table::format::Fragment;
+use log::{info, warn};
+use snafu::{location, Location};
+use tokio::sync::{oneshot, watch};
+use tokio::task::JoinHandle;
+
+use super::{
+    commit_compaction, plan_compaction, rewrite_files, CompactionMetrics, CompactionOptions,
+    RewriteResult, TaskData,
+};
+use crate::dataset::index::DatasetIndexRemapperOptions;
+use crate::{Dataset, Error, Result};
+
+/// The cost of opening a file during a scan, expressed as a number of rows read
+const FILE_OPEN_COST_ROWS: f64 = 16.0 * 1024.0;
+
+/// Options for [auto_compact] and [AutoCompaction]
+#[derive(Debug, Clone)]
+pub struct AutoCompactionOptions {
+    /// Options used to plan and rewrite the fragments
+    pub compaction: CompactionOptions,
+    /// Time to wait between compaction rounds. Defaults to one minute.
+    pub interval: Duration,
+    /// Tasks that save less scan cost than this, per row rewritten, are skipped.
+    ///
+    /// The default of 0.05 still admits fragments that just pass the default
+    /// deletion threshold of 10%.
+    pub min_score: f64,
+    /// The maximum number of rows rewritten in one round. This bounds the I/O
+    /// spent on compaction so it doesn't starve other work.  The best task always
+    /// runs, even if it is larger than the budget.
+    pub max_rows_per_round: usize,
+    /// How many times the commit of a round is retried when a concurrent commit
+    /// conflicts with it.
+    pub max_retries: u32,
+}
+
+impl Default for AutoCompactionOptions {
+    fn default() -> Self {
+        Self {
+            compaction: CompactionOptions::default(),
+            interval: Duration::from_secs(60),
+            min_score: 0.05,
+            max_rows_per_round: 16 * 1024 * 1024,
+            max_retries: 5,
+        }
+    }
+}
+
+/// The estimated value of a compaction task
+#[derive(Debug, Clone, Copy, PartialEq)]
+struct TaskScore {
+    /// Rows read by the task, including deleted rows
+    rows_read: usize,
+    /// Scan cost saved by the task divided by the rows read and written
+    score: f64,
+}
+
+/// Score a task from the fragment metadata alone
+///
+/// A scan of a fragment costs a fixed amount per data file plus the physical rows,
+/// since deleted rows are read and then discarded.  Compaction leaves only the live
+/// rows, in as few fragments as the target size allows.  Fragments written by old
+/// versions may not record their row counts, those count as empty.
+fn score_task(task: &TaskData, options: &CompactionOptions) -> TaskScore {
+    let physical_rows = |fragment: &Fragment| fragment.physical_rows.unwrap_or_default();
+    let live_rows = |fragment: &Fragment| fragment.num_rows().unwrap_or(physical_rows(fragment));
+
+    let rows_read = task.fragments.iter().map(physical_rows).sum::<usize>();
+    let rows_written = task.fragments.iter().map(live_rows).sum::<usize>();
+    let num_files = task
+        .fragments
+        .iter()
+        .map(|fragment| fragment.files.len() + fragment.deletion_file.is_some() as usize)
+        .sum::<usize>();
+
+    let target_rows = options.target_rows_per_fragment.max(1);
+    let new_files = rows_written.div_ceil(target_rows);
+
+    let cost_before = num_files as f64 * FILE_OPEN_COST_ROWS + rows_read as f64;
+    let cost_after = new_files as f64 * FILE_OPEN_COST_ROWS + rows_written as f64;
+    let work = (rows_read + rows_written).max(1) as f64;
+    TaskScore {
+        rows_read,
+        score: (cost_before - cost_after) / work,
+    }
+}
+
+/// Choose the tasks to run in one round, best first, within the row budget
+fn select_tasks(tasks: Vec<TaskData>, options: &AutoCompactionOptions) -> Vec<TaskData> {
+    let mut scored = tasks
+        .into_iter()
+        .map(|task| (score_task(&task, &options.compaction), task))
+        .filter(|(score, _)| score.score >= options.min_score)
+        .collect::<Vec<_>>();
+    scored.sort_by(|(a, _), (b, _)| b.score.total_cmp(&a.score));
+
+    let mut budget = options.max_rows_per_round;
+    let mut selected = Vec::new();
+    for (score, task) in scored {
+        if selected.is_empty() || score.rows_read <= budget {
+            budget = budget.saturating_sub(score.rows_read);
+            selected.push(task);
+        }
+    }
+    selected
+}
+
+/// Plan a round and rewrite the selected tasks
+async fn rewrite_round(
+    dataset: &Dataset,
+    options: &AutoCompactionOptions,
+) -> Result<Vec<RewriteResult>> {
+    let plan = plan_compaction(dataset, &options.compaction).await?;
+    let tasks = select_tasks(plan.tasks, options);
+    futures::stream::iter(tasks)
+        .map(|task| rewrite_files(Cow::Borrowed(dataset), task, &options.compaction))
+        .buffer_unordered(options.compaction.num_threads.max(1))
+        .try_collect()
+        .await
+}
+
+/// Split rewrites into those whose original fragments are unchanged in `dataset`,
+/// which can still be committed, and those whose fragments were modified since.
+fn partition_current(
+    dataset: &Dataset,
+    tasks: Vec<RewriteResult>,
+) -> (Vec<RewriteResult>, Vec<RewriteResult>) {
+    let fragments = dataset
+        .manifest
+        .fragments
+        .iter()
+        .map(|fragment| (fragment.id, fragment))
+        .collect::<HashMap<_, _>>();
+    tasks.into_iter().partition(|task| {
+        task.original_fragments
+            .iter()
+            .all(|original| fragments.get(&original.id) == Some(&original))
+    })
+}
+
+/// Delete the data files written by rewrites that will never be committed
+///
+/// Failures are only logged, the files are then left for
+/// [Dataset::cleanup_old_versions] to remove.
+async fn remove_rewritten_files(dataset: &Dataset, tasks: &[RewriteResult]) {
+    let data_dir = dataset.data_dir();
+    let paths = tasks
+        .iter()
+        .flat_map(|task| &task.new_fragments)
+        .flat_map(|fragment| &fragment.files)
+        .map(|file| Ok(data_dir.child(file.path.as_str())))
+        .collect::<Vec<_>>();
+    if paths.is_empty() {
+        return;
+    }
+    let removed = dataset
+        .object_store()
+        .remove_stream(futures::stream::iter(paths).boxed())
+        .try_for_each(|_| futures::future::ready(Ok(())))
+        .await;
+    if let Err(err) = removed {
+        warn!(
+            "Failed to remove the files of an abandoned compaction of {}: {}",
+            dataset.uri, err
+        );
+    }
+}
+
+/// Run a single round of cost-based compaction
+///
+/// The round is planned and rewritten against `dataset`.  If the commit conflicts
+/// with a concurrent writer then `dataset` is moved to the latest version and the
+/// commit is retried, up to [AutoCompactionOptions::max_retries] times, with the
+/// rewrites whose fragments are unchanged.  The files of the other rewrites are
+/// deleted and their fragments are left for the next round.  Only when no rewrite
+/// is left is the round planned again.
+pub async fn auto_compact(
+    dataset: &mut Dataset,
+    options: &AutoCompactionOptions,
+) -> Result<CompactionMetrics> {
+    let mut options = options.clone();
+    options.compaction.validate();
+
+    let mut completed = Vec::new();
+    let mut attempt = 0;
+    loop {
+        if completed.is_empty() {
+            completed = rewrite_round(dataset, &options).await?;
+            if completed.is_empty() {
+                return Ok(CompactionMetrics::default());
+            }
+        }
+        let result = commit_compaction(
+            dataset,
+            completed.clone(),
+            Arc::new(DatasetIndexRemapperOptions::default()),
+        )
+        .await;
+        match result {
+            Err(err @ Error::CommitConflict { .. }) if attempt >= options.max_retries => {
+                remove_rewritten_files(dataset, &completed).await;
+                return Err(err);
+            }
+            Err(Error::CommitConflict { version, .. }) => {
+                attempt += 1;
+                let latest = dataset.latest_version_id().await?;
+                *dataset = dataset.checkout_version(latest).await?;
+                let (current, stale) = partition_current(dataset, completed);
+                info!(
+                    "Compaction conflicted with version {}, retrying ({}/{}) with {} of {} rewrites",
+                    version,
+                    attempt,
+                    options.max_retries,
+                    current.len(),
+                    current.len() + stale.len()
+                );
+                remove_rewritten_files(dataset, &stale).await;
+                completed = current;
+            }
+            result => return result,
+        }
+    }
+}
+
+/// A background task that compacts a dataset at a regular interval
+///
+/// Each round starts from the latest version of the dataset.  A failed round is
+/// logged and the next round is tried after the interval.
+///
+/// Dropping this without calling [Self::stop] aborts the task, like [Self::abort].
+pub struct AutoCompaction {
+    stop: Option<oneshot::Sender<()>>,
+    handle: Option<JoinHandle<CompactionMetrics>>,
+    rounds: watch::Receiver<u64>,
+}
+
+impl AutoCompaction {
+    /// Start compacting `dataset` in the background
+    ///
+    /// This must be called from within a tokio runtime.
+    pub fn start(dataset: Dataset, options: AutoCompactionOptions) -> Self {
+        let (stop, mut stopped) = oneshot::channel();
+        let (rounds_tx, rounds) = watch::channel(0);
+        let handle = tokio::spawn(async move {
+            let mut dataset = dataset;
+            let mut total = CompactionMetrics::default();
+            let mut num_rounds = 0;
+            loop {
+                match Self::run_round(&mut dataset, &options).await {
+                    Ok(metrics) => total += metrics,
+                    Err(err) => warn!("Background compaction of {} failed: {}", dataset.uri, err),
+                }
+                num_rounds += 1;
+                // No one may be waiting for rounds, which is fine
+                let _ = rounds_tx.send(num_rounds);
+                tokio::select! {
+                    _ = &mut stopped => break,
+                    _ = tokio::time::sleep(options.interval) => {}
+                }
+            }
+            total
+        });
+        Self {
+            stop: Some(stop),
+            handle: Some(handle),
+            rounds,
+        }
+    }
+
+    async fn run_round(
+        dataset: &mut Dataset,
+        options: &AutoCompactionOptions,
+    ) -> Result<CompactionMetrics> {
+        let latest = dataset.latest_version_id().await?;
+        if latest != dataset.version().version {
+            *dataset = dataset.checkout_version(latest).await?;
+        }
+        auto_compact(dataset, options).await
+    }
+
+    /// Wait until at least `rounds` rounds have finished, successfully or not
+    ///
+    /// Returns the number of rounds finished so far.  Fails if the task has
+    /// stopped before that many rounds finished.
+    pub async fn wait_for_rounds(&self, rounds: u64) -> Result<u64> {
+        let mut receiver = self.rounds.clone();
+        loop {
+            let finished = *receiver.borrow_and_update();
+            if finished >= rounds {
+                return Ok(finished);
+            }
+            receiver.changed().await.map_err(|_| Error::Internal {
+                message: format!(
+                    "background compaction stopped after {} of {} rounds",
+                    finished, rounds
+                ),
+                location: location!(),
+            })?;
+        }
+    }
+
+    /// Stop the background task and return the metrics of every round
+    ///
+    /// A round that is already running is allowed to finish.
+    pub async fn stop(mut self) -> Result<CompactionMetrics> {
+        if let Some(stop) = self.stop.take() {
+            // The task may have already exited, in which case there is no one to notify
+            let _ = stop.send(());
+        }
+        match self.handle.take() {
+            Some(handle) => Ok(handle.await?),
+            None => Ok(CompactionMetrics::default()),
+        }
+    }
+
+    /// Stop the background task right away, without waiting for a running round
+    ///
+    /// Nothing is committed by an interrupted round, but the data files it has
+    /// already written are left for [Dataset::cleanup_old_versions] to remove.
+    pub fn abort(mut self) {
+        if let Some(handle) = self.handle.take() {
+            handle.abort();
+        }
+    }
+}
+
+impl Drop for AutoCompaction {
+    fn drop(&mut self) {
+        if let Some(handle) = self.handle.take() {
+            handle.abort();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use arrow_array::{Int64Array, RecordBatch, RecordBatchIterator};
+    use arrow_schema::{DataType, Field, Schema};
+    use tempfile::tempdir;
+
+    use super::*;
+    use crate::dataset::{WriteMode, WriteParams};
+
+    async fn append(uri: &str, range: std::ops::Range<i64>) -> Dataset {
+        let schema = Arc::new(Schema::new(vec![Field::new("a", DataType::Int64, false)]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(Int64Array::from_iter_values(range))],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        let write_params = WriteParams {
+            max_rows_per_file: 100,
+            mode: WriteMode::Append,
+            ..Default::default()
+        };
+        Dataset::write(reader, uri, Some(write_params))
+            .await
+            .unwrap()
+    }
+
+    fn task(fragments: &[(usize, usize)]) -> TaskData {
+        TaskData {
+            fragments: fragments
+                .iter()
+                .enumerate()
+                .map(|(id, (physical_rows, deleted_rows))| {
+                    let mut fragment = Fragment::with_file_legacy(
+                        id as u64,
+                        "data.lance",
+                        &lance_core::datatypes::Schema::default(),
+                        Some(*physical_rows),
+                    );
+                    if *deleted_rows > 0 {
+                        fragment.deletion_file = Some(lance_table::format::DeletionFile {
+                            read_version: 1,
+                            id: 1,
+                            file_type: lance_table::format::DeletionFileType::Array,
+                            num_deleted_rows: Some(*deleted_rows),
+                        });
+                    }
+                    fragment
+                })
+                .collect(),
+        }
+    }
+
+    #[test]
+    fn test_select_tasks() {
+        let options = AutoCompactionOptions {
+            max_rows_per_round: 6_000,
+            ..Default::default()
+        };
+        let many_small = task(&[(100, 0); 40]);
+        let few_small = task(&[(1_000, 0), (1_000, 0)]);
+        let deletions = task(&[(1_000_000, 300_000)]);
+        let few_deletions = task(&[(1_000_000, 10_000)]);
+
+        let score = |task| score_task(task, &options.compaction).score;
+        assert!(score(&many_small) > score(&few_small));
+        assert!(score(&few_small) > score(&deletions));
+        assert!(score(&few_deletions) < options.min_score);
+
+        // The best task runs even though it is over budget, then only what fits
+        let selected = select_tasks(
+            vec![
+                few_deletions.clone(),
+                deletions.clone(),
+                few_small.clone(),
+                many_small.clone(),
+            ],
+            &options,
+        );
+        assert_eq!(selected, vec![many_small, few_small]);
+
+        let selected = select_tasks(vec![few_deletions, deletions.clone()], &options);
+        assert_eq!(selected, vec![deletions]);
+    }
+
+    #[tokio::test]
+    async fn test_auto_compact_retries_conflicts() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        for i in 0..10 {
+            append(test_uri, i * 100..(i + 1) * 100).await;
+        }
+        let mut stale = Dataset::open(test_uri).await.unwrap();
+
+        // A concurrent writer deletes from fragments the stale plan will rewrite
+        let mut dataset = Dataset::open(test_uri).await.unwrap();
+        dataset.delete("a < 50").await.unwrap();
+
+        // Without retries the conflict is returned to the caller
+        let no_retries = AutoCompactionOptions {
+            max_retries: 0,
+            ..Default::default()
+        };
+        assert!(matches!(
+            auto_compact(&mut stale.clone(), &no_retries).await,
+            Err(Error::CommitConflict { .. })
+        ));
+
+        let metrics = auto_compact(&mut stale, &AutoCompactionOptions::default())
+            .await
+            .unwrap();
+        assert_eq!(metrics.fragments_removed, 10);
+        assert_eq!(metrics.fragments_added, 1);
+        assert!(stale.version().version > dataset.version().version);
+        assert_eq!(stale.get_fragments().len(), 1);
+        assert_eq!(stale.count_rows(None).await.unwrap(), 950);
+
+        // The files of both abandoned rewrites were removed, which leaves the 10
+        // appended files and the one compacted file
+        let num_data_files = std::fs::read_dir(test_dir.path().join("data"))
+            .unwrap()
+            .count();
+        assert_eq!(num_data_files, 11);
+    }
+
+    #[tokio::test]
+    async fn test_background_compaction() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let dataset = append(test_uri, 0..100).await;
+
+        let options = AutoCompactionOptions {
+            interval: Duration::from_millis(10),
+            ..Default::default()
+        };
+        let compaction = AutoCompaction::start(dataset, options);
+        let finished = compaction.wait_for_rounds(1).await.unwrap();
+        for i in 1..5 {
+            append(test_uri, i * 100..(i + 1) * 100).await;
+        }
+        // The round after the next one starts after every append has committed
+        let finished = compaction.wait_for_rounds(finished + 2).await.unwrap();
+        let metrics = compaction.stop().await.unwrap();
+        assert!(finished >= 3);
+
+        let dataset = Dataset::open(test_uri).await.unwrap();
+        assert_eq!(dataset.get_fragments().len(), 1);
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 500);
+        assert!(metrics.fragments_removed >= 5);
+    }
+
+    #[tokio::test]
+    async fn test_drop_aborts_background_compaction() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let dataset = append(test_uri, 0..100).await;
+
+        let options = AutoCompactionOptions {
+            interval: Duration::from_secs(3600),
+            ..Default::default()
+        };
+        let compaction = AutoCompaction::start(dataset, options);
+        compaction.wait_for_rounds(1).await.unwrap();
+        let mut rounds = compaction.rounds.clone();
+        assert_eq!(*rounds.borrow_and_update(), 1);
+        drop(compaction);
+
+        // The task ends without waiting out the interval
+        let changed = tokio::time::timeout(Duration::from_secs(10), rounds.changed())
+            .await
+            .unwrap();
+        assert!(changed.is_err());
+    }
+}
@@ -0,0 +1,431 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! Clustered rewrites for compaction
+//!
+//! Compaction normally keeps rows in insertion order.  If filters are on columns
+//! that are not correlated with insertion order then every fragment holds the whole
+//! range of values and page statistics can't prune anything.  Clustering rewrites
+//! rows sorted by one column, or along a Z-order curve over several columns, so
+//! that each fragment (and page) covers a narrow range of values.
+//!
+//! The sort runs in DataFusion with spilling enabled so it is not bounded by memory.
+
+use std::sync::Arc;
+
+use arrow::compute::cast;
+use arrow_array::{
+    cast::AsArray,
+    types::{Float64Type, Int64Type, UInt64Type},
+    Array, ArrayRef, RecordBatch, UInt64Array,
+};
+use arrow_schema::{DataType, Field, Schema as ArrowSchema};
+use datafusion::error::Result as DFResult;
+use datafusion::physical_plan::{
+    sorts::sort::SortExec, stream::RecordBatchStreamAdapter, SendableRecordBatchStream,
+};
+use datafusion_physical_expr::{expressions, PhysicalSortExpr};
+use futures::{StreamExt, TryStreamExt};
+use lance_datafusion::exec::{execute_plan, LanceExecutionOptions, OneShotExec};
+use lance_table::format::Fragment;
+use serde::{Deserialize, Serialize};
+use snafu::{location, Location};
+
+use crate::dataset::scanner::ColumnOrdering;
+use crate::{Dataset, Error, Result};
+
+/// Temporary column that holds the Z-order value of each row while sorting
+const ZORDER_COL: &str = "_zorder";
+
+/// How to order rows when compaction rewrites them
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+pub enum Clustering {
+    /// Sort rows by a single column, nulls first
+    Sort { column: String },
+    /// Order rows along a Z-order curve over the columns
+    ///
+    /// Each column gets an equal share of the 64 bits of the curve.  Values are
+    /// scaled between the minimum and maximum of the rows being rewritten, so
+    /// heavily skewed columns make less use of their bits.  Numeric, temporal,
+    /// boolean, string and binary columns are supported.  Strings and binary are
+    /// ordered by their first 8 bytes.  Nulls come first along each column.
+    ZOrder { columns: Vec<String> },
+}
+
+impl Clustering {
+    fn columns(&self) -> Vec<String> {
+        match self {
+            Self::Sort { column } => vec![column.clone()],
+            Self::ZOrder { columns } => columns.clone(),
+        }
+    }
+
+    pub(super) fn validate(&self, dataset: &Dataset) -> Result<()> {
+        let columns = self.columns();
+        if columns.is_empty() || columns.len() > 64 {
+            return Err(Error::invalid_input(
+                format!(
+                    "clustering needs between 1 and 64 columns, got {}",
+                    columns.len()
+                ),
+                location!(),
+            ));
+        }
+        for column in columns {
+            let field = dataset.schema().field(&column).ok_or_else(|| {
+                Error::invalid_input(
+                    format!("clustering column {} does not exist", column),
+                    location!(),
+                )
+            })?;
+            if matches!(self, Self::ZOrder { .. }) && !supports_zorder(&field.data_type()) {
+                return Err(Error::invalid_input(
+                    format!(
+                        "cannot Z-order on column {} of type {}",
+                        column,
+                        field.data_type()
+                    ),
+                    location!(),
+                ));
+            }
+        }
+        Ok(())
+    }
+}
+
+fn supports_zorder(data_type: &DataType) -> bool {
+    data_type.is_integer()
+        || data_type.is_floating()
+        || (data_type.is_temporal() && !matches!(data_type, DataType::Interval(_)))
+        || matches!(
+            data_type,
+            DataType::Boolean
+                | DataType::Utf8
+                | DataType::LargeUtf8
+                | DataType::Binary
+                | DataType::LargeBinary
+        )
+}
+
+/// Read the fragments, with row ids, in clustered order
+pub(super) async fn scan_clustered(
+    dataset: &Dataset,
+    fragments: Vec<Fragment>,
+    clustering: &Clustering,
+) -> Result<SendableRecordBatchStream> {
+    let spill = LanceExecutionOptions {
+        use_spilling: true,
+        ..Default::default()
+    };
+    match clustering {
+        Clustering::Sort { column } => {
+            let mut scanner = dataset.scan();
+            scanner
+                .with_fragments(fragments)
+                .with_row_id()
+                .order_by(Some(vec![ColumnOrdering::asc_nulls_first(column.clone())]))?;
+            scanner.try_into_dfstream(spill).await
+        }
+        Clustering::ZOrder { columns } => {
+            let bounds = ZOrderBounds::load(dataset, fragments.clone(), columns).await?;
+
+            let mut scanner = dataset.scan();
+            scanner.with_fragments(fragments).with_row_id();
+            let data = SendableRecordBatchStream::from(scanner.try_into_stream().await?);
+
+            let mut fields = data.schema().fields().to_vec();
+            fields.push(Arc::new(Field::new(ZORDER_COL, DataType::UInt64, false)));
+            let with_zorder_schema = Arc::new(ArrowSchema::new(fields));
+            let output_schema = data.schema();
+
+            let columns = columns.clone();
+            let schema = with_zorder_schema.clone();
+            let with_zorder = data.map(move |batch: DFResult<RecordBatch>| -> DFResult<_> {
+                let batch = batch?;
+                let zorder = bounds.zorder(&batch, &columns)?;
+                let mut arrays = batch.columns().to_vec();
+                arrays.push(Arc::new(zorder));
+                Ok(RecordBatch::try_new(schema.clone(), arrays)?)
+            });
+            let with_zorder = Box::pin(RecordBatchStreamAdapter::new(
+                with_zorder_schema.clone(),
+                with_zorder,
+            ));
+
+            let sort_expr = PhysicalSortExpr {
+                expr: expressions::col(ZORDER_COL, &with_zorder_schema)?,
+                options: Default::default(),
+            };
+            let plan = Arc::new(SortExec::new(
+                vec![sort_expr],
+                Arc::new(OneShotExec::new(with_zorder)),
+            ));
+            let sorted = execute_plan(plan, spill)?;
+
+            let num_columns = output_schema.fields().len();
+            let projection = (0..num_columns).collect::<Vec<_>>();
+            let sorted = sorted.map(
+                move |batch: DFResult<RecordBatch>| -> DFResult<RecordBatch> {
+                    Ok(batch?.project(&projection)?)
+                },
+            );
+            Ok(Box::pin(RecordBatchStreamAdapter::new(
+                output_schema,
+                sorted,
+            )))
+        }
+    }
+}
+
+/// Map values to `u64` so that comparing the keys compares the values
+///
+/// Nulls map to 0.  Callers that need the range of the values must skip them.
+fn order_preserving_keys(array: &ArrayRef) -> Result<Vec<u64>> {
+    const SIGN_BIT: u64 = 1 << 63;
+    let data_type = array.data_type();
+    let mut keys = if data_type.is_unsigned_integer() || data_type == &DataType::Boolean {
+        cast(array, &DataType::UInt64)?
+            .as_primitive::<UInt64Type>()
+            .values()
+            .to_vec()
+    } else if data_type.is_integer() || data_type.is_temporal() {
+        cast(array, &DataType::Int64)?
+            .as_primitive::<Int64Type>()
+            .values()
+            .iter()
+            .map(|value| (*value as u64) ^ SIGN_BIT)
+            .collect()
+    } else if data_type.is_floating() {
+        cast(array, &DataType::Float64)?
+            .as_primitive::<Float64Type>()
+            .values()
+            .iter()
+            .map(|value| {
+                let bits = value.to_bits();
+                if bits & SIGN_BIT != 0 {
+                    !bits
+                } else {
+                    bits | SIGN_BIT
+                }
+            })
+            .collect()
+    } else {
+        match data_type {
+            DataType::Utf8 => prefix_keys(
+                array
+                    .as_string::<i32>()
+                    .iter()
+                    .map(|v| v.map(str::as_bytes)),
+            ),
+            DataType::LargeUtf8 => prefix_keys(
+                array
+                    .as_string::<i64>()
+                    .iter()
+                    .map(|v| v.map(str::as_bytes)),
+            ),
+            DataType::Binary => prefix_keys(array.as_binary::<i32>().iter()),
+            DataType::LargeBinary => prefix_keys(array.as_binary::<i64>().iter()),
+            _ => {
+                return Err(Error::invalid_input(
+                    format!("cannot Z-order on values of type {}", data_type),
+                    location!(),
+                ))
+            }
+        }
+    };
+    if let Some(nulls) = array.nulls() {
+        for (key, valid) in keys.iter_mut().zip(nulls.iter()) {
+            if !valid {
+                *key = 0;
+            }
+        }
+    }
+    Ok(keys)
+}
+
+/// The first 8 bytes of each value, big endian, so that shorter values come first
+fn prefix_keys<'a>(values: impl Iterator<Item = Option<&'a [u8]>>) -> Vec<u64> {
+    values
+        .map(|value| {
+            let mut prefix = [0_u8; 8];
+            let value = value.unwrap_or_default();
+            let len = value.len().min(8);
+            prefix[..len].copy_from_slice(&value[..len]);
+            u64::from_be_bytes(prefix)
+        })
+        .collect()
+}
+
+/// The range of the keys of each Z-order column
+///
+/// Nulls are left out of the range and always take the lowest position of their
+/// column on the curve, so they don't stretch the range of the valid values.
+struct ZOrderBounds {
+    min: Vec<u64>,
+    max: Vec<u64>,
+}
+
+impl ZOrderBounds {
+    /// Scan just the Z-order columns of the fragments to find their ranges
+    async fn load(dataset: &Dataset, fragments: Vec<Fragment>, columns: &[String]) -> Result<Self> {
+        let mut scanner = dataset.scan();
+        scanner.with_fragments(fragments).project(columns)?;
+        let initial = Self {
+            min: vec![u64::MAX; columns.len()],
+            max: vec![0; columns.len()],
+        };
+        scanner
+            .try_into_stream()
+            .await?
+            .map_err(Error::from)
+            .try_fold(initial, |mut bounds, batch| async move {
+                for (col_idx, column) in batch.columns().iter().enumerate() {
+                    let keys = order_preserving_keys(column)?;
+                    for (row, key) in keys.into_iter().enumerate() {
+                        if column.is_null(row) {
+                            continue;
+                        }
+                        bounds.min[col_idx] = bounds.min[col_idx].min(key);
+                        bounds.max[col_idx] = bounds.max[col_idx].max(key);
+                    }
+                }
+                Ok(bounds)
+            })
+            .await
+    }
+
+    /// Scale each key into its share of the bits and interleave them
+    fn zorder(&self, batch: &RecordBatch, columns: &[String]) -> Result<UInt64Array> {
+        let bits = 64 / columns.len();
+        let max_scaled = (1_u128 << bits) - 1;
+        let scaled = columns
+            .iter()
+            .enumerate()
+            .map(|(col_idx, name)| {
+                let column = batch.column_by_name(name).ok_or_else(|| {
+                    Error::invalid_input(format!("column {} is missing", name), location!())
+                })?;
+                let (min, max) = (self.min[col_idx], self.max[col_idx]);
+                let range = max.saturating_sub(min) as u128;
+                Ok(order_preserving_keys(column)?
+                    .into_iter()
+                    .enumerate()
+                    .map(|(row, key)| {
+                        if range == 0 || column.is_null(row) {
+                            0
+                        } else {
+                            let offset = (key.clamp(min, max) - min) as u128;
+                            (offset * max_scaled / range) as u64
+                        }
+                    })
+                    .collect::<Vec<_>>())
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        Ok((0..batch.num_rows())
+            .map(|row| {
+                let mut z = 0_u64;
+                for bit in (0..bits).rev() {
+                    for column in scaled.iter() {
+                        z = (z << 1) | ((column[row] >> bit) & 1);
+                    }
+                }
+                z
+            })
+            .collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use arrow_array::{Float64Array, Int32Array, RecordBatchIterator, StringArray};
+    use tempfile::tempdir;
+
+    use super::*;
+
+    #[test]
+    fn test_order_preserving_keys() {
+        fn assert_sorted(array: ArrayRef) {
+            let keys = order_preserving_keys(&array).unwrap();
+            assert!(keys.windows(2).all(|w| w[0] < w[1]), "{:?}", keys);
+        }
+        assert_sorted(Arc::new(Int32Array::from(vec![
+            None,
+            Some(i32::MIN),
+            Some(-1),
+            Some(0),
+            Some(7),
+            Some(i32::MAX),
+        ])));
+        assert_sorted(Arc::new(Float64Array::from(vec![
+            f64::NEG_INFINITY,
+            -2.5,
+            -0.0,
+            0.0,
+            1e-9,
+            3.0,
+            f64::INFINITY,
+        ])));
+        assert_sorted(Arc::new(StringArray::from(vec![
+            None,
+            Some("a"),
+            Some("ab"),
+            Some("b"),
+        ])));
+    }
+
+    #[test]
+    fn test_zorder_interleaves_bits() {
+        let schema = Arc::new(ArrowSchema::new(vec![
+            Field::new("x", DataType::Int32, false),
+            Field::new("y", DataType::Int32, false),
+        ]));
+        // The four corners of the square
+        let batch = RecordBatch::try_new(
+            schema,
+            vec![
+                Arc::new(Int32Array::from(vec![0, 1, 0, 1])),
+                Arc::new(Int32Array::from(vec![0, 0, 1, 1])),
+            ],
+        )
+        .unwrap();
+        let bounds = ZOrderBounds {
+            min: vec![1 << 63; 2],
+            max: vec![(1 << 63) + 1; 2],
+        };
+        let columns = vec!["x".to_string(), "y".to_string()];
+        let z = bounds.zorder(&batch, &columns).unwrap();
+        // x takes the higher bit of each pair, each coordinate is scaled to 32 bits
+        let (lo, hi) = (0_u64, 0xAAAA_AAAA_AAAA_AAAA_u64);
+        assert_eq!(z.values().to_vec(), vec![lo, hi, hi >> 1, u64::MAX]);
+    }
+
+    #[tokio::test]
+    async fn test_zorder_bounds_skip_nulls() {
+        let schema = Arc::new(ArrowSchema::new(vec![Field::new(
+            "x",
+            DataType::Int32,
+            true,
+        )]));
+        let x: ArrayRef = Arc::new(Int32Array::from(vec![Some(100), None, Some(101), None]));
+        let batch = RecordBatch::try_new(schema.clone(), vec![x.clone()]).unwrap();
+
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch.clone())], schema);
+        let dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+
+        let columns = vec!["x".to_string()];
+        let bounds = ZOrderBounds::load(&dataset, dataset.manifest.fragments.to_vec(), &columns)
+            .await
+            .unwrap();
+        // The range covers only the valid values
+        let keys = order_preserving_keys(&x).unwrap();
+        assert_eq!(bounds.min, vec![keys[0]]);
+        assert_eq!(bounds.max, vec![keys[2]]);
+
+        // Nulls come first, the valid values span the whole curve
+        let z = bounds.zorder(&batch, &columns).unwrap();
+        assert_eq!(z.values().to_vec(), vec![0, 0, u64::MAX, 0]);
+    }
+}
@@ -3,8 +3,10 @@
 
 use super::Dataset;
 use crate::{Error, Result};
+use deepsize::DeepSizeOf;
 use futures::{Stream, StreamExt, TryFutureExt, TryStreamExt};
 use snafu::{location, Location};
+use std::collections::HashMap;
 use std::sync::Arc;
 
 use lance_table::{
@@ -67,28 +69,87 @@ pub fn load_row_id_sequences<'a>(
         .buffer_unordered(num_cpus::get())
 }
 
-// TODO: remove allow unused once we start using this in query and take paths.
-#[allow(unused)]
+/// The row id index most recently built for a dataset, and the row id sequence of each
+/// fragment it was built from.  The index for another version is derived from this one by
+/// only loading the sequences of the fragments that differ.
+struct RowIdIndexSnapshot {
+    row_id_metas: HashMap<u64, Option<RowIdMeta>>,
+    index: Arc<RowIdIndex>,
+}
+
+impl DeepSizeOf for RowIdIndexSnapshot {
+    fn deep_size_of_children(&self, _: &mut deepsize::Context) -> usize {
+        // The index is shared with the per-version cache entry so isn't counted again
+        self.row_id_metas.len() * std::mem::size_of::<(u64, Option<RowIdMeta>)>()
+    }
+}
+
+/// Get the index mapping stable row ids to row addresses for the dataset's version.
 pub async fn get_row_id_index(dataset: &Dataset) -> Result<Arc<lance_table::rowids::RowIdIndex>> {
     // The path here isn't real, it's just used to prevent collisions in the cache.
     let path = dataset
         .base
         .child("row_ids")
         .child(dataset.manifest.version.to_string());
-    dataset
-        .session
-        .file_metadata_cache
-        .get_or_insert(&path, |_path| async { load_row_id_index(dataset).await })
-        .await
-}
-
-async fn load_row_id_index(dataset: &Dataset) -> Result<lance_table::rowids::RowIdIndex> {
-    let sequences = load_row_id_sequences(dataset, &dataset.manifest.fragments)
-        .try_collect::<Vec<_>>()
-        .await?;
+    let cache = &dataset.session.file_metadata_cache;
+    if let Some(index) = cache.get::<RowIdIndex>(&path) {
+        return Ok(index);
+    }
 
-    let index = RowIdIndex::new(&sequences)?;
+    let index = load_row_id_index(dataset).await?;
+    cache.insert(path, index.clone());
+    Ok(index)
+}
 
+async fn load_row_id_index(dataset: &Dataset) -> Result<Arc<RowIdIndex>> {
+    let latest_path = dataset.base.child("row_ids").child("latest");
+    let cache = &dataset.session.file_metadata_cache;
+    let row_id_metas = dataset
+        .manifest
+        .fragments
+        .iter()
+        .map(|frag| (frag.id, frag.row_id_meta.clone()))
+        .collect::<HashMap<_, _>>();
+
+    let index = if let Some(snapshot) = cache.get::<RowIdIndexSnapshot>(&latest_path) {
+        // Fragments that were removed or rewritten (e.g. by compaction or update) since
+        // the snapshot, or when going back to an older version, that were added since
+        let removed = snapshot
+            .row_id_metas
+            .iter()
+            .filter(|(id, meta)| row_id_metas.get(id) != Some(meta))
+            .map(|(id, _)| *id as u32)
+            .collect::<Vec<_>>();
+        let changed = dataset
+            .manifest
+            .fragments
+            .iter()
+            .filter(|frag| snapshot.row_id_metas.get(&frag.id) != Some(&frag.row_id_meta))
+            .cloned()
+            .collect::<Vec<_>>();
+        let sequences = load_row_id_sequences(dataset, &changed)
+            .try_collect::<Vec<_>>()
+            .await?;
+
+        // The clone shares the segments of the unchanged fragments with the snapshot
+        let mut index = snapshot.index.as_ref().clone();
+        index.apply_fragment_changes(&removed, &sequences)?;
+        index
+    } else {
+        let sequences = load_row_id_sequences(dataset, &dataset.manifest.fragments)
+            .try_collect::<Vec<_>>()
+            .await?;
+        RowIdIndex::new(&sequences)?
+    };
+    let index = Arc::new(index);
+
+    cache.insert(
+        latest_path,
+        Arc::new(RowIdIndexSnapshot {
+            row_id_metas,
+            index: index.clone(),
+        }),
+    );
     Ok(index)
 }
 
@@ -376,5 +437,47 @@ mod test {
         assert_eq!(index.get(5), Some(RowAddress::new_from_parts(1, 0)));
     }
 
+    #[tokio::test]
+    async fn test_take_rows_by_stable_row_id() {
+        let batch = sequence_batch(0..6);
+        let reader = RecordBatchIterator::new(vec![Ok(batch.clone())], batch.schema());
+        let write_params = WriteParams {
+            enable_move_stable_row_ids: true,
+            max_rows_per_file: 2,
+            ..Default::default()
+        };
+        let dataset = Dataset::write(reader, "memory://", Some(write_params))
+            .await
+            .unwrap();
+        // Load the index so the next version's index is built incrementally from it
+        let index = get_row_id_index(&dataset).await.unwrap();
+        assert_eq!(index.get(4), Some(RowAddress::new_from_parts(2, 0)));
+
+        // Row 3 moves to a new fragment and gets row id 6
+        let dataset = UpdateBuilder::new(Arc::new(dataset))
+            .update_where("id = 3")
+            .unwrap()
+            .set("id", "100")
+            .unwrap()
+            .build()
+            .unwrap()
+            .execute()
+            .await
+            .unwrap();
+
+        let index = get_row_id_index(&dataset).await.unwrap();
+        assert_eq!(index.get(6), Some(RowAddress::new_from_parts(3, 0)));
+        assert_eq!(index.get(4), Some(RowAddress::new_from_parts(2, 0)));
+
+        let projection = dataset.schema().project(&["id"]).unwrap();
+        let result = dataset
+            .take_rows(&[6, 0, 3, 5, 42], &projection)
+            .await
+            .unwrap();
+        // Row id 3 was deleted and 42 never existed
+        let ids = result["id"].as_any().downcast_ref::<Int32Array>().unwrap();
+        assert_eq!(ids, &Int32Array::from(vec![100, 0, 5]));
+    }
+
     // TODO: query / scan / take after deletion, compaction, then deletion
 }
@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
 use std::collections::{HashMap, HashSet};
+use std::ops::Range;
 use std::pin::Pin;
 use std::sync::Arc;
 use std::task::{Context, Poll};
@@ -18,6 +19,7 @@ use datafusion::physical_plan::projection::ProjectionExec as DFProjectionExec;
 use datafusion::physical_plan::sorts::sort::SortExec;
 use datafusion::physical_plan::{
     aggregates::{AggregateExec, AggregateMode, PhysicalGroupBy},
+    coalesce_partitions::CoalescePartitionsExec,
     display::DisplayableExecutionPlan,
     expressions::{create_aggregate_expr, Literal},
     filter::FilterExec,
@@ -33,8 +35,14 @@ use futures::TryStreamExt;
 use lance_arrow::floats::{coerce_float_vector, FloatType};
 use lance_core::{ROW_ADDR, ROW_ADDR_FIELD, ROW_ID, ROW_ID_FIELD};
 use lance_datafusion::exec::{execute_plan, LanceExecutionOptions};
+use lance_index::scalar::{
+    expression::{IndexInformationProvider, ScalarIndexExpr},
+    zonemap::ZONE_SIZE,
+    ScalarIndexType,
+};
+use lance_index::scalar::{inverted::SCORE_COL, FullTextSearchQuery, ScalarQuery};
 use lance_index::vector::{Query, DIST_COL};
-use lance_index::{scalar::expression::ScalarIndexExpr, DatasetIndexExt};
+use lance_index::DatasetIndexExt;
 use lance_io::stream::RecordBatchStream;
 use lance_linalg::distance::MetricType;
 use lance_table::format::{Fragment, Index};
@@ -45,6 +53,7 @@ use tracing::{info_span, instrument, Span};
 use super::Dataset;
 use crate::datatypes::Schema;
 use crate::index::DatasetIndexInternalExt;
+use crate::io::exec::fts::{FlatFtsExec, FtsExec};
 use crate::io::exec::scalar_index::{MaterializeIndexExec, ScalarIndexExec};
 use crate::io::exec::{
     knn::new_knn_exec, FilterPlan, KNNFlatExec, LancePushdownScanExec, LanceScanExec, Planner,
@@ -146,6 +155,9 @@ pub struct Scanner {
     /// Number of fragments to read concurrently
     fragment_readahead: usize,
 
+    /// Number of partitions to split a full scan into (default: 1)
+    target_partitions: usize,
+
     limit: Option<i64>,
     offset: Option<i64>,
 
@@ -161,6 +173,9 @@ pub struct Scanner {
 
     nearest: Option<Query>,
 
+    /// If Some, a full text search on (column, query)
+    full_text_query: Option<(String, FullTextSearchQuery)>,
+
     /// Scan the dataset with a meta column: "_rowid"
     with_row_id: bool,
 
@@ -201,10 +216,12 @@ impl Scanner {
             batch_size: None,
             batch_readahead: DEFAULT_BATCH_READAHEAD,
             fragment_readahead: DEFAULT_FRAGMENT_READAHEAD,
+            target_partitions: 1,
             limit: None,
             offset: None,
             ordering: None,
             nearest: None,
+            full_text_query: None,
             use_stats: true,
             with_row_id: false,
             with_row_address: false,
@@ -381,6 +398,18 @@ impl Scanner {
         self
     }
 
+    /// Set the number of partitions a full scan is split into (default: 1)
+    ///
+    /// Each partition reads about the same number of rows and the filter,
+    /// take and projection stages above the scan run on each partition in
+    /// parallel.  This is only used if ``scan_in_order`` is set to false (or an
+    /// ordering is given), since the partitions are not ordered relative to
+    /// each other.
+    pub fn target_partitions(&mut self, num_partitions: usize) -> &mut Self {
+        self.target_partitions = num_partitions.max(1);
+        self
+    }
+
     /// Set whether to read data in order (default: true)
     ///
     /// A scan will always read from the disk concurrently.  If this property
@@ -483,6 +512,75 @@ impl Scanner {
         Ok(self)
     }
 
+    /// Find the `k` rows whose text best matches `query`
+    ///
+    /// The column must have an inverted index.  Rows are ranked by BM25 and the score is
+    /// returned in the `_score` column.  Fragments written after the index was trained are
+    /// scanned and scored with the statistics of the index, so they rank like indexed rows.
+    /// Any filter is applied while searching, so rows that fail it do not take up any of
+    /// the `k` results.
+    ///
+    /// If [`Self::nearest`] is also used then the vector search only considers the rows
+    /// that contain at least one of the query tokens (`k` is not applied to them and no
+    /// `_score` column is returned).
+    pub fn full_text_search(&mut self, column: &str, query: &str, k: usize) -> Result<&mut Self> {
+        self.ensure_not_fragment_scan()?;
+
+        if k == 0 {
+            return Err(Error::io("k must be positive".to_string(), location!()));
+        }
+        let field = self.dataset.schema().field(column).ok_or(Error::io(
+            format!("Column {} not found", column),
+            location!(),
+        ))?;
+        if !matches!(field.data_type(), DataType::Utf8 | DataType::LargeUtf8) {
+            return Err(Error::io(
+                format!(
+                    "Column {} is not a string column (type: {})",
+                    column,
+                    field.data_type()
+                ),
+                location!(),
+            ));
+        }
+        self.full_text_query = Some((column.to_string(), FullTextSearchQuery::new(query).limit(k)));
+        Ok(self)
+    }
+
+    /// True if the results are the scored rows of a full text search
+    fn is_full_text_search(&self) -> bool {
+        self.full_text_query.is_some() && self.nearest.is_none()
+    }
+
+    /// Add the full text search, if any, to the prefilter of a vector search
+    ///
+    /// The prefilter keeps every row that contains one of the query tokens rather than the
+    /// best k.  The best k would depend on which fragments the index covers, while the rows
+    /// containing a token are the same whether they are found with the index or, for the
+    /// fragments it does not cover, with the equivalent filter expression.
+    fn with_full_text_prefilter(&self, mut filter_plan: FilterPlan) -> FilterPlan {
+        let Some((column, query)) = self.full_text_query.as_ref() else {
+            return filter_plan;
+        };
+        let query = ScalarQuery::FullTextSearch(FullTextSearchQuery {
+            limit: None,
+            ..query.clone()
+        });
+        let fts_expr = query.to_expr(column.clone());
+        let fts_index_expr = ScalarIndexExpr::Query(column.clone(), query);
+        filter_plan.index_query = Some(match filter_plan.index_query.take() {
+            Some(index_query) => {
+                ScalarIndexExpr::And(Box::new(index_query), Box::new(fts_index_expr))
+            }
+            None => fts_index_expr,
+        });
+        filter_plan.full_expr = Some(match filter_plan.full_expr.take() {
+            Some(full_expr) => full_expr.and(fts_expr),
+            None => fts_expr,
+        });
+        filter_plan
+    }
+
     pub fn nprobs(&mut self, n: usize) -> &mut Self {
         if let Some(q) = self.nearest.as_mut() {
             q.nprobes = n;
@@ -595,6 +693,10 @@ impl Scanner {
             extra_columns.push(ArrowField::new(DIST_COL, DataType::Float32, true));
         };
 
+        if self.is_full_text_search() {
+            extra_columns.push(ArrowField::new(SCORE_COL, DataType::Float32, false));
+        }
+
         if self.with_row_id {
             extra_columns.push(ROW_ID_FIELD.clone());
         }
@@ -674,6 +776,11 @@ impl Scanner {
             output_expr.push((vector_expr, DIST_COL.to_string()));
         }
 
+        if self.is_full_text_search() {
+            let score_expr = expressions::col(SCORE_COL, &physical_schema)?;
+            output_expr.push((score_expr, SCORE_COL.to_string()));
+        }
+
         if self.with_row_id {
             let row_id_expr = expressions::col(ROW_ID, &physical_schema)?;
             output_expr.push((row_id_expr, ROW_ID.to_string()));
@@ -816,6 +923,17 @@ impl Scanner {
     /// 4. Limit / Offset
     /// 5. Take remaining columns / Projection
     pub async fn create_plan(&self) -> Result<Arc<dyn ExecutionPlan>> {
+        let plan = self.create_partitioned_plan().await?;
+        Ok(Self::coalesce_partitions(plan))
+    }
+
+    /// Create the physical plan without merging its output partitions
+    ///
+    /// This is the same as [`Self::create_plan`] but, if the scan was split with
+    /// [`Self::target_partitions`], the plan may have more than one output
+    /// partition.  This is useful when the plan is consumed by a DataFusion
+    /// query which can run the partitions in parallel itself.
+    pub async fn create_partitioned_plan(&self) -> Result<Arc<dyn ExecutionPlan>> {
         if self.phyical_columns.fields.is_empty() && !self.with_row_id && !self.with_row_address {
             return Err(Error::InvalidInput {
                 source:
@@ -869,12 +987,28 @@ impl Scanner {
             // The source is an nearest neighbor search
             if self.prefilter {
                 // If we are prefiltering then the knn node will take care of the filter
-                let source = self.knn(&filter_plan).await?;
+                let prefilter_plan = self.with_full_text_prefilter(filter_plan);
                 filter_plan = FilterPlan::default();
-                source
+                self.knn(&prefilter_plan).await?
             } else {
-                self.knn(&FilterPlan::default()).await?
+                self.knn(&self.with_full_text_prefilter(FilterPlan::default()))
+                    .await?
             }
+        } else if let Some((column, query)) = self.full_text_query.as_ref() {
+            // The source is a full text search, any filter is applied while searching so
+            // that the k best matching rows are returned
+            let prefilter_source = self.prefilter_source(&filter_plan).await?;
+            let fts_node = Arc::new(FtsExec::new(
+                self.dataset.clone(),
+                column.clone(),
+                query.clone(),
+                prefilter_source,
+            ));
+            let fts_node = self
+                .fts_combined(column, query, fts_node, &filter_plan)
+                .await?;
+            filter_plan = FilterPlan::default();
+            fts_node
         } else {
             // Avoid pushdown scan node if using v2 files
             let fragments = if let Some(fragments) = self.fragments.as_ref() {
@@ -892,6 +1026,13 @@ impl Scanner {
                     self.scalar_indexed_scan(&self.phyical_columns, index_query)
                         .await?
                 }
+                (Some(index_query), Some(_)) if self.is_zone_map_query(index_query).await? => {
+                    // Zone maps rule out whole ranges of rows, it is cheaper to scan the
+                    // remaining ranges than to take their rows one by one
+                    let columns = filter_plan.refine_columns();
+                    let filter_schema = Arc::new(self.dataset.schema().project(&columns)?);
+                    self.zone_map_scan(filter_schema, index_query).await?
+                }
                 // TODO: support combined pushdown and scalar index scan
                 (Some(index_query), Some(_)) => {
                     // If there is a filter then just load the filter
@@ -915,7 +1056,14 @@ impl Scanner {
                     } else {
                         Arc::new(self.phyical_columns.clone())
                     };
-                    self.scan(with_row_id, self.with_row_address, false, schema)
+                    self.scan(
+                        with_row_id,
+                        self.with_row_address,
+                        false,
+                        schema,
+                        self.target_partitions,
+                    )
+                    .await?
                 }
             }
         };
@@ -968,6 +1116,7 @@ impl Scanner {
                 // We haven't loaded the sort column yet so take it now
                 plan = self.take(plan, &remaining_schema, self.batch_readahead)?;
             }
+            plan = Self::coalesce_partitions(plan);
             let col_exprs = ordering
                 .iter()
                 .map(|col| {
@@ -985,7 +1134,7 @@ impl Scanner {
 
         // Stage 4: limit / offset
         if (self.limit.unwrap_or(0) > 0) || self.offset.is_some() {
-            plan = self.limit_node(plan);
+            plan = self.limit_node(Self::coalesce_partitions(plan));
         }
 
         // Stage 5: take remaining columns required for projection
@@ -1093,7 +1242,8 @@ impl Scanner {
                 self.scalar_indexed_scan(&vector_scan_projection, index_query)
                     .await?
             } else {
-                self.scan(true, false, true, vector_scan_projection)
+                self.scan(true, false, true, vector_scan_projection, 1)
+                    .await?
             };
             if let Some(refine_expr) = &filter_plan.refine_expr {
                 let planner = Planner::new(plan.schema());
@@ -1136,6 +1286,8 @@ impl Scanner {
                 // We are re-ordering anyways, so no need to get data in data
                 // in a deterministic order.
                 false,
+                1,
+                None,
             );
 
             if let Some(expr) = filter_plan.full_expr.as_ref() {
@@ -1172,6 +1324,75 @@ impl Scanner {
         Ok(knn_node)
     }
 
+    /// Add the best matches from the fragments the inverted index does not cover to a full
+    /// text search
+    async fn fts_combined(
+        &self,
+        column: &str,
+        query: &FullTextSearchQuery,
+        fts_node: Arc<dyn ExecutionPlan>,
+        filter_plan: &FilterPlan,
+    ) -> Result<Arc<dyn ExecutionPlan>> {
+        // Without an index FtsExec reports the error when it runs
+        let Some(index) = self.dataset.load_scalar_index_for_column(column).await? else {
+            return Ok(fts_node);
+        };
+        let unindexed_fragments = self.dataset.unindexed_fragments(&index.name).await?;
+        if unindexed_fragments.is_empty() {
+            return Ok(fts_node);
+        }
+
+        let mut columns = vec![column.to_string()];
+        if let Some(expr) = filter_plan.full_expr.as_ref() {
+            for filter_column in Planner::column_names_in_expr(expr) {
+                if !columns.contains(&filter_column) {
+                    columns.push(filter_column);
+                }
+            }
+        }
+        let projection = Arc::new(self.dataset.schema().project(&columns)?);
+        let mut scan_node = self.scan_fragments(
+            true,
+            false,
+            true,
+            projection,
+            Arc::new(unindexed_fragments),
+            // The results are ranked anyways
+            false,
+            1,
+            None,
+        );
+        if let Some(expr) = filter_plan.full_expr.as_ref() {
+            let planner = Planner::new(scan_node.schema());
+            let physical_refine_expr = planner.create_physical_expr(expr)?;
+            scan_node = Arc::new(FilterExec::try_new(physical_refine_expr, scan_node)?);
+        }
+        let flat_node: Arc<dyn ExecutionPlan> = Arc::new(FlatFtsExec::new(
+            self.dataset.clone(),
+            column.to_string(),
+            query.clone(),
+            scan_node,
+        ));
+
+        // Both inputs score with the statistics of the index so the best k of the union are
+        // the best k overall
+        let unioned = UnionExec::new(vec![fts_node, flat_node]);
+        let unioned = RepartitionExec::try_new(
+            Arc::new(unioned),
+            datafusion::physical_plan::Partitioning::RoundRobinBatch(1),
+        )?;
+        let sort_expr = PhysicalSortExpr {
+            expr: expressions::col(SCORE_COL, unioned.schema().as_ref())?,
+            options: SortOptions {
+                descending: true,
+                nulls_first: false,
+            },
+        };
+        Ok(Arc::new(
+            SortExec::new(vec![sort_expr], Arc::new(unioned)).with_fetch(query.limit),
+        ))
+    }
+
     #[async_recursion]
     async fn fragments_covered_by_index_query(
         &self,
@@ -1266,6 +1487,8 @@ impl Scanner {
                 Arc::new(schema.clone()),
                 missing_frags.into(),
                 false,
+                1,
+                None,
             );
             let filtered = Arc::new(FilterExec::try_new(physical_refine_expr, new_data_scan)?);
             let projection = Schema::try_from(taken.schema().as_ref())?;
@@ -1294,13 +1517,18 @@ impl Scanner {
     ///
     /// Setting `with_make_deletions_null` will use the validity of the _rowid
     /// column as a selection vector. Read more in [crate::io::FileReader].
-    pub(crate) fn scan(
+    ///
+    /// The scan is split into up to `num_partitions` partitions, unless the
+    /// results need to be returned in order.  The partitions are balanced by the
+    /// size of the data files that hold the projected columns.
+    pub(crate) async fn scan(
         &self,
         with_row_id: bool,
         with_row_address: bool,
         with_make_deletions_null: bool,
         projection: Arc<Schema>,
-    ) -> Arc<dyn ExecutionPlan> {
+        num_partitions: usize,
+    ) -> Result<Arc<dyn ExecutionPlan>> {
         let fragments = if let Some(fragment) = self.fragments.as_ref() {
             Arc::new(fragment.clone())
         } else {
@@ -1312,14 +1540,145 @@ impl Scanner {
         } else {
             self.ordered
         };
-        self.scan_fragments(
+        let num_partitions = if ordered { 1 } else { num_partitions };
+        let fragment_bytes = if num_partitions > 1 {
+            Some(self.fragment_data_sizes(&fragments, &projection).await?)
+        } else {
+            None
+        };
+        Ok(self.scan_fragments(
             with_row_id,
             with_row_address,
             with_make_deletions_null,
             projection,
             fragments,
             ordered,
-        )
+            num_partitions,
+            fragment_bytes.as_ref(),
+        ))
+    }
+
+    /// The number of bytes in each fragment's data files that hold a column of
+    /// `projection`, by fragment id
+    ///
+    /// This costs a HEAD request per data file, so it is only used to balance
+    /// partitioned scans.  Files that only hold other columns are not read by the
+    /// scan and are skipped.
+    async fn fragment_data_sizes(
+        &self,
+        fragments: &[Fragment],
+        projection: &Schema,
+    ) -> Result<HashMap<u64, u64>> {
+        let field_ids = projection.field_ids().into_iter().collect::<HashSet<_>>();
+        let data_dir = self.dataset.data_dir();
+        let object_store = self.dataset.object_store();
+        let files = fragments
+            .iter()
+            .flat_map(|fragment| fragment.files.iter().map(move |file| (fragment.id, file)))
+            .filter(|(_, file)| file.fields.iter().any(|id| field_ids.contains(id)))
+            .map(|(fragment_id, file)| (fragment_id, data_dir.child(file.path.as_str())))
+            .collect::<Vec<_>>();
+        let sizes = futures::stream::iter(files)
+            .map(|(fragment_id, path)| async move {
+                let size = object_store.size(&path).await?;
+                Result::Ok((fragment_id, size as u64))
+            })
+            .buffer_unordered(num_cpus::get() * 4)
+            .try_collect::<Vec<_>>()
+            .await?;
+
+        let mut fragment_bytes = HashMap::with_capacity(fragments.len());
+        for (fragment_id, size) in sizes {
+            *fragment_bytes.entry(fragment_id).or_insert(0) += size;
+        }
+        Ok(fragment_bytes)
+    }
+
+    /// True if every query in `index_expr` is answered by a zone map index
+    async fn is_zone_map_query(&self, index_expr: &ScalarIndexExpr) -> Result<bool> {
+        fn only_zone_maps(
+            index_expr: &ScalarIndexExpr,
+            index_info: &dyn IndexInformationProvider,
+        ) -> bool {
+            match index_expr {
+                ScalarIndexExpr::Not(_) => false,
+                ScalarIndexExpr::And(lhs, rhs) | ScalarIndexExpr::Or(lhs, rhs) => {
+                    only_zone_maps(lhs, index_info) && only_zone_maps(rhs, index_info)
+                }
+                ScalarIndexExpr::Query(column, _) => matches!(
+                    index_info.get_index(column),
+                    Some((_, ScalarIndexType::ZoneMap))
+                ),
+            }
+        }
+        let index_info = self.dataset.scalar_index_info().await?;
+        Ok(only_zone_maps(index_expr, &index_info))
+    }
+
+    /// Scan only the zones that a zone map index query says might match
+    ///
+    /// Zone map results are always whole zones so, unlike [`Self::scalar_indexed_scan`], the
+    /// candidates are read as contiguous row ranges instead of being taken row by row.
+    /// Fragments that the index does not cover (e.g. written by an update since the index
+    /// was last optimized), or that have no recorded row count, are read in full.  The candidates are a superset
+    /// of the matches so the filter must still be applied.
+    async fn zone_map_scan(
+        &self,
+        projection: Arc<Schema>,
+        index_expr: &ScalarIndexExpr,
+    ) -> Result<Arc<dyn ExecutionPlan>> {
+        let fragments = if let Some(fragments) = self.fragments.as_ref() {
+            fragments.clone()
+        } else {
+            (**self.dataset.fragments()).clone()
+        };
+        let covered_frags = self.fragments_covered_by_index_query(index_expr).await?;
+        let candidates = index_expr.evaluate(self.dataset.as_ref()).await?;
+
+        let mut scanned = Vec::with_capacity(fragments.len());
+        let mut ranges = HashMap::new();
+        for fragment in fragments {
+            if !covered_frags.contains(fragment.id as u32) {
+                scanned.push(fragment);
+                continue;
+            }
+            // Without a row count the zones can't be turned into ranges, read it all
+            let Some(num_rows) = fragment.physical_rows else {
+                scanned.push(fragment);
+                continue;
+            };
+            let num_rows = num_rows as u32;
+            let mut fragment_ranges: Vec<Range<u32>> = Vec::new();
+            for zone_start in (0..num_rows).step_by(ZONE_SIZE as usize) {
+                let row_id = (fragment.id << 32) | zone_start as u64;
+                if !candidates.selected(row_id) {
+                    continue;
+                }
+                let zone_end = (zone_start + ZONE_SIZE).min(num_rows);
+                match fragment_ranges.last_mut() {
+                    Some(last) if last.end == zone_start => last.end = zone_end,
+                    _ => fragment_ranges.push(zone_start..zone_end),
+                }
+            }
+            if !fragment_ranges.is_empty() {
+                ranges.insert(fragment.id, fragment_ranges);
+                scanned.push(fragment);
+            }
+        }
+
+        let scan = LanceScanExec::new(
+            self.dataset.clone(),
+            Arc::new(scanned),
+            projection,
+            self.get_batch_size(),
+            self.batch_readahead,
+            self.fragment_readahead,
+            true,
+            self.with_row_address,
+            false,
+            self.ordered,
+        );
+        Ok(Arc::new(scan.with_ranges(ranges)))
     }
 
     fn scan_fragments(
@@ -1330,8 +1689,10 @@ impl Scanner {
         projection: Arc<Schema>,
         fragments: Arc<Vec<Fragment>>,
         ordered: bool,
+        num_partitions: usize,
+        fragment_bytes: Option<&HashMap<u64, u64>>,
     ) -> Arc<dyn ExecutionPlan> {
-        Arc::new(LanceScanExec::new(
+        let scan = LanceScanExec::new(
             self.dataset.clone(),
             fragments,
             projection,
@@ -1342,7 +1703,23 @@ impl Scanner {
             with_row_address,
             with_make_deletions_null,
             ordered,
-        ))
+        );
+        if num_partitions > 1 {
+            Arc::new(scan.with_partitions(num_partitions, fragment_bytes))
+        } else {
+            Arc::new(scan)
+        }
+    }
+
+    /// Merge the partitions of the input plan, if there are more than one
+    ///
+    /// Sort and limit nodes only read the first partition of their input.
+    fn coalesce_partitions(plan: Arc<dyn ExecutionPlan>) -> Arc<dyn ExecutionPlan> {
+        if plan.properties().partitioning.partition_count() > 1 {
+            Arc::new(CoalescePartitionsExec::new(plan))
+        } else {
+            plan
+        }
     }
 
     fn pushdown_scan(
@@ -1379,19 +1756,10 @@ impl Scanner {
         Ok(Arc::new(KNNFlatExec::try_new(input, q.clone())?))
     }
 
-    /// Create an Execution plan to do indexed ANN search
-    async fn ann(
-        &self,
-        q: &Query,
-        index: &[Index],
-        filter_plan: &FilterPlan,
-    ) -> Result<Arc<dyn ExecutionPlan>> {
-        let prefilter_source = match (
-            &filter_plan.index_query,
-            &filter_plan.refine_expr,
-            self.prefilter,
-        ) {
-            (Some(index_query), Some(refine_expr), _) => {
+    /// Plan the row ids that pass `filter_plan` so an index search can skip the others
+    async fn prefilter_source(&self, filter_plan: &FilterPlan) -> Result<PreFilterSource> {
+        Ok(match (&filter_plan.index_query, &filter_plan.refine_expr) {
+            (Some(index_query), Some(refine_expr)) => {
                 // The filter is only partially satisfied by the index.  We need
                 // to do an indexed scan and then refine the results to determine
                 // the row ids.
@@ -1406,7 +1774,7 @@ impl Scanner {
                     Arc::new(FilterExec::try_new(physical_refine_expr, filter_input)?);
                 PreFilterSource::FilteredRowIds(filtered_row_ids)
             } // Should be index_scan -> filter
-            (Some(index_query), None, true) => {
+            (Some(index_query), None) => {
                 // The filter is completely satisfied by the index.  We
                 // only need to search the index to determine the valid row
                 // ids.
@@ -1416,12 +1784,12 @@ impl Scanner {
                 ));
                 PreFilterSource::ScalarIndexQuery(index_query)
             }
-            (None, Some(refine_expr), true) => {
+            (None, Some(refine_expr)) => {
                 // No indices match the filter.  We need to do a full scan
                 // of the filter columns to determine the valid row ids.
                 let columns_in_filter = Planner::column_names_in_expr(refine_expr);
                 let filter_schema = Arc::new(self.dataset.schema().project(&columns_in_filter)?);
-                let filter_input = self.scan(true, false, true, filter_schema);
+                let filter_input = self.scan(true, false, true, filter_schema, 1).await?;
                 let planner = Planner::new(filter_input.schema());
                 let physical_refine_expr = planner.create_physical_expr(refine_expr)?;
                 let filtered_row_ids =
@@ -1429,8 +1797,22 @@ impl Scanner {
                 PreFilterSource::FilteredRowIds(filtered_row_ids)
             }
             // No prefilter
-            (None, None, true) => PreFilterSource::None,
-            (_, _, false) => PreFilterSource::None,
+            (None, None) => PreFilterSource::None,
+        })
+    }
+
+    /// Create an Execution plan to do indexed ANN search
+    async fn ann(
+        &self,
+        q: &Query,
+        index: &[Index],
+        filter_plan: &FilterPlan,
+    ) -> Result<Arc<dyn ExecutionPlan>> {
+        // A full text search always restricts the vector search
+        let prefilter_source = if self.prefilter || self.full_text_query.is_some() {
+            self.prefilter_source(filter_plan).await?
+        } else {
+            PreFilterSource::None
         };
 
         let inner_fanout_search = new_knn_exec(self.dataset.clone(), index, q, prefilter_source)?;
@@ -1680,6 +2062,7 @@ mod test {
     };
     use arrow_ord::sort::sort_to_indices;
     use arrow_select::take;
+    use datafusion::execution::TaskContext;
     use datafusion::logical_expr::{col, lit};
     use half::f16;
     use lance_datagen::{array, gen, BatchCount, Dimension, RowCount};
@@ -1695,7 +2078,7 @@ mod test {
     use crate::dataset::scanner::test_dataset::TestVectorDataset;
     use crate::dataset::WriteMode;
     use crate::dataset::WriteParams;
-    use crate::index::scalar::ScalarIndexParams;
+    use crate::index::scalar::{ScalarIndexParams, ScalarIndexType};
     use crate::index::vector::VectorIndexParams;
     use crate::utils::test::IoTrackingStore;
 
@@ -2259,6 +2642,119 @@ mod test {
         }
     }
 
+    #[tokio::test]
+    async fn test_scan_partitions() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let data = gen().col("i", array::step::<Int32Type>());
+        Dataset::write(
+            data.into_reader_rows(RowCount::from(1000), BatchCount::from(3)),
+            test_uri,
+            Some(WriteParams {
+                max_rows_per_file: 1000,
+                ..Default::default()
+            }),
+        )
+        .await
+        .unwrap();
+        let dataset = Arc::new(Dataset::open(test_uri).await.unwrap());
+        assert_eq!(dataset.get_fragments().len(), 3);
+
+        let mut scan = dataset.scan();
+        scan.batch_size(100).target_partitions(4);
+
+        // An ordered scan is never split
+        let plan = scan.create_partitioned_plan().await.unwrap();
+        assert_eq!(plan.properties().partitioning.partition_count(), 1);
+
+        // Each partition reads a quarter of the rows, splitting fragments as needed
+        scan.scan_in_order(false);
+        let plan = scan.create_partitioned_plan().await.unwrap();
+        assert_eq!(plan.properties().partitioning.partition_count(), 4);
+        let mut values = Vec::new();
+        for partition in 0..4 {
+            let batches = plan
+                .execute(partition, Arc::new(TaskContext::default()))
+                .unwrap()
+                .try_collect::<Vec<_>>()
+                .await
+                .unwrap();
+            let num_rows = batches.iter().map(|batch| batch.num_rows()).sum::<usize>();
+            assert_eq!(num_rows, 750);
+            for batch in batches {
+                values.extend(
+                    batch["i"]
+                        .as_primitive::<Int32Type>()
+                        .values()
+                        .iter()
+                        .copied(),
+                );
+            }
+        }
+        values.sort();
+        assert_eq!(values, (0..3000).collect::<Vec<_>>());
+
+        // The merged plan returns all of the rows
+        let batch = scan.try_into_batch().await.unwrap();
+        assert_eq!(batch.num_rows(), 3000);
+    }
+
+    #[tokio::test]
+    async fn test_scan_partitions_balance_bytes() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        // The first fragment has short strings and the second one long strings
+        let schema = Arc::new(ArrowSchema::new(vec![ArrowField::new(
+            "s",
+            DataType::Utf8,
+            false,
+        )]));
+        let values = StringArray::from_iter_values((0..2000).map(|i| {
+            if i < 1000 {
+                "a".to_string()
+            } else {
+                "b".repeat(100)
+            }
+        }));
+        let batch = RecordBatch::try_new(schema.clone(), vec![Arc::new(values)]).unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        Dataset::write(
+            reader,
+            test_uri,
+            Some(WriteParams {
+                max_rows_per_file: 1000,
+                ..Default::default()
+            }),
+        )
+        .await
+        .unwrap();
+        let dataset = Arc::new(Dataset::open(test_uri).await.unwrap());
+        assert_eq!(dataset.get_fragments().len(), 2);
+
+        let mut scan = dataset.scan();
+        scan.batch_size(100)
+            .target_partitions(2)
+            .scan_in_order(false);
+        let plan = scan.create_partitioned_plan().await.unwrap();
+        assert_eq!(plan.properties().partitioning.partition_count(), 2);
+        let mut num_rows = Vec::new();
+        for partition in 0..2 {
+            let batches = plan
+                .execute(partition, Arc::new(TaskContext::default()))
+                .unwrap()
+                .try_collect::<Vec<_>>()
+                .await
+                .unwrap();
+            num_rows.push(batches.iter().map(|batch| batch.num_rows()).sum::<usize>());
+        }
+        // The first partition reads all of the short strings and some of the long
+        // ones, so it gets more rows than it would by row count alone
+        assert_eq!(num_rows.iter().sum::<usize>(), 2000);
+        assert!(num_rows[0] > 1000, "{:?}", num_rows);
+    }
+
     #[rstest]
     #[tokio::test]
     async fn test_scan_order(#[values(false, true)] use_legacy_format: bool) {
@@ -4073,4 +4569,193 @@ mod test {
 
         Ok(())
     }
+
+    #[tokio::test]
+    async fn test_full_text_search() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let schema = Arc::new(ArrowSchema::new(vec![
+            ArrowField::new("id", DataType::Int32, false),
+            ArrowField::new("text", DataType::Utf8, true),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(Int32Array::from_iter_values(0..5)),
+                Arc::new(StringArray::from(vec![
+                    Some("The quick brown fox"),
+                    Some("the lazy dog"),
+                    Some("Quick, quick, QUICK fox jumps"),
+                    Some("a dog and a fox"),
+                    None,
+                ])),
+            ],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema.clone());
+        let mut dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+        dataset
+            .create_index(
+                &["text"],
+                IndexType::Scalar,
+                None,
+                &ScalarIndexParams::new(ScalarIndexType::Inverted),
+                false,
+            )
+            .await
+            .unwrap();
+
+        let search = |dataset: &Dataset, filter: Option<&str>| {
+            let mut scan = dataset.scan();
+            scan.project(&["id"])
+                .unwrap()
+                .full_text_search("text", "quick fox", 2)
+                .unwrap();
+            if let Some(filter) = filter {
+                scan.filter(filter).unwrap();
+            }
+            async move { scan.try_into_batch().await.unwrap() }
+        };
+
+        let results = search(&dataset, None).await;
+        assert_eq!(results.num_columns(), 2);
+        assert_eq!(results.schema().field(1).name(), SCORE_COL);
+        let ids = results.column(0).as_primitive::<Int32Type>().values();
+        assert_eq!(ids, &[2, 0]);
+        let scores = results.column(1).as_primitive::<Float32Type>().values();
+        assert!(scores[0] >= scores[1]);
+
+        // Filters are applied while searching so k rows are still returned
+        let results = search(&dataset, Some("id > 0")).await;
+        assert_eq!(
+            results.column(0).as_primitive::<Int32Type>().values(),
+            &[2, 3]
+        );
+
+        // Deleted rows are skipped, not just removed from the results
+        dataset.delete("id = 2").await.unwrap();
+        let results = search(&dataset, None).await;
+        assert_eq!(
+            results.column(0).as_primitive::<Int32Type>().values(),
+            &[0, 3]
+        );
+
+        // Regular filters on the column do not try to use the inverted index
+        let mut scan = dataset.scan();
+        scan.filter("text = 'the lazy dog'").unwrap();
+        assert_eq!(scan.count_rows().await.unwrap(), 1);
+
+        // Appended rows are searched without the index and scored with its statistics, so
+        // a copy of the deleted best match gets the same score it had
+        let best_score = scores[0];
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(Int32Array::from_iter_values(5..7)),
+                Arc::new(StringArray::from(vec![
+                    Some("Quick, quick, QUICK fox jumps"),
+                    Some("no match here"),
+                ])),
+            ],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        dataset.append(reader, None).await.unwrap();
+        let results = search(&dataset, None).await;
+        assert_eq!(
+            results.column(0).as_primitive::<Int32Type>().values(),
+            &[5, 0]
+        );
+        let score = results.column(1).as_primitive::<Float32Type>().value(0);
+        assert!(
+            (score - best_score).abs() < 1e-4,
+            "{} {}",
+            score,
+            best_score
+        );
+        let results = search(&dataset, Some("id < 5")).await;
+        assert_eq!(
+            results.column(0).as_primitive::<Int32Type>().values(),
+            &[0, 3]
+        );
+    }
+
+    #[tokio::test]
+    async fn test_hybrid_search_ignores_index_coverage() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let schema = Arc::new(ArrowSchema::new(vec![
+            ArrowField::new("id", DataType::Int32, false),
+            ArrowField::new("text", DataType::Utf8, false),
+            ArrowField::new(
+                "vec",
+                DataType::FixedSizeList(
+                    Arc::new(ArrowField::new("item", DataType::Float32, true)),
+                    2,
+                ),
+                false,
+            ),
+        ]));
+        let make_batch = |ids: Range<i32>| {
+            let texts = ids
+                .clone()
+                .map(|id| {
+                    if id % 3 == 0 {
+                        format!("red fox {}", id)
+                    } else {
+                        format!("blue dog {}", id)
+                    }
+                })
+                .collect::<Vec<_>>();
+            let vectors =
+                Float32Array::from_iter_values(ids.clone().flat_map(|id| [id as f32, 0.0]));
+            RecordBatch::try_new(
+                schema.clone(),
+                vec![
+                    Arc::new(Int32Array::from_iter_values(ids)),
+                    Arc::new(StringArray::from(texts)),
+                    Arc::new(FixedSizeListArray::try_new_from_values(vectors, 2).unwrap()),
+                ],
+            )
+            .unwrap()
+        };
+        let reader = RecordBatchIterator::new(vec![Ok(make_batch(0..30))], schema.clone());
+        let mut dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+        dataset
+            .create_index(
+                &["text"],
+                IndexType::Scalar,
+                None,
+                &ScalarIndexParams::new(ScalarIndexType::Inverted),
+                false,
+            )
+            .await
+            .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(make_batch(30..60))], schema.clone());
+        dataset.append(reader, None).await.unwrap();
+
+        let search = |dataset: &Dataset| {
+            let mut scan = dataset.scan();
+            scan.project(&["id"])
+                .unwrap()
+                .nearest("vec", &Float32Array::from(vec![0.0, 0.0]), 100)
+                .unwrap()
+                .full_text_search("text", "fox", 1)
+                .unwrap();
+            async move {
+                let results = scan.try_into_batch().await.unwrap();
+                let mut ids = results["id"].as_primitive::<Int32Type>().values().to_vec();
+                ids.sort();
+                ids
+            }
+        };
+
+        // Every row with the token is a candidate, whether or not the index covers it
+        let expected = (0..60).step_by(3).collect::<Vec<_>>();
+        assert_eq!(search(&dataset).await, expected);
+        dataset.optimize_indices(&Default::default()).await.unwrap();
+        assert_eq!(search(&dataset).await, expected);
+    }
 }
@@ -0,0 +1,449 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! Shuffled reads for training loops
+//!
+//! Taking random rows one at a time gives very poor locality.  Instead the dataset is
+//! split into blocks of consecutive rows which are read with sequential I/O.  The order
+//! of the fragments is shuffled, and rows are shuffled again within a window of buffered
+//! blocks.  The result is close to a full random shuffle for a fraction of the I/O cost.
+
+use std::collections::VecDeque;
+use std::ops::Range;
+use std::sync::Arc;
+
+use arrow_array::{RecordBatch, UInt32Array};
+use arrow_schema::{Schema as ArrowSchema, SchemaRef};
+use arrow_select::{concat::concat_batches, take::take_record_batch};
+use datafusion::error::DataFusionError;
+use datafusion::physical_plan::stream::RecordBatchStreamAdapter;
+use futures::stream::{self, BoxStream};
+use futures::{StreamExt, TryStreamExt};
+use lance_core::datatypes::Schema;
+use rand::rngs::StdRng;
+use rand::seq::SliceRandom;
+use rand::SeedableRng;
+use snafu::{location, Location};
+
+use super::fragment::FileFragment;
+use super::scanner::DatasetRecordBatchStream;
+use super::Dataset;
+use crate::{Error, Result};
+
+/// Parameters for [`Dataset::shuffled_scan`]
+#[derive(Debug, Clone)]
+pub struct ShuffleParams {
+    /// Seed for every random choice.  The same seed and parameters always give
+    /// the same order for a given version of the dataset.
+    pub seed: u64,
+    /// Number of rows in each output batch
+    pub batch_size: usize,
+    /// Number of consecutive rows that are read together
+    ///
+    /// Larger blocks give longer sequential reads but a less random order.
+    pub block_size: usize,
+    /// Number of rows that are shuffled together
+    ///
+    /// Larger buffers give a more random order but use more memory.
+    pub shuffle_buffer_size: usize,
+    /// Number of blocks to read ahead of the consumer
+    pub prefetch: usize,
+    /// The rank of this reader, between 0 and `world_size - 1`
+    pub rank: usize,
+    /// The number of readers that share the dataset
+    ///
+    /// Each reader gets a disjoint set of blocks.  All readers must use the same seed.
+    /// Blocks are dealt so that every reader gets about the same number of rows, and the
+    /// readers are then made to return exactly the same number of rows (and so batches),
+    /// see `drop_last`.  Distributed training hangs if one rank runs out of batches
+    /// before the others.
+    pub world_size: usize,
+    /// How readers with fewer rows than the others are evened out
+    ///
+    /// If true, every reader stops at the row count of the smallest shard and the extra
+    /// rows of the other readers are dropped.  If false, every reader returns as many rows
+    /// as the largest shard and the smaller shards are padded by repeating rows from the
+    /// start of the shuffled order.  Has no effect when `world_size` is 1.
+    pub drop_last: bool,
+}
+
+impl Default for ShuffleParams {
+    fn default() -> Self {
+        Self {
+            seed: 0,
+            batch_size: 1024,
+            block_size: 8 * 1024,
+            shuffle_buffer_size: 64 * 1024,
+            prefetch: num_cpus::get(),
+            rank: 0,
+            world_size: 1,
+            drop_last: false,
+        }
+    }
+}
+
+impl ShuffleParams {
+    fn validate(&self) -> Result<()> {
+        if self.batch_size == 0 || self.block_size == 0 {
+            return Err(Error::invalid_input(
+                "batch_size and block_size must be greater than 0",
+                location!(),
+            ));
+        }
+        if self.rank >= self.world_size {
+            return Err(Error::invalid_input(
+                format!(
+                    "rank must be less than world_size, got rank={} and world_size={}",
+                    self.rank, self.world_size
+                ),
+                location!(),
+            ));
+        }
+        Ok(())
+    }
+}
+
+#[derive(Clone)]
+struct Block {
+    fragment: FileFragment,
+    range: Range<u32>,
+    /// The number of rows in the range that are not deleted
+    num_rows: usize,
+}
+
+/// Split the fragments into blocks in a seeded random fragment order and keep the
+/// blocks that belong to `rank`
+///
+/// Returns the blocks and the number of rows that `rank` should return.  The last block
+/// may contain more rows than that.
+async fn plan_blocks(
+    dataset: &Dataset,
+    params: &ShuffleParams,
+    rng: &mut StdRng,
+) -> Result<(Vec<Block>, usize)> {
+    let mut fragments = stream::iter(dataset.get_fragments())
+        .map(|fragment| async move {
+            let num_rows = fragment.physical_rows().await?;
+            let deletion_vector = fragment.get_deletion_vector().await?;
+            Result::Ok((fragment, num_rows, deletion_vector))
+        })
+        .buffered(num_cpus::get() * 4)
+        .try_collect::<Vec<_>>()
+        .await?;
+    fragments.shuffle(rng);
+
+    let blocks = fragments
+        .into_iter()
+        .flat_map(|(fragment, num_rows, deletion_vector)| {
+            (0..num_rows).step_by(params.block_size).map(move |start| {
+                let end = (start + params.block_size).min(num_rows);
+                let range = start as u32..end as u32;
+                let num_deleted = deletion_vector.as_ref().map_or(0, |deletion_vector| {
+                    deletion_vector.count_range(range.clone())
+                });
+                Block {
+                    fragment: fragment.clone(),
+                    range,
+                    num_rows: end - start - num_deleted,
+                }
+            })
+        })
+        .filter(|block| block.num_rows > 0)
+        .collect::<Vec<_>>();
+
+    // Deal each block to the rank with the fewest rows so far.  Every rank computes the
+    // same assignment since they all use the same seed.
+    let mut rank_rows = vec![0; params.world_size];
+    let mut own_blocks = Vec::new();
+    for block in &blocks {
+        let rank = (0..params.world_size)
+            .min_by_key(|rank| rank_rows[*rank])
+            .unwrap();
+        rank_rows[rank] += block.num_rows;
+        if rank == params.rank {
+            own_blocks.push(block.clone());
+        }
+    }
+
+    // Every rank must return the same number of rows
+    let mut num_rows = rank_rows[params.rank];
+    let target_rows = if params.drop_last {
+        rank_rows.iter().copied().min().unwrap()
+    } else {
+        rank_rows.iter().copied().max().unwrap()
+    };
+    if num_rows < target_rows {
+        // Pad with blocks from the start of the plan
+        for block in blocks.iter().cycle() {
+            if num_rows >= target_rows {
+                break;
+            }
+            own_blocks.push(block.clone());
+            num_rows += block.num_rows;
+        }
+    }
+    while own_blocks
+        .last()
+        .is_some_and(|block| num_rows - block.num_rows >= target_rows)
+    {
+        num_rows -= own_blocks.pop().unwrap().num_rows;
+    }
+    Ok((own_blocks, target_rows))
+}
+
+async fn read_block(
+    fragment: FileFragment,
+    range: Range<u32>,
+    projection: Arc<Schema>,
+    schema: SchemaRef,
+) -> Result<RecordBatch> {
+    let reader = fragment.open(projection.as_ref(), false, false).await?;
+    let batch_size = range.end - range.start;
+    let batches = reader
+        .read_range(range, batch_size)?
+        .buffered(1)
+        .try_collect::<Vec<_>>()
+        .await?;
+    Ok(concat_batches(&schema, &batches)?)
+}
+
+struct ShuffleBuffer {
+    blocks: BoxStream<'static, Result<RecordBatch>>,
+    schema: SchemaRef,
+    rng: StdRng,
+    batch_size: usize,
+    buffer_size: usize,
+    /// The number of rows still to be taken from the blocks
+    remaining_rows: usize,
+    buffer: Vec<RecordBatch>,
+    buffered_rows: usize,
+    ready: VecDeque<RecordBatch>,
+    exhausted: bool,
+}
+
+impl ShuffleBuffer {
+    async fn next_batch(&mut self) -> Result<Option<RecordBatch>> {
+        loop {
+            if let Some(batch) = self.ready.pop_front() {
+                return Ok(Some(batch));
+            }
+            if self.exhausted && self.buffered_rows == 0 {
+                return Ok(None);
+            }
+            if !self.exhausted && self.buffered_rows < self.buffer_size {
+                match self.blocks.try_next().await? {
+                    Some(block) if self.remaining_rows > 0 => {
+                        let block = block.slice(0, block.num_rows().min(self.remaining_rows));
+                        self.remaining_rows -= block.num_rows();
+                        self.buffered_rows += block.num_rows();
+                        self.buffer.push(block);
+                    }
+                    _ => self.exhausted = true,
+                }
+                continue;
+            }
+            self.shuffle()?;
+        }
+    }
+
+    /// Shuffle the buffered rows and split them into output batches
+    ///
+    /// Until the input is exhausted, rows that don't fill a whole batch stay in the
+    /// buffer and are shuffled again with the next window.
+    fn shuffle(&mut self) -> Result<()> {
+        let batch = concat_batches(&self.schema, &self.buffer)?;
+        self.buffer.clear();
+
+        let num_rows = batch.num_rows();
+        let mut indices = (0..num_rows as u32).collect::<Vec<_>>();
+        indices.shuffle(&mut self.rng);
+        let batch = take_record_batch(&batch, &UInt32Array::from(indices))?;
+
+        let mut offset = 0;
+        while num_rows - offset >= self.batch_size || (self.exhausted && offset < num_rows) {
+            let length = self.batch_size.min(num_rows - offset);
+            self.ready.push_back(batch.slice(offset, length));
+            offset += length;
+        }
+        if offset < num_rows {
+            self.buffer.push(batch.slice(offset, num_rows - offset));
+        }
+        self.buffered_rows = num_rows - offset;
+        Ok(())
+    }
+}
+
+pub(super) async fn shuffled_scan(
+    dataset: &Dataset,
+    projection: Arc<Schema>,
+    params: ShuffleParams,
+) -> Result<DatasetRecordBatchStream> {
+    params.validate()?;
+
+    let mut rng = StdRng::seed_from_u64(params.seed);
+    let (blocks, num_rows) = plan_blocks(dataset, &params, &mut rng).await?;
+
+    let schema: SchemaRef = Arc::new(ArrowSchema::from(projection.as_ref()));
+    let block_schema = schema.clone();
+    let blocks = stream::iter(blocks)
+        .map(move |block| {
+            let fut = read_block(
+                block.fragment,
+                block.range,
+                projection.clone(),
+                block_schema.clone(),
+            );
+            async move { tokio::task::spawn(fut).await? }
+        })
+        .buffered(params.prefetch.max(1))
+        .boxed();
+
+    let shuffle_buffer = ShuffleBuffer {
+        blocks,
+        schema: schema.clone(),
+        rng,
+        batch_size: params.batch_size,
+        // The buffer must hold at least one batch, otherwise no batch can ever be emitted
+        buffer_size: params.shuffle_buffer_size.max(params.batch_size),
+        remaining_rows: num_rows,
+        buffer: Vec::new(),
+        buffered_rows: 0,
+        ready: VecDeque::new(),
+        exhausted: false,
+    };
+    let batches = stream::try_unfold(shuffle_buffer, |mut shuffle_buffer| async move {
+        Ok(shuffle_buffer
+            .next_batch()
+            .await?
+            .map(|batch| (batch, shuffle_buffer)))
+    })
+    .map_err(|err: Error| DataFusionError::External(Box::new(err)));
+
+    Ok(DatasetRecordBatchStream::new(Box::pin(
+        RecordBatchStreamAdapter::new(schema, batches),
+    )))
+}
+
+#[cfg(test)]
+mod tests {
+    use std::collections::HashSet;
+
+    use arrow_array::{cast::AsArray, types::Int32Type, Int32Array, RecordBatchIterator};
+    use arrow_schema::{DataType, Field};
+
+    use super::*;
+    use crate::dataset::WriteParams;
+
+    async fn ids(dataset: &Dataset, params: ShuffleParams) -> Vec<i32> {
+        let projection = Arc::new(dataset.schema().clone());
+        let batches = dataset
+            .shuffled_scan(projection, params)
+            .await
+            .unwrap()
+            .try_collect::<Vec<_>>()
+            .await
+            .unwrap();
+        batches
+            .iter()
+            .flat_map(|batch| {
+                batch
+                    .column(0)
+                    .as_primitive::<Int32Type>()
+                    .values()
+                    .to_vec()
+            })
+            .collect()
+    }
+
+    #[tokio::test]
+    async fn test_shuffled_scan() {
+        let test_dir = tempfile::tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let schema = Arc::new(ArrowSchema::new(vec![Field::new(
+            "i",
+            DataType::Int32,
+            false,
+        )]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(Int32Array::from_iter_values(0..1000))],
+        )
+        .unwrap();
+        let write_params = WriteParams {
+            max_rows_per_file: 100,
+            ..Default::default()
+        };
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema);
+        let mut dataset = Dataset::write(reader, test_uri, Some(write_params))
+            .await
+            .unwrap();
+        dataset.delete("i < 10").await.unwrap();
+
+        let params = ShuffleParams {
+            seed: 42,
+            batch_size: 64,
+            block_size: 30,
+            shuffle_buffer_size: 200,
+            ..Default::default()
+        };
+        let shuffled = ids(&dataset, params.clone()).await;
+        assert_eq!(shuffled.len(), 990);
+        assert_ne!(shuffled, (10..1000).collect::<Vec<_>>());
+        let mut sorted = shuffled.clone();
+        sorted.sort();
+        assert_eq!(sorted, (10..1000).collect::<Vec<_>>());
+
+        // The same seed gives the same order, another seed a different one
+        assert_eq!(ids(&dataset, params.clone()).await, shuffled);
+        let other_seed = ShuffleParams {
+            seed: 7,
+            ..params.clone()
+        };
+        assert_ne!(ids(&dataset, other_seed).await, shuffled);
+
+        // Ranks read disjoint rows and, with drop_last, the same number of rows
+        let mut seen = HashSet::new();
+        let mut shard_lens = HashSet::new();
+        for rank in 0..4 {
+            let sharded = ShuffleParams {
+                rank,
+                world_size: 4,
+                drop_last: true,
+                ..params.clone()
+            };
+            let shard = ids(&dataset, sharded).await;
+            shard_lens.insert(shard.len());
+            for id in shard {
+                assert!(seen.insert(id));
+            }
+        }
+        assert_eq!(shard_lens.len(), 1);
+        assert!(seen.len() <= 990 && seen.len() > 990 - 4 * 30);
+
+        // Without drop_last the smaller shards are padded and together the ranks cover
+        // every row
+        let mut seen = HashSet::new();
+        let mut shard_lens = HashSet::new();
+        for rank in 0..4 {
+            let sharded = ShuffleParams {
+                rank,
+                world_size: 4,
+                ..params.clone()
+            };
+            let shard = ids(&dataset, sharded).await;
+            shard_lens.insert(shard.len());
+            seen.extend(shard);
+        }
+        assert_eq!(shard_lens.len(), 1);
+        assert!(shard_lens.into_iter().next().unwrap() * 4 >= 990);
+        assert_eq!(seen.len(), 990);
+
+        let invalid = ShuffleParams {
+            rank: 3,
+            world_size: 3,
+            ..params
+        };
+        let projection = Arc::new(dataset.schema().clone());
+        assert!(dataset.shuffled_scan(projection, invalid).await.is_err());
+    }
+}
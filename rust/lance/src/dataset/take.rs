@@ -1,7 +1,12 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
-use std::{collections::BTreeMap, ops::Range, pin::Pin, sync::Arc};
+use std::{
+    collections::BTreeMap,
+    ops::Range,
+    pin::Pin,
+    sync::{Arc, OnceLock},
+};
 
 use crate::{Error, Result};
 use arrow::{array::as_struct_array, compute::concat_batches, datatypes::UInt64Type};
@@ -15,7 +20,57 @@ use futures::{Future, Stream, StreamExt, TryStreamExt};
 use lance_core::{datatypes::Schema, ROW_ID};
 use snafu::{location, Location};
 
-use super::{fragment::FileFragment, scanner::DatasetRecordBatchStream, Dataset};
+use super::{
+    fragment::FileFragment, rowids::get_row_id_index, scanner::DatasetRecordBatchStream, Dataset,
+};
+
+/// The maximum number of fragment reads a single take will run at once
+fn take_parallelism() -> usize {
+    static TAKE_PARALLELISM: OnceLock<usize> = OnceLock::new();
+    *TAKE_PARALLELISM.get_or_init(|| {
+        std::env::var("LANCE_TAKE_PARALLELISM")
+            .ok()
+            .and_then(|s| s.parse::<usize>().ok())
+            .unwrap_or(num_cpus::get() * 4)
+    })
+}
+
+/// The offset of the first row of each fragment, followed by the total number of rows
+///
+/// This is cached per dataset version.  Row counts come from the manifest when it has them so
+/// normally no IO is needed.
+async fn fragment_offsets(dataset: &Dataset) -> Result<Arc<Vec<u64>>> {
+    // The path here isn't real, it's just used to prevent collisions in the cache.
+    let path = dataset
+        .base
+        .child("_fragment_offsets")
+        .child(dataset.manifest.version.to_string());
+    dataset
+        .session
+        .file_metadata_cache
+        .get_or_insert(&path, |_| async {
+            // Row counts in the manifest can only be trusted if it records a writer version
+            let trust_manifest = dataset.manifest.writer_version.is_some();
+            let row_counts = futures::stream::iter(dataset.get_fragments())
+                .map(|fragment| async move {
+                    match fragment.metadata().num_rows() {
+                        Some(num_rows) if trust_manifest => Ok(num_rows),
+                        _ => fragment.count_rows().await,
+                    }
+                })
+                .buffered(take_parallelism())
+                .try_collect::<Vec<_>>()
+                .await?;
+
+            let mut offsets = Vec::with_capacity(row_counts.len() + 1);
+            offsets.push(0);
+            for num_rows in row_counts {
+                offsets.push(offsets.last().unwrap() + num_rows as u64);
+            }
+            Ok(offsets)
+        })
+        .await
+}
 
 pub async fn take(
     dataset: &Dataset,
@@ -31,6 +86,14 @@ pub async fn take(
     sorted_indices.sort_by_key(|&i| row_indices[i]);
 
     let fragments = dataset.get_fragments();
+    if fragments.is_empty() {
+        return Err(Error::InvalidInput {
+            source: "Called take on an empty dataset.".to_string().into(),
+            location: location!(),
+        });
+    }
+    let offsets = fragment_offsets(dataset).await?;
+    let num_rows = *offsets.last().unwrap();
 
     // We will split into sub-requests for each fragment.
     let mut sub_requests: Vec<(&FileFragment, Range<usize>)> = Vec::new();
@@ -39,14 +102,10 @@ pub async fn take(
     let mut remap_index: Vec<(usize, usize)> = vec![(0, 0); row_indices.len()];
     let mut local_ids_buffer: Vec<u32> = Vec::with_capacity(row_indices.len());
 
-    let mut fragments_iter = fragments.iter();
-    let mut current_fragment = fragments_iter.next().ok_or_else(|| Error::InvalidInput {
-        source: "Called take on an empty dataset.".to_string().into(),
-        location: location!(),
-    })?;
-    let mut current_fragment_len = current_fragment.count_rows().await?;
+    let mut current_fragment = &fragments[0];
     let mut curr_fragment_offset: u64 = 0;
-    let mut current_fragment_end = current_fragment_len as u64;
+    // Forces a lookup of the fragment for the first row index
+    let mut current_fragment_end: u64 = 0;
     let mut start = 0;
     let mut end = 0;
     // We want to keep track of the previous row_index to detect duplicates
@@ -69,28 +128,31 @@ pub async fn take(
             previous_row_index = row_index;
         }
 
-        // If the row index is beyond the current fragment, iterate
-        // until we find the fragment that contains it.
-        while row_index >= current_fragment_end {
+        // If the row index is beyond the current fragment, jump straight to the
+        // fragment that contains it.
+        if row_index >= current_fragment_end {
+            if row_index >= num_rows {
+                return Err(Error::InvalidInput {
+                    source: format!(
+                        "Row index {} is beyond the range of the dataset.",
+                        row_index
+                    )
+                    .into(),
+                    location: location!(),
+                });
+            }
+
             // If we have a non-empty sub-request, add it to the list
             if end - start > 0 {
-                // If we have a non-empty sub-request, add it to the list
                 sub_requests.push((current_fragment, start..end));
             }
-
             start = end;
 
-            current_fragment = fragments_iter.next().ok_or_else(|| Error::InvalidInput {
-                source: format!(
-                    "Row index {} is beyond the range of the dataset.",
-                    row_index
-                )
-                .into(),
-                location: location!(),
-            })?;
-            curr_fragment_offset += current_fragment_len as u64;
-            current_fragment_len = current_fragment.count_rows().await?;
-            current_fragment_end = curr_fragment_offset + current_fragment_len as u64;
+            // The last fragment starting at or before the row, which skips empty fragments
+            let fragment_idx = offsets.partition_point(|offset| *offset <= row_index) - 1;
+            current_fragment = &fragments[fragment_idx];
+            curr_fragment_offset = offsets[fragment_idx];
+            current_fragment_end = offsets[fragment_idx + 1];
         }
 
         // Note that we cast to u32 *after* subtracting the offset,
@@ -117,7 +179,7 @@ pub async fn take(
         })
         .collect::<Vec<_>>();
     let batches = futures::stream::iter(take_tasks)
-        .buffered(num_cpus::get() * 4)
+        .buffered(take_parallelism())
         .try_collect::<Vec<RecordBatch>>()
         .await?;
 
@@ -137,6 +199,32 @@ pub async fn take_rows(
         return Ok(RecordBatch::new_empty(Arc::new(projection.into())));
     }
 
+    if dataset.manifest.uses_move_stable_row_ids() {
+        // Translate the stable row ids into addresses with one batch lookup.  Row ids that
+        // no longer exist are skipped, the same as rows that have been deleted.
+        let index = get_row_id_index(dataset).await?;
+        let (row_ids, row_addrs): (Vec<u64>, Vec<u64>) = row_ids
+            .iter()
+            .zip(index.get_many(row_ids))
+            .filter_map(|(row_id, addr)| addr.map(|addr| (*row_id, u64::from(addr))))
+            .unzip();
+        if row_addrs.is_empty() {
+            return Ok(RecordBatch::new_empty(Arc::new(projection.into())));
+        }
+        take_row_addrs(dataset, &row_addrs, &row_ids, projection).await
+    } else {
+        take_row_addrs(dataset, row_ids, row_ids, projection).await
+    }
+}
+
+/// Take rows by address, `requested_ids` are the row ids the caller asked for, in the same
+/// order.  They are the same as the addresses unless the dataset uses stable row ids.
+async fn take_row_addrs(
+    dataset: &Dataset,
+    row_ids: &[u64],
+    requested_ids: &[u64],
+    projection: &Schema,
+) -> Result<RecordBatch> {
     let projection = Arc::new(projection.clone());
     let row_id_meta = check_row_ids(row_ids);
 
@@ -215,7 +303,7 @@ pub async fn take_rows(
             batches.push(batch_fut);
         }
         let batches: Vec<RecordBatch> = futures::stream::iter(batches)
-            .buffered(4 * num_cpus::get())
+            .buffered(take_parallelism())
             .try_collect()
             .await?;
         Ok(concat_batches(&batches[0].schema(), &batches)?)
@@ -252,7 +340,7 @@ pub async fn take_rows(
 
         let mut batches = futures::stream::iter(fragment_and_indices)
             .map(|(fragment, indices)| do_take(fragment, indices, projection.clone(), true))
-            .buffered(4 * num_cpus::get())
+            .buffered(take_parallelism())
             .try_collect::<Vec<_>>()
             .await?;
 
@@ -275,7 +363,7 @@ pub async fn take_rows(
             .as_primitive::<UInt64Type>()
             .values();
 
-        let remapping_index: UInt64Array = row_ids
+        let remapping_index: UInt64Array = requested_ids
             .iter()
             .filter_map(|o| {
                 returned_row_ids
@@ -443,6 +531,43 @@ mod test {
         );
     }
 
+    #[tokio::test]
+    async fn test_take_with_deletions() {
+        let schema = Arc::new(ArrowSchema::new(vec![ArrowField::new(
+            "i",
+            DataType::Int32,
+            false,
+        )]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(Int32Array::from_iter_values(0..400))],
+        )
+        .unwrap();
+        let write_params = WriteParams {
+            max_rows_per_file: 40,
+            ..Default::default()
+        };
+        let batches = RecordBatchIterator::new(vec![Ok(batch)], schema.clone());
+        let mut dataset = Dataset::write(batches, "memory://", Some(write_params))
+            .await
+            .unwrap();
+        // Part of the second fragment and all of the fourth
+        dataset
+            .delete("(i >= 40 and i < 50) or (i >= 120 and i < 160)")
+            .await
+            .unwrap();
+
+        let projection = Schema::try_from(schema.as_ref()).unwrap();
+        let values = dataset.take(&[40, 0, 349, 110], &projection).await.unwrap();
+        assert_eq!(
+            values.column(0).as_ref(),
+            &Int32Array::from(vec![50, 0, 399, 160]) as &dyn Array
+        );
+
+        let err = dataset.take(&[0, 350], &projection).await.unwrap_err();
+        assert!(err.to_string().contains("beyond the range"), "{}", err);
+    }
+
     #[rstest]
     #[tokio::test]
     async fn test_take_rows_out_of_bound(#[values(false, true)] use_legacy_format: bool) {
@@ -232,10 +232,11 @@ impl Transaction {
     /// Returns true if the transaction cannot be committed if the other
     /// transaction is committed first.
     pub fn conflicts_with(&self, other: &Self) -> bool {
-        // TODO: this assume IsolationLevel is Serializable, but we could also
-        // support Snapshot Isolation, which is more permissive. In particular,
-        // it would allow a Delete transaction to succeed after a concurrent
-        // Append, even if the Append added rows that would be deleted.
+        // This is mostly Serializable, except that a Delete may commit after a
+        // concurrent Append (Snapshot Isolation), even if the Append added rows
+        // that the Delete would have matched.  An Update still conflicts with an
+        // Append: merge insert commits upserts as an Update, and rows inserted by
+        // the upsert could duplicate keys that were appended concurrently.
         match &self.operation {
             Operation::Append { .. } => match &other.operation {
                 // Append is compatible with anything that doesn't change the schema
@@ -288,6 +289,9 @@ impl Transaction {
                 _ => true,
             },
             Operation::Delete { .. } | Operation::Update { .. } => match &other.operation {
+                // Appended fragments are new, so they are disjoint from the fragments
+                // a delete modifies.  Rows appended concurrently are not deleted.
+                Operation::Append { .. } => matches!(self.operation, Operation::Update { .. }),
                 Operation::CreateIndex { .. } => false,
                 Operation::ReserveFragments { .. } => false,
                 Operation::Delete { .. } | Operation::Rewrite { .. } | Operation::Update { .. } => {
@@ -1102,6 +1106,7 @@ mod tests {
             fields: vec![0],
             dataset_version: 1,
             fragment_bitmap: None,
+            index_type: None,
         };
         let fragment0 = Fragment::new(0);
         let fragment1 = Fragment::new(1);
@@ -1163,7 +1168,7 @@ mod tests {
                     deleted_fragment_ids: vec![],
                     predicate: "x > 2".to_string(),
                 },
-                [true, false, false, true, true, false, false, true],
+                [false, false, false, true, true, false, false, true],
             ),
             (
                 Operation::Delete {
@@ -1172,7 +1177,7 @@ mod tests {
                     deleted_fragment_ids: vec![],
                     predicate: "x > 2".to_string(),
                 },
-                [true, false, true, true, true, true, false, true],
+                [false, false, true, true, true, true, false, true],
             ),
             (
                 Operation::Overwrite {
@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
-use std::sync::{Arc, RwLock};
+use std::sync::{Arc, Mutex, RwLock};
 
 use arrow_array::{RecordBatch, UInt64Array};
 use datafusion::error::Result as DFResult;
@@ -13,7 +13,7 @@ use crate::dataset::ROW_ID;
 use crate::Result;
 
 fn extract_row_ids(
-    row_ids: &mut RoaringTreemap,
+    capture: &mut impl FnMut(&UInt64Array) -> DFResult<()>,
     batch: DFResult<RecordBatch>,
 ) -> DFResult<RecordBatch> {
     let batch = batch?;
@@ -23,7 +23,7 @@ fn extract_row_ids(
         .column_with_name(ROW_ID)
         .expect("Received a batch without row ids");
     let row_ids_arr = batch.column(row_id_idx);
-    let row_ids_itr = row_ids_arr
+    let row_ids_arr = row_ids_arr
         .as_any()
         .downcast_ref::<UInt64Array>()
         .unwrap_or_else(|| {
@@ -31,34 +31,20 @@ fn extract_row_ids(
                 "Row ids had an unexpected type: {}",
                 row_ids_arr.data_type()
             )
-        })
-        .values()
-        .iter()
-        .copied();
-    row_ids.append(row_ids_itr).map_err(|err| {
-        datafusion::error::DataFusionError::Execution(format!(
-            "Row ids did not arrive in sorted order: {}",
-            err
-        ))
-    })?;
+        });
+    capture(row_ids_arr)?;
     let non_row_ids_cols = (0..batch.num_columns())
         .filter(|col| *col != row_id_idx)
         .collect::<Vec<_>>();
     Ok(batch.project(&non_row_ids_cols)?)
 }
 
-/// Given a stream that includes a row id column, return a stream that will
-/// capture the row ids in a `RoaringTreemap` and return a stream without the
-/// row id column.
-pub fn make_rowid_capture_stream(
-    row_ids: Arc<RwLock<RoaringTreemap>>,
+fn make_capture_stream(
     target: SendableRecordBatchStream,
+    mut capture: impl FnMut(&UInt64Array) -> DFResult<()> + Send + 'static,
 ) -> Result<SendableRecordBatchStream> {
     let schema = target.schema();
-    let stream = target.map(move |batch| {
-        let mut row_ids = row_ids.write().unwrap();
-        extract_row_ids(&mut row_ids, batch)
-    });
+    let stream = target.map(move |batch| extract_row_ids(&mut capture, batch));
 
     let (row_id_idx, _) = schema
         .column_with_name(ROW_ID)
@@ -73,3 +59,39 @@ pub fn make_rowid_capture_stream(
     let stream = RecordBatchStreamAdapter::new(schema, stream);
     Ok(Box::pin(stream))
 }
+
+/// Given a stream that includes a row id column, return a stream that will
+/// capture the row ids in a `RoaringTreemap` and return a stream without the
+/// row id column.
+pub fn make_rowid_capture_stream(
+    row_ids: Arc<RwLock<RoaringTreemap>>,
+    target: SendableRecordBatchStream,
+) -> Result<SendableRecordBatchStream> {
+    make_capture_stream(target, move |row_ids_arr| {
+        let mut row_ids = row_ids.write().unwrap();
+        row_ids
+            .append(row_ids_arr.values().iter().copied())
+            .map_err(|err| {
+                datafusion::error::DataFusionError::Execution(format!(
+                    "Row ids did not arrive in sorted order: {}",
+                    err
+                ))
+            })?;
+        Ok(())
+    })
+}
+
+/// Like [make_rowid_capture_stream] but the row ids are kept in the order they
+/// arrive, which need not be sorted.
+pub fn make_rowid_list_capture_stream(
+    row_ids: Arc<Mutex<Vec<u64>>>,
+    target: SendableRecordBatchStream,
+) -> Result<SendableRecordBatchStream> {
+    make_capture_stream(target, move |row_ids_arr| {
+        row_ids
+            .lock()
+            .unwrap()
+            .extend_from_slice(row_ids_arr.values());
+        Ok(())
+    })
+}
@@ -5,7 +5,9 @@ use std::sync::Arc;
 
 use arrow_array::{RecordBatch, RecordBatchReader};
 use datafusion::physical_plan::SendableRecordBatchStream;
-use futures::{StreamExt, TryStreamExt};
+use futures::channel::mpsc;
+use futures::stream::BoxStream;
+use futures::{SinkExt, StreamExt, TryStreamExt};
 use lance_core::{datatypes::Schema, Error, Result};
 use lance_datafusion::chunker::{break_stream, chunk_stream};
 use lance_datafusion::utils::{peek_reader_schema, reader_to_stream};
@@ -107,6 +109,22 @@ pub struct WriteParams {
     /// This makes compaction more efficient, since with stable row ids no
     /// secondary indices need to be updated to point to new row ids.
     pub enable_move_stable_row_ids: bool,
+
+    /// If set to true, the fragment list is stored in chunk files that are
+    /// shared between versions, rather than inline in every manifest.
+    ///
+    /// This keeps commits and checkouts cheap for datasets with very many
+    /// fragments, since only the chunks that changed are written or read.
+    /// Once enabled it stays enabled for all later versions.  Older versions
+    /// of Lance cannot read or write datasets that use this.
+    pub enable_fragment_chunks: bool,
+
+    /// The number of files that are encoded and written in parallel
+    ///
+    /// The input is split into files as usual and the files are spread over this many
+    /// writer tasks.  The order of the rows is preserved.  More writers use more memory
+    /// and only help when the input has more than `max_rows_per_file` rows.
+    pub max_writers: usize,
 }
 
 impl Default for WriteParams {
@@ -123,6 +141,8 @@ impl Default for WriteParams {
             commit_handler: None,
             use_legacy_format: true,
             enable_move_stable_row_ids: false,
+            enable_fragment_chunks: false,
+            max_writers: 1,
         }
     }
 }
@@ -215,7 +235,7 @@ pub async fn write_fragments_internal(
         schema
     };
 
-    let mut buffered_reader = if params.use_legacy_format {
+    let buffered_reader = if params.use_legacy_format {
         chunk_stream(data, params.max_rows_per_group)
     } else {
         // In v2 we don't care about group size but we do want to break
@@ -225,53 +245,213 @@ pub async fn write_fragments_internal(
             .boxed()
     };
 
-    let writer_generator =
-        WriterGenerator::new(object_store, base_dir, schema, params.use_legacy_format);
-    let mut writer: Option<Box<dyn GenericWriter>> = None;
+    let writer_generator = Arc::new(WriterGenerator::new(
+        object_store,
+        base_dir,
+        schema,
+        params.use_legacy_format,
+    ));
+    let fragments = if params.max_writers > 1 {
+        // Number each chunk with the file it goes to, so that files can be dealt to the
+        // writers.  A file is full once it has max_rows_per_file rows.
+        let max_rows_per_file = params.max_rows_per_file;
+        let chunks = buffered_reader
+            .scan((0, 0), move |(file_idx, num_rows), batch_chunk| {
+                let numbered = batch_chunk.map(|mut batch_chunk| {
+                    // Cut chunks that straddle a file boundary so that every file but the
+                    // last gets exactly max_rows_per_file rows
+                    let mut numbered = Vec::new();
+                    while !batch_chunk.is_empty() {
+                        let (head, tail) = split_chunk(batch_chunk, max_rows_per_file - *num_rows);
+                        *num_rows += head.iter().map(|batch| batch.num_rows()).sum::<usize>();
+                        numbered.push(Ok((*file_idx, head)));
+                        if *num_rows >= max_rows_per_file {
+                            *file_idx += 1;
+                            *num_rows = 0;
+                        }
+                        batch_chunk = tail;
+                    }
+                    futures::stream::iter(numbered)
+                });
+                futures::future::ready(Some(numbered))
+            })
+            .try_flatten()
+            .boxed();
+        write_files_parallel(writer_generator, chunks, &params).await?
+    } else {
+        // A single writer decides where each file ends by itself
+        let chunks = buffered_reader
+            .map_ok(|batch_chunk| (0, batch_chunk))
+            .boxed();
+        write_files(
+            &writer_generator,
+            chunks,
+            params.max_rows_per_file,
+            params.max_bytes_per_file as u64,
+            params.progress.as_ref(),
+        )
+        .await?
+    };
+
+    Ok(fragments
+        .into_iter()
+        .map(|(_, fragment)| fragment)
+        .collect())
+}
+
+/// Write numbered chunks to files, returning each fragment with the number of its file
+///
+/// A new file is started when the file number changes, or when the current file
+/// reaches `max_rows_per_file` rows or `max_bytes_per_file` bytes.  Both counts start
+/// again with every new file, so the file that follows one that was cut short by its
+/// size can still take `max_rows_per_file` rows, as long as the file number allows.
+async fn write_files(
+    writer_generator: &WriterGenerator,
+    mut chunks: BoxStream<'static, Result<(usize, Vec<RecordBatch>)>>,
+    max_rows_per_file: usize,
+    max_bytes_per_file: u64,
+    progress: &dyn WriteFragmentProgress,
+) -> Result<Vec<(usize, Fragment)>> {
+    let mut writer: Option<(usize, Box<dyn GenericWriter>)> = None;
     let mut num_rows_in_current_file = 0;
-    let mut fragments = Vec::new();
-    while let Some(batch_chunk) = buffered_reader.next().await {
-        let batch_chunk = batch_chunk?;
-
-        if writer.is_none() {
-            let (new_writer, new_fragment) = writer_generator.new_writer().await?;
-            // rustc has a hard time analyzing the lifetime of the &str returned
-            // by multipart_id(), so we convert it to an owned value here.
-            let multipart_id = new_writer.multipart_id().to_string();
-            params.progress.begin(&new_fragment, &multipart_id).await?;
-            writer = Some(new_writer);
-            fragments.push(new_fragment);
+    let mut fragments: Vec<(usize, Fragment)> = Vec::new();
+    while let Some((file_idx, mut batch_chunk)) = chunks.try_next().await? {
+        if matches!(&writer, Some((current_idx, _)) if *current_idx != file_idx) {
+            let (_, finished) = writer.take().unwrap();
+            finish_file(finished, &mut fragments.last_mut().unwrap().1, progress).await?;
         }
 
-        writer.as_mut().unwrap().write(&batch_chunk).await?;
-        for batch in batch_chunk {
-            num_rows_in_current_file += batch.num_rows() as u32;
-        }
+        loop {
+            if writer.is_none() {
+                let (new_writer, new_fragment) = writer_generator.new_writer().await?;
+                // rustc has a hard time analyzing the lifetime of the &str returned
+                // by multipart_id(), so we convert it to an owned value here.
+                let multipart_id = new_writer.multipart_id().to_string();
+                progress.begin(&new_fragment, &multipart_id).await?;
+                writer = Some((file_idx, new_writer));
+                fragments.push((file_idx, new_fragment));
+                num_rows_in_current_file = 0;
+            }
 
-        if num_rows_in_current_file >= params.max_rows_per_file as u32
-            || writer.as_mut().unwrap().tell().await? >= params.max_bytes_per_file as u64
-        {
-            let (num_rows, data_file) = writer.take().unwrap().finish().await?;
-            debug_assert_eq!(num_rows, num_rows_in_current_file);
-            params.progress.complete(fragments.last().unwrap()).await?;
-            let last_fragment = fragments.last_mut().unwrap();
-            last_fragment.physical_rows = Some(num_rows as usize);
-            last_fragment.files.push(data_file);
-            num_rows_in_current_file = 0;
+            // Only write as many rows as still fit in this file
+            let (head, tail) =
+                split_chunk(batch_chunk, max_rows_per_file - num_rows_in_current_file);
+            let (_, current) = writer.as_mut().unwrap();
+            current.write(&head).await?;
+            num_rows_in_current_file += head.iter().map(|batch| batch.num_rows()).sum::<usize>();
+            if num_rows_in_current_file >= max_rows_per_file
+                || current.tell().await? >= max_bytes_per_file
+            {
+                let (_, finished) = writer.take().unwrap();
+                finish_file(finished, &mut fragments.last_mut().unwrap().1, progress).await?;
+            }
+
+            if tail.is_empty() {
+                break;
+            }
+            batch_chunk = tail;
         }
     }
 
     // Complete the final writer
-    if let Some(mut writer) = writer.take() {
-        let (num_rows, data_file) = writer.finish().await?;
-        let last_fragment = fragments.last_mut().unwrap();
-        last_fragment.physical_rows = Some(num_rows as usize);
-        last_fragment.files.push(data_file);
+    if let Some((_, finished)) = writer.take() {
+        finish_file(finished, &mut fragments.last_mut().unwrap().1, progress).await?;
     }
 
     Ok(fragments)
 }
 
+/// Split a chunk of batches after the first `num_rows` rows
+fn split_chunk(chunk: Vec<RecordBatch>, num_rows: usize) -> (Vec<RecordBatch>, Vec<RecordBatch>) {
+    let mut head = Vec::with_capacity(chunk.len());
+    let mut tail = Vec::new();
+    let mut remaining = num_rows;
+    for batch in chunk {
+        if batch.num_rows() <= remaining {
+            remaining -= batch.num_rows();
+            head.push(batch);
+        } else if remaining > 0 {
+            head.push(batch.slice(0, remaining));
+            tail.push(batch.slice(remaining, batch.num_rows() - remaining));
+            remaining = 0;
+        } else {
+            tail.push(batch);
+        }
+    }
+    (head, tail)
+}
+
+async fn finish_file(
+    mut writer: Box<dyn GenericWriter>,
+    fragment: &mut Fragment,
+    progress: &dyn WriteFragmentProgress,
+) -> Result<()> {
+    let (num_rows, data_file) = writer.finish().await?;
+    fragment.physical_rows = Some(num_rows as usize);
+    fragment.files.push(data_file);
+    progress.complete(fragment).await
+}
+
+/// Spread the files over `params.max_writers` tasks that encode and write in parallel
+///
+/// Files are dealt round-robin to the writers through bounded channels, so a slow
+/// writer applies back pressure instead of buffering the input.  The fragments are
+/// returned in the order of the input.
+///
+/// Files are numbered by row count, and the chunks cut at file boundaries, before they are
+/// written.  So when a writer has to cut a file short because of `max_bytes_per_file`, the
+/// rest of that numbered file becomes a smaller file of its own.
+async fn write_files_parallel(
+    writer_generator: Arc<WriterGenerator>,
+    mut chunks: BoxStream<'static, Result<(usize, Vec<RecordBatch>)>>,
+    params: &WriteParams,
+) -> Result<Vec<(usize, Fragment)>> {
+    let mut senders = Vec::with_capacity(params.max_writers);
+    let mut writers = Vec::with_capacity(params.max_writers);
+    for _ in 0..params.max_writers {
+        let (sender, receiver) = mpsc::channel(2);
+        let writer_generator = writer_generator.clone();
+        let max_rows_per_file = params.max_rows_per_file;
+        let max_bytes_per_file = params.max_bytes_per_file as u64;
+        let progress = params.progress.clone();
+        writers.push(tokio::task::spawn(async move {
+            write_files(
+                &writer_generator,
+                receiver.map(Ok).boxed(),
+                max_rows_per_file,
+                max_bytes_per_file,
+                progress.as_ref(),
+            )
+            .await
+        }));
+        senders.push(sender);
+    }
+
+    let dispatched = async {
+        while let Some((file_idx, batch_chunk)) = chunks.try_next().await? {
+            let sender = &mut senders[file_idx % params.max_writers];
+            if sender.send((file_idx, batch_chunk)).await.is_err() {
+                // The writer failed, its error is returned below
+                break;
+            }
+        }
+        Result::Ok(())
+    }
+    .await;
+    // Close the channels so the writers finish their last file
+    drop(senders);
+
+    let mut fragments = Vec::new();
+    for writer in writers {
+        fragments.extend(writer.await??);
+    }
+    dispatched?;
+
+    // Each writer returns its fragments in order so a stable sort restores the input order
+    fragments.sort_by_key(|(file_idx, _)| *file_idx);
+    Ok(fragments)
+}
+
 #[async_trait::async_trait]
 pub trait GenericWriter: Send {
     /// Get a unique id associated with the fragment being written
@@ -421,7 +601,7 @@ impl WriterGenerator {
 mod tests {
     use super::*;
 
-    use arrow_array::{Int32Array, StructArray};
+    use arrow_array::{Int32Array, StringArray, StructArray};
     use arrow_schema::{DataType, Field as ArrowField, Fields, Schema as ArrowSchema};
     use datafusion::{error::DataFusionError, physical_plan::stream::RecordBatchStreamAdapter};
     use futures::TryStreamExt;
@@ -554,6 +734,129 @@ mod tests {
         assert_eq!(fragments.len(), 2);
     }
 
+    #[tokio::test]
+    async fn test_file_size_and_rows() {
+        let schema = Arc::new(ArrowSchema::new(vec![arrow::datatypes::Field::new(
+            "s",
+            DataType::Utf8,
+            false,
+        )]));
+
+        // 200 wide rows that reach the byte limit first, then 800 narrow rows that reach
+        // the row limit first
+        let wide = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(StringArray::from_iter_values(
+                (0..200).map(|_| "x".repeat(50)),
+            ))],
+        )
+        .unwrap();
+        let narrow = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(StringArray::from_iter_values(
+                (0..800).map(|_| "x"),
+            ))],
+        )
+        .unwrap();
+
+        let write_params = WriteParams {
+            max_rows_per_file: 300,
+            max_rows_per_group: 100,
+            max_bytes_per_file: 8 * 1024,
+            mode: WriteMode::Create,
+            ..Default::default()
+        };
+
+        let data_stream = Box::pin(RecordBatchStreamAdapter::new(
+            schema.clone(),
+            futures::stream::iter(vec![Ok(wide), Ok(narrow)]),
+        ));
+
+        let schema = Schema::try_from(schema.as_ref()).unwrap();
+
+        let object_store = Arc::new(ObjectStore::memory());
+        let fragments = write_fragments_internal(
+            None,
+            object_store,
+            &Path::from("test"),
+            &schema,
+            data_stream,
+            write_params,
+        )
+        .await
+        .unwrap();
+        // The file after the one cut short by size starts counting rows again
+        let rows = fragments
+            .iter()
+            .map(|fragment| fragment.physical_rows.unwrap())
+            .collect::<Vec<_>>();
+        assert_eq!(rows, vec![200, 300, 300, 200]);
+    }
+
+    #[rstest::rstest]
+    #[tokio::test]
+    async fn test_parallel_writers(
+        #[values(true, false)] use_legacy_format: bool,
+        // 100 row groups do not divide the files evenly
+        #[values(50, 100)] max_rows_per_group: usize,
+    ) {
+        let schema = Arc::new(ArrowSchema::new(vec![arrow::datatypes::Field::new(
+            "a",
+            DataType::Int32,
+            false,
+        )]));
+        let batches = (0..10)
+            .map(|i| {
+                RecordBatch::try_new(
+                    schema.clone(),
+                    vec![Arc::new(Int32Array::from_iter(i * 100..(i + 1) * 100))],
+                )
+            })
+            .collect::<Vec<_>>();
+
+        let write_params = WriteParams {
+            max_rows_per_file: 150,
+            max_rows_per_group,
+            max_writers: 4,
+            use_legacy_format,
+            ..Default::default()
+        };
+
+        let test_dir = tempfile::tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let reader = arrow_array::RecordBatchIterator::new(batches, schema.clone());
+        let dataset = Dataset::write(reader, test_uri, Some(write_params))
+            .await
+            .unwrap();
+
+        let fragments = dataset.get_fragments();
+        assert_eq!(fragments.len(), 7);
+        let ids = fragments
+            .iter()
+            .map(|fragment| fragment.id())
+            .collect::<Vec<_>>();
+        assert_eq!(ids, (0..7).collect::<Vec<_>>());
+        let rows = fragments
+            .iter()
+            .map(|fragment| fragment.metadata().physical_rows)
+            .collect::<Vec<_>>();
+        assert_eq!(
+            rows,
+            vec![Some(150); 6]
+                .into_iter()
+                .chain([Some(100)])
+                .collect::<Vec<_>>()
+        );
+
+        // Rows come back in the order they were written
+        let batch = dataset.scan().try_into_batch().await.unwrap();
+        let expected = Int32Array::from_iter(0..1000);
+        assert_eq!(
+            batch.column(0).as_ref(),
+            &expected as &dyn arrow_array::Array
+        );
+    }
+
     #[tokio::test]
     async fn test_file_write_v2() {
         let schema = Arc::new(ArrowSchema::new(vec![arrow::datatypes::Field::new(
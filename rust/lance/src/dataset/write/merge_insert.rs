@@ -62,7 +62,7 @@ use snafu::{location, Location, ResultExt};
 use crate::{
     datafusion::dataframe::SessionContextExt,
     dataset::transaction::{Operation, Transaction},
-    index::DatasetIndexInternalExt,
+    index::scalar::detect_scalar_index_type,
     io::{
         commit::commit_transaction,
         exec::{scalar_index::MapIndexExec, utils::ReplayExec, Planner, ProjectionExec, TakeExec},
@@ -72,6 +72,11 @@ use crate::{
 
 use super::write_fragments_internal;
 
+mod spill;
+
+/// The default memory budget for joining the source data with the dataset
+pub const DEFAULT_JOIN_MEMORY_LIMIT: usize = 1024 * 1024 * 1024;
+
 // "update if" expressions typically compare fields from the source table to the target table.
 // These tables have the same schema and so filter expressions need to differentiate.  To do that
 // we wrap the left side and the right side in a struct and make a single "combined schema"
@@ -199,6 +204,8 @@ struct MergeInsertParams {
     insert_not_matched: bool,
     // Controls whether data that is not matched by the source is deleted or not
     delete_not_matched_by_source: WhenNotMatchedBySource,
+    // If the source data is larger than this then the join spills to local disk
+    join_memory_limit: usize,
 }
 
 /// A MergeInsertJob inserts new rows, deletes old rows, and updates existing rows all as
@@ -274,6 +281,7 @@ impl MergeInsertBuilder {
                 when_matched: WhenMatched::DoNothing,
                 insert_not_matched: true,
                 delete_not_matched_by_source: WhenNotMatchedBySource::Keep,
+                join_memory_limit: DEFAULT_JOIN_MEMORY_LIMIT,
             },
         })
     }
@@ -303,6 +311,16 @@ impl MergeInsertBuilder {
         self
     }
 
+    /// Limit the memory used to join the source data with the dataset
+    ///
+    /// When the dataset has to be scanned and the source data is larger than this, both are
+    /// hash partitioned on the keys and spilled to local disk.  The partitions are then joined
+    /// in parallel, each with a share of the limit.  The default is 1GiB.
+    pub fn join_memory_limit(&mut self, bytes: usize) -> &mut Self {
+        self.params.join_memory_limit = bytes;
+        self
+    }
+
     /// Crate a merge insert job
     pub fn try_build(&mut self) -> Result<MergeInsertJob> {
         if !self.params.insert_not_matched
@@ -347,7 +365,16 @@ impl MergeInsertJob {
             Ok(None)
         } else {
             let col = &self.params.on[0];
-            self.dataset.load_scalar_index_for_column(col).await
+            let Some(index) = self.dataset.load_scalar_index_for_column(col).await? else {
+                return Ok(None);
+            };
+            // Only a scalar index that answers exact lookups (btree or bitmap) can look up
+            // keys, an index of any other kind on the column means we fall back to a full
+            // scan.  The kind comes from the index metadata so the index isn't opened here.
+            let index_type = detect_scalar_index_type(&self.dataset, &index).await?;
+            Ok(index_type
+                .filter(|index_type| index_type.supports_exact_queries())
+                .map(|_| index))
         }
     }
 
@@ -451,12 +478,46 @@ impl MergeInsertJob {
     // If the join keys are not indexed then we need to do a full scan of the table
     async fn create_full_table_joined_stream(
         &self,
-        source: SendableRecordBatchStream,
-    ) -> Result<SendableRecordBatchStream> {
-        let session_config = SessionConfig::default().with_target_partitions(1);
-        let session_ctx = SessionContext::new_with_config(session_config);
+        mut source: SendableRecordBatchStream,
+    ) -> Result<(SendableRecordBatchStream, Option<spill::SpillStats>)> {
         let schema = source.schema();
         self.check_compatible_schema(&schema)?;
+
+        // Read the source until we know whether it fits in the memory budget
+        let mut buffered = Vec::new();
+        let mut buffered_bytes = 0;
+        let mut exhausted = false;
+        while buffered_bytes <= self.params.join_memory_limit {
+            if let Some(batch) = source.try_next().await? {
+                buffered_bytes += batch.get_array_memory_size();
+                buffered.push(batch);
+            } else {
+                exhausted = true;
+                break;
+            }
+        }
+        let source = Box::pin(RecordBatchStreamAdapter::new(
+            schema.clone(),
+            stream::iter(buffered.into_iter().map(Ok)).chain(source),
+        ));
+
+        if !exhausted {
+            info!("The merge insert source data is larger than the join memory limit, spilling to disk");
+            let mut scanner = self.dataset.scan();
+            scanner.with_row_id();
+            let existing = scanner.try_into_stream().await?.into();
+            let (joined, spill_stats) = spill::spilling_full_join(
+                source,
+                existing,
+                &self.params.on,
+                self.params.join_memory_limit,
+            )
+            .await?;
+            return Ok((joined, Some(spill_stats)));
+        }
+
+        let session_config = SessionConfig::default().with_target_partitions(1);
+        let session_ctx = SessionContext::new_with_config(session_config);
         let existing = session_ctx.read_lance(self.dataset.clone(), true)?;
         let new_data = session_ctx.read_one_shot(source)?;
         let join_cols = self
@@ -466,13 +527,13 @@ impl MergeInsertJob {
             .map(|c| c.as_str())
             .collect::<Vec<_>>(); // vector of strings of col names to join
         let joined = new_data.join(existing, JoinType::Full, &join_cols, &join_cols, None)?; // full join
-        Ok(joined.execute_stream().await?)
+        Ok((joined.execute_stream().await?, None))
     }
 
     async fn create_joined_stream(
         &self,
         source: SendableRecordBatchStream,
-    ) -> Result<SendableRecordBatchStream> {
+    ) -> Result<(SendableRecordBatchStream, Option<spill::SpillStats>)> {
         // We need to do a full index scan if we're deleting source data
         let can_use_scalar_index = matches!(
             self.params.delete_not_matched_by_source, // this value marks behavior for rows in target that are not matched by the source. Value assigned earlier.
@@ -481,7 +542,10 @@ impl MergeInsertJob {
         if can_use_scalar_index {
             // keeping unmatched rows, no deletion
             if let Some(index) = self.join_key_as_scalar_index().await? {
-                self.create_indexed_scan_joined_stream(source, index).await
+                let joined = self
+                    .create_indexed_scan_joined_stream(source, index)
+                    .await?;
+                Ok((joined, None))
             } else {
                 self.create_full_table_joined_stream(source).await
             }
@@ -501,7 +565,7 @@ impl MergeInsertJob {
     ) -> Result<(Arc<Dataset>, MergeStats)> {
         let schema = source.schema();
 
-        let joined = self.create_joined_stream(source).await?;
+        let (joined, spill_stats) = self.create_joined_stream(source).await?;
         let merger = Merger::try_new(self.params, schema.clone())?;
         let merge_statistics = merger.merge_stats.clone();
         let deleted_rows = merger.deleted_rows.clone();
@@ -535,10 +599,15 @@ impl MergeInsertJob {
         )
         .await?;
 
-        let stats = Arc::into_inner(merge_statistics)
+        let mut stats = Arc::into_inner(merge_statistics)
             .unwrap()
             .into_inner()
             .unwrap();
+        if let Some(spill_stats) = spill_stats {
+            stats.num_spilled_partitions = spill_stats.num_partitions;
+            stats.num_spilled_rows = spill_stats.num_spilled_rows;
+            stats.num_spilled_bytes = spill_stats.num_spilled_bytes;
+        }
 
         Ok((committed_ds, stats))
     }
@@ -632,6 +701,13 @@ pub struct MergeStats {
     /// Note: This is different from internal references to 'deleted_rows', since we technically "delete" updated rows during processing.
     /// However those rows are not shared with the user.
     pub num_deleted_rows: u64,
+    /// Number of partitions the join was split into when the source data did not fit in
+    /// memory, 0 if the join was done in memory
+    pub num_spilled_partitions: u64,
+    /// Number of source and target rows the join wrote to local disk
+    pub num_spilled_rows: u64,
+    /// Approximate in-memory size of the rows the join wrote to local disk
+    pub num_spilled_bytes: u64,
 }
 
 // A sync-safe structure that is shared by all of the "process batch" tasks.
@@ -795,7 +871,7 @@ impl Merger {
                 }
             }
 
-            merge_statistics.num_updated_rows = matched.num_rows() as u64;
+            merge_statistics.num_updated_rows += matched.num_rows() as u64;
 
             // If the filter eliminated all rows then its important we don't try and write
             // the batch at all.  Writing an empty batch currently panics
@@ -824,13 +900,13 @@ impl Merger {
                 Vec::from_iter(not_matched.columns().iter().cloned()),
             )?;
 
-            merge_statistics.num_inserted_rows = not_matched.num_rows() as u64;
+            merge_statistics.num_inserted_rows += not_matched.num_rows() as u64;
             batches.push(Ok(not_matched));
         }
         match self.params.delete_not_matched_by_source {
             WhenNotMatchedBySource::Delete => {
                 let unmatched = arrow::compute::filter(batch.column(row_id_col), &right_only)?;
-                merge_statistics.num_deleted_rows = unmatched.len() as u64;
+                merge_statistics.num_deleted_rows += unmatched.len() as u64;
                 let row_ids = unmatched.as_primitive::<UInt64Type>();
                 deleted_row_ids.extend(row_ids.values());
             }
@@ -847,13 +923,13 @@ impl Merger {
                             mask.as_boolean(),
                         )?;
                         let row_ids = row_ids.as_primitive::<UInt64Type>();
-                        merge_statistics.num_deleted_rows = row_ids.len() as u64;
+                        merge_statistics.num_deleted_rows += row_ids.len() as u64;
                         deleted_row_ids.extend(row_ids.values());
                     }
                     ColumnarValue::Scalar(scalar) => {
                         if let ScalarValue::Boolean(Some(true)) = scalar {
                             let row_ids = unmatched.column(row_id_col).as_primitive::<UInt64Type>();
-                            merge_statistics.num_deleted_rows = row_ids.len() as u64;
+                            merge_statistics.num_deleted_rows += row_ids.len() as u64;
                             deleted_row_ids.extend(row_ids.values());
                         }
                     }
@@ -1156,6 +1232,74 @@ mod tests {
         check(new_batch.clone(), job, &[1, 4, 5, 6], &[], &[0, 0, 2]).await;
     }
 
+    #[tokio::test]
+    async fn test_spilled_merge() {
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("key", DataType::UInt32, false),
+            Field::new("value", DataType::UInt32, false),
+        ]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(UInt32Array::from(vec![1, 2, 3, 4, 5, 6])),
+                Arc::new(UInt32Array::from(vec![1, 1, 1, 1, 1, 1])),
+            ],
+        )
+        .unwrap();
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let batches = RecordBatchIterator::new([Ok(batch)], schema.clone());
+        let ds = Arc::new(Dataset::write(batches, test_uri, None).await.unwrap());
+
+        let new_batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(UInt32Array::from(vec![4, 5, 6, 7, 8, 9])),
+                Arc::new(UInt32Array::from(vec![2, 2, 2, 2, 2, 2])),
+            ],
+        )
+        .unwrap();
+
+        // A memory limit of 0 forces the join to spill, the results must not change
+        let keys = vec!["key".to_string()];
+        let job = MergeInsertBuilder::try_new(ds.clone(), keys.clone())
+            .unwrap()
+            .when_matched(WhenMatched::UpdateAll)
+            .join_memory_limit(0)
+            .try_build()
+            .unwrap();
+        check(
+            new_batch.clone(),
+            job,
+            &[1, 2, 3],
+            &[4, 5, 6, 7, 8, 9],
+            &[3, 3, 0],
+        )
+        .await;
+
+        let job = MergeInsertBuilder::try_new(ds.clone(), keys.clone())
+            .unwrap()
+            .when_matched(WhenMatched::UpdateAll)
+            .when_not_matched_by_source(WhenNotMatchedBySource::Delete)
+            .join_memory_limit(0)
+            .try_build()
+            .unwrap();
+        let source = Box::new(RecordBatchIterator::new([Ok(new_batch)], schema.clone()));
+        let (merged, stats) = job.execute_reader(source).await.unwrap();
+        assert_eq!(merged.count_rows(None).await.unwrap(), 6);
+        assert_eq!(
+            (
+                stats.num_inserted_rows,
+                stats.num_updated_rows,
+                stats.num_deleted_rows
+            ),
+            (3, 3, 3)
+        );
+        assert!(stats.num_spilled_partitions > 0);
+        assert_eq!(stats.num_spilled_rows, 12);
+        assert!(stats.num_spilled_bytes > 0);
+    }
+
     #[tokio::test]
     async fn test_indexed_merge_insert() {
         let test_dir = tempdir().unwrap();
@@ -1280,4 +1424,78 @@ mod tests {
 
         assert_eq!(ds.count_rows(None).await.unwrap(), 2048);
     }
+
+    #[tokio::test]
+    async fn test_upsert_conflicts_with_concurrent_append() {
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("key", DataType::UInt32, false),
+            Field::new("value", DataType::UInt32, false),
+        ]));
+        let make_batch = |keys: Vec<u32>, value: u32| {
+            let values = vec![value; keys.len()];
+            RecordBatch::try_new(
+                schema.clone(),
+                vec![
+                    Arc::new(UInt32Array::from(keys)),
+                    Arc::new(UInt32Array::from(values)),
+                ],
+            )
+            .unwrap()
+        };
+
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let batches = RecordBatchIterator::new([Ok(make_batch(vec![1, 2, 3], 1))], schema.clone());
+        let ds = Arc::new(Dataset::write(batches, test_uri, None).await.unwrap());
+
+        // The upsert is planned against the version that does not have key 4 yet
+        let job = MergeInsertBuilder::try_new(ds.clone(), vec!["key".to_string()])
+            .unwrap()
+            .when_matched(WhenMatched::UpdateAll)
+            .when_not_matched(WhenNotMatched::InsertAll)
+            .try_build()
+            .unwrap();
+
+        // Meanwhile another writer appends key 4
+        let mut appender = (*ds).clone();
+        let batches = RecordBatchIterator::new([Ok(make_batch(vec![4], 1))], schema.clone());
+        appender.append(batches, None).await.unwrap();
+
+        // Committing the upsert on top of the append would insert key 4 a second time
+        let source = Box::new(RecordBatchIterator::new(
+            [Ok(make_batch(vec![3, 4], 2))],
+            schema.clone(),
+        ));
+        let result = job.execute_reader(source).await;
+        assert!(
+            matches!(result, Err(Error::CommitConflict { .. })),
+            "expected a commit conflict, got {:?}",
+            result.map(|(ds, _)| ds.version().version)
+        );
+
+        let ds = Dataset::open(test_uri).await.unwrap();
+        let keys = ds
+            .scan()
+            .project(&["key"])
+            .unwrap()
+            .try_into_stream()
+            .await
+            .unwrap()
+            .try_collect::<Vec<_>>()
+            .await
+            .unwrap();
+        let mut keys = keys
+            .iter()
+            .flat_map(|batch| {
+                batch
+                    .column(0)
+                    .as_primitive::<UInt32Type>()
+                    .values()
+                    .to_vec()
+            })
+            .collect::<Vec<_>>();
+        keys.sort();
+        assert_eq!(keys, vec![1, 2, 3, 4]);
+    }
 }
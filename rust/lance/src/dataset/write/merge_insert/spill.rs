@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+//! A partitioned ("grace") hash join that spills to local disk
+//!
+//! When the source data of a merge insert is too large to hash in memory, both the source
+//! and the target are hash partitioned on the join keys and written to local files.  Rows
+//! with equal keys always land in the same bucket, so each bucket can be joined on its own.
+//! Buckets are grouped so that the source side of each group fits in the memory budget
+//! and the groups are joined in parallel.
+
+use std::collections::hash_map::DefaultHasher;
+use std::fs::File;
+use std::hash::{Hash, Hasher};
+use std::io::{BufReader, BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use arrow::ipc::reader::StreamReader;
+use arrow::ipc::writer::StreamWriter;
+use arrow_array::{RecordBatch, UInt32Array};
+use arrow_row::{RowConverter, SortField};
+use arrow_schema::{Schema as ArrowSchema, SchemaRef};
+use arrow_select::take::take_record_batch;
+use datafusion::error::DataFusionError;
+use datafusion::execution::context::{SessionConfig, SessionContext};
+use datafusion::logical_expr::JoinType;
+use datafusion::physical_plan::{stream::RecordBatchStreamAdapter, SendableRecordBatchStream};
+use futures::channel::mpsc;
+use futures::{stream, SinkExt, StreamExt, TryStreamExt};
+use tempfile::TempDir;
+
+use crate::datafusion::dataframe::SessionContextExt;
+use crate::Result;
+
+/// The number of buckets each side is partitioned into
+///
+/// Buckets are grouped back together before joining, so this only needs to be large enough
+/// that a single bucket fits in memory.
+const NUM_BUCKETS: usize = 256;
+
+/// Statistics about the data spilled by a partitioned join
+#[derive(Debug, Default, Clone, Copy)]
+pub(super) struct SpillStats {
+    pub num_partitions: u64,
+    pub num_spilled_rows: u64,
+    pub num_spilled_bytes: u64,
+}
+
+struct SpillFile {
+    path: PathBuf,
+    num_rows: usize,
+    num_bytes: usize,
+}
+
+/// Writes batches to one file per bucket, assigning rows to buckets by the hash of their keys
+struct SpillWriter {
+    key_columns: Vec<usize>,
+    files: Vec<SpillFile>,
+    writers: Vec<StreamWriter<BufWriter<File>>>,
+}
+
+impl SpillWriter {
+    fn try_new(dir: &Path, name: &str, schema: &SchemaRef, on: &[String]) -> Result<Self> {
+        let key_columns = on
+            .iter()
+            .map(|column| schema.index_of(column))
+            .collect::<std::result::Result<Vec<_>, _>>()?;
+        let mut files = Vec::with_capacity(NUM_BUCKETS);
+        let mut writers = Vec::with_capacity(NUM_BUCKETS);
+        for bucket in 0..NUM_BUCKETS {
+            let path = dir.join(format!("{}-{}.arrows", name, bucket));
+            let file = BufWriter::new(File::create(&path)?);
+            writers.push(StreamWriter::try_new(file, schema)?);
+            files.push(SpillFile {
+                path,
+                num_rows: 0,
+                num_bytes: 0,
+            });
+        }
+        Ok(Self {
+            key_columns,
+            files,
+            writers,
+        })
+    }
+
+    fn write(&mut self, batch: &RecordBatch) -> Result<()> {
+        let keys = self
+            .key_columns
+            .iter()
+            .map(|idx| batch.column(*idx).clone())
+            .collect::<Vec<_>>();
+        let converter = RowConverter::new(
+            keys.iter()
+                .map(|key| SortField::new(key.data_type().clone()))
+                .collect(),
+        )?;
+        let rows = converter.convert_columns(&keys)?;
+
+        let mut buckets = vec![Vec::new(); NUM_BUCKETS];
+        for (row_idx, row) in rows.iter().enumerate() {
+            let mut hasher = DefaultHasher::new();
+            row.hash(&mut hasher);
+            buckets[(hasher.finish() % NUM_BUCKETS as u64) as usize].push(row_idx as u32);
+        }
+
+        for (bucket, indices) in buckets.into_iter().enumerate() {
+            if indices.is_empty() {
+                continue;
+            }
+            let rows = take_record_batch(batch, &UInt32Array::from(indices))?;
+            self.files[bucket].num_rows += rows.num_rows();
+            self.files[bucket].num_bytes += rows.get_array_memory_size();
+            self.writers[bucket].write(&rows)?;
+        }
+        Ok(())
+    }
+
+    fn finish(self) -> Result<Vec<SpillFile>> {
+        for writer in self.writers {
+            writer.into_inner()?.flush()?;
+        }
+        Ok(self.files)
+    }
+}
+
+/// Partition `data` into spill files
+///
+/// The files are created and written on a blocking thread, fed through a bounded channel,
+/// so that the disk I/O doesn't hold up the async runtime.
+async fn spill(
+    mut data: SendableRecordBatchStream,
+    dir: &Path,
+    name: &str,
+    on: &[String],
+) -> Result<Vec<SpillFile>> {
+    let (sender, mut receiver) = tokio::sync::mpsc::channel::<RecordBatch>(2);
+    let schema = data.schema();
+    let dir = dir.to_path_buf();
+    let name = name.to_string();
+    let on = on.to_vec();
+    let writer = tokio::task::spawn_blocking(move || -> Result<Vec<SpillFile>> {
+        let mut writer = SpillWriter::try_new(&dir, &name, &schema, &on)?;
+        while let Some(batch) = receiver.blocking_recv() {
+            writer.write(&batch)?;
+        }
+        writer.finish()
+    });
+
+    let sent = async {
+        while let Some(batch) = data.try_next().await? {
+            if sender.send(batch).await.is_err() {
+                // The writer failed, its error is returned below
+                break;
+            }
+        }
+        Result::Ok(())
+    }
+    .await;
+    // Close the channel so the writer finishes the files
+    drop(sender);
+
+    let files = writer.await??;
+    sent?;
+    Ok(files)
+}
+
+async fn read_spill_files(paths: Vec<PathBuf>) -> Result<Vec<RecordBatch>> {
+    tokio::task::spawn_blocking(move || -> Result<Vec<RecordBatch>> {
+        let mut batches = Vec::new();
+        for path in paths {
+            let reader = StreamReader::try_new(BufReader::new(File::open(path)?), None)?;
+            for batch in reader {
+                batches.push(batch?);
+            }
+        }
+        Ok(batches)
+    })
+    .await?
+}
+
+/// Full outer join one group of buckets
+///
+/// The source side of the group is loaded into memory to build the hash table, the target
+/// side is streamed one bucket at a time.
+async fn join_group(
+    source_schema: SchemaRef,
+    source_paths: Vec<PathBuf>,
+    target_schema: SchemaRef,
+    target_paths: Vec<PathBuf>,
+    on: Arc<Vec<String>>,
+) -> Result<SendableRecordBatchStream> {
+    let source_batches = read_spill_files(source_paths).await?;
+    let source = Box::pin(RecordBatchStreamAdapter::new(
+        source_schema,
+        stream::iter(source_batches.into_iter().map(Ok)),
+    ));
+    let target_batches = stream::iter(target_paths)
+        .then(|path| read_spill_files(vec![path]))
+        .map_ok(|batches| stream::iter(batches.into_iter().map(Ok)))
+        .try_flatten()
+        .map_err(|err| DataFusionError::External(Box::new(err)));
+    let target = Box::pin(RecordBatchStreamAdapter::new(target_schema, target_batches));
+
+    let session_config = SessionConfig::default().with_target_partitions(1);
+    let session_ctx = SessionContext::new_with_config(session_config);
+    let new_data = session_ctx.read_one_shot(source)?;
+    let existing = session_ctx.read_one_shot(target)?;
+    let join_cols = on.iter().map(|c| c.as_str()).collect::<Vec<_>>();
+    let joined = new_data.join(existing, JoinType::Full, &join_cols, &join_cols, None)?;
+    Ok(joined.execute_stream().await?)
+}
+
+/// Group consecutive buckets so that the source side of each group is at most `limit` bytes
+fn group_buckets(source_files: &[SpillFile], limit: usize) -> Vec<Vec<usize>> {
+    let mut groups: Vec<Vec<usize>> = Vec::new();
+    let mut group_bytes = 0;
+    for (bucket, file) in source_files.iter().enumerate() {
+        match groups.last_mut() {
+            Some(group) if group_bytes + file.num_bytes <= limit => {
+                group.push(bucket);
+                group_bytes += file.num_bytes;
+            }
+            _ => {
+                groups.push(vec![bucket]);
+                group_bytes = file.num_bytes;
+            }
+        }
+    }
+    groups
+}
+
+/// Full outer join `source` and `target` on the `on` columns, spilling both sides to disk
+///
+/// The output has the same schema as joining the two in memory: the source columns followed
+/// by the target columns.  Up to `num_cpus` groups are joined in parallel and together they
+/// keep the source side under `memory_limit` bytes.
+pub(super) async fn spilling_full_join(
+    source: SendableRecordBatchStream,
+    target: SendableRecordBatchStream,
+    on: &[String],
+    memory_limit: usize,
+) -> Result<(SendableRecordBatchStream, SpillStats)> {
+    let dir = TempDir::new()?;
+    let source_schema = source.schema();
+    let target_schema = target.schema();
+    let source_files = spill(source, dir.path(), "source", on).await?;
+    let target_files = spill(target, dir.path(), "target", on).await?;
+
+    let parallelism = num_cpus::get();
+    let groups = group_buckets(&source_files, (memory_limit / parallelism).max(1));
+    let spilled = source_files.iter().chain(target_files.iter());
+    let stats = SpillStats {
+        num_partitions: groups.len() as u64,
+        num_spilled_rows: spilled.clone().map(|file| file.num_rows as u64).sum(),
+        num_spilled_bytes: spilled.map(|file| file.num_bytes as u64).sum(),
+    };
+
+    let on = Arc::new(on.to_vec());
+    // The spill files are deleted when the last group that reads them is done
+    let dir = Arc::new(dir);
+    // Both sides of a full outer join are nullable
+    let output_schema = Arc::new(ArrowSchema::new(
+        source_schema
+            .fields()
+            .iter()
+            .chain(target_schema.fields().iter())
+            .map(|field| field.as_ref().clone().with_nullable(true))
+            .collect::<Vec<_>>(),
+    ));
+    let joined = stream::iter(groups)
+        .map(move |group| {
+            let source_paths = group
+                .iter()
+                .map(|bucket| source_files[*bucket].path.clone())
+                .collect();
+            let target_paths = group
+                .iter()
+                .map(|bucket| target_files[*bucket].path.clone())
+                .collect();
+            let join = join_group(
+                source_schema.clone(),
+                source_paths,
+                target_schema.clone(),
+                target_paths,
+                on.clone(),
+            );
+            let dir = dir.clone();
+
+            // Run each group in its own task so the groups are joined in parallel
+            let (mut sender, receiver) = mpsc::channel(2);
+            tokio::task::spawn(async move {
+                let _dir = dir;
+                let mut joined = match join.await {
+                    Ok(joined) => joined,
+                    Err(err) => {
+                        let _ = sender
+                            .send(Err(DataFusionError::External(Box::new(err))))
+                            .await;
+                        return;
+                    }
+                };
+                while let Some(batch) = joined.next().await {
+                    if sender.send(batch).await.is_err() {
+                        // The output was dropped
+                        return;
+                    }
+                }
+            });
+            receiver
+        })
+        .flatten_unordered(parallelism);
+
+    Ok((
+        Box::pin(RecordBatchStreamAdapter::new(output_schema, joined)),
+        stats,
+    ))
+}
+
+#[cfg(test)]
+mod tests {
+    use arrow_array::{cast::AsArray, types::UInt32Type, Array};
+    use arrow_schema::{DataType, Field, Schema};
+
+    use super::*;
+
+    fn stream_of(batch: RecordBatch) -> SendableRecordBatchStream {
+        Box::pin(RecordBatchStreamAdapter::new(
+            batch.schema(),
+            stream::iter(vec![Ok(batch)]),
+        ))
+    }
+
+    #[tokio::test]
+    async fn test_spilling_full_join() {
+        let schema = Arc::new(Schema::new(vec![
+            Field::new("key", DataType::UInt32, true),
+            Field::new("value", DataType::UInt32, true),
+        ]));
+        let source = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(UInt32Array::from_iter_values(500..1500)),
+                Arc::new(UInt32Array::from_iter_values(0..1000)),
+            ],
+        )
+        .unwrap();
+        let target = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(UInt32Array::from_iter_values(0..1000)),
+                Arc::new(UInt32Array::from_iter_values(0..1000)),
+            ],
+        )
+        .unwrap();
+
+        // A tiny limit forces many groups
+        let (joined, stats) =
+            spilling_full_join(stream_of(source), stream_of(target), &["key".into()], 1024)
+                .await
+                .unwrap();
+        assert!(stats.num_partitions > 1);
+        assert_eq!(stats.num_spilled_rows, 2000);
+        assert!(stats.num_spilled_bytes > 0);
+
+        let batches = joined.try_collect::<Vec<_>>().await.unwrap();
+        let mut matched = 0;
+        let mut source_only = 0;
+        let mut target_only = 0;
+        for batch in &batches {
+            assert_eq!(batch.num_columns(), 4);
+            let source_keys = batch.column(0).as_primitive::<UInt32Type>();
+            let target_keys = batch.column(2).as_primitive::<UInt32Type>();
+            for idx in 0..batch.num_rows() {
+                match (source_keys.is_valid(idx), target_keys.is_valid(idx)) {
+                    (true, true) => {
+                        assert_eq!(source_keys.value(idx), target_keys.value(idx));
+                        matched += 1;
+                    }
+                    (true, false) => source_only += 1,
+                    (false, true) => target_only += 1,
+                    (false, false) => unreachable!(),
+                }
+            }
+        }
+        assert_eq!((matched, source_only, target_only), (500, 500, 500));
+    }
+}
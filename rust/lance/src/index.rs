@@ -4,7 +4,7 @@
 //! Secondary Index
 //!
 
-use std::collections::HashMap;
+use std::collections::{BTreeMap, HashMap};
 use std::sync::Arc;
 
 use arrow_schema::DataType;
@@ -20,6 +20,7 @@ use lance_index::scalar::ScalarIndex;
 use lance_index::vector::flat::index::{FlatIndex, FlatQuantizer};
 pub use lance_index::IndexParams;
 use lance_index::{pb, vector::VectorIndex, DatasetIndexExt, Index, IndexType, INDEX_FILE_NAME};
+use lance_io::object_store::ObjectStore;
 use lance_io::traits::Reader;
 use lance_io::utils::{
     read_last_block, read_message, read_message_from_buf, read_metadata_offset, read_version,
@@ -27,7 +28,10 @@ use lance_io::utils::{
 use lance_table::format::Index as IndexMetadata;
 use lance_table::format::{Fragment, SelfDescribingFileReader};
 use lance_table::io::manifest::read_manifest_indexes;
+use log::warn;
+use object_store::path::Path;
 use roaring::RoaringBitmap;
+use serde::{Deserialize, Serialize};
 use serde_json::json;
 use snafu::{location, Location};
 use tracing::instrument;
@@ -41,6 +45,7 @@ pub mod scalar;
 pub mod vector;
 
 use crate::dataset::index::LanceIndexStoreExt;
+pub use crate::index::cache::{CacheStats, IndexCacheStats};
 pub use crate::index::prefilter::{FilterLoader, PreFilter};
 
 use crate::dataset::transaction::{Operation, Transaction};
@@ -49,7 +54,10 @@ use crate::io::commit::commit_transaction;
 use crate::{dataset::Dataset, Error, Result};
 
 use self::append::merge_indices;
-use self::scalar::{build_scalar_index, LANCE_SCALAR_INDEX};
+use self::scalar::{
+    build_scalar_index, detect_scalar_index_type, ScalarIndexParams, ScalarIndexType,
+    LANCE_SCALAR_INDEX,
+};
 use self::vector::{build_vector_index, VectorIndexParams, LANCE_VECTOR_INDEX};
 
 /// Builds index.
@@ -121,12 +129,14 @@ pub(crate) async fn remap_index(
 
 #[derive(Debug)]
 pub struct ScalarIndexInfo {
-    indexed_columns: HashMap<String, DataType>,
+    indexed_columns: HashMap<String, (DataType, ScalarIndexType)>,
 }
 
 impl IndexInformationProvider for ScalarIndexInfo {
-    fn get_index(&self, col: &str) -> Option<&DataType> {
-        self.indexed_columns.get(col)
+    fn get_index(&self, col: &str) -> Option<(&DataType, ScalarIndexType)> {
+        self.indexed_columns
+            .get(col)
+            .map(|(data_type, index_type)| (data_type, *index_type))
     }
 }
 
@@ -194,9 +204,19 @@ impl DatasetIndexExt for Dataset {
         }
 
         let index_id = Uuid::new_v4();
+        // Scalar indices record their kind so it doesn't have to be detected when opening them
+        let mut recorded_type = None;
         match (index_type, params.index_name()) {
             (IndexType::Scalar, LANCE_SCALAR_INDEX) => {
-                build_scalar_index(self, column, &index_id.to_string()).await?;
+                let scalar_params = params
+                    .as_any()
+                    .downcast_ref::<ScalarIndexParams>()
+                    .ok_or_else(|| Error::Index {
+                        message: "Scalar index type must take a ScalarIndexParams".to_string(),
+                        location: location!(),
+                    })?;
+                build_scalar_index(self, column, &index_id.to_string(), scalar_params).await?;
+                recorded_type = Some(scalar_params.scalar_index_type.name().to_string());
             }
             (IndexType::Vector, LANCE_VECTOR_INDEX) => {
                 // Vector index params.
@@ -252,6 +272,7 @@ impl DatasetIndexExt for Dataset {
             fields: vec![field.id],
             dataset_version: self.manifest.version,
             fragment_bitmap: Some(self.get_fragments().iter().map(|f| f.id() as u32).collect()),
+            index_type: recorded_type,
         };
         let transaction = Transaction::new(
             self.manifest.version,
@@ -320,70 +341,8 @@ impl DatasetIndexExt for Dataset {
 
     #[instrument(skip_all)]
     async fn optimize_indices(&mut self, options: &OptimizeOptions) -> Result<()> {
-        let dataset = Arc::new(self.clone());
         let indices = self.load_indices().await?;
-
-        let name_to_indices = indices
-            .iter()
-            .map(|idx| (idx.name.clone(), idx))
-            .into_group_map();
-
-        let mut new_indices = vec![];
-        let mut removed_indices = vec![];
-        for deltas in name_to_indices.values() {
-            let Some((new_id, removed, mut new_frag_ids)) =
-                merge_indices(dataset.clone(), deltas.as_slice(), options).await?
-            else {
-                continue;
-            };
-            for removed_idx in removed.iter() {
-                new_frag_ids |= removed_idx.fragment_bitmap.as_ref().unwrap();
-            }
-
-            let last_idx = deltas.last().expect("Delte indices should not be empty");
-            let new_idx = IndexMetadata {
-                uuid: new_id,
-                name: last_idx.name.clone(), // Keep the same name
-                fields: last_idx.fields.clone(),
-                dataset_version: self.manifest.version,
-                fragment_bitmap: Some(new_frag_ids),
-            };
-            removed_indices.extend(removed.iter().map(|&idx| idx.clone()));
-            if deltas.len() > removed.len() {
-                new_indices.extend(
-                    deltas[0..(deltas.len() - removed.len())]
-                        .iter()
-                        .map(|&idx| idx.clone()),
-                );
-            }
-            new_indices.push(new_idx);
-        }
-
-        if new_indices.is_empty() {
-            return Ok(());
-        }
-
-        let transaction = Transaction::new(
-            self.manifest.version,
-            Operation::CreateIndex {
-                new_indices,
-                removed_indices,
-            },
-            None,
-        );
-
-        let new_manifest = commit_transaction(
-            self,
-            self.object_store(),
-            self.commit_handler.as_ref(),
-            &transaction,
-            &Default::default(),
-            &Default::default(),
-        )
-        .await?;
-
-        self.manifest = Arc::new(new_manifest);
-        Ok(())
+        optimize_index_deltas(self, indices.as_slice(), options).await
     }
 
     async fn index_statistics(&self, index_name: &str) -> Result<String> {
@@ -444,6 +403,223 @@ impl DatasetIndexExt for Dataset {
             location: location!(),
         })
     }
+    async fn prewarm_index(&self, index_name: &str) -> Result<()> {
+        let metadatas = self.load_indices_by_name(index_name).await?;
+        if metadatas.is_empty() {
+            return Err(Error::IndexNotFound {
+                identity: format!("name={}", index_name),
+                location: location!(),
+            });
+        }
+
+        let column = self
+            .schema()
+            .field_by_id(metadatas[0].fields[0])
+            .map(|f| f.name.as_str())
+            .ok_or(Error::IndexNotFound {
+                identity: index_name.to_string(),
+                location: location!(),
+            })?;
+
+        // Each delta index is opened, and its partitions loaded, concurrently
+        let loaded = stream::iter(metadatas.iter())
+            .map(|m| async move {
+                let uuid = m.uuid.to_string();
+                let num_partitions = prewarm_index_uuid(self, column, &uuid, None).await?;
+                Ok::<_, Error>((uuid, num_partitions))
+            })
+            .buffer_unordered(num_cpus::get())
+            .try_collect::<Vec<_>>()
+            .await?;
+        warn_if_not_cached(self, &format!("index {}", index_name), &loaded);
+        Ok(())
+    }
+}
+
+/// The indices, and index partitions, held in a session's index cache
+///
+/// A service can save the hot set when it stops (see [`Dataset::index_hot_set`]) and replay
+/// it when it starts (see [`Dataset::prewarm_index_hot_set`]) so that only the parts of the
+/// indices that queries actually used are loaded again.
+#[derive(Debug, Clone, Default, PartialEq, Eq, Serialize, Deserialize)]
+pub struct IndexHotSet {
+    /// The ids of the cached partitions of each index, by index uuid
+    ///
+    /// Indices that are not partitioned have no partition ids.
+    pub indices: BTreeMap<String, Vec<usize>>,
+}
+
+impl IndexHotSet {
+    /// Write the hot set, as JSON, to `path`
+    pub async fn save(&self, object_store: &ObjectStore, path: &Path) -> Result<()> {
+        let json = serde_json::to_vec(self).map_err(|e| Error::Internal {
+            message: format!("Failed to serialize index hot set: {}", e),
+            location: location!(),
+        })?;
+        object_store.put(path, &json).await
+    }
+
+    /// Read a hot set written by [`Self::save`]
+    pub async fn load(object_store: &ObjectStore, path: &Path) -> Result<Self> {
+        let reader = object_store.open(path).await?;
+        let json = reader.get_range(0..reader.size().await?).await?;
+        serde_json::from_slice(&json).map_err(|e| Error::InvalidInput {
+            source: format!("{} is not a valid index hot set: {}", path, e).into(),
+            location: location!(),
+        })
+    }
+}
+
+/// Merges the new data, and up to `options.num_indices_to_merge` deltas, into the given indices
+async fn optimize_index_deltas(
+    dataset: &mut Dataset,
+    indices: &[IndexMetadata],
+    options: &OptimizeOptions,
+) -> Result<()> {
+    let snapshot = Arc::new(dataset.clone());
+    let name_to_indices = indices
+        .iter()
+        .map(|idx| (idx.name.clone(), idx))
+        .into_group_map();
+
+    let mut new_indices = vec![];
+    let mut removed_indices = vec![];
+    for deltas in name_to_indices.values() {
+        let Some((new_id, removed, mut new_frag_ids)) =
+            merge_indices(snapshot.clone(), deltas.as_slice(), options).await?
+        else {
+            continue;
+        };
+        for removed_idx in removed.iter() {
+            new_frag_ids |= removed_idx.fragment_bitmap.as_ref().unwrap();
+        }
+
+        let last_idx = deltas.last().expect("Delte indices should not be empty");
+        let new_idx = IndexMetadata {
+            uuid: new_id,
+            name: last_idx.name.clone(), // Keep the same name
+            fields: last_idx.fields.clone(),
+            dataset_version: dataset.manifest.version,
+            fragment_bitmap: Some(new_frag_ids),
+            index_type: last_idx.index_type.clone(),
+        };
+        removed_indices.extend(removed.iter().map(|&idx| idx.clone()));
+        if deltas.len() > removed.len() {
+            new_indices.extend(
+                deltas[0..(deltas.len() - removed.len())]
+                    .iter()
+                    .map(|&idx| idx.clone()),
+            );
+        }
+        new_indices.push(new_idx);
+    }
+
+    if new_indices.is_empty() {
+        return Ok(());
+    }
+
+    let transaction = Transaction::new(
+        dataset.manifest.version,
+        Operation::CreateIndex {
+            new_indices,
+            removed_indices,
+        },
+        None,
+    );
+
+    let new_manifest = commit_transaction(
+        dataset,
+        dataset.object_store(),
+        dataset.commit_handler.as_ref(),
+        &transaction,
+        &Default::default(),
+        &Default::default(),
+    )
+    .await?;
+
+    dataset.manifest = Arc::new(new_manifest);
+    Ok(())
+}
+
+/// Open the index with the given uuid into the session cache, and load its partitions
+///
+/// All partitions are loaded if `partition_ids` is None.  Returns the number of partitions
+/// that were loaded.
+pub(crate) async fn prewarm_index_uuid(
+    dataset: &Dataset,
+    column: &str,
+    uuid: &str,
+    partition_ids: Option<&[usize]>,
+) -> Result<usize> {
+    let index_file = dataset.indices_dir().child(uuid).child(INDEX_FILE_NAME);
+    if dataset.object_store.exists(&index_file).await? {
+        let index = dataset.open_vector_index(column, uuid).await?;
+        match partition_ids {
+            Some(partition_ids) => {
+                index.prewarm_partitions(partition_ids).await?;
+                Ok(partition_ids.len())
+            }
+            None => {
+                index.prewarm().await?;
+                Ok(index.num_partitions())
+            }
+        }
+    } else {
+        dataset.open_scalar_index(column, uuid).await?;
+        Ok(0)
+    }
+}
+
+/// Adds the zones of newly appended fragments to every zone map index
+///
+/// A zone map only needs the min, max and null count of each new zone so, unlike the other
+/// indices, it is cheap enough to keep up to date on every append.  The update is committed
+/// as its own version right after the append.
+pub(crate) async fn update_zone_maps(dataset: &mut Dataset) -> Result<()> {
+    let mut zone_maps = Vec::new();
+    for index in dataset.load_indices().await?.iter() {
+        if detect_scalar_index_type(dataset, index).await? == Some(ScalarIndexType::ZoneMap)
+            && !dataset.unindexed_fragments(&index.name).await?.is_empty()
+        {
+            zone_maps.push(index.clone());
+        }
+    }
+    if zone_maps.is_empty() {
+        return Ok(());
+    }
+    optimize_index_deltas(dataset, &zone_maps, &OptimizeOptions::default()).await
+}
+
+/// Warn if fewer partitions than were loaded (by index uuid) stayed in the cache
+///
+/// The cache only admits an entry if it is expected to be used more often than the entry it
+/// evicts, so once the cache is full, prewarmed partitions are silently dropped.
+pub(crate) fn warn_if_not_cached(dataset: &Dataset, what: &str, loaded: &[(String, usize)]) {
+    let hot_set = dataset.session.index_cache.hot_set();
+    let num_loaded = loaded.iter().map(|(_, n)| n).sum::<usize>();
+    let num_cached = loaded
+        .iter()
+        .map(|(uuid, n)| {
+            hot_set
+                .get(uuid)
+                .map(|parts| parts.len())
+                .unwrap_or_default()
+                .min(*n)
+        })
+        .sum::<usize>();
+    if num_cached < num_loaded {
+        let capacity = dataset
+            .session
+            .index_cache
+            .vector_capacity()
+            .map(|capacity| format!("{} entries", capacity))
+            .unwrap_or_else(|| "its size in bytes".to_string());
+        warn!(
+            "Only {} of the {} partitions of {} fit in the index cache (limited to {}), \
+             increase the index cache size to keep them in memory",
+            num_cached, num_loaded, what, capacity
+        );
+    }
 }
 
 /// A trait for internal dataset utilities
@@ -564,7 +740,9 @@ impl DatasetIndexInternalExt for Dataset {
                     Arc::downgrade(&self.session),
                 )
                 .await?;
-                Ok(Arc::new(ivf))
+                let index: Arc<dyn VectorIndex> = Arc::new(ivf);
+                self.session.index_cache.insert_vector(uuid, index.clone());
+                Ok(index)
             }
 
             _ => Err(Error::Index {
@@ -578,14 +756,22 @@ impl DatasetIndexInternalExt for Dataset {
     async fn scalar_index_info(&self) -> Result<ScalarIndexInfo> {
         let indices = self.load_indices().await?;
         let schema = self.schema();
-        let indexed_fields = indices
-        .iter()
-        .filter(|idx| idx.fields.len() == 1)
-        .map(|idx| {
+        // The kind of index decides which filters it can be used for
+        let mut indexed_fields = Vec::with_capacity(indices.len());
+        for idx in indices.iter().filter(|idx| idx.fields.len() == 1) {
+            let Some(index_type) = detect_scalar_index_type(self, idx).await? else {
+                // Vector indices, and files we don't recognize, can't be used for filters
+                continue;
+            };
             let field = idx.fields[0];
-            let field = schema.field_by_id(field).ok_or_else(|| Error::Internal { message: format!("Index referenced a field with id {field} which did not exist in the schema"), location: location!() });
-            field.map(|field| (field.name.clone(), field.data_type()))
-        }).collect::<Result<Vec<_>>>()?;
+            let field = schema.field_by_id(field).ok_or_else(|| Error::Internal {
+                message: format!(
+                    "Index referenced a field with id {field} which did not exist in the schema"
+                ),
+                location: location!(),
+            })?;
+            indexed_fields.push((field.name.clone(), (field.data_type(), index_type)));
+        }
         let index_info_map = HashMap::from_iter(indexed_fields);
         Ok(ScalarIndexInfo {
             indexed_columns: index_info_map,
@@ -685,6 +871,80 @@ mod tests {
             .is_err());
     }
 
+    #[tokio::test]
+    async fn test_detect_scalar_index_type() {
+        const DIM: i32 = 8;
+        let schema = Arc::new(Schema::new(vec![
+            Field::new(
+                "v",
+                DataType::FixedSizeList(Arc::new(Field::new("item", DataType::Float32, true)), DIM),
+                true,
+            ),
+            Field::new("i", DataType::Int32, true),
+        ]));
+        let data = generate_random_array(512 * DIM as usize);
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![
+                Arc::new(FixedSizeListArray::try_new_from_values(data, DIM).unwrap()),
+                Arc::new(arrow_array::Int32Array::from_iter_values(0..512)),
+            ],
+        )
+        .unwrap();
+
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema.clone());
+        let mut dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+        let params = VectorIndexParams::ivf_pq(2, 8, 2, MetricType::L2, 2);
+        dataset
+            .create_index(&["v"], IndexType::Vector, None, &params, true)
+            .await
+            .unwrap();
+        dataset
+            .create_index(
+                &["i"],
+                IndexType::Scalar,
+                None,
+                &ScalarIndexParams::default(),
+                true,
+            )
+            .await
+            .unwrap();
+
+        // Only the scalar index can be used for filters
+        let info = dataset.scalar_index_info().await.unwrap();
+        assert!(info.get_index("v").is_none());
+        assert_eq!(info.get_index("i").unwrap().1, ScalarIndexType::BTree);
+
+        // Indices written by older versions don't record their kind, which is detected from
+        // their files.  Vector indices and files we don't recognize are not scalar indices.
+        let indices = dataset.load_indices().await.unwrap();
+        let unrecorded = |name: &str| {
+            let mut index = indices.iter().find(|idx| idx.name == name).unwrap().clone();
+            index.index_type = None;
+            index
+        };
+        assert_eq!(
+            detect_scalar_index_type(&dataset, &unrecorded("v_idx"))
+                .await
+                .unwrap(),
+            None
+        );
+        assert_eq!(
+            detect_scalar_index_type(&dataset, &unrecorded("i_idx"))
+                .await
+                .unwrap(),
+            Some(ScalarIndexType::BTree)
+        );
+        let mut unknown = unrecorded("i_idx");
+        unknown.uuid = Uuid::new_v4();
+        assert_eq!(
+            detect_scalar_index_type(&dataset, &unknown).await.unwrap(),
+            None
+        );
+    }
+
     #[tokio::test]
     async fn test_count_index_rows() {
         let test_dir = tempdir().unwrap();
@@ -842,6 +1102,87 @@ mod tests {
         assert_eq!(stats["num_indices"], 1);
     }
 
+    #[tokio::test]
+    async fn test_prewarm_index() {
+        let test_dir = tempdir().unwrap();
+        let dimensions = 16;
+        let field = Field::new(
+            "vec",
+            DataType::FixedSizeList(
+                Arc::new(Field::new("item", DataType::Float32, true)),
+                dimensions,
+            ),
+            false,
+        );
+        let schema = Arc::new(Schema::new(vec![field]));
+        let float_arr = generate_random_array(512 * dimensions as usize);
+        let vectors =
+            arrow_array::FixedSizeListArray::try_new_from_values(float_arr, dimensions).unwrap();
+        let record_batch = RecordBatch::try_new(schema.clone(), vec![Arc::new(vectors)]).unwrap();
+        let reader = RecordBatchIterator::new(vec![record_batch].into_iter().map(Ok), schema);
+
+        let test_uri = test_dir.path().to_str().unwrap();
+        let mut dataset = Dataset::write(reader, test_uri, None).await.unwrap();
+        let params = VectorIndexParams::ivf_pq(10, 8, 2, MetricType::L2, 10);
+        dataset
+            .create_index(
+                &["vec"],
+                IndexType::Vector,
+                Some("vec_idx".into()),
+                &params,
+                true,
+            )
+            .await
+            .unwrap();
+
+        // A fresh session has nothing cached
+        let dataset = DatasetBuilder::from_uri(test_uri).load().await.unwrap();
+        assert_eq!(dataset.index_cache_stats().vector.entry_count, 0);
+
+        dataset.prewarm_index("vec_idx").await.unwrap();
+        // The IVF index itself and each of its 10 partitions
+        assert_eq!(dataset.index_cache_stats().vector.entry_count, 11);
+
+        assert!(matches!(
+            dataset.prewarm_index("missing").await,
+            Err(Error::IndexNotFound { .. })
+        ));
+
+        // Only the partitions that a query used are in the hot set
+        let dataset = DatasetBuilder::from_uri(test_uri).load().await.unwrap();
+        let query = generate_random_array(dimensions as usize);
+        let mut scan = dataset.scan();
+        scan.nearest("vec", &query, 5).unwrap().nprobs(2);
+        scan.try_into_batch().await.unwrap();
+        let hot_set = dataset.index_hot_set().await.unwrap();
+        assert_eq!(hot_set.indices.len(), 1);
+        assert_eq!(hot_set.indices.values().next().unwrap().len(), 2);
+
+        // The hot set survives a round trip through storage and is replayed in a new session
+        let hot_set_path =
+            Path::from_filesystem_path(test_dir.path().join("hot_set.json")).unwrap();
+        hot_set
+            .save(&dataset.object_store, &hot_set_path)
+            .await
+            .unwrap();
+        let hot_set = IndexHotSet::load(&dataset.object_store, &hot_set_path)
+            .await
+            .unwrap();
+        let dataset = DatasetBuilder::from_uri(test_uri).load().await.unwrap();
+        dataset.prewarm_index_hot_set(&hot_set).await.unwrap();
+        assert_eq!(dataset.index_cache_stats().vector.entry_count, 3);
+        assert_eq!(dataset.index_hot_set().await.unwrap(), hot_set);
+
+        // Prewarming an index that does not fit in the cache keeps part of it
+        let dataset = DatasetBuilder::from_uri(test_uri)
+            .with_index_cache_size(4)
+            .load()
+            .await
+            .unwrap();
+        dataset.prewarm_index("vec_idx").await.unwrap();
+        assert!(dataset.index_cache_stats().vector.entry_count <= 4);
+    }
+
     #[tokio::test]
     async fn test_optimize_ivf_hnsw_sq_delta_indices() {
         let test_dir = tempdir().unwrap();
@@ -6,6 +6,7 @@ use std::sync::Arc;
 use lance_core::{Error, Result};
 use lance_index::optimize::OptimizeOptions;
 use lance_index::scalar::lance_format::LanceIndexStore;
+use lance_index::scalar::zonemap::ZoneMapIndex;
 use lance_index::IndexType;
 use lance_table::format::Index as IndexMetadata;
 use roaring::RoaringBitmap;
@@ -88,10 +89,13 @@ pub async fn merge_indices<'a>(
             scanner
                 .with_fragments(unindexed)
                 .with_row_id()
-                .order_by(Some(vec![ColumnOrdering::asc_nulls_first(
-                    column.name.clone(),
-                )]))?
                 .project(&[&column.name])?;
+            // Zone maps summarize runs of consecutive rows, sorting would only break them up
+            if index.as_any().downcast_ref::<ZoneMapIndex>().is_none() {
+                scanner.order_by(Some(vec![ColumnOrdering::asc_nulls_first(
+                    column.name.clone(),
+                )]))?;
+            }
             let new_data_stream = scanner.try_into_stream().await?;
 
             let new_uuid = Uuid::new_v4();
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
+use std::collections::{BTreeMap, BTreeSet};
+use std::sync::atomic::{AtomicU64, Ordering};
 use std::sync::Arc;
 
 use deepsize::DeepSizeOf;
@@ -8,15 +10,16 @@ use lance_index::{scalar::ScalarIndex, vector::VectorIndex};
 use lance_table::format::Index;
 use moka::sync::{Cache, ConcurrentCacheExt};
 
-use std::sync::atomic::{AtomicU64, Ordering};
+use super::scalar::ScalarIndexType;
 
-#[derive(Debug, Default, DeepSizeOf)]
-struct CacheStats {
+#[derive(Debug, Default)]
+struct CacheCounters {
     hits: AtomicU64,
     misses: AtomicU64,
+    evictions: AtomicU64,
 }
 
-impl CacheStats {
+impl CacheCounters {
     fn record_hit(&self) {
         self.hits.fetch_add(1, Ordering::Relaxed);
     }
@@ -24,13 +27,100 @@ impl CacheStats {
     fn record_miss(&self) {
         self.misses.fetch_add(1, Ordering::Relaxed);
     }
+
+    fn record_eviction(&self) {
+        self.evictions.fetch_add(1, Ordering::Relaxed);
+    }
+
+    fn snapshot(&self, entry_count: u64, size_bytes: u64) -> CacheStats {
+        CacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            entry_count,
+            size_bytes,
+        }
+    }
+}
+
+/// The counters of each kind of entry
+#[derive(Default)]
+struct Counters {
+    scalar: Arc<CacheCounters>,
+    vector: Arc<CacheCounters>,
+    metadata: Arc<CacheCounters>,
+}
+
+/// Statistics for one kind of entry in the index cache
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct CacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    /// Entries removed to make room for other entries
+    pub evictions: u64,
+    pub entry_count: u64,
+    pub size_bytes: u64,
+}
+
+impl CacheStats {
+    /// The fraction of lookups that were hits, 1.0 if there were no lookups
+    pub fn hit_rate(&self) -> f32 {
+        let lookups = self.hits + self.misses;
+        if lookups == 0 {
+            1.0
+        } else {
+            self.hits as f32 / lookups as f32
+        }
+    }
 }
 
+/// Statistics for the index cache, by kind of entry
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct IndexCacheStats {
+    /// Opened scalar indices
+    pub scalar: CacheStats,
+    /// Opened vector indices and vector index partitions
+    pub vector: CacheStats,
+    /// Index metadata for each dataset version
+    pub metadata: CacheStats,
+}
+
+#[derive(Clone)]
+enum CachedIndex {
+    Scalar(Arc<dyn ScalarIndex>),
+    Vector(Arc<dyn VectorIndex>),
+}
+
+impl CachedIndex {
+    fn size_bytes(&self) -> usize {
+        match self {
+            Self::Scalar(index) => index.deep_size_of(),
+            Self::Vector(index) => index.deep_size_of(),
+        }
+    }
+}
+
+/// Entries of a byte budgeted cache are weighed in KiB so that entries over 4 GiB still fit
+/// in moka's u32 weights (up to 4 TiB)
+const WEIGHT_UNIT_BYTES: usize = 1024;
+
+/// The cache for opened indices
+///
+/// The budget is either a number of entries or, with [`IndexCache::with_capacity_bytes`], a
+/// number of bytes where each entry is weighed by its deep size.  With an entry budget scalar
+/// and vector indices are kept in separate caches, each holding up to that many entries, so
+/// that opening many small scalar indices can't push out vector partitions (or vice versa).
+/// With a byte budget they share one cache: entries vary from tiny btree lookups to multi-GB
+/// IVF partitions and a single byte budget gives much more predictable memory use.
+///
+/// The caches use a TinyLFU admission policy with LRU eviction: a new entry is only admitted
+/// if it is estimated to be accessed more often than the entry it would evict.  A single large
+/// scan that touches many partitions once therefore can't flush the frequently used ones.
 #[derive(Clone)]
 pub struct IndexCache {
-    // TODO: Can we merge these two caches into one for uniform memory management?
-    scalar_cache: Arc<Cache<String, Arc<dyn ScalarIndex>>>,
-    vector_cache: Arc<Cache<String, Arc<dyn VectorIndex>>>,
+    scalar_cache: Arc<Cache<String, CachedIndex>>,
+    /// The same cache as `scalar_cache` if the budget is in bytes
+    vector_cache: Arc<Cache<String, CachedIndex>>,
 
     /// Index metadata cache.
     ///
@@ -38,82 +128,232 @@ pub struct IndexCache {
     /// Value is all the indies of a particular version of the dataset.
     metadata_cache: Arc<Cache<String, Arc<Vec<Index>>>>,
 
-    cache_stats: Arc<CacheStats>,
+    /// The type of each scalar index, keyed by index uuid.
+    ///
+    /// Index files are immutable so the type never changes.  These entries are tiny and
+    /// are not counted in the cache size or statistics.
+    scalar_type_cache: Arc<Cache<String, Option<ScalarIndexType>>>,
+
+    scalar_counters: Arc<CacheCounters>,
+    vector_counters: Arc<CacheCounters>,
+    metadata_counters: Arc<CacheCounters>,
 }
 
 impl DeepSizeOf for IndexCache {
     fn deep_size_of_children(&self, context: &mut deepsize::Context) -> usize {
-        self.scalar_cache
-            .iter()
-            .map(|(_, v)| v.deep_size_of_children(context))
+        self.index_caches()
+            .flat_map(|cache| cache.iter())
+            .map(|(_, v)| match v {
+                CachedIndex::Scalar(index) => index.deep_size_of_children(context),
+                CachedIndex::Vector(index) => index.deep_size_of_children(context),
+            })
             .sum::<usize>()
-            + self
-                .vector_cache
-                .iter()
-                .map(|(_, v)| v.deep_size_of_children(context))
-                .sum::<usize>()
             + self
                 .metadata_cache
                 .iter()
                 .map(|(_, v)| v.deep_size_of_children(context))
                 .sum::<usize>()
-            + self.cache_stats.deep_size_of_children(context)
     }
 }
 
 impl IndexCache {
+    /// Create a cache that holds up to `capacity` scalar indices and `capacity` vector indices
+    /// (or partitions)
+    ///
+    /// Index metadata is kept for up to `capacity` dataset versions.
     pub(crate) fn new(capacity: usize) -> Self {
+        let counters = Counters::default();
+        let scalar_cache = Arc::new(Self::build_index_cache(capacity, false, &counters));
+        let vector_cache = Arc::new(Self::build_index_cache(capacity, false, &counters));
+        Self::build(scalar_cache, vector_cache, capacity, counters)
+    }
+
+    /// Create a cache that holds indices with a total size of up to `capacity_bytes`
+    ///
+    /// Index metadata is kept for up to `metadata_capacity` dataset versions.
+    pub(crate) fn with_capacity_bytes(capacity_bytes: usize, metadata_capacity: usize) -> Self {
+        let counters = Counters::default();
+        let index_cache = Arc::new(Self::build_index_cache(capacity_bytes, true, &counters));
+        Self::build(
+            index_cache.clone(),
+            index_cache,
+            metadata_capacity,
+            counters,
+        )
+    }
+
+    fn build_index_cache(
+        capacity: usize,
+        weigh_by_size: bool,
+        counters: &Counters,
+    ) -> Cache<String, CachedIndex> {
+        let eviction_counters = (counters.scalar.clone(), counters.vector.clone());
+        let max_capacity = if weigh_by_size {
+            capacity.div_ceil(WEIGHT_UNIT_BYTES)
+        } else {
+            capacity
+        };
+        let builder = Cache::builder()
+            .max_capacity(max_capacity as u64)
+            .eviction_listener(move |_, value: CachedIndex, cause| {
+                if cause.was_evicted() {
+                    match value {
+                        CachedIndex::Scalar(_) => eviction_counters.0.record_eviction(),
+                        CachedIndex::Vector(_) => eviction_counters.1.record_eviction(),
+                    }
+                }
+            });
+        if weigh_by_size {
+            builder
+                .weigher(|_, value: &CachedIndex| {
+                    u32::try_from(value.size_bytes().div_ceil(WEIGHT_UNIT_BYTES))
+                        .unwrap_or(u32::MAX)
+                })
+                .build()
+        } else {
+            builder.build()
+        }
+    }
+
+    fn build(
+        scalar_cache: Arc<Cache<String, CachedIndex>>,
+        vector_cache: Arc<Cache<String, CachedIndex>>,
+        metadata_capacity: usize,
+        counters: Counters,
+    ) -> Self {
+        let metadata_counters = counters.metadata.clone();
+        let metadata_cache = Cache::builder()
+            .max_capacity(metadata_capacity as u64)
+            .eviction_listener(move |_, _, cause| {
+                if cause.was_evicted() {
+                    metadata_counters.record_eviction();
+                }
+            })
+            .build();
+
         Self {
-            scalar_cache: Arc::new(Cache::new(capacity as u64)),
-            vector_cache: Arc::new(Cache::new(capacity as u64)),
-            metadata_cache: Arc::new(Cache::new(capacity as u64)),
-            cache_stats: Arc::new(CacheStats::default()),
+            scalar_cache,
+            vector_cache,
+            metadata_cache: Arc::new(metadata_cache),
+            scalar_type_cache: Arc::new(Cache::new(metadata_capacity as u64)),
+            scalar_counters: counters.scalar,
+            vector_counters: counters.vector,
+            metadata_counters: counters.metadata,
         }
     }
 
+    /// The number of dataset versions whose index metadata can be cached
+    pub(crate) fn metadata_capacity(&self) -> usize {
+        self.metadata_cache
+            .policy()
+            .max_capacity()
+            .unwrap_or_default() as usize
+    }
+
+    /// The maximum number of vector indices and partitions, None if the budget is in bytes
+    pub(crate) fn vector_capacity(&self) -> Option<usize> {
+        if Arc::ptr_eq(&self.scalar_cache, &self.vector_cache) {
+            None
+        } else {
+            self.vector_cache
+                .policy()
+                .max_capacity()
+                .map(|capacity| capacity as usize)
+        }
+    }
+
+    /// The uuids of the cached indices, each with the ids of its cached partitions
+    ///
+    /// Partitions are cached either as entries of their own ("{uuid}-ivf-{id}") or by the
+    /// index itself.  This does not count as a lookup.
+    pub(crate) fn hot_set(&self) -> BTreeMap<String, BTreeSet<usize>> {
+        let mut hot_set = BTreeMap::<String, BTreeSet<usize>>::new();
+        for (key, value) in self.index_caches().flat_map(|cache| cache.iter()) {
+            let partition = key
+                .rsplit_once("-ivf-")
+                .and_then(|(uuid, id)| Some((uuid, id.parse::<usize>().ok()?)));
+            if let Some((uuid, partition_id)) = partition {
+                hot_set
+                    .entry(uuid.to_string())
+                    .or_default()
+                    .insert(partition_id);
+            } else {
+                let partitions = hot_set.entry(key.to_string()).or_default();
+                if let CachedIndex::Vector(index) = value {
+                    partitions.extend(index.cached_partitions());
+                }
+            }
+        }
+        hot_set
+    }
+
+    /// The distinct caches that hold opened indices
+    fn index_caches(&self) -> impl Iterator<Item = &Cache<String, CachedIndex>> {
+        let shared = Arc::ptr_eq(&self.scalar_cache, &self.vector_cache);
+        std::iter::once(self.scalar_cache.as_ref())
+            .chain((!shared).then_some(self.vector_cache.as_ref()))
+    }
+
     #[allow(dead_code)]
     pub(crate) fn len_vector(&self) -> usize {
         self.vector_cache.sync();
-        self.vector_cache.entry_count() as usize
+        self.vector_cache
+            .iter()
+            .filter(|(_, v)| matches!(v, CachedIndex::Vector(_)))
+            .count()
     }
 
     pub(crate) fn get_size(&self) -> usize {
-        self.scalar_cache.sync();
-        self.vector_cache.sync();
         self.metadata_cache.sync();
-        (self.scalar_cache.entry_count()
-            + self.vector_cache.entry_count()
-            + self.metadata_cache.entry_count()) as usize
+        let index_entries = self
+            .index_caches()
+            .map(|cache| {
+                cache.sync();
+                cache.entry_count()
+            })
+            .sum::<u64>();
+        (index_entries + self.metadata_cache.entry_count()) as usize
     }
 
     /// Get an Index if present. Otherwise returns [None].
     pub(crate) fn get_scalar(&self, key: &str) -> Option<Arc<dyn ScalarIndex>> {
-        if let Some(index) = self.scalar_cache.get(key) {
-            self.cache_stats.record_hit();
+        if let Some(CachedIndex::Scalar(index)) = self.scalar_cache.get(key) {
+            self.scalar_counters.record_hit();
             Some(index)
         } else {
-            self.cache_stats.record_miss();
+            self.scalar_counters.record_miss();
             None
         }
     }
 
     pub(crate) fn get_vector(&self, key: &str) -> Option<Arc<dyn VectorIndex>> {
-        if let Some(index) = self.vector_cache.get(key) {
-            self.cache_stats.record_hit();
+        if let Some(CachedIndex::Vector(index)) = self.vector_cache.get(key) {
+            self.vector_counters.record_hit();
             Some(index)
         } else {
-            self.cache_stats.record_miss();
+            self.vector_counters.record_miss();
             None
         }
     }
 
     /// Insert a new entry into the cache.
     pub(crate) fn insert_scalar(&self, key: &str, index: Arc<dyn ScalarIndex>) {
-        self.scalar_cache.insert(key.to_string(), index);
+        self.scalar_cache
+            .insert(key.to_string(), CachedIndex::Scalar(index));
     }
 
     pub(crate) fn insert_vector(&self, key: &str, index: Arc<dyn VectorIndex>) {
-        self.vector_cache.insert(key.to_string(), index);
+        self.vector_cache
+            .insert(key.to_string(), CachedIndex::Vector(index));
+    }
+
+    /// The detected kind of an index, `Some(None)` if it is known not to be a scalar index
+    pub(crate) fn get_scalar_type(&self, key: &str) -> Option<Option<ScalarIndexType>> {
+        self.scalar_type_cache.get(key)
+    }
+
+    pub(crate) fn insert_scalar_type(&self, key: &str, index_type: Option<ScalarIndexType>) {
+        self.scalar_type_cache.insert(key.to_string(), index_type);
     }
 
     /// Construct a key for index metadata arrays.
@@ -125,10 +365,10 @@ impl IndexCache {
     pub(crate) fn get_metadata(&self, key: &str, version: u64) -> Option<Arc<Vec<Index>>> {
         let key = Self::metadata_key(key, version);
         if let Some(indices) = self.metadata_cache.get(&key) {
-            self.cache_stats.record_hit();
+            self.metadata_counters.record_hit();
             Some(indices)
         } else {
-            self.cache_stats.record_miss();
+            self.metadata_counters.record_miss();
             None
         }
     }
@@ -139,16 +379,64 @@ impl IndexCache {
         self.metadata_cache.insert(key, indices);
     }
 
+    /// Get the hit, miss and eviction counts and current size of each kind of entry
+    pub(crate) fn stats(&self) -> IndexCacheStats {
+        self.metadata_cache.sync();
+        let (mut scalar_entries, mut scalar_bytes) = (0, 0);
+        let (mut vector_entries, mut vector_bytes) = (0, 0);
+        for (_, value) in self.index_caches().flat_map(|cache| {
+            cache.sync();
+            cache.iter()
+        }) {
+            let size_bytes = value.size_bytes() as u64;
+            match value {
+                CachedIndex::Scalar(_) => {
+                    scalar_entries += 1;
+                    scalar_bytes += size_bytes;
+                }
+                CachedIndex::Vector(_) => {
+                    vector_entries += 1;
+                    vector_bytes += size_bytes;
+                }
+            }
+        }
+        let metadata_bytes = self
+            .metadata_cache
+            .iter()
+            .map(|(_, v)| v.deep_size_of() as u64)
+            .sum();
+        IndexCacheStats {
+            scalar: self.scalar_counters.snapshot(scalar_entries, scalar_bytes),
+            vector: self.vector_counters.snapshot(vector_entries, vector_bytes),
+            metadata: self
+                .metadata_counters
+                .snapshot(self.metadata_cache.entry_count(), metadata_bytes),
+        }
+    }
+
     /// Get cache hit ratio.
+    ///
+    /// This only reads the counters, unlike [`Self::stats`] it does not visit the entries.
     #[allow(dead_code)]
     pub(crate) fn hit_rate(&self) -> f32 {
-        let hits = self.cache_stats.hits.load(Ordering::Relaxed) as f32;
-        let misses = self.cache_stats.misses.load(Ordering::Relaxed) as f32;
+        let counters = [
+            &self.scalar_counters,
+            &self.vector_counters,
+            &self.metadata_counters,
+        ];
+        let hits = counters
+            .iter()
+            .map(|counters| counters.hits.load(Ordering::Relaxed))
+            .sum::<u64>();
+        let misses = counters
+            .iter()
+            .map(|counters| counters.misses.load(Ordering::Relaxed))
+            .sum::<u64>();
         // Returns 1.0 if hits + misses == 0 and avoids division by zero.
-        if (hits + misses) == 0.0 {
+        if (hits + misses) == 0 {
             1.0
         } else {
-            hits / (hits + misses)
+            hits as f32 / (hits + misses) as f32
         }
     }
 }
@@ -150,6 +150,19 @@ impl DatasetPreFilter {
     }
 }
 
+impl DatasetPreFilter {
+    /// Runs `f` with the combined filter and deletion mask
+    ///
+    /// This is cheaper than `filter_row_ids` when row ids are checked one at a time.  This
+    /// method must be called after `wait_for_ready`
+    pub fn with_mask<R>(&self, f: impl FnOnce(&RowIdMask) -> R) -> R {
+        let final_mask = self.final_mask.lock().unwrap();
+        f(final_mask
+            .get()
+            .expect("with_mask called without call to wait_for_ready"))
+    }
+}
+
 #[async_trait]
 impl PreFilter for DatasetPreFilter {
     /// Waits for the prefilter to be fully loaded
@@ -6,18 +6,28 @@
 
 use std::sync::Arc;
 
+use arrow_schema::DataType;
 use async_trait::async_trait;
 use datafusion::physical_plan::SendableRecordBatchStream;
 use lance_datafusion::{chunker::chunk_concat_stream, exec::LanceExecutionOptions};
 use lance_index::{
     scalar::{
-        btree::{train_btree_index, BTreeIndex, BtreeTrainingSource},
+        bitmap::{train_bitmap_index, BitmapIndex, BITMAP_LOOKUP_NAME},
+        btree::{
+            train_btree_index_with_options, BTreeIndex, BTreeTrainingOptions, BtreeTrainingSource,
+            BTREE_LOOKUP_NAME,
+        },
         flat::FlatIndexMetadata,
+        inverted::{train_inverted_index, InvertedIndex, INVERTED_POSTINGS_NAME},
+        label_list::{train_label_list_index, LabelListIndex, LABEL_LIST_LOOKUP_NAME},
         lance_format::LanceIndexStore,
+        ngram::{train_ngram_index, NGramIndex, NGRAM_POSTINGS_NAME},
+        zonemap::{train_zone_map_index, ZoneMapIndex, ZONEMAP_NAME},
         ScalarIndex,
     },
-    IndexType,
+    DatasetIndexExt, IndexType, INDEX_FILE_NAME,
 };
+use lance_table::format::Index;
 use snafu::{location, Location};
 use tracing::instrument;
 
@@ -32,8 +42,31 @@ use super::IndexParams;
 
 pub const LANCE_SCALAR_INDEX: &str = "__lance_scalar_index";
 
+pub use lance_index::scalar::ScalarIndexType;
+
 #[derive(Default)]
-pub struct ScalarIndexParams {}
+pub struct ScalarIndexParams {
+    /// The kind of scalar index to build
+    pub scalar_index_type: ScalarIndexType,
+    /// Store a bloom filter per page so point lookups can skip pages without the value
+    ///
+    /// Only used by btree indices.  Costs a little over one byte of memory per row.
+    pub bloom_filters: bool,
+}
+
+impl ScalarIndexParams {
+    pub fn new(scalar_index_type: ScalarIndexType) -> Self {
+        Self {
+            scalar_index_type,
+            ..Default::default()
+        }
+    }
+
+    pub fn with_bloom_filters(mut self, bloom_filters: bool) -> Self {
+        self.bloom_filters = bloom_filters;
+        self
+    }
+}
 
 impl IndexParams for ScalarIndexParams {
     fn as_any(&self) -> &dyn std::any::Any {
@@ -78,9 +111,39 @@ impl BtreeTrainingSource for TrainingRequest {
     }
 }
 
-/// Build a Vector Index
-#[instrument(level = "debug", skip(dataset))]
-pub async fn build_scalar_index(dataset: &Dataset, column: &str, uuid: &str) -> Result<()> {
+impl TrainingRequest {
+    /// Scans the values and row ids in whatever order is cheapest
+    async fn scan_unordered(self: Box<Self>) -> Result<SendableRecordBatchStream> {
+        let mut scan = self.dataset.scan();
+        let scan = scan.with_row_id().project(&[&self.column])?;
+        scan.try_into_dfstream(LanceExecutionOptions::default())
+            .await
+    }
+}
+
+fn require_string_column(column: &str, data_type: &DataType, index_desc: &str) -> Result<()> {
+    if matches!(data_type, DataType::Utf8 | DataType::LargeUtf8) {
+        Ok(())
+    } else {
+        Err(Error::InvalidInput {
+            source: format!(
+                "{} index can only be created on a string column, {} is {}",
+                index_desc, column, data_type
+            )
+            .into(),
+            location: location!(),
+        })
+    }
+}
+
+/// Build a Scalar Index
+#[instrument(level = "debug", skip(dataset, params))]
+pub async fn build_scalar_index(
+    dataset: &Dataset,
+    column: &str,
+    uuid: &str,
+    params: &ScalarIndexParams,
+) -> Result<()> {
     let training_request = Box::new(TrainingRequest {
         dataset: Arc::new(dataset.clone()),
         column: column.to_string(),
@@ -91,21 +154,163 @@ pub async fn build_scalar_index(dataset: &Dataset, column: &str, uuid: &str) ->
     })?;
     // In theory it should be possible to create a scalar index (e.g. btree) on a nested field but
     // performance would be poor and I'm not sure we want to allow that unless there is a need.
-    if field.data_type().is_nested() {
+    // Label list indices are the exception, they index the (non-nested) items of a list field.
+    let indexed_type = match (params.scalar_index_type, field.data_type()) {
+        (ScalarIndexType::LabelList, DataType::List(item) | DataType::LargeList(item)) => {
+            item.data_type().clone()
+        }
+        (ScalarIndexType::LabelList, data_type) => {
+            return Err(Error::InvalidInput {
+                source: format!(
+                    "A label list index can only be created on a list column, {} is {}",
+                    column, data_type
+                )
+                .into(),
+                location: location!(),
+            });
+        }
+        (_, data_type) => data_type,
+    };
+    if indexed_type.is_nested() {
         return Err(Error::InvalidInput {
             source: "A scalar index can only be created on a non-nested field.".into(),
             location: location!(),
         });
     }
-    let flat_index_trainer = FlatIndexMetadata::new(field.data_type());
     let index_store = LanceIndexStore::from_dataset(dataset, uuid);
-    train_btree_index(training_request, &flat_index_trainer, &index_store).await
+    match params.scalar_index_type {
+        ScalarIndexType::BTree => {
+            let flat_index_trainer = FlatIndexMetadata::new(field.data_type());
+            let options = BTreeTrainingOptions {
+                bloom_filters: params.bloom_filters,
+            };
+            train_btree_index_with_options(
+                training_request,
+                &flat_index_trainer,
+                &index_store,
+                &options,
+            )
+            .await
+        }
+        ScalarIndexType::Bitmap => {
+            let data = training_request.scan_unordered().await?;
+            train_bitmap_index(data, &index_store).await
+        }
+        ScalarIndexType::Inverted => {
+            require_string_column(column, &field.data_type(), "An inverted")?;
+            let data = training_request.scan_unordered().await?;
+            train_inverted_index(data, &index_store).await
+        }
+        ScalarIndexType::NGram => {
+            require_string_column(column, &field.data_type(), "An ngram")?;
+            let data = training_request.scan_unordered().await?;
+            train_ngram_index(data, &index_store).await
+        }
+        ScalarIndexType::LabelList => {
+            let data = training_request.scan_unordered().await?;
+            train_label_list_index(data, &index_store).await
+        }
+        ScalarIndexType::ZoneMap => {
+            let data = training_request.scan_unordered().await?;
+            train_zone_map_index(data, &index_store).await
+        }
+    }
+}
+
+/// Determines the kind of a scalar index, or `None` if `index` is not a scalar index
+///
+/// The kind is recorded in the index metadata when the index is created.  Indices written
+/// by older versions don't record it, so it is detected from the files in the index
+/// directory.  Vector indices (and legacy indices) write an [`INDEX_FILE_NAME`] file, which
+/// is checked first.  Otherwise each kind of scalar index writes a differently named lookup
+/// file.  The result is cached, so the files are only probed once per index.
+pub async fn detect_scalar_index_type(
+    dataset: &Dataset,
+    index: &Index,
+) -> Result<Option<ScalarIndexType>> {
+    if let Some(name) = index.index_type.as_deref() {
+        return Ok(ScalarIndexType::from_name(name));
+    }
+    let uuid = index.uuid.to_string();
+    if let Some(index_type) = dataset.session.index_cache.get_scalar_type(&uuid) {
+        return Ok(index_type);
+    }
+    let index_type = probe_scalar_index_type(dataset, &uuid).await?;
+    dataset
+        .session
+        .index_cache
+        .insert_scalar_type(&uuid, index_type);
+    Ok(index_type)
+}
+
+async fn probe_scalar_index_type(dataset: &Dataset, uuid: &str) -> Result<Option<ScalarIndexType>> {
+    let index_dir = dataset.indices_dir().child(uuid);
+    if dataset
+        .object_store
+        .exists(&index_dir.child(INDEX_FILE_NAME))
+        .await?
+    {
+        return Ok(None);
+    }
+    for (lookup_name, candidate) in [
+        (BTREE_LOOKUP_NAME, ScalarIndexType::BTree),
+        (BITMAP_LOOKUP_NAME, ScalarIndexType::Bitmap),
+        (INVERTED_POSTINGS_NAME, ScalarIndexType::Inverted),
+        (NGRAM_POSTINGS_NAME, ScalarIndexType::NGram),
+        (LABEL_LIST_LOOKUP_NAME, ScalarIndexType::LabelList),
+        (ZONEMAP_NAME, ScalarIndexType::ZoneMap),
+    ] {
+        if dataset
+            .object_store
+            .exists(&index_dir.child(lookup_name))
+            .await?
+        {
+            return Ok(Some(candidate));
+        }
+    }
+    Ok(None)
 }
 
 pub async fn open_scalar_index(dataset: &Dataset, uuid: &str) -> Result<Arc<dyn ScalarIndex>> {
+    let indices = dataset.load_indices().await?;
+    let index = indices
+        .iter()
+        .find(|idx| idx.uuid.to_string() == uuid)
+        .ok_or_else(|| Error::Index {
+            message: format!("Index with id {} does not exist", uuid),
+            location: location!(),
+        })?;
+    let index_type = detect_scalar_index_type(dataset, index)
+        .await?
+        .ok_or_else(|| Error::Index {
+            message: format!("Index {} ({}) is not a scalar index", index.name, uuid),
+            location: location!(),
+        })?;
     let index_store = Arc::new(LanceIndexStore::from_dataset(dataset, uuid));
-    // Currently we assume all scalar indices are btree indices.  In the future, if this is not the
-    // case, we may need to store a metadata file in the index directory with scalar index metadata
-    let btree_index = BTreeIndex::load(index_store).await?;
-    Ok(btree_index as Arc<dyn ScalarIndex>)
+    match index_type {
+        ScalarIndexType::BTree => {
+            let btree_index = BTreeIndex::load(index_store).await?;
+            Ok(btree_index as Arc<dyn ScalarIndex>)
+        }
+        ScalarIndexType::Bitmap => {
+            let bitmap_index = BitmapIndex::load(index_store).await?;
+            Ok(bitmap_index as Arc<dyn ScalarIndex>)
+        }
+        ScalarIndexType::Inverted => {
+            let inverted_index = InvertedIndex::load(index_store).await?;
+            Ok(inverted_index as Arc<dyn ScalarIndex>)
+        }
+        ScalarIndexType::NGram => {
+            let ngram_index = NGramIndex::load(index_store).await?;
+            Ok(ngram_index as Arc<dyn ScalarIndex>)
+        }
+        ScalarIndexType::LabelList => {
+            let label_list_index = LabelListIndex::load(index_store).await?;
+            Ok(label_list_index as Arc<dyn ScalarIndex>)
+        }
+        ScalarIndexType::ZoneMap => {
+            let zone_map_index = ZoneMapIndex::load(index_store).await?;
+            Ok(zone_map_index as Arc<dyn ScalarIndex>)
+        }
+    }
 }
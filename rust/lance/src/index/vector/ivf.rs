@@ -241,6 +241,24 @@ impl IVFIndex {
     }
 }
 
+/// Loads (and so caches) the given partitions of an IVF index with `load`
+///
+/// Shared by the IVF index implementations so they prewarm with the same concurrency.
+pub(crate) async fn load_partitions<T, Fut>(
+    partition_ids: &[usize],
+    load: impl Fn(usize) -> Fut,
+) -> Result<()>
+where
+    Fut: std::future::Future<Output = Result<T>>,
+{
+    // Partition loads are dominated by I/O so we allow more than one per core
+    stream::iter(partition_ids.iter().copied())
+        .map(load)
+        .buffer_unordered(num_cpus::get() * 4)
+        .try_for_each(|_| futures::future::ready(Ok(())))
+        .await
+}
+
 impl std::fmt::Debug for IVFIndex {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         write!(f, "Ivf({}) -> {:?}", self.metric_type, self.sub_index)
@@ -736,6 +754,14 @@ impl VectorIndex for IVFIndex {
         })
     }
 
+    async fn prewarm_partitions(&self, partition_ids: &[usize]) -> Result<()> {
+        load_partitions(partition_ids, |part_id| self.load_partition(part_id, true)).await
+    }
+
+    fn num_partitions(&self) -> usize {
+        self.ivf.num_partitions()
+    }
+
     fn row_ids(&self) -> Box<dyn Iterator<Item = &u64>> {
         todo!("this method is for only IVF_HNSW_* index");
     }
@@ -2075,6 +2101,7 @@ mod tests {
             fields: Vec::new(),
             name: INDEX_NAME.to_string(),
             fragment_bitmap: None,
+            index_type: None,
         };
 
         let prefilter = Arc::new(DatasetPreFilter::new(dataset.clone(), &[index_meta], None));
@@ -46,7 +46,9 @@ use crate::{
     session::Session,
 };
 
-use super::{centroids_to_vectors, Ivf, IvfIndexPartitionStatistics, IvfIndexStatistics};
+use super::{
+    centroids_to_vectors, load_partitions, Ivf, IvfIndexPartitionStatistics, IvfIndexStatistics,
+};
 /// IVF Index.
 #[derive(Debug)]
 pub struct IVFIndex<I: IvfSubIndex + 'static, Q: Quantization> {
@@ -336,6 +338,22 @@ impl<I: IvfSubIndex + fmt::Debug + 'static, Q: Quantization + fmt::Debug + 'stat
         })
     }
 
+    async fn prewarm_partitions(&self, partition_ids: &[usize]) -> Result<()> {
+        load_partitions(partition_ids, |part_id| self.load_partition(part_id, true)).await
+    }
+
+    fn num_partitions(&self) -> usize {
+        self.ivf.num_partitions()
+    }
+
+    fn cached_partitions(&self) -> Vec<usize> {
+        let prefix = format!("{}-ivf-", self.uuid);
+        self.sub_index_cache
+            .iter()
+            .filter_map(|(key, _)| key.strip_prefix(&prefix)?.parse().ok())
+            .collect()
+    }
+
     fn row_ids(&self) -> Box<dyn Iterator<Item = &'_ u64> + '_> {
         todo!("this method is for only IVF_HNSW_* index");
     }
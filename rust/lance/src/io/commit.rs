@@ -361,23 +361,17 @@ async fn migrate_indices(dataset: &Dataset, indices: &mut [Index]) -> Result<()>
     Ok(())
 }
 
-/// Attempt to commit a transaction, with retries and conflict resolution.
-pub(crate) async fn commit_transaction(
-    dataset: &Dataset,
+/// Check `transaction` against every transaction committed after `version`
+///
+/// On success `dataset` is moved to the latest version and the next free version is
+/// returned.  Returns [crate::Error::CommitConflict] if any of those transactions
+/// can't be reconciled with `transaction`.
+async fn rebase_transaction(
+    dataset: &mut Dataset,
+    mut version: u64,
     object_store: &ObjectStore,
-    commit_handler: &dyn CommitHandler,
     transaction: &Transaction,
-    write_config: &ManifestWriteConfig,
-    commit_config: &CommitConfig,
-) -> Result<Manifest> {
-    // Note: object_store has been configured with WriteParams, but dataset.object_store()
-    // has not necessarily. So for anything involving writing, use `object_store`.
-    let transaction_file = write_transaction_file(object_store, &dataset.base, transaction).await?;
-
-    let mut dataset = dataset.clone();
-    // First, get all transactions since read_version
-    let mut other_transactions = Vec::new();
-    let mut version = transaction.read_version;
+) -> Result<u64> {
     loop {
         version += 1;
         match dataset.checkout_version(version).await {
@@ -387,27 +381,56 @@ pub(crate) async fn commit_transaction(
                 } else {
                     None
                 };
-                other_transactions.push(other_txn);
-                dataset = next_dataset;
+                check_transaction(transaction, version, &other_txn)?;
+                *dataset = next_dataset;
             }
             Err(crate::Error::NotFound { .. }) | Err(crate::Error::DatasetNotFound { .. }) => {
-                break;
+                return Ok(version);
             }
             Err(e) => {
                 return Err(e);
             }
         }
     }
+}
 
-    let mut target_version = version;
-
-    // If any of them conflict with the transaction, return an error
-    for (version_offset, other_transaction) in other_transactions.iter().enumerate() {
-        let other_version = transaction.read_version + version_offset as u64 + 1;
-        check_transaction(transaction, other_version, other_transaction)?;
+/// Attempt to commit a transaction, with retries and conflict resolution.
+///
+/// Transactions that don't conflict with the ones committed concurrently (see
+/// [Transaction::conflicts_with]) are rebased onto the latest version and retried,
+/// with exponential backoff.
+pub(crate) async fn commit_transaction(
+    dataset: &Dataset,
+    object_store: &ObjectStore,
+    commit_handler: &dyn CommitHandler,
+    transaction: &Transaction,
+    write_config: &ManifestWriteConfig,
+    commit_config: &CommitConfig,
+) -> Result<Manifest> {
+    // A dataset opened with only some of its fragments would drop the others
+    if dataset.manifest.fragments_pruned() {
+        return Err(Error::NotSupported {
+            source: "Cannot commit to a dataset that was opened with only some of its fragments"
+                .into(),
+            location: location!(),
+        });
     }
 
-    for _ in 0..commit_config.num_retries {
+    // Note: object_store has been configured with WriteParams, but dataset.object_store()
+    // has not necessarily. So for anything involving writing, use `object_store`.
+    let transaction_file = write_transaction_file(object_store, &dataset.base, transaction).await?;
+
+    // First, check every transaction committed since read_version
+    let mut dataset = dataset.clone();
+    let mut target_version = rebase_transaction(
+        &mut dataset,
+        transaction.read_version,
+        object_store,
+        transaction,
+    )
+    .await?;
+
+    for attempt in 0..commit_config.num_retries {
         // Build an up-to-date manifest from the transaction and current manifest
         let (mut manifest, mut indices) = match transaction.operation {
             Operation::Restore { version } => {
@@ -464,17 +487,13 @@ pub(crate) async fn commit_transaction(
                 return Ok(manifest);
             }
             Err(CommitError::CommitConflict) => {
-                // See if we can retry the commit
-                dataset = dataset.checkout_version(target_version).await?;
-
-                let other_transaction =
-                    if let Some(txn_file) = dataset.manifest.transaction_file.as_ref() {
-                        Some(read_transaction_file(object_store, &dataset.base, txn_file).await?)
-                    } else {
-                        None
-                    };
-                check_transaction(transaction, target_version, &other_transaction)?;
-                target_version += 1;
+                // Another writer took target_version.  Wait a little so that writers
+                // that collided spread out, then rebase on everything committed since.
+                // No data files are rewritten, only the manifest is built again.
+                tokio::time::sleep(commit_config.backoff(attempt)).await;
+                target_version =
+                    rebase_transaction(&mut dataset, target_version - 1, object_store, transaction)
+                        .await?;
             }
             Err(CommitError::OtherError(err)) => {
                 // If other error, return
@@ -833,6 +852,69 @@ mod tests {
         }
     }
 
+    #[tokio::test]
+    async fn test_rebase_concurrent_commits() {
+        let test_dir = tempfile::tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+
+        let schema = Arc::new(ArrowSchema::new(vec![ArrowField::new(
+            "i",
+            DataType::Int32,
+            false,
+        )]));
+        let batch = |values: Vec<i32>| {
+            RecordBatch::try_new(schema.clone(), vec![Arc::new(Int32Array::from(values))]).unwrap()
+        };
+        let reader = RecordBatchIterator::new(vec![Ok(batch(vec![100, 101, 102]))], schema.clone());
+        Dataset::write(reader, test_uri, None).await.unwrap();
+
+        // 20 appenders, a delete and an index build all race to commit.  None of them
+        // conflict so every one should be rebased and committed.
+        let mut tasks = (0..20)
+            .map(|_| {
+                let reader =
+                    RecordBatchIterator::new(vec![Ok(batch(vec![1, 2, 3]))], schema.clone());
+                let uri = test_uri.to_string();
+                tokio::spawn(async move {
+                    let params = WriteParams {
+                        mode: WriteMode::Append,
+                        commit_handler: Some(Arc::new(RenameCommitHandler)),
+                        ..Default::default()
+                    };
+                    Dataset::write(reader, &uri, Some(params)).await.map(|_| ())
+                })
+            })
+            .collect::<Vec<_>>();
+        let uri = test_uri.to_string();
+        tasks.push(tokio::spawn(async move {
+            let mut dataset = Dataset::open(&uri).await?;
+            dataset.delete("i = 100").await
+        }));
+        let uri = test_uri.to_string();
+        tasks.push(tokio::spawn(async move {
+            let mut dataset = Dataset::open(&uri).await?;
+            dataset
+                .create_index(
+                    &["i"],
+                    IndexType::Scalar,
+                    None,
+                    &crate::index::scalar::ScalarIndexParams::default(),
+                    false,
+                )
+                .await
+        }));
+        for result in join_all(tasks).await {
+            assert!(matches!(result, Ok(Ok(_))), "{:?}", result);
+        }
+
+        let dataset = Dataset::open(test_uri).await.unwrap();
+        assert_eq!(dataset.version().version, 23);
+        assert_eq!(dataset.get_fragments().len(), 21);
+        assert_eq!(dataset.count_rows(None).await.unwrap(), 62);
+        assert_eq!(dataset.load_indices().await.unwrap().len(), 1);
+        dataset.validate().await.unwrap();
+    }
+
     #[test]
     fn test_fix_schema() {
         // Manifest has a fragment with no fields in use
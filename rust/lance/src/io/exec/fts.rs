@@ -0,0 +1,404 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: Copyright The Lance Authors
+
+use std::sync::Arc;
+
+use arrow_array::types::UInt64Type;
+use arrow_array::{cast::AsArray, Float32Array, RecordBatch, UInt64Array};
+use arrow_schema::{DataType, Field, Schema, SchemaRef};
+use datafusion::{
+    common::Statistics,
+    physical_plan::{
+        stream::RecordBatchStreamAdapter, DisplayAs, DisplayFormatType, ExecutionMode,
+        ExecutionPlan, Partitioning, PlanProperties, SendableRecordBatchStream,
+    },
+};
+use datafusion_physical_expr::EquivalenceProperties;
+use futures::{stream::BoxStream, StreamExt, TryFutureExt, TryStreamExt};
+use lance_core::utils::mask::RowIdMask;
+use lance_core::{Error, Result, ROW_ID, ROW_ID_FIELD};
+use lance_index::{
+    prefilter::{FilterLoader, PreFilter},
+    scalar::{
+        inverted::{InvertedIndex, SCORE_COL},
+        FullTextSearchQuery, ScalarIndex,
+    },
+    DatasetIndexExt,
+};
+use lance_table::format::Index;
+use snafu::{location, Location};
+
+use crate::{
+    index::{prefilter::DatasetPreFilter, DatasetIndexInternalExt},
+    io::exec::knn::{FilteredRowIdsToPrefilter, PreFilterSource, SelectionVectorToPrefilter},
+    Dataset,
+};
+
+lazy_static::lazy_static! {
+    pub static ref FTS_SCHEMA: SchemaRef = Arc::new(Schema::new(vec![
+        ROW_ID_FIELD.clone(),
+        Field::new(SCORE_COL, DataType::Float32, false),
+    ]));
+}
+
+/// Loads the inverted index of `column`
+async fn open_inverted_index(
+    dataset: &Dataset,
+    column: &str,
+) -> Result<(Index, Arc<dyn ScalarIndex>)> {
+    let index_meta = dataset
+        .load_scalar_index_for_column(column)
+        .await?
+        .ok_or_else(|| Error::InvalidInput {
+            source: format!("Column {} has no inverted index", column).into(),
+            location: location!(),
+        })?;
+    let index = dataset
+        .open_scalar_index(column, &index_meta.uuid.to_string())
+        .await?;
+    Ok((index_meta, index))
+}
+
+fn as_inverted_index<'a>(index: &'a dyn ScalarIndex, column: &str) -> Result<&'a InvertedIndex> {
+    index
+        .as_any()
+        .downcast_ref::<InvertedIndex>()
+        .ok_or_else(|| Error::InvalidInput {
+            source: format!(
+                "Full text search requires an inverted index but column {} has a different kind of index",
+                column
+            )
+            .into(),
+            location: location!(),
+        })
+}
+
+/// An execution node that performs a full text search with an inverted index
+///
+/// The output is the row ids of the best matching documents and their BM25 scores, sorted
+/// by descending score.  Deleted rows, and rows rejected by the prefilter, are skipped while
+/// searching so up to k rows are still returned.  Only fragments covered by the index are
+/// searched, the scanner adds the rest with [`FlatFtsExec`].
+#[derive(Debug)]
+pub struct FtsExec {
+    dataset: Arc<Dataset>,
+    column: String,
+    query: FullTextSearchQuery,
+    prefilter_source: PreFilterSource,
+    properties: PlanProperties,
+}
+
+impl DisplayAs for FtsExec {
+    fn fmt_as(&self, t: DisplayFormatType, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match t {
+            DisplayFormatType::Default | DisplayFormatType::Verbose => {
+                write!(
+                    f,
+                    "FullTextSearch: column={}, query={}, k={}",
+                    self.column,
+                    self.query.query,
+                    self.query.limit.unwrap_or_default()
+                )
+            }
+        }
+    }
+}
+
+impl FtsExec {
+    pub fn new(
+        dataset: Arc<Dataset>,
+        column: String,
+        query: FullTextSearchQuery,
+        prefilter_source: PreFilterSource,
+    ) -> Self {
+        let properties = PlanProperties::new(
+            EquivalenceProperties::new(FTS_SCHEMA.clone()),
+            Partitioning::RoundRobinBatch(1),
+            ExecutionMode::Bounded,
+        );
+        Self {
+            dataset,
+            column,
+            query,
+            prefilter_source,
+            properties,
+        }
+    }
+
+    async fn do_execute(
+        dataset: Arc<Dataset>,
+        column: String,
+        query: FullTextSearchQuery,
+        prefilter_loader: Option<Box<dyn FilterLoader>>,
+    ) -> Result<RecordBatch> {
+        let (index_meta, index) = open_inverted_index(&dataset, &column).await?;
+        let index = as_inverted_index(index.as_ref(), &column)?;
+
+        let pre_filter = DatasetPreFilter::new(dataset.clone(), &[index_meta], prefilter_loader);
+        pre_filter.wait_for_ready().await?;
+        let limit = query.limit.unwrap_or(usize::MAX);
+        let (row_ids, scores) = pre_filter.with_mask(|mask: &RowIdMask| {
+            index.bm25_search_filtered(&query.query, limit, |row_id| mask.selected(row_id))
+        });
+        Ok(RecordBatch::try_new(
+            FTS_SCHEMA.clone(),
+            vec![
+                Arc::new(UInt64Array::from(row_ids)),
+                Arc::new(Float32Array::from(scores)),
+            ],
+        )?)
+    }
+}
+
+impl ExecutionPlan for FtsExec {
+    fn as_any(&self) -> &dyn std::any::Any {
+        self
+    }
+
+    fn schema(&self) -> SchemaRef {
+        FTS_SCHEMA.clone()
+    }
+
+    fn children(&self) -> Vec<Arc<dyn ExecutionPlan>> {
+        match &self.prefilter_source {
+            PreFilterSource::None => vec![],
+            PreFilterSource::FilteredRowIds(src) => vec![src.clone()],
+            PreFilterSource::ScalarIndexQuery(src) => vec![src.clone()],
+        }
+    }
+
+    fn with_new_children(
+        self: Arc<Self>,
+        mut children: Vec<Arc<dyn ExecutionPlan>>,
+    ) -> datafusion::error::Result<Arc<dyn ExecutionPlan>> {
+        if children.len() != self.children().len() {
+            return Err(datafusion::error::DataFusionError::Internal(
+                "FtsExec node must have exactly as many children as its prefilter has".to_string(),
+            ));
+        }
+        let prefilter_source = match (&self.prefilter_source, children.pop()) {
+            (PreFilterSource::FilteredRowIds(_), Some(src)) => PreFilterSource::FilteredRowIds(src),
+            (PreFilterSource::ScalarIndexQuery(_), Some(src)) => {
+                PreFilterSource::ScalarIndexQuery(src)
+            }
+            _ => PreFilterSource::None,
+        };
+        Ok(Arc::new(Self::new(
+            self.dataset.clone(),
+            self.column.clone(),
+            self.query.clone(),
+            prefilter_source,
+        )))
+    }
+
+    fn execute(
+        &self,
+        partition: usize,
+        context: Arc<datafusion::execution::context::TaskContext>,
+    ) -> datafusion::error::Result<datafusion::physical_plan::SendableRecordBatchStream> {
+        let prefilter_loader = match &self.prefilter_source {
+            PreFilterSource::FilteredRowIds(src_node) => {
+                let stream = src_node.execute(partition, context)?;
+                Some(Box::new(FilteredRowIdsToPrefilter(stream)) as Box<dyn FilterLoader>)
+            }
+            PreFilterSource::ScalarIndexQuery(src_node) => {
+                let stream = src_node.execute(partition, context)?;
+                Some(Box::new(SelectionVectorToPrefilter(stream)) as Box<dyn FilterLoader>)
+            }
+            PreFilterSource::None => None,
+        };
+        let batch_fut = Self::do_execute(
+            self.dataset.clone(),
+            self.column.clone(),
+            self.query.clone(),
+            prefilter_loader,
+        );
+        let stream = futures::stream::iter(vec![batch_fut])
+            .then(|batch_fut| batch_fut.map_err(|err| err.into()))
+            .boxed()
+            as BoxStream<'static, datafusion::common::Result<RecordBatch>>;
+        Ok(Box::pin(RecordBatchStreamAdapter::new(
+            FTS_SCHEMA.clone(),
+            stream,
+        )))
+    }
+
+    fn statistics(&self) -> datafusion::error::Result<Statistics> {
+        Ok(Statistics::new_unknown(&FTS_SCHEMA))
+    }
+
+    fn properties(&self) -> &PlanProperties {
+        &self.properties
+    }
+}
+
+/// An execution node that scores the documents the inverted index does not cover
+///
+/// The input must have the text column and the row id, e.g. a scan of the fragments written
+/// after the index was trained.  Documents are scored with BM25 using the statistics of the
+/// index so the output (same schema as [`FtsExec`]) can be merged with that of [`FtsExec`].
+/// Documents without any of the query tokens are dropped and only the best k are returned.
+#[derive(Debug)]
+pub struct FlatFtsExec {
+    dataset: Arc<Dataset>,
+    column: String,
+    query: FullTextSearchQuery,
+    input: Arc<dyn ExecutionPlan>,
+    properties: PlanProperties,
+}
+
+impl DisplayAs for FlatFtsExec {
+    fn fmt_as(&self, t: DisplayFormatType, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match t {
+            DisplayFormatType::Default | DisplayFormatType::Verbose => {
+                write!(
+                    f,
+                    "FlatFullTextSearch: column={}, query={}, k={}",
+                    self.column,
+                    self.query.query,
+                    self.query.limit.unwrap_or_default()
+                )
+            }
+        }
+    }
+}
+
+impl FlatFtsExec {
+    pub fn new(
+        dataset: Arc<Dataset>,
+        column: String,
+        query: FullTextSearchQuery,
+        input: Arc<dyn ExecutionPlan>,
+    ) -> Self {
+        let properties = PlanProperties::new(
+            EquivalenceProperties::new(FTS_SCHEMA.clone()),
+            Partitioning::RoundRobinBatch(1),
+            ExecutionMode::Bounded,
+        );
+        Self {
+            dataset,
+            column,
+            query,
+            input,
+            properties,
+        }
+    }
+
+    async fn do_execute(
+        dataset: Arc<Dataset>,
+        column: String,
+        query: FullTextSearchQuery,
+        mut input: SendableRecordBatchStream,
+    ) -> Result<RecordBatch> {
+        let (_, index) = open_inverted_index(&dataset, &column).await?;
+        let index = as_inverted_index(index.as_ref(), &column)?;
+        let scorer = index.unindexed_scorer(&query.query);
+        let limit = query.limit.unwrap_or(usize::MAX);
+
+        let mut scored = Vec::<(u64, f32)>::new();
+        let keep_best = |scored: &mut Vec<(u64, f32)>| {
+            scored.sort_unstable_by(|left, right| right.1.total_cmp(&left.1));
+            scored.truncate(limit);
+        };
+        while let Some(batch) = input.try_next().await? {
+            let row_ids = batch
+                .column_by_name(ROW_ID)
+                .ok_or_else(|| Error::Internal {
+                    message: "FlatFtsExec input must have the row id".into(),
+                    location: location!(),
+                })?
+                .as_primitive::<UInt64Type>();
+            let docs = batch
+                .column_by_name(&column)
+                .ok_or_else(|| Error::Internal {
+                    message: format!("FlatFtsExec input must have the column {}", column),
+                    location: location!(),
+                })?;
+            let docs = match docs.data_type() {
+                DataType::LargeUtf8 => docs.as_string::<i64>().iter().collect::<Vec<_>>(),
+                _ => docs.as_string::<i32>().iter().collect::<Vec<_>>(),
+            };
+            for (doc, row_id) in docs.into_iter().zip(row_ids.values().iter()) {
+                let score = doc.map(|doc| scorer.score(doc)).unwrap_or_default();
+                if score > 0.0 {
+                    scored.push((*row_id, score));
+                }
+            }
+            // Bound the memory used by large scans
+            if scored.len() > limit.saturating_mul(2) {
+                keep_best(&mut scored);
+            }
+        }
+        keep_best(&mut scored);
+
+        let (row_ids, scores): (Vec<_>, Vec<_>) = scored.into_iter().unzip();
+        Ok(RecordBatch::try_new(
+            FTS_SCHEMA.clone(),
+            vec![
+                Arc::new(UInt64Array::from(row_ids)),
+                Arc::new(Float32Array::from(scores)),
+            ],
+        )?)
+    }
+}
+
+impl ExecutionPlan for FlatFtsExec {
+    fn as_any(&self) -> &dyn std::any::Any {
+        self
+    }
+
+    fn schema(&self) -> SchemaRef {
+        FTS_SCHEMA.clone()
+    }
+
+    fn children(&self) -> Vec<Arc<dyn ExecutionPlan>> {
+        vec![self.input.clone()]
+    }
+
+    fn with_new_children(
+        self: Arc<Self>,
+        mut children: Vec<Arc<dyn ExecutionPlan>>,
+    ) -> datafusion::error::Result<Arc<dyn ExecutionPlan>> {
+        if children.len() != 1 {
+            return Err(datafusion::error::DataFusionError::Internal(
+                "FlatFtsExec node must have exactly one child".to_string(),
+            ));
+        }
+        Ok(Arc::new(Self::new(
+            self.dataset.clone(),
+            self.column.clone(),
+            self.query.clone(),
+            children.pop().unwrap(),
+        )))
+    }
+
+    fn execute(
+        &self,
+        partition: usize,
+        context: Arc<datafusion::execution::context::TaskContext>,
+    ) -> datafusion::error::Result<SendableRecordBatchStream> {
+        let input = self.input.execute(partition, context)?;
+        let batch_fut = Self::do_execute(
+            self.dataset.clone(),
+            self.column.clone(),
+            self.query.clone(),
+            input,
+        );
+        let stream = futures::stream::iter(vec![batch_fut])
+            .then(|batch_fut| batch_fut.map_err(|err| err.into()))
+            .boxed()
+            as BoxStream<'static, datafusion::common::Result<RecordBatch>>;
+        Ok(Box::pin(RecordBatchStreamAdapter::new(
+            FTS_SCHEMA.clone(),
+            stream,
+        )))
+    }
+
+    fn statistics(&self) -> datafusion::error::Result<Statistics> {
+        Ok(Statistics::new_unknown(&FTS_SCHEMA))
+    }
+
+    fn properties(&self) -> &PlanProperties {
+        &self.properties
+    }
+}
@@ -277,7 +277,7 @@ impl ExecutionPlan for KNNFlatExec {
 }
 
 // Utility to convert an input (containing row ids) into a prefilter
-struct FilteredRowIdsToPrefilter(SendableRecordBatchStream);
+pub(crate) struct FilteredRowIdsToPrefilter(pub SendableRecordBatchStream);
 
 #[async_trait]
 impl FilterLoader for FilteredRowIdsToPrefilter {
@@ -299,7 +299,7 @@ impl FilterLoader for FilteredRowIdsToPrefilter {
 }
 
 // Utility to convert a serialized selection vector into a prefilter
-struct SelectionVectorToPrefilter(SendableRecordBatchStream);
+pub(crate) struct SelectionVectorToPrefilter(pub SendableRecordBatchStream);
 
 #[async_trait]
 impl FilterLoader for SelectionVectorToPrefilter {
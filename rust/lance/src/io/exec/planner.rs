@@ -283,6 +283,10 @@ impl Planner {
             BinaryOperator::NotEq => Operator::NotEq,
             BinaryOperator::And => Operator::And,
             BinaryOperator::Or => Operator::Or,
+            BinaryOperator::PGRegexMatch => Operator::RegexMatch,
+            BinaryOperator::PGRegexIMatch => Operator::RegexIMatch,
+            BinaryOperator::PGRegexNotMatch => Operator::RegexNotMatch,
+            BinaryOperator::PGRegexNotIMatch => Operator::RegexNotIMatch,
             _ => {
                 return Err(Error::io(
                     format!("Operator {op} is not supported"),
@@ -810,6 +814,7 @@ mod tests {
     };
     use arrow_schema::{DataType, Fields, Schema};
     use datafusion::logical_expr::{lit, Cast, ScalarFunctionDefinition};
+    use lance_index::scalar::{FullTextSearchQuery, ScalarQuery};
 
     #[test]
     fn test_parse_filter_simple() {
@@ -1029,6 +1034,41 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_full_text_search_expr() {
+        let schema = Arc::new(Schema::new(vec![Field::new("s", DataType::Utf8, true)]));
+        let planner = Planner::new(schema.clone());
+
+        // Without the index the query matches whole tokens, ignoring case
+        let expr = ScalarQuery::FullTextSearch(FullTextSearchQuery::new("Quick fox").limit(1))
+            .to_expr("s".to_string());
+        let physical_expr = planner.create_physical_expr(&expr).unwrap();
+        let batch = RecordBatch::try_new(
+            schema,
+            vec![Arc::new(StringArray::from(vec![
+                Some("The quick brown fox"),
+                Some("quickly"),
+                Some("a foxy dog"),
+                Some("QUICK!"),
+                Some("dog,fox"),
+                None,
+            ]))],
+        )
+        .unwrap();
+        let predicates = physical_expr.evaluate(&batch).unwrap();
+        assert_eq!(
+            predicates.into_array(0).unwrap().as_ref(),
+            &BooleanArray::from(vec![
+                Some(true),
+                Some(false),
+                Some(false),
+                Some(true),
+                Some(true),
+                None
+            ])
+        );
+    }
+
     #[test]
     fn test_not_like() {
         let schema = Arc::new(Schema::new(vec![Field::new("s", DataType::Utf8, true)]));
@@ -1057,6 +1097,37 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_sql_regex_match() {
+        let schema = Arc::new(Schema::new(vec![Field::new("s", DataType::Utf8, true)]));
+
+        let planner = Planner::new(schema.clone());
+
+        let batch = RecordBatch::try_new(
+            schema,
+            vec![Arc::new(StringArray::from(vec![
+                "str-4", "STR-42", "other",
+            ]))],
+        )
+        .unwrap();
+        for (filter, expected) in [
+            ("s ~ '^str-4'", vec![true, false, false]),
+            ("s ~* '^str-4'", vec![true, true, false]),
+            ("s !~ '^str-4'", vec![false, true, true]),
+            ("s !~* '^str-4'", vec![false, false, true]),
+        ] {
+            let expr = planner.parse_filter(filter).unwrap();
+            let physical_expr = planner.create_physical_expr(&expr).unwrap();
+            let predicates = physical_expr.evaluate(&batch).unwrap();
+            assert_eq!(
+                predicates.into_array(0).unwrap().as_ref(),
+                &BooleanArray::from(expected),
+                "{}",
+                filter
+            );
+        }
+    }
+
     #[test]
     fn test_sql_is_in() {
         let schema = Arc::new(Schema::new(vec![Field::new("s", DataType::Utf8, true)]));
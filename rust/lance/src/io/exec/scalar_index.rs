@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
+use std::collections::{BTreeMap, HashMap};
 use std::sync::Arc;
 
 use arrow_array::{RecordBatch, UInt64Array};
@@ -16,10 +17,7 @@ use datafusion::{
 };
 use datafusion_physical_expr::EquivalenceProperties;
 use futures::{stream::BoxStream, Stream, StreamExt, TryFutureExt, TryStreamExt};
-use lance_core::{
-    utils::{address::RowAddress, mask::RowIdTreeMap},
-    Error, Result, ROW_ID_FIELD,
-};
+use lance_core::{utils::address::RowAddress, Error, Result, ROW_ID_FIELD};
 use lance_index::{
     scalar::{
         expression::{ScalarIndexExpr, ScalarIndexLoader},
@@ -33,6 +31,7 @@ use snafu::{location, Location};
 use tracing::{debug_span, instrument};
 
 use crate::{
+    dataset::fragment::FileFragment,
     index::{prefilter::DatasetPreFilter, DatasetIndexInternalExt},
     Dataset,
 };
@@ -194,7 +193,6 @@ impl MapIndexExec {
     async fn map_batch(
         column_name: String,
         dataset: Arc<Dataset>,
-        deletion_mask: Option<Arc<RowIdTreeMap>>,
         batch: RecordBatch,
     ) -> datafusion::error::Result<RecordBatch> {
         let index_vals = batch.column(0);
@@ -212,11 +210,8 @@ impl MapIndexExec {
                         "IndexedLookupExec: row addresses didn't have an iterable allow list"
                             .into(),
                     ))?;
-            let mut allow_list = allow_list.map(u64::from).collect::<Vec<_>>();
-            if let Some(deletion_mask) = deletion_mask {
-                allow_list.retain(|row_id| !deletion_mask.contains(*row_id));
-            }
-            let allow_list = UInt64Array::from(allow_list);
+            let allow_list = allow_list.map(u64::from).collect::<Vec<_>>();
+            let allow_list = UInt64Array::from(Self::remove_deleted(&dataset, allow_list).await?);
             Ok(RecordBatch::try_new(
                 INDEX_LOOKUP_SCHEMA.clone(),
                 vec![Arc::new(allow_list)],
@@ -228,6 +223,48 @@ impl MapIndexExec {
         }
     }
 
+    /// Remove the addresses of rows that have been deleted
+    ///
+    /// Only the deletion files of the fragments that contain a match are loaded, so a lookup
+    /// of a few keys stays cheap no matter how many fragments have deletions.
+    async fn remove_deleted(dataset: &Arc<Dataset>, row_addrs: Vec<u64>) -> Result<Vec<u64>> {
+        let mut by_fragment: BTreeMap<u32, Vec<u64>> = BTreeMap::new();
+        for row_addr in row_addrs {
+            by_fragment
+                .entry(RowAddress::new_from_id(row_addr).fragment_id())
+                .or_default()
+                .push(row_addr);
+        }
+        let fragments = dataset
+            .fragments()
+            .iter()
+            .map(|fragment| (fragment.id as u32, fragment))
+            .collect::<HashMap<_, _>>();
+        let fragments = &fragments;
+
+        let remaining = futures::stream::iter(by_fragment)
+            .map(|(fragment_id, row_addrs)| async move {
+                // The index may still cover fragments that have since been removed
+                let Some(fragment) = fragments.get(&fragment_id) else {
+                    return Result::Ok(Vec::new());
+                };
+                let fragment = FileFragment::new(dataset.clone(), (*fragment).clone());
+                let Some(deletion_vector) = fragment.get_deletion_vector().await? else {
+                    return Ok(row_addrs);
+                };
+                Ok(row_addrs
+                    .into_iter()
+                    .filter(|row_addr| {
+                        !deletion_vector.contains(RowAddress::new_from_id(*row_addr).row_id())
+                    })
+                    .collect())
+            })
+            .buffered(num_cpus::get())
+            .try_collect::<Vec<Vec<u64>>>()
+            .await?;
+        Ok(remaining.into_iter().flatten().collect())
+    }
+
     async fn do_execute(
         input: datafusion::physical_plan::SendableRecordBatchStream,
         dataset: Arc<Dataset>,
@@ -235,22 +272,10 @@ impl MapIndexExec {
     ) -> datafusion::error::Result<
         impl Stream<Item = datafusion::error::Result<RecordBatch>> + Send + 'static,
     > {
-        let index = dataset
-            .load_scalar_index_for_column(&column_name)
-            .await?
-            .unwrap();
-        let deletion_mask_fut =
-            DatasetPreFilter::create_deletion_mask(dataset.clone(), index.fragment_bitmap.unwrap());
-        let deletion_mask = if let Some(deletion_mask_fut) = deletion_mask_fut {
-            Some(deletion_mask_fut.await?)
-        } else {
-            None
-        };
         Ok(input.and_then(move |res| {
             let column_name = column_name.clone();
             let dataset = dataset.clone();
-            let deletion_mask = deletion_mask.clone();
-            Self::map_batch(column_name, dataset, deletion_mask, res)
+            Self::map_batch(column_name, dataset, res)
         }))
     }
 }
@@ -500,3 +525,90 @@ impl ExecutionPlan for MaterializeIndexExec {
         &self.properties
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use arrow_array::{Int32Array, RecordBatchIterator};
+    use arrow_schema::Field as ArrowField;
+    use datafusion::execution::TaskContext;
+    use lance_datafusion::exec::OneShotExec;
+    use lance_index::IndexType;
+    use tempfile::tempdir;
+
+    use super::*;
+    use crate::dataset::WriteParams;
+    use crate::index::scalar::ScalarIndexParams;
+
+    #[tokio::test]
+    async fn test_map_index_skips_deleted_rows() {
+        let test_dir = tempdir().unwrap();
+        let test_uri = test_dir.path().to_str().unwrap();
+        let schema = Arc::new(Schema::new(vec![ArrowField::new(
+            "id",
+            DataType::Int32,
+            false,
+        )]));
+        let batch = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(Int32Array::from_iter_values(0..100))],
+        )
+        .unwrap();
+        let reader = RecordBatchIterator::new(vec![Ok(batch)], schema.clone());
+        let write_params = WriteParams {
+            max_rows_per_file: 50,
+            ..Default::default()
+        };
+        let mut dataset = Dataset::write(reader, test_uri, Some(write_params))
+            .await
+            .unwrap();
+        dataset
+            .create_index(
+                &["id"],
+                IndexType::Scalar,
+                None,
+                &ScalarIndexParams::default(),
+                false,
+            )
+            .await
+            .unwrap();
+        // Rows are deleted after the index was built, so the index still contains them
+        dataset.delete("id < 10 OR id = 60").await.unwrap();
+
+        let keys = RecordBatch::try_new(
+            schema.clone(),
+            vec![Arc::new(Int32Array::from(vec![5, 15, 60, 70]))],
+        )
+        .unwrap();
+        let input = Arc::new(OneShotExec::new(Box::pin(RecordBatchStreamAdapter::new(
+            schema,
+            futures::stream::iter(vec![Ok(keys)]),
+        ))));
+        let map_index = MapIndexExec::new(Arc::new(dataset), "id".to_string(), input);
+        let batches = map_index
+            .execute(0, Arc::new(TaskContext::default()))
+            .unwrap()
+            .try_collect::<Vec<_>>()
+            .await
+            .unwrap();
+        let mut row_addrs = batches
+            .iter()
+            .flat_map(|batch| {
+                batch
+                    .column(0)
+                    .as_any()
+                    .downcast_ref::<UInt64Array>()
+                    .unwrap()
+                    .values()
+                    .to_vec()
+            })
+            .collect::<Vec<_>>();
+        row_addrs.sort();
+        assert_eq!(
+            row_addrs,
+            vec![
+                u64::from(RowAddress::new_from_parts(0, 15)),
+                u64::from(RowAddress::new_from_parts(1, 20)),
+            ]
+        );
+    }
+}
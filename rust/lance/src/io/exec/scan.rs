@@ -2,6 +2,8 @@
 // SPDX-FileCopyrightText: Copyright The Lance Authors
 
 use std::any::Any;
+use std::collections::HashMap;
+use std::ops::Range;
 use std::pin::Pin;
 use std::sync::Arc;
 use std::task::{Context, Poll};
@@ -17,7 +19,7 @@ use datafusion::physical_plan::{
 use datafusion_physical_expr::EquivalenceProperties;
 use futures::stream;
 use futures::stream::Stream;
-use futures::{StreamExt, TryStreamExt};
+use futures::{StreamExt, TryFutureExt, TryStreamExt};
 use lance_arrow::SchemaExt;
 use lance_core::utils::tracing::StreamTracingExt;
 use lance_core::{ROW_ADDR_FIELD, ROW_ID_FIELD};
@@ -44,6 +46,124 @@ async fn open_file(
     Ok(reader)
 }
 
+/// A share of a scan: one fragment, or a range of the rows of a large fragment.
+#[derive(Debug, Clone)]
+struct ScanTask {
+    fragment: Fragment,
+    /// The physical rows of the fragment to read, or `None` to read all of them.
+    range: Option<Range<u32>>,
+}
+
+impl ScanTask {
+    fn full(fragment: Fragment) -> Self {
+        Self {
+            fragment,
+            range: None,
+        }
+    }
+}
+
+/// Split the fragments into up to `num_partitions` contiguous runs with about
+/// the same amount of data each.
+///
+/// The amount of data of a fragment is its size in `fragment_bytes`, if given, and
+/// otherwise its number of rows (scaled by the average row size of the sized
+/// fragments, if there are any).  Rows are assumed to be about the same size within
+/// a fragment.  A fragment that straddles a partition boundary is split into row
+/// ranges, as long as each side gets at least `min_rows` rows.  Fragments without
+/// a row count (written by very old versions) can't be split and are counted as
+/// average sized.
+fn partition_fragments(
+    fragments: &[Fragment],
+    num_partitions: usize,
+    min_rows: usize,
+    fragment_bytes: Option<&HashMap<u64, u64>>,
+) -> Vec<Vec<ScanTask>> {
+    let known_rows = fragments
+        .iter()
+        .filter_map(|fragment| fragment.physical_rows)
+        .collect::<Vec<_>>();
+    let default_rows = if known_rows.is_empty() {
+        1
+    } else {
+        known_rows.iter().sum::<usize>() / known_rows.len()
+    };
+    let num_rows_of = |fragment: &Fragment| fragment.physical_rows.unwrap_or(default_rows);
+    let bytes_of = |fragment: &Fragment| {
+        fragment_bytes
+            .and_then(|sizes| sizes.get(&fragment.id))
+            .copied()
+            .filter(|_| num_rows_of(fragment) > 0)
+    };
+    let (sized_bytes, sized_rows) = fragments
+        .iter()
+        .filter_map(|fragment| Some((bytes_of(fragment)?, num_rows_of(fragment))))
+        .fold(
+            (0_u64, 0_u64),
+            |(total_bytes, total_rows), (bytes, rows)| {
+                (total_bytes + bytes, total_rows + rows as u64)
+            },
+        );
+    let default_row_size = if sized_rows > 0 {
+        sized_bytes as f64 / sized_rows as f64
+    } else {
+        1.0
+    };
+    let row_size_of = |fragment: &Fragment| match bytes_of(fragment) {
+        Some(bytes) => bytes as f64 / num_rows_of(fragment) as f64,
+        None => default_row_size,
+    };
+
+    let total_size = fragments
+        .iter()
+        .map(|fragment| num_rows_of(fragment) as f64 * row_size_of(fragment))
+        .sum::<f64>();
+    let num_partitions = num_partitions.max(1);
+    let target_size = total_size / num_partitions as f64;
+
+    let mut partitions = Vec::with_capacity(num_partitions);
+    let mut current = Vec::new();
+    let mut current_size = 0.0;
+    for fragment in fragments {
+        let num_rows = num_rows_of(fragment);
+        let row_size = row_size_of(fragment);
+        let mut start = 0;
+        // Fill up the current partition with the first rows of the fragment
+        while fragment.physical_rows.is_some()
+            && current_size + (num_rows - start) as f64 * row_size > target_size
+            && partitions.len() + 1 < num_partitions
+        {
+            // Round to the nearest row so that equally sized rows split evenly
+            let take = ((target_size - current_size) / row_size).round() as usize;
+            if take == 0 || take < min_rows || (num_rows - start).saturating_sub(take) < min_rows {
+                break;
+            }
+            current.push(ScanTask {
+                fragment: fragment.clone(),
+                range: Some(start as u32..(start + take) as u32),
+            });
+            partitions.push(std::mem::take(&mut current));
+            current_size = 0.0;
+            start += take;
+        }
+
+        current.push(ScanTask {
+            fragment: fragment.clone(),
+            range: (start > 0).then_some(start as u32..num_rows as u32),
+        });
+        current_size += (num_rows - start) as f64 * row_size;
+        // Leave some slack for rounding so an exactly full partition is closed
+        if current_size >= target_size * (1.0 - 1e-9) && partitions.len() + 1 < num_partitions {
+            partitions.push(std::mem::take(&mut current));
+            current_size = 0.0;
+        }
+    }
+    if !current.is_empty() || partitions.is_empty() {
+        partitions.push(current);
+    }
+    partitions
+}
+
 /// Dataset Scan Node.
 pub struct LanceStream {
     inner_stream: stream::BoxStream<'static, Result<RecordBatch>>,
@@ -62,6 +182,7 @@ impl LanceStream {
     /// Parameters
     ///
     ///  - ***dataset***: The source dataset.
+    ///  - ***tasks***: The fragments, or ranges of fragments, to read.
     ///  - ***projection***: the projection [Schema].
     ///  - ***filter***: filter [`PhysicalExpr`], optional.
     ///  - ***read_size***: the number of rows to read for each request.
@@ -73,9 +194,9 @@ impl LanceStream {
     ///  - ***with_make_deletions_null***: make deletions null.
     ///  - ***scan_in_order***: whether to scan the fragments in the provided order.
     #[allow(clippy::too_many_arguments)]
-    pub fn try_new(
+    fn try_new(
         dataset: Arc<Dataset>,
-        fragments: Arc<Vec<Fragment>>,
+        tasks: Vec<ScanTask>,
         projection: Arc<Schema>,
         read_size: usize,
         batch_readahead: usize,
@@ -87,31 +208,33 @@ impl LanceStream {
     ) -> Result<Self> {
         let project_schema = projection.clone();
 
-        let file_fragments = fragments
-            .iter()
-            .map(|fragment| FileFragment::new(dataset.clone(), fragment.clone()))
-            .collect::<Vec<_>>();
+        let readers = stream::iter(tasks)
+            .map(move |task| {
+                let file_fragment = FileFragment::new(dataset.clone(), task.fragment);
+                let range = task.range;
+                Ok(open_file(
+                    file_fragment,
+                    project_schema.clone(),
+                    with_row_id,
+                    with_row_address,
+                    with_make_deletions_null,
+                )
+                .map_ok(move |reader| (reader, range)))
+            })
+            .try_buffered(fragment_readahead);
+        let tasks = readers.and_then(move |(reader, range)| {
+            let task_stream = match range {
+                Some(range) => reader.read_range(range, read_size as u32),
+                None => reader.read_all(read_size as u32),
+            };
+            std::future::ready(
+                task_stream
+                    .map(|task_stream| task_stream.map(Ok))
+                    .map_err(DataFusionError::from),
+            )
+        });
 
         let inner_stream = if scan_in_order {
-            let readers = stream::iter(file_fragments)
-                .map(move |file_fragment| {
-                    Ok(open_file(
-                        file_fragment,
-                        project_schema.clone(),
-                        with_row_id,
-                        with_row_address,
-                        with_make_deletions_null,
-                    ))
-                })
-                .try_buffered(fragment_readahead);
-            let tasks = readers.and_then(move |reader| {
-                std::future::ready(
-                    reader
-                        .read_all(read_size as u32)
-                        .map(|task_stream| task_stream.map(Ok))
-                        .map_err(DataFusionError::from),
-                )
-            });
             tasks
                 // We must be waiting to finish a file before moving onto thenext. That's an issue.
                 .try_flatten()
@@ -120,25 +243,6 @@ impl LanceStream {
                 .stream_in_current_span()
                 .boxed()
         } else {
-            let readers = stream::iter(file_fragments)
-                .map(move |file_fragment| {
-                    Ok(open_file(
-                        file_fragment,
-                        project_schema.clone(),
-                        with_row_id,
-                        with_row_address,
-                        with_make_deletions_null,
-                    ))
-                })
-                .try_buffered(fragment_readahead);
-            let tasks = readers.and_then(move |reader| {
-                std::future::ready(
-                    reader
-                        .read_all(read_size as u32)
-                        .map(|task_stream| task_stream.map(Ok))
-                        .map_err(DataFusionError::from),
-                )
-            });
             // When we flatten the streams (one stream per fragment), we allow
             // `fragment_readahead` stream to be read concurrently.
             tasks
@@ -194,10 +298,17 @@ impl Stream for LanceStream {
 }
 
 /// DataFusion [ExecutionPlan] for scanning one Lance dataset
+///
+/// The scan has a single output partition unless it is split with
+/// [`LanceScanExec::with_partitions`].
 #[derive(Debug)]
 pub struct LanceScanExec {
     dataset: Arc<Dataset>,
     fragments: Arc<Vec<Fragment>>,
+    /// The share of the scan read by each output partition.
+    partitions: Arc<Vec<Vec<ScanTask>>>,
+    /// The number of row ranges read, if the scan was restricted with [`Self::with_ranges`].
+    num_ranges: Option<usize>,
     projection: Arc<Schema>,
     read_size: usize,
     batch_readahead: usize,
@@ -229,7 +340,14 @@ impl DisplayAs for LanceScanExec {
                     self.with_row_id,
                     self.with_row_address,
                     self.ordered_output
-                )
+                )?;
+                if self.partitions.len() > 1 {
+                    write!(f, ", partitions={}", self.partitions.len())?;
+                }
+                if let Some(num_ranges) = self.num_ranges {
+                    write!(f, ", ranges={}", num_ranges)?;
+                }
+                Ok(())
             }
         }
     }
@@ -266,9 +384,16 @@ impl LanceScanExec {
             Partitioning::RoundRobinBatch(1),
             datafusion::physical_plan::ExecutionMode::Bounded,
         );
+        let partitions = Arc::new(vec![fragments
+            .iter()
+            .cloned()
+            .map(ScanTask::full)
+            .collect()]);
         Self {
             dataset,
             fragments,
+            partitions,
+            num_ranges: None,
             projection,
             read_size,
             batch_readahead,
@@ -281,6 +406,69 @@ impl LanceScanExec {
             properties,
         }
     }
+
+    /// Split the scan into up to `num_partitions` output partitions, so that
+    /// the operators above it can run in parallel.
+    ///
+    /// Each partition reads a contiguous run of the fragments with about the
+    /// same number of bytes, and large fragments are split into row ranges to
+    /// get there.  `fragment_bytes` has the number of bytes the scan reads from
+    /// each fragment (by fragment id), e.g. the size of the data files that
+    /// hold the projected columns.  Without it the partitions get about the same
+    /// number of rows, which only balances the bytes if rows are about the same
+    /// size in every fragment (e.g. no variable width columns).  Each partition
+    /// still returns its rows in order (if `ordered_output` is set), but the
+    /// partitions are not ordered relative to each other.
+    pub fn with_partitions(
+        mut self,
+        num_partitions: usize,
+        fragment_bytes: Option<&HashMap<u64, u64>>,
+    ) -> Self {
+        let partitions = partition_fragments(
+            &self.fragments,
+            num_partitions,
+            self.read_size,
+            fragment_bytes,
+        );
+        self.properties = PlanProperties::new(
+            EquivalenceProperties::new(self.output_schema.clone()),
+            Partitioning::UnknownPartitioning(partitions.len()),
+            datafusion::physical_plan::ExecutionMode::Bounded,
+        );
+        self.partitions = Arc::new(partitions);
+        self.num_ranges = None;
+        self
+    }
+
+    /// Only read the given physical row ranges of some of the fragments
+    ///
+    /// Fragments without an entry in `ranges` are read in full.  This is used to skip the
+    /// parts of fragments that an index ruled out, the rows that are read still need to be
+    /// filtered.  The scan has a single output partition.
+    pub fn with_ranges(mut self, ranges: HashMap<u64, Vec<Range<u32>>>) -> Self {
+        let tasks = self
+            .fragments
+            .iter()
+            .flat_map(|fragment| match ranges.get(&fragment.id) {
+                Some(ranges) => ranges
+                    .iter()
+                    .map(|range| ScanTask {
+                        fragment: fragment.clone(),
+                        range: Some(range.clone()),
+                    })
+                    .collect::<Vec<_>>(),
+                None => vec![ScanTask::full(fragment.clone())],
+            })
+            .collect::<Vec<_>>();
+        self.num_ranges = Some(ranges.values().map(|ranges| ranges.len()).sum());
+        self.properties = PlanProperties::new(
+            EquivalenceProperties::new(self.output_schema.clone()),
+            Partitioning::RoundRobinBatch(1),
+            datafusion::physical_plan::ExecutionMode::Bounded,
+        );
+        self.partitions = Arc::new(vec![tasks]);
+        self
+    }
 }
 
 impl ExecutionPlan for LanceScanExec {
@@ -312,12 +500,19 @@ impl ExecutionPlan for LanceScanExec {
 
     fn execute(
         &self,
-        _partition: usize,
+        partition: usize,
         _context: Arc<datafusion::execution::context::TaskContext>,
     ) -> Result<SendableRecordBatchStream> {
+        let tasks = self.partitions.get(partition).ok_or_else(|| {
+            DataFusionError::Internal(format!(
+                "LanceScanExec has {} partitions, cannot execute partition {}",
+                self.partitions.len(),
+                partition
+            ))
+        })?;
         Ok(Box::pin(LanceStream::try_new(
             self.dataset.clone(),
-            self.fragments.clone(),
+            tasks.clone(),
             self.projection.clone(),
             self.read_size,
             self.batch_readahead,
@@ -341,9 +536,20 @@ impl ExecutionPlan for LanceScanExec {
                         None => (row_count, false),
                     },
                 );
-        let num_rows = match is_exact {
-            true => Precision::Exact(row_count),
-            false => Precision::Absent,
+        let num_rows = match (is_exact, self.num_ranges) {
+            (true, None) => Precision::Exact(row_count),
+            // Only the physical rows in the ranges are read, some of them may be deleted
+            (true, Some(_)) => Precision::Inexact(
+                self.partitions
+                    .iter()
+                    .flatten()
+                    .map(|task| match &task.range {
+                        Some(range) => range.len(),
+                        None => task.fragment.num_rows().unwrap_or_default(),
+                    })
+                    .sum(),
+            ),
+            (false, _) => Precision::Absent,
         };
 
         Ok(Statistics {
@@ -5,7 +5,7 @@ use std::collections::HashMap;
 use std::sync::Arc;
 
 use deepsize::DeepSizeOf;
-use lance_core::cache::FileMetadataCache;
+use lance_core::cache::{FileMetadataCache, IndexPageCache, DEFAULT_INDEX_PAGE_CACHE_SIZE_BYTES};
 use lance_core::{Error, Result};
 use lance_index::IndexType;
 use snafu::{location, Location};
@@ -26,6 +26,9 @@ pub struct Session {
     /// Cache for file metadata
     pub(crate) file_metadata_cache: FileMetadataCache,
 
+    /// Cache for deserialized pages of scalar indices, bounded by size in bytes
+    pub(crate) index_page_cache: IndexPageCache,
+
     pub(crate) index_extensions: HashMap<(IndexType, String), Arc<dyn IndexExtension>>,
 }
 
@@ -45,10 +48,31 @@ impl Session {
         Self {
             index_cache: IndexCache::new(index_cache_size),
             file_metadata_cache: FileMetadataCache::new(metadata_cache_size),
+            index_page_cache: IndexPageCache::new(DEFAULT_INDEX_PAGE_CACHE_SIZE_BYTES),
             index_extensions: HashMap::new(),
         }
     }
 
+    /// Bound the index cache by the total size of the cached indices, in bytes.
+    ///
+    /// By default the index cache holds a fixed number of indices, but cached indices range
+    /// from a few KB to many GB, so a byte budget gives far more predictable memory use.
+    pub fn with_index_cache_size_bytes(mut self, capacity_bytes: usize) -> Self {
+        let metadata_capacity = self.index_cache.metadata_capacity();
+        self.index_cache = IndexCache::with_capacity_bytes(capacity_bytes, metadata_capacity);
+        self
+    }
+
+    /// Set the capacity, in bytes, of the cache for scalar index pages.
+    ///
+    /// Point lookups on a btree index only need to load the pages that may contain the
+    /// requested values.  Cached pages are reused across queries.  A capacity of 0 disables
+    /// the cache.
+    pub fn with_index_page_cache_size(mut self, capacity_bytes: usize) -> Self {
+        self.index_page_cache = IndexPageCache::new(capacity_bytes);
+        self
+    }
+
     /// Register a new index extension.
     ///
     /// A name can only be registered once per type of index extension.
@@ -108,6 +132,7 @@ impl Default for Session {
         Self {
             index_cache: IndexCache::new(DEFAULT_INDEX_CACHE_SIZE),
             file_metadata_cache: FileMetadataCache::new(DEFAULT_METADATA_CACHE_SIZE),
+            index_page_cache: IndexPageCache::new(DEFAULT_INDEX_PAGE_CACHE_SIZE_BYTES),
             index_extensions: HashMap::new(),
         }
     }
@@ -120,6 +145,7 @@ mod tests {
     use arrow_array::types::Float32Type;
     use std::sync::Arc;
 
+    use crate::index::cache::CacheStats;
     use crate::index::vector::pq::PQIndex;
     use lance_index::vector::pq::ProductQuantizerImpl;
     use lance_linalg::distance::MetricType;
@@ -188,5 +214,42 @@ mod tests {
 
         // Capacity is 10 so there should be at most 10 items
         assert_eq!(session.index_cache.len_vector(), 10);
+
+        let stats = session.index_cache.stats();
+        assert_eq!(stats.vector.hits, 2);
+        assert_eq!(stats.vector.misses, 1);
+        assert_eq!(stats.vector.entry_count, 10);
+        assert!(stats.vector.evictions > 0);
+        assert_eq!(stats.scalar, CacheStats::default());
+    }
+
+    #[test]
+    fn test_index_cache_size_bytes() {
+        let make_index = || {
+            // A few KiB each since the cache weighs entries in KiB
+            let pq = Arc::new(ProductQuantizerImpl::<Float32Type>::new(
+                1,
+                8,
+                8,
+                Arc::new(vec![0.0f32; 256 * 8].into()),
+                MetricType::L2,
+            ));
+            Arc::new(PQIndex::new(pq, MetricType::L2))
+        };
+        let index_size = make_index().deep_size_of();
+
+        // Room for about 4 indices, regardless of the entry count
+        let session = Session::new(1000, 1).with_index_cache_size_bytes(index_size * 4);
+        for iter_idx in 0..100 {
+            session
+                .index_cache
+                .insert_vector(format!("{iter_idx}").as_str(), make_index());
+        }
+
+        let stats = session.index_cache.stats();
+        assert!(stats.vector.entry_count <= 4);
+        assert!(stats.vector.size_bytes <= (index_size * 4) as u64);
+        // The metadata cache keeps the capacity the session was created with
+        assert_eq!(session.index_cache.metadata_capacity(), 1000);
     }
 }